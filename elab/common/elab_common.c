@@ -14,6 +14,7 @@
 #if defined(__linux__)
 #include <unistd.h>
 #include <termios.h>
+#include <time.h>
 #endif
 
 #if defined(_WIN32)
@@ -98,6 +99,32 @@ ELAB_WEAK uint32_t elab_time_ms(void)
 #endif
 }
 
+/**
+  * @brief  eLab time in micro-second, for time stamps and latency measuring.
+  *         The start point of it is not defined.
+  * @retval The time in micro-second.
+  */
+ELAB_WEAK uint64_t elab_time_us(void)
+{
+    return elab_time_ns() / 1000;
+}
+
+/**
+  * @brief  eLab time in nano-second, for time stamps and latency measuring.
+  *         It is the kernel time based on CLOCK_MONOTONIC on Linux, which
+  *         follows the virtual time if switched on, and the millisecond time
+  *         on other platforms if not overridden by a hardware timer.
+  * @retval The time in nano-second.
+  */
+ELAB_WEAK uint64_t elab_time_ns(void)
+{
+#if defined(__linux__)
+    return osKernelGetTimeNs();
+#else
+    return (uint64_t)elab_time_ms() * 1000000;
+#endif
+}
+
 #if !defined(__linux__) && !defined(_WIN32)
 /**
   * @brief  eLab debug uart weak initialization function.
@@ -126,11 +153,19 @@ ELAB_WEAK int16_t elab_debug_uart_receive(void *buffer, uint16_t size)
 }
 #endif
 
+#if (ELAB_HEAP_LOCK_EN != 0)
+static bool heap_locked = false;
+#endif
+
 #if !defined(__linux__) && !defined(_WIN32)
 ELAB_WEAK
 #endif
 void *elab_malloc(uint32_t size)
 {
+#if (ELAB_HEAP_LOCK_EN != 0)
+    assert(!heap_locked);
+#endif
+
     return malloc(size);
 }
 
@@ -145,6 +180,23 @@ void elab_free(void *memory)
     }
 }
 
+/**
+  * @brief  Forbid the dynamic memory allocation from now on, if the switch
+  *         ELAB_HEAP_LOCK_EN is enabled. It is called by eLab when all the
+  *         modules are initialized, so the allocation in the running time is
+  *         caught at once.
+  * @retval None
+  */
+void elab_heap_lock(void)
+{
+#if (ELAB_HEAP_LOCK_EN != 0)
+    heap_locked = true;
+#if defined(__linux__) && (ELAB_RTOS_CMSIS_OS_EN != 0)
+    osKernelHeapLock();
+#endif
+#endif
+}
+
 #if defined(_WIN32) || defined(__linux__)
 /**
   * @brief  The weak initialization function for the debug uart.
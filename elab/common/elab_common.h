@@ -23,11 +23,14 @@ uint32_t elab_version(void);
 
 /* time related. */
 uint32_t elab_time_ms(void);
+uint64_t elab_time_us(void);
+uint64_t elab_time_ns(void);
 void elab_delay_us(void);
 
 /* Memory management related. */
 void *elab_malloc(uint32_t size);
 void elab_free(void *memory);
+void elab_heap_lock(void);
 
 /* MCU related */
 void elab_mcu_reset(void);
@@ -35,6 +35,7 @@ typedef enum elab_err
     ELAB_ERR_NOT_ENOUGH                 = -11,
     ELAB_ERR_NO_SYSTEM                  = -12,
     ELAB_ERR_BUS                        = -13,
+    ELAB_ERR_CANCEL                     = -14,
 } elab_err_t;
 
 typedef struct elab_date
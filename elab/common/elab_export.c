@@ -19,6 +19,10 @@ ELAB_TAG("eLabExport");
 #if (ELAB_RTOS_CMSIS_OS_EN != 0)
 #include "../os/cmsis_os.h"
 #endif
+#if defined(__linux__) && (ELAB_RTOS_PROFILE_EN != 0)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 #if (ELAB_RTOS_BASIC_OS_EN != 0)
 #include "basic_os.h"
 #endif
@@ -49,6 +53,9 @@ static void _get_init_export_table(void);
 static void elab_exit(void);
 static void _exit_func_execute(int8_t level);
 #endif
+#if defined(__linux__) && (ELAB_RTOS_PROFILE_EN != 0)
+static void _profile_save(void);
+#endif
 
 #if (ELAB_RTOS_CMSIS_OS_EN != 0 || ELAB_RTOS_BASIC_OS_EN != 0)
 static void _entry_start_poll(void *para);
@@ -65,6 +72,9 @@ static uint32_t count_export_init = 0;
 static elab_export_t *export_poll_table = NULL;
 static uint32_t count_export_poll = 0;
 static int8_t export_level_max = INT8_MIN;
+#if defined(__linux__) || defined(_WIN32)
+static volatile sig_atomic_t exit_in_signal = 0;
+#endif
 
 #if (ELAB_RTOS_CMSIS_OS_EN != 0)
 /**
@@ -125,6 +135,7 @@ static void signal_handler(int sig)
         printf("Elab Signal: %d.\n", sig);
     }
     
+    exit_in_signal = 1;
     elab_exit();
 #if defined(__linux__)
     system("stty echo");
@@ -150,11 +161,31 @@ void elab_run(void)
 #endif
     signal(SIGSEGV, signal_handler);
 #endif
+#if defined(__linux__) && (ELAB_RTOS_PROFILE_EN != 0)
+    atexit(_profile_save);
+#endif
 
     /* Start polling function in metal eLab, or start the RTOS kernel in RTOS 
        eLab. */
     _get_init_export_table();
     _get_poll_export_table();
+#if (ELAB_RTOS_CMSIS_OS_EN != 0) && defined(__linux__) && \
+    (ELAB_RTOS_RT_PROFILE_EN != 0)
+    /* Before the kernel creates the timer thread. */
+    const osKernelRtProfile_t rt_profile =
+    {
+        .attr_bits = osKernelRtMemLock | osKernelRtPrefault | osKernelRtSched,
+        .affinity_mask = ELAB_RTOS_RT_AFFINITY_MASK,
+        .priority_rt = osPriorityHigh7,
+    };
+    osKernelSetRtProfile(&rt_profile);
+#endif
+#if (ELAB_RTOS_CMSIS_OS_EN != 0) && defined(__linux__) && \
+    (ELAB_RTOS_VIRTUAL_TIME_EN != 0)
+    /* Simulation in the virtual time, before the kernel creates the timer
+       thread or any other one. */
+    osKernelSetVirtualTime(1, ELAB_RTOS_VIRTUAL_TIME_SCALE);
+#endif
 #if (ELAB_RTOS_CMSIS_OS_EN != 0 || ELAB_RTOS_BASIC_OS_EN != 0)
     osKernelInitialize();
 #endif
@@ -174,6 +205,8 @@ void elab_run(void)
     {
         _init_func_execute(level);
     }
+    /* No dynamic allocation in the running time if ELAB_HEAP_LOCK_EN. */
+    elab_heap_lock();
 
     /* Start polling function in metal eLab. */
     while (1)
@@ -199,6 +232,30 @@ static void elab_exit(void)
 }
 #endif
 
+#if defined(__linux__) && (ELAB_RTOS_PROFILE_EN != 0)
+/**
+  * @brief  Save the contention profile of the RTOS objects for the analysis
+  *         tools at the normal exit. It is skipped in exiting from a signal,
+  *         as the printing allocates memory and takes the profile mutex, which
+  *         may be held by the interrupted thread.
+  * @retval None
+  */
+static void _profile_save(void)
+{
+    if (exit_in_signal != 0)
+    {
+        return;
+    }
+
+    int fd = open(ELAB_RTOS_PROFILE_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0)
+    {
+        osKernelProfilePrint(fd, 1);
+        close(fd);
+    }
+}
+#endif
+
 /**
   * @brief  Get the init export table.
   */
@@ -371,12 +428,24 @@ static void _entry_start_poll(void *para)
     {
         _init_func_execute(level);
     }
+    /* No dynamic allocation in the running time if ELAB_HEAP_LOCK_EN. */
+    elab_heap_lock();
 
     /* Start polling function in metal eLab. */
+#if (ELAB_RTOS_CMSIS_OS_EN != 0)
+    uint32_t time_poll = osKernelGetTickCount();
+#endif
     while (1)
     {
         _poll_func_execute();
-#if (ELAB_RTOS_CMSIS_OS_EN != 0 || ELAB_RTOS_BASIC_OS_EN != 0)
+#if (ELAB_RTOS_CMSIS_OS_EN != 0)
+        /* Poll in the fixed period, not drifted by the polling time. */
+        time_poll += 10;
+        if (osDelayUntil(time_poll) != osOK)
+        {
+            time_poll = osKernelGetTickCount();
+        }
+#elif (ELAB_RTOS_BASIC_OS_EN != 0)
         osDelay(10);
 #endif
     }
@@ -7,6 +7,9 @@
 #include <termios.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/uio.h>
 #include <stdint.h>
 #include <stdio.h>
 #include "driver_uart.h"
@@ -21,8 +24,10 @@ ELAB_TAG("Bsp-Serial-Linux");
 static elab_err_t _enable(elab_serial_t *serial, bool status);
 static int32_t _read(elab_serial_t *serial, void *buffer, uint32_t size);
 static int32_t _write(elab_serial_t *serial, const void *buffer, uint32_t size);
+static int32_t _writev(elab_serial_t *serial, const elab_iovec_t *iov, uint32_t num);
 static void _set_tx(elab_serial_t *serial, bool status);
 static elab_err_t _config(elab_serial_t *serial, elab_serial_config_t *config);
+static int _get_fd(elab_serial_t *serial);
 
 /* private variables -------------------------------------------------------- */
 static elab_serial_ops_t _serial_ops =
@@ -32,6 +37,8 @@ static elab_serial_ops_t _serial_ops =
     .write = _write,
     .set_tx = _set_tx,
     .config = _config,
+    .get_fd = _get_fd,
+    .writev = _writev,
 };
 
 /* public function ---------------------------------------------------------- */
@@ -74,8 +81,10 @@ static elab_err_t _enable(elab_serial_t *serial, bool status)
     {
         if (driver->serial_fd == INT32_MIN)
         {
-            /* Open the serial port. */
-            driver->serial_fd = open(driver->name_serial, O_RDWR | O_NOCTTY);
+            /* Open the serial port, which is read in the serial reactor in
+               non-blocking mode. */
+            driver->serial_fd = open(driver->name_serial,
+                                        O_RDWR | O_NOCTTY | O_NONBLOCK);
             if (driver->serial_fd != INT32_MIN && driver->serial_fd < 0)
             {
                 elog_error("Serial port %s opening fails.", driver->name_serial);
@@ -107,7 +116,12 @@ static int32_t _read(elab_serial_t *serial, void *buffer, uint32_t size)
 
     int32_t ret = size;
     int32_t ret_r = read(driver->serial_fd, buffer, size);
-    if (ret_r < 0)
+    if (ret_r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+        /* All the received data is read. */
+        ret = 0;
+    }
+    else if (ret_r < 0)
     {
         ret = ELAB_ERROR;
     }
@@ -123,23 +137,81 @@ static int32_t _write(elab_serial_t *serial, const void *buffer, uint32_t size)
 {
     driver_uart_t *driver = (driver_uart_t *)serial->super.user_data;
     int32_t ret = size;
-    int32_t ret_w = write(driver->serial_fd, buffer, size);
+    uint32_t count = 0;
+
+    /* The port is in non-blocking mode, so wait for the output buffer when it
+       is full. */
+    while (count < size)
+    {
+        int32_t ret_w = write(driver->serial_fd,
+                                &((const uint8_t *)buffer)[count], (size - count));
+        if (ret_w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            struct pollfd pfd = { .fd = driver->serial_fd, .events = POLLOUT };
+            poll(&pfd, 1, -1);
+            continue;
+        }
+        if (ret_w < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (ret_w < 0)
+        {
+            ret = ELAB_ERROR;
+            goto exit;
+        }
+        count += ret_w;
+    }
+    ret = count;
+
     /* Wait the data transmitted completely. */
 #if defined(__x86_64__) || defined(__i386__)
     tcdrain(driver->serial_fd);
 #endif
-    if (ret_w < 0)
+
+exit:
+    elab_serial_tx_end(serial);
+    return ret;
+}
+
+static int32_t _writev(elab_serial_t *serial, const elab_iovec_t *iov, uint32_t num)
+{
+    driver_uart_t *driver = (driver_uart_t *)serial->super.user_data;
+    struct iovec vec[2];
+
+    /* The segments of the tx ring, sent in one system call. */
+    assert(num <= 2);
+    for (uint32_t i = 0; i < num; i ++)
     {
-        ret = ELAB_ERROR;
+        vec[i].iov_base = iov[i].buffer;
+        vec[i].iov_len = iov[i].size;
     }
-    else
+
+    int32_t ret = 0;
+    do
+    {
+        ret = writev(driver->serial_fd, vec, (int)num);
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
     {
-        ret = ret_w;
+        /* The output buffer is full. */
+        ret = 0;
+    }
+    else if (ret < 0)
+    {
+        ret = ELAB_ERROR;
     }
 
     return ret;
 }
 
+static int _get_fd(elab_serial_t *serial)
+{
+    driver_uart_t *driver = (driver_uart_t *)serial->super.user_data;
+
+    return driver->serial_fd;
+}
+
 static void _set_tx(elab_serial_t *serial, bool status)
 {
     driver_uart_t *driver = (driver_uart_t *)serial->super.user_data;
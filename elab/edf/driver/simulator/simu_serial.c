@@ -21,6 +21,8 @@ ELAB_TAG("SerialDriverSimuLocal");
 /* Private config ----------------------------------------------------------- */
 #define SIMU_HASH_TABLE_SIZE                (32)
 #define SIMU_SERIAL_TOPIC_SIZE              MQTT_TOPIC_LEN_MAX
+#define SIMU_SERIAL_BYTE_BITS               (10)    /* 8N1 */
+#define SIMU_SERIAL_DMA_WAIT_MS             (10)    /* Exiting checked */
 
 /* Private typedef ---------------------------------------------------------- */
 typedef struct simu_serial
@@ -38,6 +40,20 @@ typedef struct simu_serial
     mqtt_client_t *client;
     char topic_sub[SIMU_SERIAL_TOPIC_SIZE];
 
+    /* In the line timing mode, the rx data is put into the queue at once, but
+       arrives byte by byte at the baud rate, and the last byte in the queue
+       arrives at rx_time_end. Otherwise it arrives at once. */
+    bool line_timing;
+    uint64_t rx_time_end;                       /* Atomic, in ns */
+
+    /* The simulated circular rx DMA, moving the received data into the buffer
+       in its own thread. */
+    uint8_t *dma_buff;
+    uint32_t dma_pos;
+    bool dma_rx;
+    bool dma_exit;
+    osThreadId_t thread_dma;
+
     struct simu_serial *partner;
 } simu_serial_t;
 
@@ -50,6 +66,13 @@ static int32_t _write(elab_serial_t *serial, const void *buffer, uint32_t size);
 static elab_err_t _config(elab_serial_t *puart_dev,
                                 elab_serial_config_t *pcfg);
 static void msg_com_handler(void* client, message_data_t* msg);
+static void *_get_rx_dma(elab_serial_t *serial, uint32_t *size);
+static void _entry_dma(void *para);
+static void _rx_line_put(simu_serial_t *simu_serial, uint32_t size);
+static uint32_t _rx_line_in(simu_serial_t *simu_serial);
+static uint32_t _rx_line_arrived(simu_serial_t *simu_serial);
+static bool _rx_line_idle(simu_serial_t *simu_serial);
+static uint32_t _rx_line_wait_ms(simu_serial_t *simu_serial);
 
 /* Private variables -------------------------------------------------------- */
 hash_table_t *ht_simu = NULL;
@@ -65,6 +88,15 @@ static elab_serial_ops_t _serial_ops =
     .config = _config,
 };
 
+static elab_serial_ops_t _serial_ops_dma =
+{
+    .enable = _enable,
+    .write = _write,
+    .set_tx = NULL,
+    .config = _config,
+    .get_rx_dma = _get_rx_dma,
+};
+
 static const osMutexAttr_t mutex_attr_simu_serial =
 {
     "MutexSimuSerial",
@@ -73,6 +105,14 @@ static const osMutexAttr_t mutex_attr_simu_serial =
     0U
 };
 
+static const osThreadAttr_t thread_attr_simu_serial_dma =
+{
+    .name = "ThreadSimuSerialDma",
+    .attr_bits = osThreadJoinable,
+    .priority = osPriorityRealtime,
+    .stack_size = 2048,
+};
+
 /* Public function ---------------------------------------------------------- */
 static void simu_serial_export(void)
 {
@@ -89,10 +129,12 @@ INIT_EXPORT(simu_serial_export, EXPORT_LEVEL_HW_INDEPNEDENT);
   * @param  name        Name of the serial port.
   * @param  mode        Serial port mode. See simu_serial_mode.
   * @param  baudrate    The serial port baudrate.
+  * @param  dma         Received in the circular DMA mode or not.
   * @retval The simulated serial port handle.
   */
 static simu_serial_t *_simu_serial_new(const char *name,
-                                        uint8_t mode, uint32_t baudrate)
+                                        uint8_t mode, uint32_t baudrate,
+                                        bool dma)
 {
     simu_serial_t *serial = NULL;
     elab_assert(!hash_table_existent(ht_simu, (char *)name));
@@ -102,9 +144,13 @@ static simu_serial_t *_simu_serial_new(const char *name,
     elab_assert(serial != NULL);
     serial->enable = false;
     serial->baudrate = baudrate;
+    serial->line_timing = false;
+    serial->rx_time_end = 0;
     serial->name = name;
     serial->partner = NULL;
     serial->mode = mode;
+    serial->dma_buff = NULL;
+    serial->thread_dma = NULL;
     serial->queue_rx = osMessageQueueNew(SIMU_SERIAL_BUFFER_MAX, 1, NULL);
     serial->mutex = osMutexNew(&mutex_attr_simu_serial);
     elab_assert(serial->queue_rx != NULL && serial->mutex != NULL);
@@ -147,7 +193,22 @@ static simu_serial_t *_simu_serial_new(const char *name,
     /* Register the serial device to device framework. */
     elab_serial_attr_t attr = (elab_serial_attr_t)ELAB_SERIAL_ATTR_DEFAULT;
     attr.baud_rate = baudrate;
-    elab_serial_register(&serial->device, name, &_serial_ops, &attr, serial);
+    if (dma)
+    {
+        serial->dma_buff = elab_malloc(SIMU_SERIAL_DMA_SIZE);
+        elab_assert(serial->dma_buff != NULL);
+        serial->dma_pos = 0;
+        serial->dma_rx = false;
+        serial->dma_exit = false;
+        elab_serial_register(&serial->device, name, &_serial_ops_dma, &attr, serial);
+        serial->thread_dma = osThreadNew(_entry_dma, serial,
+                                            &thread_attr_simu_serial_dma);
+        elab_assert(serial->thread_dma != NULL);
+    }
+    else
+    {
+        elab_serial_register(&serial->device, name, &_serial_ops, &attr, serial);
+    }
 
     /* Register the simulated serial device into the hash table. */
     ret = hash_table_add(ht_simu, (char *)name, serial);
@@ -170,7 +231,21 @@ void simu_serial_new(const char *name, uint8_t mode, uint32_t baudrate)
     /* TODO After 485 mode is completed, the assert will be removed. */
     elab_assert(mode == SIMU_SERIAL_MODE_SINGLE);
 
-    _simu_serial_new(name, mode, baudrate);
+    _simu_serial_new(name, mode, baudrate, false);
+}
+
+/**
+  * @brief  Newly create one simulated serial port in single mode, which is
+  *         received in the circular DMA mode of SIMU_SERIAL_DMA_SIZE bytes.
+  * @param  name        Name of the serial port.
+  * @param  baudrate    The serial port baudrate.
+  * @retval None.
+  */
+void simu_serial_new_dma(const char *name, uint32_t baudrate)
+{
+    elab_assert(name != NULL);
+
+    _simu_serial_new(name, SIMU_SERIAL_MODE_SINGLE, baudrate, true);
 }
 
 /**
@@ -184,9 +259,20 @@ void simu_serial_destroy(const char *name)
     elab_assert(serial != NULL);
     elab_serial_t *dev_serial = (elab_serial_t *)elab_device_find(name);
     elab_assert(dev_serial != NULL);
-    elab_serial_unregister(dev_serial);
 
     osStatus_t ret_os = osOK;
+    if (serial->thread_dma != NULL)
+    {
+        __atomic_store_n(&serial->dma_exit, true, __ATOMIC_RELEASE);
+        ret_os = osThreadJoin(serial->thread_dma);
+        elab_assert(ret_os == osOK);
+    }
+    elab_serial_unregister(dev_serial);
+    if (serial->dma_buff != NULL)
+    {
+        elab_free(serial->dma_buff);
+    }
+
     ret_os = osMessageQueueDelete(serial->queue_rx);
     elab_assert(ret_os == osOK);
     ret_os = osMutexDelete(serial->mutex);
@@ -234,10 +320,10 @@ void simu_serial_new_pair(const char *name_one, const char *name_two, uint32_t b
     simu_serial_t *serial_one = NULL;
     simu_serial_t *serial_two = NULL;
 
-    serial_one = _simu_serial_new(name_one, SIMU_SERIAL_MODE_UART, baudrate);
+    serial_one = _simu_serial_new(name_one, SIMU_SERIAL_MODE_UART, baudrate, false);
     elab_assert(serial_one != NULL);
 
-    serial_two = _simu_serial_new(name_two, SIMU_SERIAL_MODE_UART, baudrate);
+    serial_two = _simu_serial_new(name_two, SIMU_SERIAL_MODE_UART, baudrate, false);
     elab_assert(serial_two != NULL);
     
     serial_one->partner = serial_two;
@@ -264,10 +350,10 @@ void simu_serial_mqtt_new_pair(const char *name_one,
     simu_serial_t *serial_one = NULL;
     simu_serial_t *serial_two = NULL;
 
-    serial_one = _simu_serial_new(name_one, SIMU_SERIAL_MODE_MQTT, baudrate);
+    serial_one = _simu_serial_new(name_one, SIMU_SERIAL_MODE_MQTT, baudrate, false);
     elab_assert(serial_one != NULL);
 
-    serial_two = _simu_serial_new(name_two, SIMU_SERIAL_MODE_MQTT, baudrate);
+    serial_two = _simu_serial_new(name_two, SIMU_SERIAL_MODE_MQTT, baudrate, false);
     elab_assert(serial_two != NULL);
     
     serial_one->partner = serial_two;
@@ -277,6 +363,26 @@ void simu_serial_mqtt_new_pair(const char *name_one,
     simu_serial_destroy(name_one);
 }
 
+/**
+  * @brief  Set the line timing mode of the simulated serial port, in which the
+  *         rx data arrives byte by byte at the baud rate, with the idle line
+  *         seen between the data. Off by default, the data arriving at once.
+  * @param  name    Name of the serial port.
+  * @param  status  The line timing mode on or off.
+  * @retval None.
+  */
+void simu_serial_set_line_timing(const char *name, bool status)
+{
+    simu_serial_t *serial = hash_table_get(ht_simu, (char *)name);
+    assert_name(serial != NULL, name);
+
+    __atomic_store_n(&serial->rx_time_end, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&serial->line_timing, status, __ATOMIC_RELEASE);
+
+exit:
+    return;
+}
+
 /**
   * @brief  Add the slave serial port to master serial port.
   * @param  name        Name of the master serial port.
@@ -307,12 +413,12 @@ void simu_serial_make_rx_data(const char *name, void *buffer, uint32_t size)
     elab_assert(serial->mode == SIMU_SERIAL_MODE_SINGLE);
 
 #if defined(__linux__) || defined(_WIN32)
-    osStatus_t ret_os = osOK;
     uint8_t *buff = (uint8_t *)buffer;
-    for (uint32_t i = 0; i < size; i ++)
+    _rx_line_put(serial, size);
+    for (uint32_t count = 0; count < size;)
     {
-        ret_os = osMessageQueuePut(serial->queue_rx, &buff[i], 0, osWaitForever);
-        elab_assert(ret_os == osOK);
+        count += osMessageQueuePutN(serial->queue_rx, &buff[count],
+                                    (size - count), 0, osWaitForever);
     }
 #else
     dev_serial_isr_rx(&serial->device, buffer, size);
@@ -361,12 +467,12 @@ int32_t simu_serial_read_tx_data(const char *name,
     elab_assert(serial->mode == SIMU_SERIAL_MODE_SINGLE);
 
     ret = ELAB_ERR_TIMEOUT;
-    osStatus_t ret_os = osOK;
 
     uint8_t *buff = (uint8_t *)buffer;
     uint32_t time_start = osKernelGetTickCount();
     uint32_t time = timeout_ms;
-    for (uint32_t i = 0; i < size; i ++)
+    uint32_t count = 0;
+    while (count < size)
     {
         if (timeout_ms != osWaitForever && timeout_ms != 0)
         {
@@ -379,19 +485,14 @@ int32_t simu_serial_read_tx_data(const char *name,
                 break;
             }
         }
-        ret_os = osMessageQueueGet(serial->queue_tx, &buff[i], NULL, time);
-        if (ret_os == osOK)
-        {
-            ret = (ret == ELAB_ERR_TIMEOUT) ? 1 : (ret + 1);
-        }
-        else if (ret_os == osErrorTimeout)
+        uint32_t num = osMessageQueueGetN(serial->queue_tx, &buff[count],
+                                            (size - count), NULL, time);
+        if (num == 0)
         {
             break;
         }
-        else
-        {
-            elab_assert(false);
-        }
+        count += num;
+        ret = (int32_t)count;
     }
 
 exit:
@@ -414,6 +515,12 @@ static elab_err_t _enable(elab_serial_t *serial, bool status)
     elab_assert(ret == osOK);
 
     simu_serial->enable = status;
+    if (status)
+    {
+        /* The DMA starts from the beginning of the buffer. */
+        simu_serial->dma_pos = 0;
+        simu_serial->dma_rx = false;
+    }
 
     ret = osMutexRelease(simu_serial->mutex);
     elab_assert(ret == osOK);
@@ -423,7 +530,9 @@ static elab_err_t _enable(elab_serial_t *serial, bool status)
 
 #if defined(__linux__) || defined(_WIN32)
 /**
-  * @brief  The simulated serial port read function.
+  * @brief  The simulated serial port read function, which returns all the
+  *         received data at most the given size, once any data arrives on the
+  *         simulated line.
   * @param  serial  The pointer of platform serial port device.
   * @param  pos     Position
   * @param  pbuf    The pointer of buffer
@@ -432,22 +541,29 @@ static elab_err_t _enable(elab_serial_t *serial, bool status)
   */
 static int32_t _read(elab_serial_t *serial, void *pbuf, uint32_t size)
 {
-    osStatus_t ret = osOK;
-
     simu_serial_t *simu_serial = container_of(serial, simu_serial_t, device);
 
     uint32_t read_cnt = 0;
     uint8_t *buffer = (uint8_t *)pbuf;
-    buffer[0] = 0;
-    for (uint32_t i = 0; i < size; i ++)
+    while (read_cnt == 0)
     {
-        ret = osMessageQueueGet(simu_serial->queue_rx,
-                                &buffer[i], NULL, osWaitForever);
-        if (ret != osOK)
-        {
-            break;
-        }
-        read_cnt ++;
+        read_cnt = osMessageQueueGetN(simu_serial->queue_rx, buffer, 1,
+                                        NULL, osWaitForever);
+    }
+
+    /* The first byte is taken from the queue, and returned once it arrives,
+       with the ones arriving after it. */
+    uint32_t time_wait = _rx_line_wait_ms(simu_serial);
+    if (time_wait != 0)
+    {
+        osDelay(time_wait);
+    }
+    uint32_t size_arrived = _rx_line_arrived(simu_serial);
+    size_arrived = (size_arrived < (size - 1)) ? size_arrived : (size - 1);
+    if (size_arrived != 0)
+    {
+        read_cnt += osMessageQueueGetN(simu_serial->queue_rx, &buffer[1],
+                                        size_arrived, NULL, 0);
     }
 
 exit:
@@ -476,11 +592,10 @@ static int32_t _write(elab_serial_t *serial, const void *pbuf, uint32_t size)
     {
         /* Write the buffer data into message queue. */
         uint8_t *buffer = (uint8_t *)pbuf;
-        for (uint32_t i = 0; i < size; i ++)
+        for (uint32_t count = 0; count < size;)
         {
-            ret = osMessageQueuePut(simu_serial->queue_tx,
-                                    &buffer[i], 0, osWaitForever);
-            elab_assert(ret == osOK);
+            count += osMessageQueuePutN(simu_serial->queue_tx, &buffer[count],
+                                        (size - count), 0, osWaitForever);
         }
     }
     else if (simu_serial->mode == SIMU_SERIAL_MODE_UART)
@@ -491,10 +606,11 @@ static int32_t _write(elab_serial_t *serial, const void *pbuf, uint32_t size)
 
         /* Write the buffer data into message queue. */
         uint8_t *buffer = (uint8_t *)pbuf;
-        for (uint32_t i = 0; i < size; i ++)
+        _rx_line_put(partner, size);
+        for (uint32_t count = 0; count < size;)
         {
-            ret = osMessageQueuePut(partner->queue_rx, &buffer[i], 0, osWaitForever);
-            elab_assert(ret == osOK);
+            count += osMessageQueuePutN(partner->queue_rx, &buffer[count],
+                                        (size - count), 0, osWaitForever);
         }
 
         ret = osMutexRelease(partner->mutex);
@@ -542,12 +658,215 @@ exit:
   */
 static elab_err_t _config(elab_serial_t *serial, elab_serial_config_t *config)
 {
-    (void)serial;
-    (void)config;
+    simu_serial_t *simu_serial = container_of(serial, simu_serial_t, device);
+
+    /* The rx data arrives at the new baud rate. */
+    elab_assert(config->baud_rate != 0);
+    simu_serial->baudrate = config->baud_rate;
 
     return ELAB_OK;
 }
 
+/**
+  * @brief  The simulated serial port function getting the rx DMA buffer.
+  * @param  serial  The pointer of platform serial port device.
+  * @param  size    The buffer size, returned.
+  * @retval The DMA buffer.
+  */
+static void *_get_rx_dma(elab_serial_t *serial, uint32_t *size)
+{
+    simu_serial_t *simu_serial = container_of(serial, simu_serial_t, device);
+
+    *size = SIMU_SERIAL_DMA_SIZE;
+
+    return simu_serial->dma_buff;
+}
+
+/**
+  * @brief  The simulated circular rx DMA, which moves the data arrived on the
+  *         line into the buffer, and reports the position in the half transfer,
+  *         the full transfer, and the idle line one byte time after the last
+  *         byte. Blocked on the queue while the line is idle, and checked every
+  *         1 ms while the data is arriving.
+  * @param  para    The simulated serial port.
+  * @retval None.
+  */
+static void _entry_dma(void *para)
+{
+    simu_serial_t *simu_serial = (simu_serial_t *)para;
+    osStatus_t ret = osOK;
+    bool line_idle = true;
+
+    while (!__atomic_load_n(&simu_serial->dma_exit, __ATOMIC_ACQUIRE))
+    {
+        uint8_t byte = 0;
+        uint32_t count_first = 0;
+        uint32_t count = 0;
+
+        /* The first byte is taken from the queue, and moved once it arrives. */
+        if (line_idle)
+        {
+            count_first = osMessageQueueGetN(simu_serial->queue_rx, &byte, 1,
+                                                NULL, SIMU_SERIAL_DMA_WAIT_MS);
+            if (count_first == 0)
+            {
+                continue;
+            }
+            uint32_t time_wait = _rx_line_wait_ms(simu_serial);
+            if (time_wait != 0)
+            {
+                osDelay(time_wait);
+            }
+        }
+
+        ret = osMutexAcquire(simu_serial->mutex, osWaitForever);
+        elab_assert(ret == osOK);
+        if (simu_serial->enable)
+        {
+            /* The transfer stops at the half or the end of the buffer. */
+            uint32_t pos = simu_serial->dma_pos;
+            uint32_t pos_end = (pos < (SIMU_SERIAL_DMA_SIZE / 2)) ?
+                                (SIMU_SERIAL_DMA_SIZE / 2) : SIMU_SERIAL_DMA_SIZE;
+            if (count_first != 0)
+            {
+                simu_serial->dma_buff[pos ++] = byte;
+            }
+            uint32_t size = _rx_line_arrived(simu_serial);
+            size = (size < (pos_end - pos)) ? size : (pos_end - pos);
+            if (size != 0)
+            {
+                count = osMessageQueueGetN(simu_serial->queue_rx,
+                                            &simu_serial->dma_buff[pos],
+                                            size, NULL, 0);
+            }
+            pos += count;
+            count += count_first;
+            if (pos == pos_end)
+            {
+                elab_serial_isr_rx_dma(&simu_serial->device, pos);
+            }
+            if (count != 0)
+            {
+                simu_serial->dma_rx = true;
+            }
+            else if (simu_serial->dma_rx && _rx_line_idle(simu_serial))
+            {
+                elab_serial_isr_rx_dma(&simu_serial->device, pos);
+                elab_serial_isr_rx_idle(&simu_serial->device);
+                simu_serial->dma_rx = false;
+            }
+            simu_serial->dma_pos = pos % SIMU_SERIAL_DMA_SIZE;
+        }
+        line_idle = !simu_serial->dma_rx;
+        ret = osMutexRelease(simu_serial->mutex);
+        elab_assert(ret == osOK);
+
+        if (count == 0 && !line_idle)
+        {
+            osDelay(1);
+        }
+    }
+}
+
+/**
+  * @brief  The time of one byte on the simulated line, in ns.
+  */
+static uint64_t _rx_line_byte_ns(simu_serial_t *simu_serial)
+{
+    return (uint64_t)SIMU_SERIAL_BYTE_BITS * 1000000000 / simu_serial->baudrate;
+}
+
+/**
+  * @brief  Put the rx data on the simulated line, which arrives after the data
+  *         on it already, or from now on if the line is idle. Called before the
+  *         data is put into the queue.
+  */
+static void _rx_line_put(simu_serial_t *simu_serial, uint32_t size)
+{
+    if (!__atomic_load_n(&simu_serial->line_timing, __ATOMIC_ACQUIRE))
+    {
+        return;
+    }
+
+    uint64_t time_end = __atomic_load_n(&simu_serial->rx_time_end, __ATOMIC_ACQUIRE);
+    uint64_t time_end_new = 0;
+    do
+    {
+        uint64_t time = elab_time_ns();
+        time_end_new = ((time_end > time) ? time_end : time) +
+                        (uint64_t)size * _rx_line_byte_ns(simu_serial);
+    } while (!__atomic_compare_exchange_n(&simu_serial->rx_time_end, &time_end,
+                                            time_end_new, false,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+}
+
+/**
+  * @brief  The count of the bytes still on the simulated line, put into the
+  *         queue but not arrived yet.
+  */
+static uint32_t _rx_line_in(simu_serial_t *simu_serial)
+{
+    if (!__atomic_load_n(&simu_serial->line_timing, __ATOMIC_ACQUIRE))
+    {
+        return 0;
+    }
+
+    uint64_t time_end = __atomic_load_n(&simu_serial->rx_time_end, __ATOMIC_ACQUIRE);
+    uint64_t time = elab_time_ns();
+    uint64_t byte_ns = _rx_line_byte_ns(simu_serial);
+
+    return (time_end > time) ? (uint32_t)((time_end - time + byte_ns - 1) / byte_ns) : 0;
+}
+
+/**
+  * @brief  The count of the bytes in the queue arrived on the simulated line.
+  */
+static uint32_t _rx_line_arrived(simu_serial_t *simu_serial)
+{
+    uint32_t count = osMessageQueueGetCount(simu_serial->queue_rx);
+    uint32_t count_in = _rx_line_in(simu_serial);
+
+    return (count > count_in) ? (count - count_in) : 0;
+}
+
+/**
+  * @brief  The simulated line is idle for one byte time after the last byte.
+  */
+static bool _rx_line_idle(simu_serial_t *simu_serial)
+{
+    if (!__atomic_load_n(&simu_serial->line_timing, __ATOMIC_ACQUIRE))
+    {
+        return true;
+    }
+
+    uint64_t time_end = __atomic_load_n(&simu_serial->rx_time_end, __ATOMIC_ACQUIRE);
+
+    return (elab_time_ns() >= (time_end + _rx_line_byte_ns(simu_serial)));
+}
+
+/**
+  * @brief  The time in ms until the byte just taken from the queue arrives on
+  *         the simulated line, which is followed by the ones in the queue.
+  */
+static uint32_t _rx_line_wait_ms(simu_serial_t *simu_serial)
+{
+    uint32_t time_ms = 0;
+
+    if (__atomic_load_n(&simu_serial->line_timing, __ATOMIC_ACQUIRE))
+    {
+        uint64_t time_end = __atomic_load_n(&simu_serial->rx_time_end, __ATOMIC_ACQUIRE);
+        uint64_t time_rest = (uint64_t)osMessageQueueGetCount(simu_serial->queue_rx) *
+                                _rx_line_byte_ns(simu_serial);
+        uint64_t time = elab_time_ns();
+        if (time_end > (time + time_rest))
+        {
+            time_ms = (uint32_t)((time_end - time_rest - time + 999999) / 1000000);
+        }
+    }
+
+    return time_ms;
+}
+
 /**
   * @brief  The MQTT handler for simulated serial.
   * @param  client  The MQTT handle.
@@ -563,11 +882,9 @@ static void msg_com_handler(void *client, message_data_t *msg)
 
     if (elab_device_is_enabled(&serial->device.super))
     {
-        uint8_t *load = msg->message->payload;
-        for (uint32_t i = 0; i < msg->message->payloadlen; i ++)
-        {
-            osMessageQueuePut(serial->queue_rx, (const void *)&load[i], 0, 0);
-        }
+        _rx_line_put(serial, msg->message->payloadlen);
+        osMessageQueuePutN(serial->queue_rx, msg->message->payload,
+                            msg->message->payloadlen, 0, 0);
     }
 }
 
@@ -18,6 +18,7 @@
 #define SIMU_SERIAL_MQTT_PORT               "1883"
 #define SIMU_SERAIL_SLAVE_NUM_MAX           (16)
 #define SIMU_SERIAL_BUFFER_MAX              (2048)
+#define SIMU_SERIAL_DMA_SIZE                (256)
 
 enum simu_serial_mode
 {
@@ -32,6 +33,7 @@ enum simu_serial_mode
 
 /* Exported function ---------------------------------------------------------*/
 void simu_serial_new(const char *name, uint8_t mode, uint32_t baudrate);
+void simu_serial_new_dma(const char *name, uint32_t baudrate);
 void simu_serial_new_pair(const char *name_one,
                             const char *name_two,
                             uint32_t baudrate);
@@ -39,6 +41,7 @@ void simu_serial_mqtt_new_pair(const char *name_one,
                                 const char *name_two,
                                 uint32_t baudrate);
 void simu_serial_destroy(const char *name);
+void simu_serial_set_line_timing(const char *name, bool status);
 void simu_serial_make_rx_data(const char *name, void *buffer, uint32_t size);
 void simu_serial_make_rx_data_delay(const char *name,
                                     void *buffer, uint32_t size,
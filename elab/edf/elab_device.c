@@ -7,18 +7,91 @@
 #include "elab_device.h"
 #include "elab_device_def.h"
 #include "../common/elab_assert.h"
+#include "../common/elab_common.h"
 #include "../common/elab_log.h"
 #include "../os/cmsis_os.h"
 
 ELAB_TAG("EdfDevice");
 
+/* private config ----------------------------------------------------------- */
+#if defined(__linux__)
+#define EDF_READER_GROUP_NUM                (8)             /* Power of 2 */
+#else
+#define EDF_READER_GROUP_NUM                (1)
+#endif
+#define EDF_CACHE_LINE_SIZE                 (64)
+#define EDF_LIST_SIZE_MIN                   (16)
+#define EDF_INDEX_SIZE_MIN                  (32)            /* Power of 2 */
+#define EDF_IOV_STACK_SIZE                  (128)
+
+/* private define ----------------------------------------------------------- */
+#define EDF_INDEX_REMOVED                   ((elab_device_t *)&_edf_removed)
+
+/* private typedef ---------------------------------------------------------- */
+/*
+ * The devices are kept in two growable arrays:
+ *   - The list holds them in the registering order, and is compacted when one
+ *     is unregistered, so the iterating order is stable. It is only accessed
+ *     with the edf mutex held.
+ *   - The index is one open addressing hashing table of the names, in linear
+ *     probing, and is at most half full. The finding takes no lock on it.
+ *
+ * The registering and unregistering are serialized by the edf mutex, and
+ * change the index in the RCU way:
+ *   - One new device is set up entirely before being published in its slot,
+ *     so one reader sees it either wholly or not at all.
+ *   - One removed device is replaced by the removed mark in its slot, which
+ *     keeps the probing going. The readers may still hold the device, so the
+ *     unregistering waits a grace period, in which all the readers leave,
+ *     before the device memory is given back to the user.
+ *   - When the index gets too full or too empty, a new one is built from the
+ *     list and published, and the old one is freed after a grace period.
+ * The readers are counted in two counters selected by the epoch, like SRCU.
+ * The waiting flips the epoch and waits the old counter to be zero, twice, so
+ * that the new coming readers can not starve it. The readers are spread over
+ * some reader groups in different cache lines by the name hashing, so the
+ * ones finding different devices do not contend on one counter.
+ */
+typedef union edf_reader
+{
+    struct
+    {
+        uint32_t epoch;
+        uint32_t count[2];
+    } group;
+    uint8_t reserved[EDF_CACHE_LINE_SIZE];
+} edf_reader_t;
+
+typedef struct edf_index
+{
+    uint32_t size;                              /* Power of 2 */
+    elab_device_t *slot[];
+} edf_index_t;
+
 /* private function prototypes ---------------------------------------------- */
-static void _add_device(elab_device_t *me);
 static osMutexId_t _edf_mutex(void);
+static uint32_t _hash_time33(const char *str);
+static void _edf_list_add(elab_device_t *me);
+static void _edf_list_remove(elab_device_t *me);
+static void _edf_index_add(elab_device_t *me);
+static void _edf_index_remove(elab_device_t *me);
+static void _edf_index_rebuild(void);
+static uint32_t _edf_read_lock(edf_reader_t *reader);
+static void _edf_read_unlock(edf_reader_t *reader, uint32_t index);
+static void _edf_synchronize(void);
+static uint32_t _iov_size(const elab_iovec_t *iov, uint32_t num);
+static void _iov_copy(const elab_iovec_t *iov, uint32_t *index, uint32_t *offset,
+                        uint8_t *buff, uint32_t size, bool to_iov);
 
 /* private variables -------------------------------------------------------- */
 static uint32_t _edf_device_count = 0;
-static elab_device_t *_edf_table[ELAB_DEV_NUM_MAX];
+static elab_device_t **_edf_list = NULL;
+static uint32_t _edf_list_size = 0;
+static uint32_t _edf_foreach_nesting = 0;
+static edf_index_t *_edf_index = NULL;
+static uint32_t _edf_index_used = 0;            /* Devices and removed marks */
+static uint8_t _edf_removed;
+static edf_reader_t _edf_reader[EDF_READER_GROUP_NUM];
 static osMutexId_t _mutex_edf = NULL;
 
 /**
@@ -56,12 +129,16 @@ void elab_device_register(elab_device_t *me, elab_device_attr_t *attr)
     memcpy(&me->attr, attr, sizeof(elab_device_attr_t));
     me->enable_count = 0;
     me->lock_count = 0;
+    me->async = NULL;
     me->mutex = osMutexNew(&_mutex_attr_edf);
     assert(me->mutex != NULL);
+    __device_poll_init(me);
 
-    /* Add the device the edf table. */
-    memcpy(&me->attr, attr, sizeof(elab_device_attr_t));
-    _add_device(me);
+    /* Add the device the edf list and index after setting it up. */
+    assert(_edf_foreach_nesting == 0);
+    me->hash = _hash_time33(attr->name);
+    _edf_list_add(me);
+    _edf_index_add(me);
 
     /* Edf mutex unlocking. */
     ret = osMutexRelease(mutex);
@@ -77,6 +154,8 @@ void elab_device_unregister(elab_device_t *me)
 {
     elab_assert(me != NULL);
     elab_assert(!elab_device_is_enabled(me));
+    __device_async_deinit(me);
+    __device_poll_deinit(me);
 
     /* Edf mutex locking. */
     osStatus_t ret = osOK;
@@ -84,15 +163,17 @@ void elab_device_unregister(elab_device_t *me)
     ret = osMutexAcquire(mutex, osWaitForever);
     assert(ret == osOK);
 
-    for (uint32_t i = 0; i < ELAB_DEV_NUM_MAX; i ++)
+    assert(_edf_foreach_nesting == 0);
+    for (uint32_t i = 0; i < _edf_device_count; i ++)
     {
-        if (_edf_table[i] == me)
+        if (_edf_list[i] == me)
         {
+            _edf_list_remove(me);
+            _edf_index_remove(me);
+
             osStatus_t ret = osMutexDelete(me->mutex);
             elab_assert(ret == osOK);
             me->mutex = NULL;
-            _edf_table[i] = NULL;
-            _edf_device_count --;
             break;
         }
     }
@@ -125,6 +206,53 @@ uint32_t elab_device_get_number(void)
     return num;
 }
 
+/**
+ * @brief Call the given function for every device of the given type, in the
+ *        registering order. The function should not register or unregister
+ *        any device.
+ * @param type  Device type.
+ * @param cb    The function called for every device.
+ * @param para  The parameter of the function.
+ * @retval Count number of the devices of the type.
+ */
+uint32_t elab_device_foreach(uint8_t type, elab_device_cb_t cb, void *para)
+{
+    assert(cb != NULL);
+
+    uint32_t num = 0;
+
+    /* Edf mutex locking. */
+    osStatus_t ret = osOK;
+    osMutexId_t mutex = _edf_mutex();
+    ret = osMutexAcquire(mutex, osWaitForever);
+    assert(ret == osOK);
+
+    _edf_foreach_nesting ++;
+    for (uint32_t i = 0; i < _edf_device_count; i ++)
+    {
+        if (_edf_list[i]->attr.type == type)
+        {
+            cb(_edf_list[i], para);
+            num ++;
+        }
+    }
+    _edf_foreach_nesting --;
+
+    /* Edf mutex unlocking. */
+    ret = osMutexRelease(mutex);
+    assert(ret == osOK);
+
+    return num;
+}
+
+/*
+ * The device state is checked without locking, as the serial reading and
+ * writing check it every time. The enable count and the test mode are only
+ * changed with the device mutex held, and stored in releasing, and they are
+ * loaded in acquiring by the checking. The name and the sole flag are set
+ * once in registering and never changed, so they are loaded relaxed.
+ */
+
 /**
  * This function check the given name is the device's name or not.
  * @param me    Device handle.
@@ -133,16 +261,10 @@ uint32_t elab_device_get_number(void)
  */
 bool elab_device_of_name(elab_device_t *me, const char *name)
 {
-    bool of_the_name = false;
-
-    elab_device_lock(me);
-    if (strcmp(me->attr.name, name) == 0)
-    {
-        of_the_name = true;
-    }
-    elab_device_unlock(me);
+    /* The name is set once in registering, before the device is published. */
+    const char *dev_name = __atomic_load_n(&me->attr.name, __ATOMIC_RELAXED);
 
-    return of_the_name;
+    return (strcmp(dev_name, name) == 0) ? true : false;
 }
 
 /**
@@ -152,37 +274,33 @@ bool elab_device_of_name(elab_device_t *me, const char *name)
  */
 elab_device_t *elab_device_find(const char *name)
 {
-    if (_edf_table[0] != NULL)
-    assert_name(_edf_table[0]->attr.name != NULL, name);
     assert(name != NULL);
-    
-    /* Edf mutex locking. */
-    osStatus_t ret = osOK;
-    osMutexId_t mutex = _edf_mutex();
-    ret = osMutexAcquire(mutex, osWaitForever);
-    assert(ret == osOK);
 
-    /* Find the device */
+    uint32_t hash = _hash_time33(name);
+    edf_reader_t *reader = &_edf_reader[hash & (EDF_READER_GROUP_NUM - 1)];
     elab_device_t *me = NULL;
-    for (uint32_t i = 0; i < ELAB_DEV_NUM_MAX; i++)
+
+    /* Find the device without locking. */
+    uint32_t index = _edf_read_lock(reader);
+    edf_index_t *edf_index = __atomic_load_n(&_edf_index, __ATOMIC_SEQ_CST);
+    if (edf_index != NULL)
     {
-        /* No device yet in the device table. */
-        if (_edf_table[i] == NULL)
-        {
-            break;
-        }
-        elab_assert(_edf_table[i]->attr.name != NULL);
-        /* Device matching */
-        if (strcmp(_edf_table[i]->attr.name, name) == 0)
+        uint32_t mask = edf_index->size - 1;
+        for (uint32_t i = (hash & mask); ; i = ((i + 1) & mask))
         {
-            me = _edf_table[i];
-            break;
+            me = __atomic_load_n(&edf_index->slot[i], __ATOMIC_SEQ_CST);
+            if (me == NULL)
+            {
+                break;
+            }
+            if (me != EDF_INDEX_REMOVED &&
+                me->hash == hash && strcmp(me->attr.name, name) == 0)
+            {
+                break;
+            }
         }
     }
-
-    /* Edf mutex unlocking. */
-    ret = osMutexRelease(mutex);
-    assert(ret == osOK);
+    _edf_read_unlock(reader, index);
 
     return me;
 }
@@ -204,11 +322,8 @@ bool elab_device_valid(const char *name)
  */
 bool elab_device_is_sole(elab_device_t *me)
 {
-    elab_device_lock(me);
-    bool enable_status = me->attr.sole;
-    elab_device_unlock(me);
-
-    return enable_status;
+    /* The sole flag is set once in registering, like the name. */
+    return __atomic_load_n(&me->attr.sole, __ATOMIC_RELAXED);
 }
 
 /**
@@ -218,7 +333,9 @@ bool elab_device_is_sole(elab_device_t *me)
  */
 bool elab_device_is_test_mode(elab_device_t *dev)
 {
-    return (dev->thread_test != NULL) ? true : false;
+    /* Pairs with the releasing in setting the mode. */
+    return (__atomic_load_n(&dev->thread_test, __ATOMIC_ACQUIRE) != NULL) ?
+                true : false;
 }
 
 /**
@@ -231,7 +348,7 @@ void elab_device_set_test_mode(elab_device_t *dev)
     elab_assert(dev != NULL);
 
     elab_device_lock(dev);
-    dev->thread_test = osThreadGetId();
+    __atomic_store_n(&dev->thread_test, osThreadGetId(), __ATOMIC_RELEASE);
     elab_device_unlock(dev);
 }
 
@@ -245,7 +362,7 @@ void elab_device_set_normal_mode(elab_device_t *dev)
     elab_assert(dev != NULL);
 
     elab_device_lock(dev);
-    dev->thread_test = NULL;
+    __atomic_store_n(&dev->thread_test, NULL, __ATOMIC_RELEASE);
     elab_device_unlock(dev);
 }
 
@@ -258,11 +375,10 @@ bool elab_device_is_enabled(elab_device_t *me)
 {
     assert(me != NULL);
 
-    elab_device_lock(me);
-    bool enable_status = me->enable_count > 0 ? true : false;
-    elab_device_unlock(me);
-
-    return enable_status;
+    /* Pairs with the releasing in enabling, so the device seen enabled is
+       seen with all the driver state set up by its enabling. */
+    return (__atomic_load_n(&me->enable_count, __ATOMIC_ACQUIRE) > 0) ?
+                true : false;
 }
 
 /**
@@ -301,6 +417,12 @@ elab_err_t __device_enable(elab_device_t *me, bool status)
     assert(me->ops != NULL);
     assert(me->ops->enable != NULL);
 
+    if (!status && me->ops->flush != NULL &&
+        __atomic_load_n(&me->enable_count, __ATOMIC_ACQUIRE) == 1)
+    {
+        me->ops->flush(me);
+    }
+
     elab_device_lock(me);
     
     if (me->attr.sole)
@@ -328,10 +450,24 @@ elab_err_t __device_enable(elab_device_t *me, bool status)
     {
         ret = me->ops->enable(me, false);
     }
-    me->enable_count = status ? (me->enable_count + 1) : (me->enable_count - 1);
+    __atomic_store_n(&me->enable_count,
+                        status ? (me->enable_count + 1) : (me->enable_count - 1),
+                        __ATOMIC_RELEASE);
+    bool closed = (me->enable_count == 0) ? true : false;
 
     elab_device_unlock(me);
 
+    /* The closed device is in error for the polling threads, and the queued
+       requests are cancelled. */
+    if (!status)
+    {
+        elab_device_poll_wake(me);
+    }
+    if (closed)
+    {
+        __device_async_close(me);
+    }
+
     return ret;
 }
 
@@ -349,7 +485,7 @@ int32_t elab_device_read(elab_device_t *me,
                             uint32_t pos, void *buffer, uint32_t size)
 {
     assert(me != NULL);
-    assert(me->enable_count != 0);
+    assert(__atomic_load_n(&me->enable_count, __ATOMIC_RELAXED) != 0);
     assert(me->ops != NULL);
     assert(me->ops->read != NULL);
 
@@ -380,7 +516,7 @@ int32_t elab_device_write(elab_device_t *me,
                             uint32_t pos, const void *buffer, uint32_t size)
 {
     assert(me != NULL);
-    assert(me->enable_count != 0);
+    assert(__atomic_load_n(&me->enable_count, __ATOMIC_RELAXED) != 0);
     assert(me->ops != NULL);
     assert(me->ops->write != NULL);
 
@@ -397,6 +533,148 @@ exit:
     return ret;
 }
 
+/**
+ * This function will read some data from a device into the segments.
+ *
+ * The driver without the readv interface reads the data chunk by chunk at the
+ * position moving on. The big segment is read into in place, and the small
+ * ones get the data scattered from the buffer on the stack.
+ *
+ * @param me        the pointer of device driver structure.
+ * @param iov       the segments to save read data.
+ * @param num       the number of the segments.
+ *
+ * @return the actually read size on successful, otherwise negative returned.
+ */
+int32_t elab_device_readv(elab_device_t *me,
+                            uint32_t pos, const elab_iovec_t *iov, uint32_t num)
+{
+    assert(me != NULL);
+    assert(__atomic_load_n(&me->enable_count, __ATOMIC_RELAXED) != 0);
+    assert(me->ops != NULL);
+    assert(me->ops->readv != NULL || me->ops->read != NULL);
+    assert(iov != NULL);
+    assert(num != 0);
+
+    int32_t ret = 0;
+    uint8_t buff[EDF_IOV_STACK_SIZE];
+
+    if (elab_device_is_test_mode(me))
+    {
+        ret = ELAB_OK;
+        goto exit;
+    }
+
+    if (me->ops->readv != NULL)
+    {
+        ret = me->ops->readv(me, pos, iov, num);
+        goto exit;
+    }
+
+    uint32_t size_rest = _iov_size(iov, num);
+    uint32_t count = 0;
+    uint32_t index = 0;
+    uint32_t offset = 0;
+    while (size_rest != 0)
+    {
+        uint8_t *segment = &((uint8_t *)iov[index].buffer)[offset];
+        bool in_place = ((iov[index].size - offset) >= EDF_IOV_STACK_SIZE);
+        uint32_t size = in_place ? (iov[index].size - offset) :
+                        ((size_rest < EDF_IOV_STACK_SIZE) ?
+                            size_rest : EDF_IOV_STACK_SIZE);
+        ret = me->ops->read(me, (pos + count), (in_place ? segment : buff), size);
+        if (ret <= 0)
+        {
+            break;
+        }
+        _iov_copy(iov, &index, &offset, (in_place ? NULL : buff),
+                    (uint32_t)ret, true);
+        count += (uint32_t)ret;
+        size_rest -= (uint32_t)ret;
+
+        /* No more data for now. */
+        if ((uint32_t)ret < size)
+        {
+            break;
+        }
+    }
+    ret = (count != 0 || ret >= 0) ? (int32_t)count : ret;
+
+exit:
+    return ret;
+}
+
+/**
+ * This function will write the segments to a device.
+ *
+ * The driver without the writev interface gets the data written chunk by
+ * chunk at the position moving on. The big segment is written in place, and
+ * the small ones are gathered into the buffer on the stack. The driver which
+ * needs all the data in one writing should have the writev interface.
+ *
+ * @param me        the pointer of device driver structure.
+ * @param iov       the segments to be written to device.
+ * @param num       the number of the segments.
+ *
+ * @return The actually written size on successful, otherwise negative returned.
+ */
+int32_t elab_device_writev(elab_device_t *me,
+                            uint32_t pos, const elab_iovec_t *iov, uint32_t num)
+{
+    assert(me != NULL);
+    assert(__atomic_load_n(&me->enable_count, __ATOMIC_RELAXED) != 0);
+    assert(me->ops != NULL);
+    assert(me->ops->writev != NULL || me->ops->write != NULL);
+    assert(iov != NULL);
+    assert(num != 0);
+
+    int32_t ret = 0;
+    uint8_t buff[EDF_IOV_STACK_SIZE];
+
+    if (elab_device_is_test_mode(me))
+    {
+        ret = ELAB_OK;
+        goto exit;
+    }
+
+    if (me->ops->writev != NULL)
+    {
+        ret = me->ops->writev(me, pos, iov, num);
+        goto exit;
+    }
+
+    uint32_t size_rest = _iov_size(iov, num);
+    uint32_t count = 0;
+    uint32_t index = 0;
+    uint32_t offset = 0;
+    while (size_rest != 0)
+    {
+        const uint8_t *segment = &((const uint8_t *)iov[index].buffer)[offset];
+        bool in_place = ((iov[index].size - offset) >= EDF_IOV_STACK_SIZE);
+        uint32_t size = in_place ? (iov[index].size - offset) :
+                        ((size_rest < EDF_IOV_STACK_SIZE) ?
+                            size_rest : EDF_IOV_STACK_SIZE);
+        _iov_copy(iov, &index, &offset, (in_place ? NULL : buff), size, false);
+        ret = me->ops->write(me, (pos + count), (in_place ? segment : buff), size);
+        if (ret <= 0)
+        {
+            break;
+        }
+        count += (uint32_t)ret;
+        size_rest -= size;
+
+        /* The device is busy, and the rest is not written. */
+        if ((uint32_t)ret < size)
+        {
+            break;
+        }
+    }
+    ret = (count != 0 || ret >= 0) ? (int32_t)count : ret;
+
+exit:
+    return ret;
+}
+
 /* private functions -------------------------------------------------------- */
 static osMutexId_t _edf_mutex(void)
 {
@@ -409,18 +687,257 @@ static osMutexId_t _edf_mutex(void)
     return _mutex_edf;
 }
 
-static void _add_device(elab_device_t *me)
+/**
+ * @brief The time33 hashing of the device name.
+ */
+static uint32_t _hash_time33(const char *str)
+{
+    uint32_t hash = 5381;
+
+    while (*str != 0)
+    {
+        hash += (hash << 5) + (uint8_t)(*str ++);
+    }
+
+    return hash;
+}
+
+/**
+ * @brief The total size of the segments.
+ */
+static uint32_t _iov_size(const elab_iovec_t *iov, uint32_t num)
+{
+    uint32_t size = 0;
+
+    for (uint32_t i = 0; i < num; i ++)
+    {
+        assert(iov[i].buffer != NULL || iov[i].size == 0);
+        size += iov[i].size;
+    }
+
+    return size;
+}
+
+/**
+ * @brief Copy the data between the buffer and the segments from the cursor of
+ *        the segment index and the offset in it, and move the cursor on. Only
+ *        the cursor is moved if the buffer is NULL.
+ */
+static void _iov_copy(const elab_iovec_t *iov, uint32_t *index, uint32_t *offset,
+                        uint8_t *buff, uint32_t size, bool to_iov)
+{
+    for (uint32_t count = 0; count < size;)
+    {
+        uint8_t *segment = &((uint8_t *)iov[*index].buffer)[*offset];
+        uint32_t size_copy = iov[*index].size - *offset;
+        size_copy = (size_copy < (size - count)) ? size_copy : (size - count);
+        if (buff != NULL && to_iov)
+        {
+            memcpy(segment, &buff[count], size_copy);
+        }
+        else if (buff != NULL)
+        {
+            memcpy(&buff[count], segment, size_copy);
+        }
+        count += size_copy;
+        *offset += size_copy;
+        if (*offset == iov[*index].size)
+        {
+            *index += 1;
+            *offset = 0;
+        }
+    }
+}
+
+/**
+ * @brief Add the device to the end of the edf list, which grows if full.
+ */
+static void _edf_list_add(elab_device_t *me)
+{
+    if (_edf_device_count == _edf_list_size)
+    {
+        uint32_t size = (_edf_list_size == 0) ?
+                            EDF_LIST_SIZE_MIN : (_edf_list_size * 2);
+        elab_device_t **list = elab_malloc(size * sizeof(elab_device_t *));
+        assert(list != NULL);
+        if (_edf_list != NULL)
+        {
+            memcpy(list, _edf_list, _edf_device_count * sizeof(elab_device_t *));
+            elab_free(_edf_list);
+        }
+        _edf_list = list;
+        _edf_list_size = size;
+    }
+
+    _edf_list[_edf_device_count ++] = me;
+}
+
+/**
+ * @brief Remove the device from the edf list, keeping the order of the others,
+ *        and shrink the list if it is mostly empty.
+ */
+static void _edf_list_remove(elab_device_t *me)
+{
+    uint32_t i = 0;
+    while (_edf_list[i] != me)
+    {
+        i ++;
+    }
+    memmove(&_edf_list[i], &_edf_list[i + 1],
+            (_edf_device_count - i - 1) * sizeof(elab_device_t *));
+    _edf_device_count --;
+
+    if (_edf_list_size > EDF_LIST_SIZE_MIN &&
+        (_edf_device_count * 4) < _edf_list_size)
+    {
+        uint32_t size = _edf_list_size / 2;
+        elab_device_t **list = elab_malloc(size * sizeof(elab_device_t *));
+        assert(list != NULL);
+        memcpy(list, _edf_list, _edf_device_count * sizeof(elab_device_t *));
+        elab_free(_edf_list);
+        _edf_list = list;
+        _edf_list_size = size;
+    }
+}
+
+/**
+ * @brief Add the device, which is in the edf list already, to the index.
+ */
+static void _edf_index_add(elab_device_t *me)
+{
+    /* Keep the index at most half full, counting the removed marks. */
+    if (_edf_index == NULL || ((_edf_index_used + 1) * 2) > _edf_index->size)
+    {
+        _edf_index_rebuild();
+        return;
+    }
+
+    uint32_t mask = _edf_index->size - 1;
+    uint32_t i = me->hash & mask;
+    while (_edf_index->slot[i] != NULL && _edf_index->slot[i] != EDF_INDEX_REMOVED)
+    {
+        i = (i + 1) & mask;
+    }
+    if (_edf_index->slot[i] == NULL)
+    {
+        _edf_index_used ++;
+    }
+    __atomic_store_n(&_edf_index->slot[i], me, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Remove the device, which is out of the edf list already, from the
+ *        index, and return after no reader holds it any more.
+ */
+static void _edf_index_remove(elab_device_t *me)
+{
+    uint32_t mask = _edf_index->size - 1;
+    uint32_t i = me->hash & mask;
+    while (_edf_index->slot[i] != me)
+    {
+        assert(_edf_index->slot[i] != NULL);
+        i = (i + 1) & mask;
+    }
+    __atomic_store_n(&_edf_index->slot[i], EDF_INDEX_REMOVED, __ATOMIC_SEQ_CST);
+
+    if (_edf_index->size > EDF_INDEX_SIZE_MIN &&
+        (_edf_device_count * 8) < _edf_index->size)
+    {
+        _edf_index_rebuild();
+    }
+    else
+    {
+        _edf_synchronize();
+    }
+}
+
+/**
+ * @brief Build a new index from the edf list in the size of four times of the
+ *        devices at least, publish it, and free the old one after no reader
+ *        is on it any more.
+ */
+static void _edf_index_rebuild(void)
 {
-    assert(_edf_device_count < ELAB_DEV_NUM_MAX);
+    edf_index_t *edf_index = NULL;
+
+    if (_edf_device_count != 0)
+    {
+        uint32_t size = EDF_INDEX_SIZE_MIN;
+        while (size < (_edf_device_count * 4))
+        {
+            size *= 2;
+        }
+        edf_index = elab_malloc(sizeof(edf_index_t) +
+                                size * sizeof(elab_device_t *));
+        assert(edf_index != NULL);
+        edf_index->size = size;
+        memset(edf_index->slot, 0, size * sizeof(elab_device_t *));
+        for (uint32_t i = 0; i < _edf_device_count; i ++)
+        {
+            uint32_t j = _edf_list[i]->hash & (size - 1);
+            while (edf_index->slot[j] != NULL)
+            {
+                j = (j + 1) & (size - 1);
+            }
+            edf_index->slot[j] = _edf_list[i];
+        }
+    }
 
-    if (_edf_device_count == 0)
+    edf_index_t *edf_index_old = _edf_index;
+    __atomic_store_n(&_edf_index, edf_index, __ATOMIC_SEQ_CST);
+    _edf_index_used = _edf_device_count;
+    _edf_synchronize();
+    if (edf_index_old != NULL)
+    {
+        elab_free(edf_index_old);
+    }
+}
+
+/**
+ * @brief Enter the read-side critical section of the given reader group.
+ * @retval The index of the reader counter, for the leaving.
+ */
+static uint32_t _edf_read_lock(edf_reader_t *reader)
+{
+    /* The acquiring pairs with the epoch flipping, so the reader seeing the
+       new epoch sees the removing before it too. */
+    uint32_t index = __atomic_load_n(&reader->group.epoch, __ATOMIC_ACQUIRE) & 1;
+    __atomic_fetch_add(&reader->group.count[index], 1, __ATOMIC_SEQ_CST);
+
+    return index;
+}
+
+/**
+ * @brief Leave the read-side critical section of the given reader group.
+ */
+static void _edf_read_unlock(edf_reader_t *reader, uint32_t index)
+{
+    __atomic_fetch_sub(&reader->group.count[index], 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Wait until all the readers being in the read-side critical section
+ *        leave. Called with the edf mutex held.
+ */
+static void _edf_synchronize(void)
+{
+    /* Either the counting of one reader is before the zero checking and it is
+       waited, or it is after the checking and then the reader surely sees
+       the removing, all in the total order of the sequential consistency. */
+    for (uint32_t i = 0; i < EDF_READER_GROUP_NUM; i ++)
     {
-        for (uint32_t i = 0; i < ELAB_DEV_NUM_MAX; i ++)
+        edf_reader_t *reader = &_edf_reader[i];
+        for (uint32_t j = 0; j < 2; j ++)
         {
-            _edf_table[i] = NULL;
+            uint32_t epoch = __atomic_fetch_add(&reader->group.epoch, 1,
+                                                __ATOMIC_SEQ_CST);
+            while (__atomic_load_n(&reader->group.count[epoch & 1],
+                                    __ATOMIC_SEQ_CST) != 0)
+            {
+                osDelay(1);
+            }
         }
     }
-    _edf_table[_edf_device_count ++] = me;
 }
 
 /* ----------------------------- end of file -------------------------------- */
@@ -18,7 +18,6 @@ extern "C" {
 #endif
 
 /* public config ------------------------------------------------------------ */
-#define ELAB_DEV_NUM_MAX                (64)
 #define ELAB_DEV_PALTFORM               ELAB_PALTFORM_RTOS
 
 /* public define ------------------------------------------------------------ */
@@ -49,6 +48,26 @@ enum elab_device_layer
     ELAB_DEV_LAYER_USER,                        /* User defined device mode */
 };
 
+enum elab_device_req_type
+{
+    ELAB_DEVICE_REQ_READ = 0,
+    ELAB_DEVICE_REQ_WRITE,
+};
+
+enum elab_device_req_status
+{
+    ELAB_DEVICE_REQ_IDLE = 0,
+    ELAB_DEVICE_REQ_PENDING,
+    ELAB_DEVICE_REQ_DONE,
+};
+
+enum elab_device_event
+{
+    ELAB_DEVICE_EV_READ = 0x01,                 /* Data to read */
+    ELAB_DEVICE_EV_WRITE = 0x02,                /* Ready for writing */
+    ELAB_DEVICE_EV_ERROR = 0x04,                /* Closed or broken */
+};
+
 enum elab_device_boot_level
 {
     ELAB_DEV_BOOT_L0 = 0,                       /* The lowest */
@@ -82,16 +101,68 @@ typedef struct elab_driver
     bool enabled;
 } elab_driver_t;
 
+/*
+ * One segment of the vectored reading or writing, in which the segments are
+ * transferred in order as one contiguous data.
+ */
+typedef struct elab_iovec
+{
+    void *buffer;
+    uint32_t size;
+} elab_iovec_t;
+
+struct elab_device_req;
+typedef void (* elab_device_req_cb_t)(struct elab_device_req *req);
+
+/*
+ * One asynchronous reading or writing request. The user fills the first part
+ * and submits it, and the request belongs to the device framework until it is
+ * done, with the result of the actual size or the error ID. The completion is
+ * informed by the callback, the completion queue and the waiting in order,
+ * all optional.
+ */
+typedef struct elab_device_req
+{
+    uint8_t type;                               /* Reading or writing */
+    uint32_t pos;
+    void *buffer;
+    uint32_t size;
+    uint32_t timeout;                           /* ms, or osWaitForever */
+    elab_device_req_cb_t cb;                    /* Called in completing */
+    osMessageQueueId_t queue;                   /* Getting the request pointer */
+    void *user_data;
+
+    /* Set by the device framework. */
+    struct elab_device *dev;
+    int32_t result;
+    uint8_t status;
+    uint32_t time_deadline;
+    osThreadId_t thread_wait;
+    struct elab_device_req *next;
+} elab_device_req_t;
+
+struct elab_device_async;
+struct elab_device_poll;
+
 typedef struct elab_device
 {
     elab_device_attr_t attr;
 
-    uint8_t enable_count;
+    uint8_t enable_count;                       /* Atomic, changed locked */
 #if (ELAB_DEV_PALTFORM == ELAB_PALTFORM_RTOS)
     uint8_t lock_count;
     osMutexId_t mutex;
 #endif
-    osThreadId_t thread_test;
+    osThreadId_t thread_test;                   /* Atomic, changed locked */
+
+    /* The name hashing of the device framework index */
+    uint32_t hash;
+
+    /* The thread-backed asynchronous requests, for the driver without */
+    struct elab_device_async *async;
+
+    /* The threads waiting in elab_device_poll */
+    struct elab_device_poll *poll_wait;
 
     /* common device interface */
     const struct elab_dev_ops *ops;
@@ -107,8 +178,23 @@ typedef struct elab_dev_ops
     void (* poll)(elab_device_t *me);
     elab_err_t (* isr_enable)(elab_device_t *me, bool status);
 #endif
+    /* Optional, the segments transferred as one, without gathering. */
+    int32_t (* readv)(elab_device_t *me, uint32_t pos,
+                        const elab_iovec_t *iov, uint32_t num);
+    int32_t (* writev)(elab_device_t *me, uint32_t pos,
+                        const elab_iovec_t *iov, uint32_t num);
+    /* Optional, the ready events, or always ready for reading and writing. */
+    uint8_t (* get_events)(elab_device_t *me);
+    /* Optional, started request finished by elab_device_req_complete. */
+    elab_err_t (* submit)(elab_device_t *me, elab_device_req_t *req);
+    elab_err_t (* cancel)(elab_device_t *me, elab_device_req_t *req);
+    /* Optional, sending the buffered data in the last closing, called before
+       the device is locked, so the other users are not blocked by it. */
+    void (* flush)(elab_device_t *me);
 } elab_dev_ops_t;
 
+typedef void (* elab_device_cb_t)(elab_device_t *me, void *para);
+
 #define ELAB_DEVICE_CAST(_dev)      ((elab_device_t *)_dev)
 
 /* public functions --------------------------------------------------------- */
@@ -128,6 +214,17 @@ void elab_device_register(elab_device_t *me, elab_device_attr_t *attr);
  */
 elab_device_t *elab_device_find(const char *name);
 
+/**
+ * @brief Call the given function for every device of the given type, in the
+ *        registering order. The function should not register or unregister
+ *        any device.
+ * @param type  Device type.
+ * @param cb    The function called for every device.
+ * @param para  The parameter of the function.
+ * @return Count number of the devices of the type.
+ */
+uint32_t elab_device_foreach(uint8_t type, elab_device_cb_t cb, void *para);
+
 /**
  * This function check the given name is the device's name or not.
  * @param me    Device handle.
@@ -200,6 +297,93 @@ int32_t elab_device_read(elab_device_t *me,
 int32_t elab_device_write(elab_device_t *me,
                             uint32_t pos, const void *buffer, uint32_t size);
 
+/**
+ * @brief Device vectored reading function. The data is read as one contiguous
+ *        data, and scattered into the segments in order.
+ * @param me        Device handle.
+ * @param pos       Reading position
+ * @param iov       The segments array.
+ * @param num       Number of the segments.
+ * @return if > 0, actual reading size in total; if < 0, error ID.
+ */
+int32_t elab_device_readv(elab_device_t *me,
+                            uint32_t pos, const elab_iovec_t *iov, uint32_t num);
+
+/**
+ * @brief Device vectored writting function. The segments are written in order
+ *        as one contiguous data.
+ * @param me        Device handle.
+ * @param pos       Writting position
+ * @param iov       The segments array.
+ * @param num       Number of the segments.
+ * @return if > 0, actual writting size in total; if < 0, error ID.
+ */
+int32_t elab_device_writev(elab_device_t *me,
+                            uint32_t pos, const elab_iovec_t *iov, uint32_t num);
+
+/**
+ * @brief Submit one asynchronous reading or writing request to the device.
+ *        The driver's submit interface takes it if existent, or one thread of
+ *        the device does the blocking reading or writing for it in order, in
+ *        which the request not started before its timeout is timed out.
+ * @param me        Device handle.
+ * @param req       The request, which is not in progress.
+ * @return ELAB_OK if submitted, or error ID.
+ */
+elab_err_t elab_device_submit(elab_device_t *me, elab_device_req_t *req);
+
+/**
+ * @brief Check the request is done or not, without blocking.
+ * @param req       The request.
+ * @return True or false.
+ */
+bool elab_device_req_is_done(elab_device_req_t *req);
+
+/**
+ * @brief Wait for the request to be done.
+ * @param req       The request.
+ * @param timeout   Waiting timeout in ms, or osWaitForever.
+ * @return ELAB_OK if done, or ELAB_ERR_TIMEOUT.
+ */
+elab_err_t elab_device_req_wait(elab_device_req_t *req, uint32_t timeout);
+
+/**
+ * @brief Cancel the request in progress, which is done in ELAB_ERR_CANCEL then.
+ * @param req       The request.
+ * @return ELAB_OK if cancelled, or ELAB_ERR_BUSY if it is being transferred and
+ *         can not be cancelled, or ELAB_ERROR if not in progress.
+ */
+elab_err_t elab_device_cancel(elab_device_req_t *req);
+
+/**
+ * @brief Complete the request, called by the driver, even in the ISR.
+ * @param req       The request.
+ * @param result    The actual size, or error ID.
+ * @return None.
+ */
+void elab_device_req_complete(elab_device_req_t *req, int32_t result);
+
+/**
+ * @brief Wait for any of the devices to be ready for the given events. The
+ *        device not opened is always in ELAB_DEVICE_EV_ERROR.
+ * @param devices   The devices array.
+ * @param events    The waited events of every device, see elab_device_event.
+ * @param revents   The ready events of every device, set in returning.
+ * @param num       Number of the devices, 16 at most.
+ * @param timeout   Waiting timeout in ms, 0 or osWaitForever.
+ * @return Number of the ready devices, or 0 if timeout.
+ */
+int32_t elab_device_poll(elab_device_t *devices[], const uint8_t events[],
+                            uint8_t revents[], uint32_t num, uint32_t timeout);
+
+/**
+ * @brief Wake up the threads polling the device, called by the driver when the
+ *        events of the device may change, even in the ISR.
+ * @param me        Device handle.
+ * @return None.
+ */
+void elab_device_poll_wake(elab_device_t *me);
+
 /**
  * @brief Open the given device.
  * @param _dev  Device handle.
@@ -231,6 +415,10 @@ int32_t elab_device_write(elab_device_t *me,
 /* private function --------------------------------------------------------- */
 void __device_mutex_lock(elab_device_t *me, bool status);
 elab_err_t __device_enable(elab_device_t *me, bool status);
+void __device_async_deinit(elab_device_t *me);
+void __device_async_close(elab_device_t *me);
+void __device_poll_init(elab_device_t *me);
+void __device_poll_deinit(elab_device_t *me);
 
 /* private define ----------------------------------------------------------- */
 /* eLab platform */
@@ -0,0 +1,436 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+/* includes ----------------------------------------------------------------- */
+#include "elab_device.h"
+#include "../common/elab_assert.h"
+#include "../common/elab_common.h"
+#include "../common/elab_log.h"
+#include "../os/cmsis_os.h"
+
+ELAB_TAG("EdfDeviceAsync");
+
+/* private config ----------------------------------------------------------- */
+#define EDF_ASYNC_STACK_SIZE                (2048)
+#define EDF_ASYNC_REQ_MAX                   (0xffff)
+#define EDF_REQ_FLAG_DONE                   (0x40000000U)
+/* The waiting thread slot taken by the completing. */
+#define EDF_REQ_WAIT_TAKEN                  ((osThreadId_t)(uintptr_t)1)
+
+/* private typedef ---------------------------------------------------------- */
+/*
+ * The thread-backed requests of one device whose driver has no submit
+ * interface. The requests are queued in the submitting order, and the thread
+ * of the device does the blocking reading or writing one by one. The queue
+ * is protected by the device mutex.
+ */
+typedef struct elab_device_async
+{
+    osThreadId_t thread;
+    osSemaphoreId_t sem;
+    elab_device_req_t *head;
+    elab_device_req_t *tail;
+    bool exit;
+} elab_device_async_t;
+
+/* private function prototypes ---------------------------------------------- */
+static elab_device_async_t *_async_get(elab_device_t *me);
+static void _entry_async(void *para);
+
+/* private variables -------------------------------------------------------- */
+static const osThreadAttr_t _thread_attr_async =
+{
+    .name = "ThreadDevAsync",
+    .attr_bits = osThreadJoinable,
+    .priority = osPriorityNormal,
+    .stack_size = EDF_ASYNC_STACK_SIZE,
+};
+
+/* public function ---------------------------------------------------------- */
+/**
+ * @brief Submit one asynchronous reading or writing request to the device.
+ * @param me        Device handle.
+ * @param req       The request, which is not in progress.
+ * @retval ELAB_OK if submitted, or error ID.
+ */
+elab_err_t elab_device_submit(elab_device_t *me, elab_device_req_t *req)
+{
+    assert(me != NULL);
+    assert(me->ops != NULL);
+    assert(req != NULL);
+    assert(req->type == ELAB_DEVICE_REQ_READ || req->type == ELAB_DEVICE_REQ_WRITE);
+    assert_name(elab_device_is_enabled(me), me->attr.name);
+    assert(__atomic_load_n(&req->status, __ATOMIC_ACQUIRE) !=
+            ELAB_DEVICE_REQ_PENDING);
+
+    elab_err_t ret = ELAB_OK;
+
+    req->dev = me;
+    req->result = 0;
+    req->next = NULL;
+    req->thread_wait = NULL;
+    req->time_deadline = elab_time_ms() + req->timeout;
+    __atomic_store_n(&req->status, ELAB_DEVICE_REQ_PENDING, __ATOMIC_SEQ_CST);
+
+    if (me->ops->submit != NULL)
+    {
+        ret = me->ops->submit(me, req);
+        if (ret != ELAB_OK)
+        {
+            __atomic_store_n(&req->status, ELAB_DEVICE_REQ_IDLE, __ATOMIC_SEQ_CST);
+        }
+        goto exit;
+    }
+
+    assert((req->type == ELAB_DEVICE_REQ_READ) ?
+            (me->ops->read != NULL) : (me->ops->write != NULL));
+    elab_device_lock(me);
+    elab_device_async_t *async = _async_get(me);
+    if (async->tail == NULL)
+    {
+        async->head = req;
+    }
+    else
+    {
+        async->tail->next = req;
+    }
+    async->tail = req;
+    elab_device_unlock(me);
+
+    osStatus_t ret_os = osSemaphoreRelease(async->sem);
+    elab_assert(ret_os == osOK);
+
+exit:
+    return ret;
+}
+
+/**
+ * @brief Check the request is done or not, without blocking.
+ * @param req       The request.
+ * @retval True or false.
+ */
+bool elab_device_req_is_done(elab_device_req_t *req)
+{
+    assert(req != NULL);
+
+    return (__atomic_load_n(&req->status, __ATOMIC_ACQUIRE) ==
+                ELAB_DEVICE_REQ_DONE) ? true : false;
+}
+
+/**
+ * @brief Wait for the request to be done.
+ * @param req       The request.
+ * @param timeout   Waiting timeout in ms, or osWaitForever.
+ * @retval ELAB_OK if done, or ELAB_ERR_TIMEOUT.
+ */
+elab_err_t elab_device_req_wait(elab_device_req_t *req, uint32_t timeout)
+{
+    assert(req != NULL);
+
+    elab_err_t ret = ELAB_OK;
+    uint32_t time_start = elab_time_ms();
+    osThreadId_t thread = osThreadGetId();
+    osThreadId_t thread_none = NULL;
+
+    /* Either the waiting thread is put into the slot before the completing
+       takes it, or the completing is in progress already. */
+    if (__atomic_compare_exchange_n(&req->thread_wait, &thread_none, thread,
+                                    false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+    {
+        while (__atomic_load_n(&req->status, __ATOMIC_SEQ_CST) !=
+                ELAB_DEVICE_REQ_DONE)
+        {
+            uint32_t time_wait = osWaitForever;
+            if (timeout != osWaitForever)
+            {
+                uint32_t time_elapsed = elab_time_ms() - time_start;
+                if (time_elapsed >= timeout)
+                {
+                    /* Not timeout if the completing takes the slot first. */
+                    if (__atomic_compare_exchange_n(&req->thread_wait, &thread,
+                                                    NULL, false,
+                                                    __ATOMIC_SEQ_CST,
+                                                    __ATOMIC_SEQ_CST))
+                    {
+                        ret = ELAB_ERR_TIMEOUT;
+                    }
+                    break;
+                }
+                time_wait = timeout - time_elapsed;
+            }
+
+            /* The flag may be from one former request, so it is checked
+               again. */
+            osThreadFlagsWait(EDF_REQ_FLAG_DONE, osFlagsWaitAny, time_wait);
+        }
+    }
+
+    /* The slot is taken by the completing, and the done status is coming. */
+    while (ret == ELAB_OK &&
+            __atomic_load_n(&req->status, __ATOMIC_SEQ_CST) !=
+                ELAB_DEVICE_REQ_DONE)
+    {
+        osThreadYield();
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Cancel the request in progress, which is done in ELAB_ERR_CANCEL then.
+ * @param req       The request.
+ * @retval ELAB_OK if cancelled, or ELAB_ERR_BUSY if it is being transferred and
+ *         can not be cancelled, or ELAB_ERROR if not in progress.
+ */
+elab_err_t elab_device_cancel(elab_device_req_t *req)
+{
+    assert(req != NULL);
+
+    elab_err_t ret = ELAB_ERROR;
+    elab_device_t *me = req->dev;
+
+    if (__atomic_load_n(&req->status, __ATOMIC_ACQUIRE) !=
+            ELAB_DEVICE_REQ_PENDING)
+    {
+        goto exit;
+    }
+
+    if (me->ops->submit != NULL)
+    {
+        ret = (me->ops->cancel != NULL) ? me->ops->cancel(me, req) : ELAB_ERR_BUSY;
+    }
+    else
+    {
+        /* Only the request still in the queue can be cancelled, and the others
+           in progress are being transferred. */
+        ret = ELAB_ERR_BUSY;
+        elab_device_lock(me);
+        elab_device_async_t *async = me->async;
+        elab_device_req_t *prev = NULL;
+        elab_device_req_t *next = async->head;
+        while (next != NULL && next != req)
+        {
+            prev = next;
+            next = next->next;
+        }
+        if (next == req)
+        {
+            if (prev == NULL)
+            {
+                async->head = req->next;
+            }
+            else
+            {
+                prev->next = req->next;
+            }
+            if (async->tail == req)
+            {
+                async->tail = prev;
+            }
+            ret = ELAB_OK;
+        }
+        elab_device_unlock(me);
+    }
+
+    if (ret == ELAB_OK)
+    {
+        elab_device_req_complete(req, ELAB_ERR_CANCEL);
+    }
+
+exit:
+    return ret;
+}
+
+/**
+ * @brief Complete the request, called by the driver, even in the ISR. The
+ *        request may be freed or submitted again by its user as soon as it is
+ *        seen done, so the done status is the last access to it.
+ * @param req       The request.
+ * @param result    The actual size, or error ID.
+ * @retval None.
+ */
+void elab_device_req_complete(elab_device_req_t *req, int32_t result)
+{
+    assert(req != NULL);
+    assert(__atomic_load_n(&req->status, __ATOMIC_ACQUIRE) ==
+            ELAB_DEVICE_REQ_PENDING);
+
+    /* The queue and the waiting thread are taken before the done status. The
+       waiting thread taken out of the slot waits for the done status then,
+       and the one coming later knows the completing is in progress. */
+    osMessageQueueId_t queue = req->queue;
+    req->result = result;
+    if (req->cb != NULL)
+    {
+        req->cb(req);
+    }
+    osThreadId_t thread = __atomic_exchange_n(&req->thread_wait,
+                                                EDF_REQ_WAIT_TAKEN,
+                                                __ATOMIC_SEQ_CST);
+    __atomic_store_n(&req->status, ELAB_DEVICE_REQ_DONE, __ATOMIC_SEQ_CST);
+
+    if (thread != NULL)
+    {
+        osThreadFlagsSet(thread, EDF_REQ_FLAG_DONE);
+    }
+    if (queue != NULL)
+    {
+        /* The queue should be large enough for all the requests in progress. */
+        osStatus_t ret_os = osMessageQueuePut(queue, &req, 0, 0);
+        elab_assert(ret_os == osOK);
+    }
+}
+
+/**
+ * @brief Cancel the thread-backed requests still in the queue of the device,
+ *        which can not be transferred any more. Called in the last closing.
+ * @param me        Device handle.
+ * @retval None.
+ */
+void __device_async_close(elab_device_t *me)
+{
+    elab_device_req_t *req = NULL;
+
+    elab_device_lock(me);
+    elab_device_async_t *async = me->async;
+    if (async != NULL)
+    {
+        req = async->head;
+        async->head = NULL;
+        async->tail = NULL;
+    }
+    elab_device_unlock(me);
+
+    /* The semaphore counts are left without requests, as the cancelled. */
+    while (req != NULL)
+    {
+        elab_device_req_t *next = req->next;
+        elab_device_req_complete(req, ELAB_ERR_CANCEL);
+        req = next;
+    }
+}
+
+/**
+ * @brief Stop the thread of the thread-backed requests of the device, and
+ *        cancel the requests still in the queue. Called in unregistering.
+ * @param me        Device handle.
+ * @retval None.
+ */
+void __device_async_deinit(elab_device_t *me)
+{
+    elab_device_async_t *async = me->async;
+    if (async == NULL)
+    {
+        return;
+    }
+
+    elab_device_lock(me);
+    async->exit = true;
+    elab_device_req_t *req = async->head;
+    async->head = NULL;
+    async->tail = NULL;
+    elab_device_unlock(me);
+
+    osStatus_t ret_os = osSemaphoreRelease(async->sem);
+    elab_assert(ret_os == osOK);
+    ret_os = osThreadJoin(async->thread);
+    elab_assert(ret_os == osOK);
+    ret_os = osSemaphoreDelete(async->sem);
+    elab_assert(ret_os == osOK);
+
+    while (req != NULL)
+    {
+        elab_device_req_t *next = req->next;
+        elab_device_req_complete(req, ELAB_ERR_CANCEL);
+        req = next;
+    }
+
+    me->async = NULL;
+    elab_free(async);
+}
+
+/* private functions -------------------------------------------------------- */
+/**
+ * @brief Get the thread-backed requests of the device, which are created in
+ *        the first submitting. Called with the device mutex held.
+ */
+static elab_device_async_t *_async_get(elab_device_t *me)
+{
+    if (me->async == NULL)
+    {
+        elab_device_async_t *async = elab_malloc(sizeof(elab_device_async_t));
+        assert(async != NULL);
+        memset(async, 0, sizeof(elab_device_async_t));
+
+        async->sem = osSemaphoreNew(EDF_ASYNC_REQ_MAX, 0, NULL);
+        assert(async->sem != NULL);
+        async->thread = osThreadNew(_entry_async, me, &_thread_attr_async);
+        assert(async->thread != NULL);
+        me->async = async;
+    }
+
+    return me->async;
+}
+
+/**
+ * @brief The thread doing the blocking reading and writing of the requests of
+ *        one device in order.
+ */
+static void _entry_async(void *para)
+{
+    elab_device_t *me = (elab_device_t *)para;
+    elab_device_async_t *async = NULL;
+
+    /* The thread may run before the device gets the async data. */
+    elab_device_lock(me);
+    async = me->async;
+    elab_device_unlock(me);
+
+    while (1)
+    {
+        osStatus_t ret_os = osSemaphoreAcquire(async->sem, osWaitForever);
+        elab_assert(ret_os == osOK);
+
+        /* The cancelled requests leave the semaphore counts without ones. */
+        elab_device_lock(me);
+        if (async->exit)
+        {
+            elab_device_unlock(me);
+            break;
+        }
+        elab_device_req_t *req = async->head;
+        if (req != NULL)
+        {
+            async->head = req->next;
+            if (async->head == NULL)
+            {
+                async->tail = NULL;
+            }
+        }
+        elab_device_unlock(me);
+        if (req == NULL)
+        {
+            continue;
+        }
+
+        /* The device may be closed after the request is taken. */
+        int32_t result = ELAB_ERR_TIMEOUT;
+        if (!elab_device_is_enabled(me))
+        {
+            result = ELAB_ERR_CANCEL;
+        }
+        else if (req->timeout == osWaitForever ||
+            (int32_t)(req->time_deadline - elab_time_ms()) > 0)
+        {
+            result = (req->type == ELAB_DEVICE_REQ_READ) ?
+                elab_device_read(me, req->pos, req->buffer, req->size) :
+                elab_device_write(me, req->pos, req->buffer, req->size);
+        }
+
+        elab_device_req_complete(req, result);
+    }
+}
+
+/* ----------------------------- end of file -------------------------------- */
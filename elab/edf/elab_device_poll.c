@@ -0,0 +1,237 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+/* includes ----------------------------------------------------------------- */
+#include "elab_device.h"
+#include "../common/elab_assert.h"
+#include "../common/elab_common.h"
+#include "../common/elab_log.h"
+#include "../os/cmsis_os.h"
+
+ELAB_TAG("EdfDevicePoll");
+
+/* private config ----------------------------------------------------------- */
+#define EDF_POLL_WAITER_NUM                 (8)
+#define EDF_POLL_DEVICE_MAX                 (16)
+#define EDF_POLL_FLAG_WAKE                  (0x20000000U)
+
+/* private typedef ---------------------------------------------------------- */
+/*
+ * The wait queue of one device, which is the slots of the polling threads.
+ * One polling thread takes one free slot in every device before checking the
+ * events of them, and the driver changes the events of the device before
+ * waking the threads in the slots, so the thread sees either the new events
+ * or the waking flag. The waking takes no lock, and is done in the ISR, so
+ * the waking in progress is counted, and the thread waits it to end before
+ * leaving the slot, to not be woken after it ends.
+ */
+typedef struct elab_device_poll
+{
+    osThreadId_t waiter[EDF_POLL_WAITER_NUM];   /* Atomic */
+    uint32_t waking;                            /* Atomic */
+} elab_device_poll_t;
+
+/* private function prototypes ---------------------------------------------- */
+static uint32_t _poll_enter(elab_device_t *me, osThreadId_t thread);
+static void _poll_leave(elab_device_t *me, uint32_t index);
+static uint8_t _poll_check(elab_device_t *me, uint8_t events);
+
+/* public function ---------------------------------------------------------- */
+/**
+ * @brief Wait for any of the devices to be ready for the given events.
+ * @param devices   The devices array.
+ * @param events    The waited events of every device.
+ * @param revents   The ready events of every device, set in returning.
+ * @param num       Number of the devices, EDF_POLL_DEVICE_MAX at most.
+ * @param timeout   Waiting timeout in ms, 0 or osWaitForever.
+ * @retval Number of the ready devices, or 0 if timeout.
+ */
+int32_t elab_device_poll(elab_device_t *devices[], const uint8_t events[],
+                            uint8_t revents[], uint32_t num, uint32_t timeout)
+{
+    assert(devices != NULL);
+    assert(events != NULL);
+    assert(revents != NULL);
+    assert(num != 0 && num <= EDF_POLL_DEVICE_MAX);
+
+    int32_t count = 0;
+    uint32_t time_start = elab_time_ms();
+    osThreadId_t thread = osThreadGetId();
+    uint32_t index[EDF_POLL_DEVICE_MAX];
+
+    if (timeout != 0)
+    {
+        /* The waking flag may be from the former polling. */
+        osThreadFlagsClear(EDF_POLL_FLAG_WAKE);
+        for (uint32_t i = 0; i < num; i ++)
+        {
+            index[i] = _poll_enter(devices[i], thread);
+        }
+    }
+
+    while (1)
+    {
+        count = 0;
+        for (uint32_t i = 0; i < num; i ++)
+        {
+            revents[i] = _poll_check(devices[i], events[i]);
+            count += (revents[i] != 0) ? 1 : 0;
+        }
+        if (count != 0 || timeout == 0)
+        {
+            break;
+        }
+
+        uint32_t time_wait = osWaitForever;
+        if (timeout != osWaitForever)
+        {
+            uint32_t time_elapsed = elab_time_ms() - time_start;
+            if (time_elapsed >= timeout)
+            {
+                break;
+            }
+            time_wait = timeout - time_elapsed;
+        }
+        osThreadFlagsWait(EDF_POLL_FLAG_WAKE, osFlagsWaitAny, time_wait);
+    }
+
+    if (timeout != 0)
+    {
+        for (uint32_t i = 0; i < num; i ++)
+        {
+            _poll_leave(devices[i], index[i]);
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief Wake up the threads polling the device, even in the ISR.
+ * @param me        Device handle.
+ * @retval None.
+ */
+void elab_device_poll_wake(elab_device_t *me)
+{
+    assert(me != NULL);
+
+    elab_device_poll_t *poll = __atomic_load_n(&me->poll_wait, __ATOMIC_ACQUIRE);
+    if (poll == NULL)
+    {
+        return;
+    }
+
+    /* The events are changed before, which is ordered by the sequential
+       consistency against the slot taking and the event checking. */
+    __atomic_fetch_add(&poll->waking, 1, __ATOMIC_SEQ_CST);
+    for (uint32_t i = 0; i < EDF_POLL_WAITER_NUM; i ++)
+    {
+        osThreadId_t thread = __atomic_load_n(&poll->waiter[i], __ATOMIC_SEQ_CST);
+        if (thread != NULL)
+        {
+            osThreadFlagsSet(thread, EDF_POLL_FLAG_WAKE);
+        }
+    }
+    __atomic_fetch_sub(&poll->waking, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Create the wait queue of the device, so the polling allocates no
+ *        memory. Called in registering.
+ * @param me        Device handle.
+ * @retval None.
+ */
+void __device_poll_init(elab_device_t *me)
+{
+    elab_device_poll_t *poll = elab_malloc(sizeof(elab_device_poll_t));
+    assert(poll != NULL);
+    memset(poll, 0, sizeof(elab_device_poll_t));
+    __atomic_store_n(&me->poll_wait, poll, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Free the wait queue of the device. Called in unregistering.
+ * @param me        Device handle.
+ * @retval None.
+ */
+void __device_poll_deinit(elab_device_t *me)
+{
+    elab_device_poll_t *poll = me->poll_wait;
+
+    for (uint32_t i = 0; i < EDF_POLL_WAITER_NUM; i ++)
+    {
+        assert_name(poll->waiter[i] == NULL, me->attr.name);
+    }
+
+    /* The waking in progress is in the ISR or one running thread, and just
+       setting the thread flags, so it ends soon. */
+    __atomic_store_n(&me->poll_wait, NULL, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&poll->waking, __ATOMIC_ACQUIRE) != 0)
+    {
+        osThreadYield();
+    }
+    elab_free(poll);
+}
+
+/* private functions -------------------------------------------------------- */
+/**
+ * @brief Take one free slot in the wait queue of the device.
+ * @retval The slot index.
+ */
+static uint32_t _poll_enter(elab_device_t *me, osThreadId_t thread)
+{
+    elab_device_poll_t *poll = me->poll_wait;
+
+    for (uint32_t i = 0; i < EDF_POLL_WAITER_NUM; i ++)
+    {
+        osThreadId_t thread_free = NULL;
+        if (__atomic_compare_exchange_n(&poll->waiter[i], &thread_free, thread,
+                                        false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        {
+            return i;
+        }
+    }
+
+    /* Too many threads polling one device. */
+    assert_name(false, me->attr.name);
+
+    return 0;
+}
+
+/**
+ * @brief Leave the slot, after the waking in progress.
+ */
+static void _poll_leave(elab_device_t *me, uint32_t index)
+{
+    elab_device_poll_t *poll = me->poll_wait;
+
+    __atomic_store_n(&poll->waiter[index], NULL, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&poll->waking, __ATOMIC_ACQUIRE) != 0)
+    {
+        osThreadYield();
+    }
+}
+
+/**
+ * @brief The ready events of the device among the waited ones, and the error
+ *        event if not opened.
+ */
+static uint8_t _poll_check(elab_device_t *me, uint8_t events)
+{
+    uint8_t revents = ELAB_DEVICE_EV_ERROR;
+
+    if (elab_device_is_enabled(me))
+    {
+        revents = (me->ops->get_events != NULL) ?
+                    me->ops->get_events(me) :
+                    (ELAB_DEVICE_EV_READ | ELAB_DEVICE_EV_WRITE);
+        revents &= (events | ELAB_DEVICE_EV_ERROR);
+    }
+
+    return revents;
+}
+
+/* ----------------------------- end of file -------------------------------- */
@@ -13,6 +13,18 @@
 
 ELAB_TAG("Edf_I2C");
 
+/* Private config ------------------------------------------------------------*/
+#define EDF_I2C_IOV_STACK_SIZE              (32)
+
+/* Private function prototypes -----------------------------------------------*/
+static elab_err_t _device_enable(elab_device_t *me, bool status);
+static int32_t _device_read(elab_device_t *me,
+                            uint32_t pos, void *buffer, uint32_t size);
+static int32_t _device_write(elab_device_t *me,
+                                uint32_t pos, const void *buffer, uint32_t size);
+static int32_t _device_writev(elab_device_t *me, uint32_t pos,
+                                const elab_iovec_t *iov, uint32_t num);
+
 /* Private variables ---------------------------------------------------------*/
 /**
  * @brief  The I2C oprations function.
@@ -27,6 +39,20 @@ static const elab_dev_ops_t i2c_ops =
 #endif
 };
 
+/**
+ * @brief  The I2C device oprations function.
+ */
+static const elab_dev_ops_t i2c_dev_ops =
+{
+    .enable = _device_enable,
+    .read = _device_read,
+    .write = _device_write,
+    .writev = _device_writev,
+#if (ELAB_DEV_PALTFORM == ELAB_PALTFORM_POLL)
+    .poll = NULL,
+#endif
+};
+
 /* Exported functions --------------------------------------------------------*/
 /**
   * @brief  I2C bus device register
@@ -111,6 +137,7 @@ void elab_i2c_register(elab_i2c_t *device, const char *name, const char *bus_nam
 
     device->bus = bus;
     device->config = config;
+    device->super.ops = &i2c_dev_ops;
     device->super.user_data = NULL;
 
     /* Register to device manager. */
@@ -330,6 +357,11 @@ exit:
     return ret;
 }
 
+/**
+  * @brief  Write the data to the memory of I2C device in one message, after the
+  *         memory address byte.
+  * @retval The message size, the data size and the address byte, or error ID.
+  */
 elab_err_t elab_i2c_write_memory(elab_device_t *me, uint8_t addr,
                                     uint8_t *buff, uint16_t size,
                                     uint32_t timeout)
@@ -337,14 +369,63 @@ elab_err_t elab_i2c_write_memory(elab_device_t *me, uint8_t addr,
     elab_assert(me != NULL);
     elab_assert(me->attr.type == ELAB_DEVICE_I2C);
 
+    elab_iovec_t iov[2] =
+    {
+        { .buffer = &addr, .size = 1 },
+        { .buffer = buff, .size = size },
+    };
+
+    return elab_i2c_writev(me, iov, 2, timeout);
+}
+
+/**
+  * @brief  Write the segments to I2C device in one message. Every message is
+  *         one bus transaction, so more segments are gathered into one buffer,
+  *         which is on the stack for the small data, and one segment is written
+  *         in place.
+  * @param  me      I2C device handle.
+  * @param  iov     The segments array.
+  * @param  num     The number of the segments.
+  * @retval The message size, or error ID.
+  */
+elab_err_t elab_i2c_writev(elab_device_t *me,
+                            const elab_iovec_t *iov, uint32_t num,
+                            uint32_t timeout)
+{
+    elab_assert(me != NULL);
+    elab_assert(me->attr.type == ELAB_DEVICE_I2C);
+    elab_assert(iov != NULL);
+    elab_assert(num != 0);
+
     elab_err_t ret = ELAB_OK;
     osStatus_t ret_os = osOK;
     elab_i2c_t *i2c = (elab_i2c_t *)me;
+    uint8_t buff_stack[EDF_I2C_IOV_STACK_SIZE];
     elab_i2c_msg_t msg;
-    msg.buffer = NULL;
 
     elab_assert(i2c->bus != NULL);
 
+    /* Gather the segments into one message. */
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < num; i ++)
+    {
+        size += iov[i].size;
+    }
+    elab_assert(size != 0 && size <= UINT16_MAX);
+    msg.write = true;
+    msg.len = (uint16_t)size;
+    msg.buffer = (uint8_t *)iov[0].buffer;
+    if (num != 1)
+    {
+        msg.buffer = (size <= EDF_I2C_IOV_STACK_SIZE) ? buff_stack : elab_malloc(size);
+        elab_assert(msg.buffer != NULL);
+    }
+    for (uint32_t i = 0, offset = 0; i < num && num != 1; i ++)
+    {
+        memcpy(&msg.buffer[offset], iov[i].buffer, iov[i].size);
+        offset += iov[i].size;
+    }
+
     ret_os = osMutexAcquire(i2c->bus->mutex, osWaitForever);
     elab_assert(ret_os == osOK);
 
@@ -363,12 +444,6 @@ elab_err_t elab_i2c_write_memory(elab_device_t *me, uint8_t addr,
     }
 
     /* Transfer message. */
-    msg.write = true;
-    msg.len = size + 1;
-    msg.buffer = elab_malloc(msg.len);
-    elab_assert(msg.buffer != NULL);
-    msg.buffer[0] = addr;
-    memcpy(&msg.buffer[1], buff, size);
     ret = (elab_err_t)i2c->bus->ops->xfer(i2c->bus, i2c->config.addr, msg);
     if (ret == msg.len)
     {
@@ -381,15 +456,70 @@ elab_err_t elab_i2c_write_memory(elab_device_t *me, uint8_t addr,
     }
 
 exit:
-    if (msg.buffer != NULL)
-    {
-        elab_free(msg.buffer);
-    }
     ret_os = osMutexRelease(i2c->bus->mutex);
     elab_assert(ret_os == osOK);
     (void)ret_os;
+    if (num != 1 && msg.buffer != buff_stack)
+    {
+        elab_free(msg.buffer);
+    }
 
     return ret;
 }
 
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  The I2C device is always ready in the device framework.
+  */
+static elab_err_t _device_enable(elab_device_t *me, bool status)
+{
+    (void)me;
+    (void)status;
+
+    return ELAB_OK;
+}
+
+/**
+  * @brief  The I2C device reading function in the device framework.
+  * @retval Auctual read length or error ID.
+  */
+static int32_t _device_read(elab_device_t *me,
+                            uint32_t pos, void *buffer, uint32_t size)
+{
+    (void)pos;
+    elab_assert(size <= UINT16_MAX);
+
+    elab_i2c_msg_t msg =
+    {
+        .write = false, .len = (uint16_t)size, .buffer = (uint8_t *)buffer,
+    };
+    elab_err_t ret = elab_i2c_xfer(me, msg, osWaitForever);
+
+    return (ret == (elab_err_t)size) ? (int32_t)size : (int32_t)ret;
+}
+
+/**
+  * @brief  The I2C device writting function in the device framework.
+  * @retval Auctual write length or error ID.
+  */
+static int32_t _device_write(elab_device_t *me,
+                                uint32_t pos, const void *buffer, uint32_t size)
+{
+    elab_iovec_t iov = { .buffer = (void *)buffer, .size = size };
+
+    return _device_writev(me, pos, &iov, 1);
+}
+
+/**
+  * @brief  The I2C device vectored writting function in the device framework.
+  * @retval Auctual write length in total or error ID.
+  */
+static int32_t _device_writev(elab_device_t *me, uint32_t pos,
+                                const elab_iovec_t *iov, uint32_t num)
+{
+    (void)pos;
+
+    return (int32_t)elab_i2c_writev(me, iov, num, osWaitForever);
+}
+
 /* ----------------------------- end of file -------------------------------- */
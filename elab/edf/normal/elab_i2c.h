@@ -84,6 +84,9 @@ elab_err_t elab_i2c_read_memory(elab_device_t *me, uint8_t addr,
 elab_err_t elab_i2c_write_memory(elab_device_t *me, uint8_t addr,
                                     uint8_t *buff, uint16_t size,
                                     uint32_t timeout);
+elab_err_t elab_i2c_writev(elab_device_t *me,
+                            const elab_iovec_t *iov, uint32_t num,
+                            uint32_t timeout);
 #ifdef __cplusplus
 }
 #endif
@@ -6,6 +6,7 @@
 /* includes ----------------------------------------------------------------- */
 #include "elab_serial.h"
 #include "../../common/elab_assert.h"
+#include "../../common/elab_common.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -13,6 +14,21 @@ extern "C" {
 
 ELAB_TAG("Edf_Serial");
 
+/* private config ----------------------------------------------------------- */
+#define EDF_SERIAL_TX_WAITER_MAX            (0xffff)
+#define EDF_SERIAL_TX_CLOSE_TIMEOUT         (1000)
+
+#if defined(__linux__) || defined(_WIN32)
+/* The received data reaches the ring in batches with the latency of the host,
+   in which the shorter gap is not seen, so the gap is this at least. */
+#define EDF_SERIAL_FRAME_GAP_MIN_US         (10000)
+#else
+#define EDF_SERIAL_FRAME_GAP_MIN_US         (0)
+#endif
+
+/* The ring over 3/4 full is not writable. */
+#define EDF_SERIAL_TX_HIGH_WATER(_ring)     ((_ring)->capacity / 4 * 3)
+
 /* public function prototypes ----------------------------------------------- */
 void elab_device_unregister(elab_device_t *me);
 
@@ -22,7 +38,26 @@ static int32_t _device_read(elab_device_t *me,
                                 uint32_t pos, void *buffer, uint32_t size);
 static int32_t _device_write(elab_device_t *me,
                                 uint32_t pos, const void *buffer, uint32_t size);
+static int32_t _device_readv(elab_device_t *me, uint32_t pos,
+                                const elab_iovec_t *iov, uint32_t num);
+static int32_t _device_writev(elab_device_t *me, uint32_t pos,
+                                const elab_iovec_t *iov, uint32_t num);
+static uint8_t _device_get_events(elab_device_t *me);
+static void _device_flush(elab_device_t *me);
+static void _rx_resume(elab_serial_t *serial);
+static void _rx_overrun_drop(elab_serial_t *serial);
+static void _ring_new(elib_ring_t *ring, uint32_t size);
+static int32_t _tx_ring_put(elab_serial_t *serial,
+                            const elab_iovec_t *iov, uint32_t num);
+static void _tx_kick(elab_serial_t *serial);
+static void _tx_wait(elab_serial_t *serial, uint32_t timeout);
+static uint32_t _frame_gap_us(uint32_t gap_bits, uint32_t baudrate);
+static uint32_t _frame_byte_ns(elab_serial_attr_t *attr);
+static void _frame_end_put(elab_serial_t *serial, uint32_t pos);
+static uint32_t _frame_size(elab_serial_t *serial, uint32_t *wait_us);
+#if defined(__linux__) || defined(_WIN32)
 static void _thread_entry(void *parameter);
+#endif
 
 #if (ELAB_DEV_PALTFORM == ELAB_PALTFORM_POLL)
 static void _device_poll(elab_device_t *me);
@@ -34,6 +69,10 @@ static const elab_dev_ops_t _device_ops =
     .enable = _device_enable,
     .read = _device_read,
     .write = _device_write,
+    .readv = _device_readv,
+    .writev = _device_writev,
+    .get_events = _device_get_events,
+    .flush = _device_flush,
 #if (ELAB_DEV_PALTFORM == ELAB_PALTFORM_POLL)
     .poll = _device_poll,
 #endif
@@ -105,8 +144,35 @@ void elab_serial_register(elab_serial_t *serial, const char *name,
     elab_assert(serial->mutex_tx != NULL);
     serial->sem_tx = osSemaphoreNew(1, 0, NULL);
     elab_assert(serial->sem_tx != NULL);
-    serial->queue_rx = osMessageQueueNew(serial->attr.rx_bufsz, 1, NULL);
-    elab_assert(serial->queue_rx != NULL);
+    serial->mutex_rx = osMutexNew(NULL);
+    elab_assert(serial->mutex_rx != NULL);
+    serial->sem_rx = osSemaphoreNew(1, 0, NULL);
+    elab_assert(serial->sem_rx != NULL);
+    if (serial->ops->get_rx_dma != NULL)
+    {
+        /* The data is read from the DMA buffer of the driver in place. */
+        uint32_t size = 0;
+        void *buffer = serial->ops->get_rx_dma(serial, &size);
+        elab_assert(size <= 0x8000);
+        elib_ring_init(&serial->ring_rx, buffer, size);
+        serial->attr.rx_bufsz = size;
+    }
+    else
+    {
+        elab_assert(serial->attr.rx_bufsz != 0);
+        _ring_new(&serial->ring_rx, serial->attr.rx_bufsz);
+    }
+    if (serial->attr.tx_bufsz != 0)
+    {
+        /* The direction of RS485 can not follow the data sent in background. */
+        elab_assert(serial->attr.mode == ELAB_SERIAL_MODE_FULL_DUPLEX);
+#if defined(__linux__)
+        elab_assert(serial->ops->get_fd == NULL || serial->ops->writev != NULL);
+#endif
+        serial->sem_tx_ring = osSemaphoreNew(EDF_SERIAL_TX_WAITER_MAX, 0, NULL);
+        elab_assert(serial->sem_tx_ring != NULL);
+        _ring_new(&serial->ring_tx, serial->attr.tx_bufsz);
+    }
 
     /* The super class data */
     elab_device_t *device = &(serial->super);
@@ -128,8 +194,22 @@ void elab_serial_register(elab_serial_t *serial, const char *name,
 
     /* Apply buffer memory */
 #if defined(__linux__) || defined(_WIN32)
-    serial->thread_rx = osThreadNew(_thread_entry, serial, &thread_attr_serial_rx);
-    elab_assert(serial->thread_rx != NULL);
+    serial->sem_rx_free = osSemaphoreNew(1, 0, NULL);
+    elab_assert(serial->sem_rx_free != NULL);
+    bool thread_rx_used = (serial->ops->get_rx_dma == NULL) ? true : false;
+#if defined(__linux__)
+    /* The ports with file descriptors are received in the reactor thread. */
+    serial->reactor_slot = -1;
+    if (serial->ops->get_fd != NULL)
+    {
+        thread_rx_used = false;
+    }
+#endif
+    if (thread_rx_used)
+    {
+        serial->thread_rx = osThreadNew(_thread_entry, serial, &thread_attr_serial_rx);
+        elab_assert(serial->thread_rx != NULL);
+    }
 #endif
 }
 
@@ -146,9 +226,15 @@ void elab_serial_unregister(elab_serial_t *serial)
     osStatus_t ret_os = osOK;
 
 #if defined(__linux__) || defined(_WIN32)
-    ret_os = osThreadTerminate(serial->thread_rx);
+    if (serial->thread_rx != NULL)
+    {
+        ret_os = osThreadTerminate(serial->thread_rx);
+        elab_assert(ret_os == osOK);
+        serial->thread_rx = NULL;
+    }
+    ret_os = osSemaphoreDelete(serial->sem_rx_free);
     elab_assert(ret_os == osOK);
-    serial->thread_rx = NULL;
+    serial->sem_rx_free = NULL;
 #endif
 
     elab_device_lock(ELAB_DEVICE_CAST(serial));
@@ -162,9 +248,29 @@ void elab_serial_unregister(elab_serial_t *serial)
     elab_assert(ret_os == osOK);
     serial->sem_tx = NULL;
 
-    ret_os = osMessageQueueDelete(serial->queue_rx);
+    ret_os = osMutexDelete(serial->mutex_rx);
     elab_assert(ret_os == osOK);
-    serial->queue_rx = NULL;
+    serial->mutex_rx = NULL;
+
+    ret_os = osSemaphoreDelete(serial->sem_rx);
+    elab_assert(ret_os == osOK);
+    serial->sem_rx = NULL;
+
+    if (serial->ops->get_rx_dma == NULL)
+    {
+        elab_free(serial->ring_rx.buffer);
+    }
+    serial->ring_rx.buffer = NULL;
+
+    if (serial->ring_tx.buffer != NULL)
+    {
+        ret_os = osSemaphoreDelete(serial->sem_tx_ring);
+        elab_assert(ret_os == osOK);
+        serial->sem_tx_ring = NULL;
+
+        elab_free(serial->ring_tx.buffer);
+        serial->ring_tx.buffer = NULL;
+    }
 
     elab_device_unlock(ELAB_DEVICE_CAST(serial));
 
@@ -181,8 +287,193 @@ void elab_serial_tx_end(elab_serial_t *serial)
     elab_assert(serial != NULL);
     elab_assert(serial->sem_tx != NULL);
 
-    osStatus_t ret_os = osSemaphoreRelease(serial->sem_tx);
-    elab_assert(ret_os == osOK);
+    if (serial->ring_tx.buffer != NULL)
+    {
+        /* The next chunk is started here, or in the kicking loop if the chunk
+           is done in the driver writing function. */
+        __serial_tx_commit(serial, serial->tx_chunk, true);
+        if (__atomic_load_n(&serial->tx_in_write, __ATOMIC_SEQ_CST) == 0)
+        {
+            _tx_kick(serial);
+        }
+    }
+    else
+    {
+        osStatus_t ret_os = osSemaphoreRelease(serial->sem_tx);
+        elab_assert(ret_os == osOK);
+    }
+}
+
+/**
+  * @brief  Get the data in the tx ring as at most two segments, the one to the
+  *         end of the buffer and the wrapped one.
+  * @param  serial      elab serial device handle
+  * @param  iov         The segments, returned.
+  * @retval The number of the segments.
+  */
+uint32_t __serial_tx_segments(elab_serial_t *serial, elab_iovec_t iov[2])
+{
+    uint32_t num = 0;
+    uint32_t size = 0;
+    uint32_t count = elib_ring_count(&serial->ring_tx);
+    void *block = elib_ring_read_block(&serial->ring_tx, &size);
+
+    if (size != 0)
+    {
+        iov[num].buffer = block;
+        iov[num].size = size;
+        num ++;
+    }
+    if (count > size)
+    {
+        iov[num].buffer = serial->ring_tx.buffer;
+        iov[num].size = count - size;
+        num ++;
+    }
+
+    return num;
+}
+
+/**
+  * @brief  Give back the sent data of the tx ring, and wake up the threads
+  *         waiting for the space or the flushing.
+  * @param  serial      elab serial device handle
+  * @param  size        The sent size.
+  * @param  done        No data being sent in the driver any more.
+  * @retval None.
+  */
+void __serial_tx_commit(elab_serial_t *serial, uint32_t size, bool done)
+{
+    uint32_t high_water = EDF_SERIAL_TX_HIGH_WATER(&serial->ring_tx);
+    uint32_t count = elib_ring_count(&serial->ring_tx);
+
+    elib_ring_read_commit(&serial->ring_tx, size);
+    if (done)
+    {
+        __atomic_store_n(&serial->tx_busy, 0, __ATOMIC_SEQ_CST);
+    }
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    uint32_t waiting = __atomic_load_n(&serial->tx_waiting, __ATOMIC_SEQ_CST);
+    for (uint32_t i = 0; i < waiting; i ++)
+    {
+        osSemaphoreRelease(serial->sem_tx_ring);
+    }
+    if (count >= high_water && (count - size) < high_water)
+    {
+        /* Writable again. */
+        elab_device_poll_wake(&serial->super);
+    }
+}
+
+/**
+  * @brief  Wake up the reading thread waiting for the received data, and the
+  *         polling ones. Called after the data is put into the ring.
+  */
+void __serial_rx_notify(elab_serial_t *serial)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&serial->rx_waiting, __ATOMIC_SEQ_CST) != 0)
+    {
+        /* It is already released if failed, as a binary semaphore. */
+        osSemaphoreRelease(serial->sem_rx);
+    }
+    elab_device_poll_wake(&serial->super);
+}
+
+/**
+  * @brief  End the former frame at the beginning of one batch of the new data,
+  *         if the gap is seen before it. The batch is received at once, after
+  *         the former data, and is on the line for its transfer time before, so
+  *         the gap is the time before its first byte. Called by the receiving
+  *         side before the batch is notified.
+  * @param  serial      elab serial device handle.
+  * @param  pos         The ring position of the batch.
+  * @param  size        The batch size.
+  * @param  time_last   The time of the former data, in us.
+  * @param  time        The time of the batch, in us.
+  * @retval None.
+  */
+void __serial_rx_frame_gap(elab_serial_t *serial, uint32_t pos, uint32_t size,
+                            uint32_t time_last, uint32_t time)
+{
+    uint32_t gap_us = __atomic_load_n(&serial->frame_gap_us, __ATOMIC_RELAXED);
+
+    if (gap_us != 0)
+    {
+        uint64_t time_data = (uint64_t)size *
+                __atomic_load_n(&serial->frame_byte_ns, __ATOMIC_RELAXED) / 1000;
+        if ((uint64_t)(time - time_last) >= ((uint64_t)gap_us + time_data))
+        {
+            _frame_end_put(serial, pos);
+        }
+    }
+}
+
+/**
+  * @brief  The serial device rx idle line ISR function, which ends the frame
+  *         received. Called by the driver in the same context as receiving.
+  * @param  serial      elab serial device handle.
+  * @retval None.
+  */
+void elab_serial_isr_rx_idle(elab_serial_t *serial)
+{
+    elab_assert(serial != NULL);
+
+    if (serial->frame_gap_us != 0 &&
+        elab_device_is_enabled(&serial->super) &&
+        !elab_device_is_test_mode(&serial->super))
+    {
+        _frame_end_put(serial, serial->ring_rx.head);
+        __serial_rx_notify(serial);
+    }
+}
+
+/**
+  * @brief  The serial device rx DMA ISR function, called by the driver in the
+  *         half transfer, full transfer and idle line interrupts. The received
+  *         data is left in the DMA buffer and read there.
+  * @param  serial      elab serial device handle.
+  * @param  write_pos   The DMA writing position in the buffer, or the buffer
+  *                     size in the full transfer.
+  * @retval None.
+  */
+void elab_serial_isr_rx_dma(elab_serial_t *serial, uint32_t write_pos)
+{
+    elab_assert(serial != NULL);
+    elab_assert(serial->ops->get_rx_dma != NULL);
+    elab_assert(write_pos <= serial->ring_rx.capacity);
+
+    /* At most one buffer of data is received between two reports, so the new
+       data is the distance from the former position, and the full transfer
+       reported at the former position is one whole buffer. */
+    uint32_t size = (write_pos - serial->ring_rx.head) &
+                        (serial->ring_rx.capacity - 1);
+    if (size == 0 && write_pos == serial->ring_rx.capacity)
+    {
+        size = serial->ring_rx.capacity;
+    }
+    if (size == 0)
+    {
+        return;
+    }
+
+    if (elab_device_is_enabled(&serial->super) &&
+        !elab_device_is_test_mode(&serial->super))
+    {
+        /* The DMA may have overwritten the data not read yet, which is more
+           than the ring capacity then, and dropped by the reading side. The
+           half and full transfers may be in the middle of a frame, so the
+           frames are ended by the idle line only. */
+        elib_ring_write_commit(&serial->ring_rx, size);
+        __serial_rx_notify(serial);
+    }
+    else
+    {
+        /* Dropped as the rx ISR does, but the position is still followed. */
+        elib_ring_write_commit(&serial->ring_rx, size);
+        elib_ring_clear(&serial->ring_rx);
+    }
 }
 
 #if !defined(__linux__) && !defined(_WIN32)
@@ -199,17 +490,23 @@ void elab_serial_isr_rx(elab_serial_t *serial, void *buffer, uint32_t size)
     elab_assert(buffer != NULL);
     elab_assert(size != 0);
 
-    osStatus_t ret_os = osOK;
     uint8_t *buff = (uint8_t *)buffer;
-    if (!device_is_test_mode(&serial->parent))
+    if (!elab_device_is_test_mode(&serial->super))
     {
         if (elab_device_is_enabled(&serial->super))
         {
-            for (uint32_t i = 0; i < size; i ++)
+            uint32_t time = (uint32_t)elab_time_us();
+            uint32_t time_last = __atomic_exchange_n(&serial->rx_time_last, time,
+                                                        __ATOMIC_SEQ_CST);
+            __serial_rx_frame_gap(serial, serial->ring_rx.head, size, time_last, time);
+            /* The data over the free space of the full ring is dropped. */
+            uint32_t count = elib_ring_write(&serial->ring_rx, buff, size);
+            if (count < size)
             {
-                ret_os = osMessageQueuePut(serial->queue_rx, &buff[i], 0, 0);
-                elab_assert(ret_os == osOK);
+                __atomic_fetch_add(&serial->rx_dropped, (size - count),
+                                    __ATOMIC_RELAXED);
             }
+            __serial_rx_notify(serial);
         }
     }
 }
@@ -224,9 +521,30 @@ void elab_serial_isr_rx(elab_serial_t *serial, void *buffer, uint32_t size)
   */
 int32_t elab_serial_write(elab_device_t * const me, void *buff, uint32_t size)
 {
-    elab_assert(me != NULL);
     elab_assert(buff != NULL);
     elab_assert(size != 0);
+
+    elab_iovec_t iov = { .buffer = buff, .size = size };
+
+    return elab_serial_writev(me, &iov, 1);
+}
+
+/**
+  * @brief  elab serial device vectored write function. The segments are sent
+  *         one by one in one sending process, in which the serial is locked
+  *         and kept in tx mode, so the data from other threads can not be
+  *         inserted between them.
+  * @param  me      The elab device handle.
+  * @param  iov     The segments array.
+  * @param  num     The number of the segments.
+  * @retval Auctual write length in total or error ID.
+  */
+int32_t elab_serial_writev(elab_device_t * const me,
+                            const elab_iovec_t *iov, uint32_t num)
+{
+    elab_assert(me != NULL);
+    elab_assert(iov != NULL);
+    elab_assert(num != 0);
     elab_assert(elab_device_is_enabled(me));
 
     int32_t ret = ELAB_OK;
@@ -240,7 +558,12 @@ int32_t elab_serial_write(elab_device_t * const me, void *buff, uint32_t size)
     }
 
     /* If not in testing mode. */
-    if (!elab_device_is_test_mode(&serial->super))
+    if (!elab_device_is_test_mode(&serial->super) &&
+        serial->ring_tx.buffer != NULL)
+    {
+        ret = _tx_ring_put(serial, iov, num);
+    }
+    else if (!elab_device_is_test_mode(&serial->super))
     {
         /* Lock serial in the sending process to prevent data from being sent in
            other threads. */
@@ -253,17 +576,29 @@ int32_t elab_serial_write(elab_device_t * const me, void *buff, uint32_t size)
             serial->ops->set_tx(serial, true);
         }
 
-        /* Send data by the low level serial write function in non-block mode. */
-        ret = serial->ops->write(serial, buff, size);
-        if (ret < 0)
+        int32_t count = 0;
+        for (uint32_t i = 0; i < num; i ++)
         {
-            goto exit;
-        }
+            if (iov[i].size == 0)
+            {
+                continue;
+            }
 
-        /* Wait the send process to be completed, which is released in the function
-           dev_serial_tx_end. */
-        ret_os = osSemaphoreAcquire(serial->sem_tx, osWaitForever);
-        elab_assert(ret_os == osOK);
+            /* Send data by the low level serial write function in non-block
+               mode. */
+            ret = serial->ops->write(serial, iov[i].buffer, iov[i].size);
+            if (ret < 0)
+            {
+                goto exit;
+            }
+
+            /* Wait the send process to be completed, which is released in the
+               function dev_serial_tx_end. */
+            ret_os = osSemaphoreAcquire(serial->sem_tx, osWaitForever);
+            elab_assert(ret_os == osOK);
+            count += ret;
+        }
+        ret = count;
 
 exit:
         /* If RS485 mode, set to rx mode. */
@@ -275,9 +610,83 @@ exit:
         /* Unlock serial at the end of sending process. */
         ret_os = osMutexRelease(serial->mutex_tx);
         elab_assert(ret_os == osOK);
+
+        /* Ready for writing again. */
+        elab_device_poll_wake(me);
+    }
+
+    return ret;
+}
+
+/**
+  * @brief  Wait for all the written data to be sent.
+  * @param  me      The elab device handle.
+  * @param  timeout Timeout in ms.
+  * @retval ELAB_OK, or ELAB_ERR_TIMEOUT.
+  */
+elab_err_t elab_serial_flush(elab_device_t * const me, uint32_t timeout)
+{
+    elab_assert(me != NULL);
+
+    elab_err_t ret = ELAB_OK;
+    osStatus_t ret_os = osOK;
+    elab_serial_t *serial = (elab_serial_t *)me;
+
+    if (serial->ring_tx.buffer == NULL)
+    {
+        /* The blocking writing is done once the mutex is released. */
+        ret_os = osMutexAcquire(serial->mutex_tx, timeout);
+        if (ret_os != osOK)
+        {
+            ret = ELAB_ERR_TIMEOUT;
+            goto exit;
+        }
+        ret_os = osMutexRelease(serial->mutex_tx);
+        elab_assert(ret_os == osOK);
+        goto exit;
+    }
+
+    uint32_t time_start = osKernelGetTickCount();
+    while (elib_ring_count(&serial->ring_tx) != 0 ||
+            __atomic_load_n(&serial->tx_busy, __ATOMIC_SEQ_CST) != 0)
+    {
+        uint32_t time = timeout;
+        if (timeout != osWaitForever)
+        {
+            uint32_t time_elapsed = osKernelGetTickCount() - time_start;
+            if (time_elapsed >= timeout)
+            {
+                ret = ELAB_ERR_TIMEOUT;
+                break;
+            }
+            time = timeout - time_elapsed;
+        }
+        _tx_wait(serial, time);
+    }
+
+exit:
+    return ret;
+}
+
+/**
+  * @brief  Check the tx ring is over its high water or not, in which case the
+  *         writing thread should slow down, not to be blocked for the space.
+  * @param  me      The elab device handle.
+  * @retval True or false, always false without the tx ring.
+  */
+bool elab_serial_tx_over_high_water(elab_device_t * const me)
+{
+    elab_assert(me != NULL);
+
+    elab_serial_t *serial = (elab_serial_t *)me;
+    bool ret = false;
+
+    if (serial->ring_tx.buffer != NULL)
+    {
+        ret = (elib_ring_count(&serial->ring_tx) >=
+                EDF_SERIAL_TX_HIGH_WATER(&serial->ring_tx)) ? true : false;
     }
 
-exit1:
     return ret;
 }
 
@@ -290,26 +699,67 @@ exit1:
   */
 int32_t elab_serial_read(elab_device_t * const me, void *buff,
                             uint32_t size, uint32_t timeout)
+{
+    return elab_serial_read_range(me, buff, size, size, timeout);
+}
+
+/**
+  * @brief  elab serial device read function, which returns once at least
+  *         size_min bytes are read, with all the received data at most
+  *         size_max bytes copied at one time.
+  * @param  me          The elab device handle.
+  * @param  buffer      The pointer of buffer
+  * @param  size_min    The least read length.
+  * @param  size_max    The most read length, the buffer size.
+  * @param  timeout     Timeout in ms, in which less data may be read.
+  * @retval Auctual read length or error ID.
+  */
+int32_t elab_serial_read_range(elab_device_t * const me, void *buff,
+                                uint32_t size_min, uint32_t size_max,
+                                uint32_t timeout)
 {
     elab_assert(me != NULL);
     elab_assert(buff != NULL);
-    elab_assert(size != 0);
+    elab_assert(size_min != 0 && size_min <= size_max);
     elab_assert(elab_device_is_enabled(me));
 
     int32_t ret = ELAB_OK;
     osStatus_t ret_os = osOK;
     elab_serial_t *serial = (elab_serial_t *)me;
     elab_assert(serial->ops != NULL);
-    elab_assert(serial->ops->read != NULL);
+#if defined(__linux__) || defined(_WIN32)
+    elab_assert(serial->ops->read != NULL || serial->ops->get_rx_dma != NULL);
+#endif
 
     /* If not in testing mode. */
     if (!elab_device_is_test_mode(&serial->super))
     {
         uint32_t time_start = osKernelGetTickCount();
         uint32_t time = timeout;
-        for (uint32_t i = 0; i < size; i ++)
+        uint32_t count = 0;
+        while (1)
         {
-            if (timeout != osWaitForever && timeout != 0)
+            /* Get all the received data at one time, and only wait for the
+               data not arrived yet. The ring has only one consumer, so the
+               reading threads are serialized, but not in waiting. */
+            ret_os = osMutexAcquire(serial->mutex_rx, osWaitForever);
+            elab_assert(ret_os == osOK);
+            _rx_overrun_drop(serial);
+            count += elib_ring_read(&serial->ring_rx,
+                                    &((uint8_t *)buff)[count], (size_max - count));
+            if (elib_ring_count(&serial->ring_rx) != 0)
+            {
+                /* The data left is for the other reading threads. */
+                __serial_rx_notify(serial);
+            }
+            ret_os = osMutexRelease(serial->mutex_rx);
+            elab_assert(ret_os == osOK);
+            _rx_resume(serial);
+            if (count >= size_min || timeout == 0)
+            {
+                break;
+            }
+            if (timeout != osWaitForever)
             {
                 if ((osKernelGetTickCount() - time_start) < timeout)
                 {
@@ -317,44 +767,32 @@ int32_t elab_serial_read(elab_device_t * const me, void *buff,
                 }
                 else
                 {
-                    if (ret == ELAB_OK)
-                    {
-                        ret = ELAB_ERR_TIMEOUT;
-                    }
                     break;
                 }
             }
 
-            ret_os = osMessageQueueGet(serial->queue_rx,
-                                        &((uint8_t *)buff)[i], 0U, time);
-            if (ret_os == osErrorTimeout)
+            /* Either the waiting flag is seen by the producer, or the new data
+               is seen here, so no wakeup is lost. */
+            __atomic_fetch_add(&serial->rx_waiting, 1, __ATOMIC_SEQ_CST);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            if (elib_ring_count(&serial->ring_rx) == 0)
             {
-                if (ret == ELAB_OK)
-                {
-                    ret = ELAB_ERR_TIMEOUT;
-                }
-                break;
+                /* The semaphore may be released in the former waiting, which
+                   just leads to one more checking. */
+                osSemaphoreAcquire(serial->sem_rx, time);
             }
-            if (ret_os == osOK)
-            {
-                ret ++;
-                if (ret >= size)
-                {
-                    break;
-                }
-                else
-                {
-                    continue;
-                }
-            }
-            elab_assert(false);
+            __atomic_fetch_sub(&serial->rx_waiting, 1, __ATOMIC_SEQ_CST);
         }
+        ret = (count == 0) ? ELAB_ERR_TIMEOUT : (int32_t)count;
     }
     else
     {
 #if !defined(__linux__) && !defined(_WIN32)
-        /* Clear the queue for rx. */
-        ret_os = osMessageQueueReset(serial->queue_rx);
+        /* Clear the ring for rx. */
+        ret_os = osMutexAcquire(serial->mutex_rx, osWaitForever);
+        elab_assert(ret_os == osOK);
+        elib_ring_clear(&serial->ring_rx);
+        ret_os = osMutexRelease(serial->mutex_rx);
         elab_assert(ret_os == osOK);
 #endif
         if (timeout == osWaitForever)
@@ -375,6 +813,126 @@ int32_t elab_serial_read(elab_device_t * const me, void *buff,
         }
     }
 
+    return ret;
+}
+
+/**
+  * @brief  Set the framing of the received data by the inter-byte gap, in which
+  *         the frames are read by elab_serial_read_frame. Called before the
+  *         serial device is opened.
+  * @param  me          The elab device handle.
+  * @param  gap_bits    The gap in bit times, like 39 for 3.5 characters of
+  *                     Modbus RTU, or 0 for no framing. On the hosted ports,
+  *                     the gap is EDF_SERIAL_FRAME_GAP_MIN_US at least. In the
+  *                     rx DMA mode, the frames are ended by the idle line.
+  * @param  size_max    The most frame size, over which the data is split into
+  *                     frames even without the gap, not over the rx buffer.
+  * @retval None.
+  */
+void elab_serial_set_frame(elab_device_t * const me,
+                            uint32_t gap_bits, uint32_t size_max)
+{
+    elab_assert(me != NULL);
+    elab_assert(!elab_device_is_enabled(me));
+
+    elab_serial_t *serial = ELAB_SERIAL_CAST(me);
+    elab_assert(gap_bits == 0 ||
+                (size_max != 0 && size_max <= serial->ring_rx.capacity));
+
+    serial->frame_gap_bits = gap_bits;
+    serial->frame_size_max = size_max;
+    serial->frame_gap_us = _frame_gap_us(gap_bits, serial->attr.baud_rate);
+    serial->frame_byte_ns = _frame_byte_ns(&serial->attr);
+}
+
+/**
+  * @brief  elab serial device frame reading function, which returns one whole
+  *         frame split by the inter-byte gap. See elab_serial_set_frame.
+  * @param  me      The elab device handle.
+  * @param  buffer  The pointer of buffer
+  * @param  size    The buffer size, the part of the frame over which is dropped.
+  * @param  timeout Timeout in ms for the whole frame.
+  * @retval The frame size or error ID.
+  */
+int32_t elab_serial_read_frame(elab_device_t * const me, void *buff,
+                                uint32_t size, uint32_t timeout)
+{
+    elab_assert(me != NULL);
+    elab_assert(buff != NULL);
+    elab_assert(size != 0);
+    elab_assert(elab_device_is_enabled(me));
+
+    int32_t ret = ELAB_ERR_TIMEOUT;
+    osStatus_t ret_os = osOK;
+    elab_serial_t *serial = (elab_serial_t *)me;
+    elab_assert(serial->frame_gap_bits != 0);
+
+    /* No frame in testing mode, the same as the reading. */
+    if (elab_device_is_test_mode(&serial->super))
+    {
+        ret = elab_serial_read_range(me, buff, 1, size, timeout);
+        goto exit;
+    }
+
+    uint32_t time_start = osKernelGetTickCount();
+    while (1)
+    {
+        uint32_t wait_us = 0;
+        ret_os = osMutexAcquire(serial->mutex_rx, osWaitForever);
+        elab_assert(ret_os == osOK);
+        _rx_overrun_drop(serial);
+        uint32_t size_frame = _frame_size(serial, &wait_us);
+        if (size_frame != 0)
+        {
+            uint32_t count = elib_ring_read(&serial->ring_rx, buff,
+                                    (size_frame < size) ? size_frame : size);
+            elib_ring_read_commit(&serial->ring_rx, (size_frame - count));
+            ret = (int32_t)count;
+            if (elib_ring_count(&serial->ring_rx) != 0)
+            {
+                /* The data left is for the other reading threads. */
+                __serial_rx_notify(serial);
+            }
+        }
+        uint32_t count = elib_ring_count(&serial->ring_rx);
+        uint32_t end_head = __atomic_load_n(&serial->frame_end_head,
+                                            __ATOMIC_SEQ_CST);
+        ret_os = osMutexRelease(serial->mutex_rx);
+        elab_assert(ret_os == osOK);
+        if (size_frame != 0)
+        {
+            _rx_resume(serial);
+            break;
+        }
+
+        uint32_t time = osWaitForever;
+        if (timeout != osWaitForever)
+        {
+            uint32_t time_elapsed = osKernelGetTickCount() - time_start;
+            if (time_elapsed >= timeout)
+            {
+                break;
+            }
+            time = timeout - time_elapsed;
+        }
+        if (wait_us != 0 && ((wait_us + 999) / 1000) < time)
+        {
+            /* The frame ends if no more data in the rest of the gap. */
+            time = (wait_us + 999) / 1000;
+        }
+
+        /* The same waiting as the reading, woken up by the new data or the
+           new end of frame. */
+        __atomic_fetch_add(&serial->rx_waiting, 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (elib_ring_count(&serial->ring_rx) == count &&
+            __atomic_load_n(&serial->frame_end_head, __ATOMIC_SEQ_CST) == end_head)
+        {
+            osSemaphoreAcquire(serial->sem_rx, time);
+        }
+        __atomic_fetch_sub(&serial->rx_waiting, 1, __ATOMIC_SEQ_CST);
+    }
+
 exit:
     return ret;
 }
@@ -405,6 +963,11 @@ void elab_serial_set_attr(elab_device_t *me, elab_serial_attr_t *attr)
         if (ret == ELAB_OK)
         {
             memcpy(&serial->attr, attr, sizeof(elab_serial_attr_t));
+            __atomic_store_n(&serial->frame_gap_us,
+                    _frame_gap_us(serial->frame_gap_bits, attr->baud_rate),
+                    __ATOMIC_RELAXED);
+            __atomic_store_n(&serial->frame_byte_ns, _frame_byte_ns(attr),
+                                __ATOMIC_RELAXED);
         }
     }
     elab_device_unlock(serial);
@@ -432,6 +995,19 @@ elab_serial_attr_t elab_serial_get_attr(elab_device_t *me)
     return attr;
 }
 
+/**
+  * @brief  Get the count of the received bytes dropped, as they are overwritten
+  *         by the rx DMA before read, or over the full rx ring in the ISR.
+  * @param  me          The elab device handle.
+  * @retval The dropped bytes since the registering.
+  */
+uint32_t elab_serial_get_rx_dropped(elab_device_t * const me)
+{
+    elab_assert(me != NULL);
+
+    return __atomic_load_n(&ELAB_SERIAL_CAST(me)->rx_dropped, __ATOMIC_RELAXED);
+}
+
 /**
   * @brief  Set the serial device baudrate.
   * @param  dev         The device handle.
@@ -486,7 +1062,10 @@ int32_t elab_serial_xfer(elab_device_t *me,
     elab_assert(size_rx != 0);
     elab_assert(ELAB_SERIAL_CAST(me)->ops != NULL);
     elab_assert(ELAB_SERIAL_CAST(me)->ops->write != NULL);
-    elab_assert(ELAB_SERIAL_CAST(me)->ops->read != NULL);
+#if defined(__linux__) || defined(_WIN32)
+    elab_assert(ELAB_SERIAL_CAST(me)->ops->read != NULL ||
+                ELAB_SERIAL_CAST(me)->ops->get_rx_dma != NULL);
+#endif
 
     elab_serial_t *serial = ELAB_SERIAL_CAST(me);
     elab_assert(serial->attr.mode == ELAB_SERIAL_MODE_HALF_DUPLEX);
@@ -531,7 +1110,38 @@ static elab_err_t _device_enable(elab_device_t *me, bool status)
     elab_assert(serial->ops != NULL);
     elab_assert(serial->ops->enable != NULL);
 
-    return serial->ops->enable(serial, status);
+    if (status && serial->ops->get_rx_dma != NULL)
+    {
+        /* The DMA starts from the beginning of the buffer again. */
+        elib_ring_init(&serial->ring_rx, serial->ring_rx.buffer,
+                        serial->ring_rx.capacity);
+    }
+    if (status)
+    {
+        /* The frames start from the data received after opening. */
+        serial->frame_end_head = 0;
+        serial->frame_end_tail = 0;
+        serial->frame_end_last = serial->ring_rx.head;
+        serial->rx_time_last = (uint32_t)elab_time_us();
+    }
+
+#if defined(__linux__)
+    /* The closed port leaves the reactor before its file descriptor is closed,
+       and the opened one joins it after. */
+    if (serial->ops->get_fd != NULL && !status)
+    {
+        __serial_reactor_remove(serial);
+    }
+#endif
+    ret = serial->ops->enable(serial, status);
+#if defined(__linux__)
+    if (serial->ops->get_fd != NULL && status && ret == ELAB_OK)
+    {
+        __serial_reactor_add(serial);
+    }
+#endif
+
+    return ret;
 }
 
 /**
@@ -566,6 +1176,397 @@ static int32_t _device_write(elab_device_t *me,
     return elab_serial_write(me, (void *)buffer, size);
 }
 
+/**
+  * @brief  elab device vectored read function, the segments are filled one by
+  *         one.
+  * @param  me      The elab device handle.
+  * @param  pos     Position
+  * @param  iov     The segments array.
+  * @param  num     The number of the segments.
+  * @retval Auctual read length in total
+  */
+static int32_t _device_readv(elab_device_t *me, uint32_t pos,
+                                const elab_iovec_t *iov, uint32_t num)
+{
+    (void)pos;
+
+    int32_t count = 0;
+    for (uint32_t i = 0; i < num; i ++)
+    {
+        if (iov[i].size == 0)
+        {
+            continue;
+        }
+
+        int32_t ret = elab_serial_read(me, iov[i].buffer, iov[i].size,
+                                        osWaitForever);
+        if (ret < 0)
+        {
+            count = (count == 0) ? ret : count;
+            break;
+        }
+        count += ret;
+    }
+
+    return count;
+}
+
+/**
+  * @brief  elab device vectored write function.
+  * @param  me      The elab device handle.
+  * @param  pos     Position
+  * @param  iov     The segments array.
+  * @param  num     The number of the segments.
+  * @retval Auctual write length in total
+  */
+static int32_t _device_writev(elab_device_t *me, uint32_t pos,
+                                const elab_iovec_t *iov, uint32_t num)
+{
+    (void)pos;
+
+    return elab_serial_writev(me, iov, num);
+}
+
+
+/**
+  * @brief  elab device events function, readable if any data received, and
+  *         writable if not in sending.
+  * @param  me      The elab device handle.
+  * @retval See elab_device_event.
+  */
+static uint8_t _device_get_events(elab_device_t *me)
+{
+    elab_serial_t *serial = (elab_serial_t *)me;
+    uint8_t events = 0;
+
+    if (elib_ring_count(&serial->ring_rx) != 0)
+    {
+        events |= ELAB_DEVICE_EV_READ;
+    }
+    if (serial->ring_tx.buffer != NULL)
+    {
+        if (!elab_serial_tx_over_high_water(me))
+        {
+            events |= ELAB_DEVICE_EV_WRITE;
+        }
+    }
+    else if (osMutexGetOwner(serial->mutex_tx) == NULL)
+    {
+        events |= ELAB_DEVICE_EV_WRITE;
+    }
+
+    return events;
+}
+
+/**
+  * @brief  elab device flush function in the last closing, the data in the tx
+  *         ring not sent in time is dropped.
+  * @param  me      The elab device handle.
+  * @retval None.
+  */
+static void _device_flush(elab_device_t *me)
+{
+    elab_serial_t *serial = (elab_serial_t *)me;
+
+    if (serial->ring_tx.buffer != NULL &&
+        elab_serial_flush(me, EDF_SERIAL_TX_CLOSE_TIMEOUT) != ELAB_OK)
+    {
+        elog_warn("The data of serial %s is not sent before closing.",
+                    me->attr.name);
+    }
+}
+
+/**
+  * @brief  Wake up the rx thread or the reactor waiting for the free space once
+  *         half of the ring is free, to avoid waking it up for every byte.
+  *         Called after the data is read from the ring.
+  */
+static void _rx_resume(elab_serial_t *serial)
+{
+#if defined(__linux__) || defined(_WIN32)
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&serial->rx_full, __ATOMIC_SEQ_CST) == 0 ||
+        elib_ring_free_size(&serial->ring_rx) < (serial->ring_rx.capacity / 2))
+    {
+        return;
+    }
+
+#if defined(__linux__)
+    if (serial->thread_rx == NULL)
+    {
+        /* Only one of the reactor and the reading thread resumes the port. */
+        if (__atomic_exchange_n(&serial->rx_full, 0, __ATOMIC_SEQ_CST) != 0)
+        {
+            __serial_reactor_resume(serial);
+        }
+        return;
+    }
+#endif
+    osSemaphoreRelease(serial->sem_rx_free);
+#else
+    (void)serial;
+#endif
+}
+
+/**
+  * @brief  Create the ring buffer in the size of power of 2.
+  */
+static void _ring_new(elib_ring_t *ring, uint32_t size)
+{
+    uint32_t capacity = 1;
+    while (capacity < size)
+    {
+        capacity <<= 1;
+    }
+    void *buffer = elab_malloc(capacity);
+    elab_assert(buffer != NULL);
+    elib_ring_init(ring, buffer, capacity);
+}
+
+/**
+  * @brief  Put the segments into the tx ring, and start sending them if the
+  *         driver is idle. Only blocked when the ring is full.
+  * @retval The written size.
+  */
+static int32_t _tx_ring_put(elab_serial_t *serial,
+                            const elab_iovec_t *iov, uint32_t num)
+{
+    int32_t count = 0;
+
+    /* The ring has only one producer, and the data of one writing is kept
+       together in it. */
+    osStatus_t ret_os = osMutexAcquire(serial->mutex_tx, osWaitForever);
+    elab_assert(ret_os == osOK);
+
+    for (uint32_t i = 0; i < num; i ++)
+    {
+        const uint8_t *buffer = (const uint8_t *)iov[i].buffer;
+        uint32_t size = 0;
+        while (size < iov[i].size)
+        {
+            size += elib_ring_write(&serial->ring_tx, &buffer[size],
+                                    (iov[i].size - size));
+            if (size < iov[i].size)
+            {
+                _tx_kick(serial);
+                _tx_wait(serial, osWaitForever);
+            }
+        }
+        count += (int32_t)size;
+    }
+    _tx_kick(serial);
+
+    ret_os = osMutexRelease(serial->mutex_tx);
+    elab_assert(ret_os == osOK);
+
+    return count;
+}
+
+/**
+  * @brief  Start sending the data in the tx ring if the driver is idle. In the
+  *         reactor mode, it is sent in the reactor. Otherwise, the chunk is
+  *         sent by the driver writing function, and the next one is started
+  *         in elab_serial_tx_end, or here if it is done in the writing function.
+  */
+static void _tx_kick(elab_serial_t *serial)
+{
+    uint32_t busy = 0;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#if defined(__linux__)
+    if (serial->ops->get_fd != NULL)
+    {
+        if (elib_ring_count(&serial->ring_tx) != 0 &&
+            __atomic_compare_exchange_n(&serial->tx_busy, &busy, 1, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+        {
+            __serial_reactor_kick_tx(serial);
+        }
+        return;
+    }
+#endif
+
+    while (elib_ring_count(&serial->ring_tx) != 0 &&
+            __atomic_compare_exchange_n(&serial->tx_busy, &busy, 1, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+    {
+        uint32_t size = 0;
+        void *block = elib_ring_read_block(&serial->ring_tx, &size);
+        serial->tx_chunk = size;
+        __atomic_store_n(&serial->tx_in_write, 1, __ATOMIC_SEQ_CST);
+        int32_t ret = serial->ops->write(serial, block, size);
+        __atomic_store_n(&serial->tx_in_write, 0, __ATOMIC_SEQ_CST);
+        if (ret < 0)
+        {
+            /* The chunk is dropped, not to block the writing threads. */
+            elog_error("Serial %s sending fails.", serial->super.attr.name);
+            __serial_tx_commit(serial, size, true);
+        }
+        busy = 0;
+    }
+}
+
+/**
+  * @brief  Wait for the tx ring to be changed, the space freed or the chunk
+  *         sent, which may be woken up for the former changing as well. Not
+  *         blocked if all the data is sent, as nothing changes it any more.
+  */
+static void _tx_wait(elab_serial_t *serial, uint32_t timeout)
+{
+    uint32_t count = elib_ring_count(&serial->ring_tx);
+    uint32_t busy = __atomic_load_n(&serial->tx_busy, __ATOMIC_SEQ_CST);
+
+    __atomic_fetch_add(&serial->tx_waiting, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if ((count != 0 || busy != 0) &&
+        elib_ring_count(&serial->ring_tx) == count &&
+        __atomic_load_n(&serial->tx_busy, __ATOMIC_SEQ_CST) == busy)
+    {
+        osSemaphoreAcquire(serial->sem_tx_ring, timeout);
+    }
+    __atomic_fetch_sub(&serial->tx_waiting, 1, __ATOMIC_SEQ_CST);
+}
+
+/**
+  * @brief  The inter-byte gap in us, at least 1 us, or the latency of the host.
+  */
+static uint32_t _frame_gap_us(uint32_t gap_bits, uint32_t baudrate)
+{
+    uint64_t gap_us = 0;
+
+    if (gap_bits != 0)
+    {
+        gap_us = ((uint64_t)gap_bits * 1000000 + baudrate - 1) / baudrate;
+        if (gap_us < EDF_SERIAL_FRAME_GAP_MIN_US)
+        {
+            gap_us = EDF_SERIAL_FRAME_GAP_MIN_US;
+        }
+    }
+
+    return (uint32_t)gap_us;
+}
+
+/**
+  * @brief  The transfer time of one character in ns, with the start bit, the
+  *         parity bit and the stop bits.
+  */
+static uint32_t _frame_byte_ns(elab_serial_attr_t *attr)
+{
+    uint32_t bits = 1 + attr->data_bits +
+                    ((attr->parity != ELAB_SERIAL_PARITY_NONE) ? 1 : 0) +
+                    ((attr->stop_bits == ELAB_SERIAL_STOP_BITS_2) ? 2 : 1);
+
+    return (uint32_t)((uint64_t)bits * 1000000000 / attr->baud_rate);
+}
+
+/**
+  * @brief  Drop all the data not read yet, once the rx DMA has overwritten it
+  *         in part, as the order of it is broken. Only the reading side moves
+  *         the ring tail. Called with the rx mutex held.
+  */
+static void _rx_overrun_drop(elab_serial_t *serial)
+{
+    uint32_t head = __atomic_load_n(&serial->ring_rx.head, __ATOMIC_ACQUIRE);
+    uint32_t count = head - serial->ring_rx.tail;
+
+    if (count > serial->ring_rx.capacity)
+    {
+        __atomic_store_n(&serial->ring_rx.tail, head, __ATOMIC_RELEASE);
+        __atomic_fetch_add(&serial->rx_dropped, count, __ATOMIC_RELAXED);
+        elog_warn("Serial %s rx overrun, %u bytes dropped.",
+                    serial->super.attr.name, (unsigned)count);
+    }
+}
+
+/**
+  * @brief  End the frame at the given position of the received data, if any
+  *         data is received after the former end. Called by the receiving side.
+  */
+static void _frame_end_put(elab_serial_t *serial, uint32_t pos)
+{
+    if (pos != serial->frame_end_last)
+    {
+        uint32_t head = serial->frame_end_head;
+        uint32_t tail = __atomic_load_n(&serial->frame_end_tail, __ATOMIC_SEQ_CST);
+        if ((head - tail) < ELAB_SERIAL_FRAME_END_MAX)
+        {
+            serial->frame_end[head % ELAB_SERIAL_FRAME_END_MAX] = pos;
+            __atomic_store_n(&serial->frame_end_head, (head + 1), __ATOMIC_SEQ_CST);
+        }
+        serial->frame_end_last = pos;
+    }
+}
+
+/**
+  * @brief  Get the size of the first whole frame in the rx ring, ended by the
+  *         receiving side, or by the gap passed after the last data, or by the
+  *         most frame size. Called with the rx mutex held.
+  * @param  wait_us     The rest of the gap, if the frame is not ended yet.
+  * @retval The frame size, or 0 if no whole frame.
+  */
+static uint32_t _frame_size(elab_serial_t *serial, uint32_t *wait_us)
+{
+    uint32_t size = 0;
+    uint32_t tail = serial->ring_rx.tail;
+    uint32_t end_head = 0;
+
+    do
+    {
+        size = 0;
+        *wait_us = 0;
+
+        /* The ends in the data read already are skipped. */
+        end_head = __atomic_load_n(&serial->frame_end_head, __ATOMIC_SEQ_CST);
+        while (size == 0 && serial->frame_end_tail != end_head)
+        {
+            uint32_t end = serial->frame_end[serial->frame_end_tail %
+                                                ELAB_SERIAL_FRAME_END_MAX];
+            if ((int32_t)(end - tail) > 0)
+            {
+                size = end - tail;
+            }
+            else
+            {
+                __atomic_store_n(&serial->frame_end_tail,
+                                    (serial->frame_end_tail + 1), __ATOMIC_SEQ_CST);
+            }
+        }
+        if (size != 0)
+        {
+            break;
+        }
+
+        /* The time is recorded before the data is put, so the gap is checked
+           with the time of the last data, or later. Not in the DMA mode, in
+           which the last frame is ended by the idle line too. */
+        uint32_t count = elib_ring_count(&serial->ring_rx);
+        if (count != 0 && serial->ops->get_rx_dma == NULL)
+        {
+            uint32_t time_last = __atomic_load_n(&serial->rx_time_last,
+                                                    __ATOMIC_SEQ_CST);
+            uint32_t time_gap = (uint32_t)elab_time_us() - time_last;
+            if (time_gap >= serial->frame_gap_us)
+            {
+                size = count;
+            }
+            else
+            {
+                *wait_us = serial->frame_gap_us - time_gap;
+            }
+        }
+        if (count >= serial->frame_size_max)
+        {
+            size = count;
+        }
+    } while (__atomic_load_n(&serial->frame_end_head, __ATOMIC_SEQ_CST) != end_head);
+
+    if (size > serial->frame_size_max)
+    {
+        size = serial->frame_size_max;
+    }
+
+    return size;
+}
 
 /**
   * @brief  The entry function for serial device data receiving.
@@ -578,22 +1579,68 @@ static void _thread_entry(void *parameter)
     elab_assert(serial->ops != NULL);
     elab_assert(serial->ops->read != NULL);
 
-    uint8_t data;
     int32_t ret = 0;
-    osStatus_t ret_os = osOK;
+
+    /* The data received at once may be read in parts limited by the free block
+       of the ring, which are checked for the gap as one batch. */
+    uint32_t batch_pos = 0;
+    uint32_t batch_size = 0;
+    uint32_t batch_time_last = 0;
 
     while (1)
     {
         if (elab_device_is_enabled(&serial->super) &&
             !elab_device_is_test_mode(&serial->super))
         {
-            ret = serial->ops->read(serial, &data, 1);
-            elab_assert(ret == 1);
-            ret_os = osMessageQueuePut(serial->queue_rx, &data, 0, osWaitForever);
-            elab_assert(ret_os == osOK);
+            /* The data is read into the free space of the ring directly, as
+               much as the driver has. */
+            uint32_t size = 0;
+            void *block = elib_ring_write_block(&serial->ring_rx, &size);
+            if (size == 0)
+            {
+                /* Full, waiting for the data to be read, in the same way as
+                   the reading thread waits for the data. */
+                __atomic_store_n(&serial->rx_full, 1, __ATOMIC_SEQ_CST);
+                __atomic_thread_fence(__ATOMIC_SEQ_CST);
+                if (elib_ring_free_size(&serial->ring_rx) == 0)
+                {
+                    osSemaphoreAcquire(serial->sem_rx_free, 10);
+                }
+                __atomic_store_n(&serial->rx_full, 0, __ATOMIC_SEQ_CST);
+                continue;
+            }
+            ret = serial->ops->read(serial, block, size);
+            elab_assert(ret > 0 && ret <= (int32_t)size);
+            uint32_t time = (uint32_t)elab_time_us();
+            uint32_t time_last = __atomic_exchange_n(&serial->rx_time_last, time,
+                                                        __ATOMIC_SEQ_CST);
+            if (batch_size != 0 &&
+                (time - time_last) >= __atomic_load_n(&serial->frame_gap_us,
+                                                        __ATOMIC_RELAXED))
+            {
+                /* Waited for the data, so the former part was the whole. */
+                __serial_rx_frame_gap(serial, batch_pos, batch_size,
+                                        batch_time_last, time_last);
+                batch_size = 0;
+            }
+            if (batch_size == 0)
+            {
+                batch_pos = serial->ring_rx.head;
+                batch_time_last = time_last;
+            }
+            batch_size += (uint32_t)ret;
+            if ((uint32_t)ret < size)
+            {
+                __serial_rx_frame_gap(serial, batch_pos, batch_size,
+                                        batch_time_last, time);
+                batch_size = 0;
+            }
+            elib_ring_write_commit(&serial->ring_rx, (uint32_t)ret);
+            __serial_rx_notify(serial);
         }
         else
         {
+            batch_size = 0;
             osDelay(10);
         }
     }
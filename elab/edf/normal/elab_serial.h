@@ -9,6 +9,7 @@
 /* includes ----------------------------------------------------------------- */
 #include "../elab_device.h"
 #include "../../os/cmsis_os.h"
+#include "../../elib/elib_ring.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -52,8 +53,14 @@ enum elab_serail_mode
     ELAB_SERIAL_MODE_FULL_DUPLEX,                   /* Full / half duplex */   \
     0,                                                                         \
     256,                                            /* rx buffer size */       \
+    0,                                              /* No tx ring */           \
+    0,                                                                         \
 }
 
+/* The ends of the received frames not read yet, more of which are dropped and
+   the frames are merged. */
+#define ELAB_SERIAL_FRAME_END_MAX                   (8)
+
 /* public types ------------------------------------------------------------- */
 typedef struct elab_serial_attr
 {
@@ -64,6 +71,8 @@ typedef struct elab_serial_attr
     uint32_t mode                       : 1;
     uint32_t reserved                   : 7;
     uint32_t rx_bufsz                   : 16;
+    uint32_t tx_bufsz                   : 16;       /* 0, writing blocked */
+    uint32_t reserved_ext               : 16;
 } elab_serial_attr_t;
 
 typedef struct elab_serial_config
@@ -81,11 +90,52 @@ typedef struct elab_serail
     elab_device_t super;
 
 #if defined(__linux__) || defined(_WIN32)
-    osThreadId_t thread_rx;
+    osThreadId_t thread_rx;                     /* NULL in the reactor mode */
+    osSemaphoreId_t sem_rx_free;
+    uint32_t rx_full;
+#endif
+#if defined(__linux__)
+    int32_t reactor_slot;
 #endif
     osMutexId_t mutex_tx;
     osSemaphoreId_t sem_tx;
-    osMessageQueueId_t queue_rx;
+
+    /* The received data is put into the byte ring by the rx thread or ISR, and
+       the reading threads waiting for more data, counted in rx_waiting, are
+       woken up by the semaphore. */
+    osMutexId_t mutex_rx;
+    osSemaphoreId_t sem_rx;
+    elib_ring_t ring_rx;
+    uint32_t rx_waiting;
+    uint32_t rx_dropped;                        /* Overrun, or the ring full */
+
+    /* The optional tx ring. The writing threads just put the data into it, and
+       the driver sends it chunk by chunk, the next one started in the tx end
+       callback of the former one, or in the reactor. The threads waiting for
+       the free space or the flushing, counted in tx_waiting, are woken up by
+       the semaphore. */
+    osSemaphoreId_t sem_tx_ring;
+    elib_ring_t ring_tx;
+    uint32_t tx_waiting;
+    uint32_t tx_busy;
+    uint32_t tx_chunk;
+    uint32_t tx_in_write;
+
+    /* The optional framing of the received data by the inter-byte gap. The
+       ends of the frames are put into frame_end by the receiving side, once
+       the gap is seen before the new data, or the driver reports the idle
+       line. The last frame is ended by the reading side in the gap timeout
+       after rx_time_last, except in the rx DMA mode. The gap before the new data excludes the transfer
+       time of it, frame_byte_ns each byte. */
+    uint32_t frame_gap_bits;
+    uint32_t frame_gap_us;
+    uint32_t frame_byte_ns;
+    uint32_t frame_size_max;
+    uint32_t frame_end[ELAB_SERIAL_FRAME_END_MAX];
+    uint32_t frame_end_head;                    /* Atomic, the receiving side */
+    uint32_t frame_end_tail;                    /* The reading side */
+    uint32_t frame_end_last;
+    uint32_t rx_time_last;                      /* Atomic, in us */
 
     const struct elab_serial_ops *ops;
     elab_serial_attr_t attr;
@@ -95,9 +145,28 @@ typedef struct elab_serial_ops
 {
     elab_err_t (* enable)(elab_serial_t *serial, bool status);
 #if defined(__linux__) || defined(_WIN32)
+    /* Blocking until any data is received, and return the data available at
+       most the given size, instead of waiting for all of it. */
     int32_t (* read)(elab_serial_t *serial, void *buffer, uint32_t size);
+#endif
     int32_t (* write)(elab_serial_t *serial, const void *buffer, uint32_t size);
+#if defined(__linux__)
+    /* Optional, the file descriptor of the opened port. With it, the port is
+       received by the reactor thread of all the ports instead of its own rx
+       thread, and the read function should be non-blocking then, returning 0
+       if no data. */
+    int (* get_fd)(elab_serial_t *serial);
+    /* Needed with get_fd and the tx ring, the non-blocking vectored writing,
+       returning the written size, or 0 if the port is busy. */
+    int32_t (* writev)(elab_serial_t *serial, const elab_iovec_t *iov, uint32_t num);
 #endif
+    /* Optional, the circular rx DMA buffer owned by the driver, in power of 2
+       size. With it, the buffer is the rx ring itself, and the driver reports
+       the DMA writing position by elab_serial_isr_rx_dma, instead of reading
+       or calling elab_serial_isr_rx, in the half transfer, the full transfer
+       and the idle line at least. The DMA starts from the beginning of the
+       buffer in every enabling. */
+    void *(* get_rx_dma)(elab_serial_t *serial, uint32_t *size);
     void (* set_tx)(elab_serial_t *serial, bool status);
     elab_err_t (* config)(elab_serial_t *serial, elab_serial_config_t *config);
 } elab_serial_ops_t;
@@ -111,6 +180,8 @@ void elab_serial_register(elab_serial_t *serial, const char *name,
                             void *user_data);
 void elab_serial_unregister(elab_serial_t *serial);
 void elab_serial_tx_end(elab_serial_t *serial);
+void elab_serial_isr_rx_idle(elab_serial_t *serial);
+void elab_serial_isr_rx_dma(elab_serial_t *serial, uint32_t write_pos);
 
 #if !defined(__linux__) && !defined(_WIN32)
 void elab_serial_isr_rx(elab_serial_t *serial, void *buffer, uint32_t size);
@@ -118,11 +189,23 @@ void elab_serial_isr_rx(elab_serial_t *serial, void *buffer, uint32_t size);
 
 /* For high level program. */
 int32_t elab_serial_write(elab_device_t * const me, void *buff, uint32_t size);
+int32_t elab_serial_writev(elab_device_t * const me,
+                            const elab_iovec_t *iov, uint32_t num);
+elab_err_t elab_serial_flush(elab_device_t * const me, uint32_t timeout);
+bool elab_serial_tx_over_high_water(elab_device_t * const me);
 int32_t elab_serial_read(elab_device_t * const me, void *buff,
                             uint32_t size, uint32_t timeout);
+int32_t elab_serial_read_range(elab_device_t * const me, void *buff,
+                                uint32_t size_min, uint32_t size_max,
+                                uint32_t timeout);
+void elab_serial_set_frame(elab_device_t * const me,
+                            uint32_t gap_bits, uint32_t size_max);
+int32_t elab_serial_read_frame(elab_device_t * const me, void *buff,
+                                uint32_t size, uint32_t timeout);
 void elab_serial_set_baudrate(elab_device_t * const me, uint32_t baudrate);
 void elab_serial_set_attr(elab_device_t * const me, elab_serial_attr_t *attr);
 elab_serial_attr_t elab_serial_get_attr(elab_device_t * const me);
+uint32_t elab_serial_get_rx_dropped(elab_device_t * const me);
 
 /* TODO Just for half duplex mode. */
 int32_t elab_serial_xfer(elab_device_t *me,
@@ -130,6 +213,19 @@ int32_t elab_serial_xfer(elab_device_t *me,
                             void *buff_rx, uint32_t size_rx,
                             uint32_t timeout);
 
+/* private function --------------------------------------------------------- */
+void __serial_rx_notify(elab_serial_t *serial);
+void __serial_rx_frame_gap(elab_serial_t *serial, uint32_t pos, uint32_t size,
+                            uint32_t time_last, uint32_t time);
+uint32_t __serial_tx_segments(elab_serial_t *serial, elab_iovec_t iov[2]);
+void __serial_tx_commit(elab_serial_t *serial, uint32_t size, bool done);
+#if defined(__linux__)
+void __serial_reactor_add(elab_serial_t *serial);
+void __serial_reactor_remove(elab_serial_t *serial);
+void __serial_reactor_resume(elab_serial_t *serial);
+void __serial_reactor_kick_tx(elab_serial_t *serial);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,415 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+#if defined(__linux__)
+
+/* includes ----------------------------------------------------------------- */
+#include <sys/epoll.h>
+#include <errno.h>
+#include <pthread.h>
+#include "elab_serial.h"
+#include "../../common/elab_assert.h"
+#include "../../common/elab_common.h"
+#include "../../common/elab_log.h"
+
+ELAB_TAG("Edf_SerialReactor");
+
+/* private config ----------------------------------------------------------- */
+#define EDF_REACTOR_PORT_MAX                (64)
+#define EDF_REACTOR_EVENT_MAX               (16)
+#define EDF_REACTOR_STACK_SIZE              (4096)
+#define EDF_REACTOR_DISCARD_SIZE            (256)
+
+/* private typedef ---------------------------------------------------------- */
+/*
+ * The only one thread receiving all the serial ports with file descriptors.
+ * Every opened port is in the epoll set with one slot, and the ready ones are
+ * read into their rx rings in bulk, and the data in their tx rings is sent in
+ * the vectored writing. The events of one port are decided by its flags, not
+ * reading when the rx ring is full, and writing when the tx ring is busy. The
+ * slot and its generation, instead of the port, are given to the epoll set,
+ * so the event of one removed port in the same epoll waiting is just dropped,
+ * even if the slot is taken by another port then. The slots are protected by
+ * the reactor mutex, which is also held in handling the events, so the port
+ * is not read any more once it is removed.
+ */
+typedef struct elab_serial_reactor
+{
+    osThreadId_t thread;
+    osMutexId_t mutex;
+    int fd_epoll;
+    elab_serial_t *port[EDF_REACTOR_PORT_MAX];
+    uint32_t gen[EDF_REACTOR_PORT_MAX];         /* Counted in every adding */
+} elab_serial_reactor_t;
+
+/* private function prototypes ---------------------------------------------- */
+static void _reactor_init(void);
+static uint64_t _reactor_data(int32_t slot);
+static void _reactor_update(elab_serial_t *serial);
+static void _reactor_ctl(elab_serial_t *serial, uint32_t events);
+static void _reactor_read(elab_serial_t *serial, uint32_t events);
+static void _reactor_write(elab_serial_t *serial);
+static void _entry_reactor(void *para);
+
+/* private variables -------------------------------------------------------- */
+static elab_serial_reactor_t _reactor =
+{
+    .thread = NULL,
+    .mutex = NULL,
+    .fd_epoll = -1,
+};
+
+static pthread_once_t _reactor_once = PTHREAD_ONCE_INIT;
+
+static const osThreadAttr_t _thread_attr_reactor =
+{
+    .name = "ThreadSerialReactor",
+    .attr_bits = osThreadDetached,
+    .priority = osPriorityRealtime,
+    .stack_size = EDF_REACTOR_STACK_SIZE,
+};
+
+/* public functions --------------------------------------------------------- */
+/**
+  * @brief  Add the opened serial port into the reactor.
+  * @param  serial      elab serial device handle.
+  * @retval None.
+  */
+void __serial_reactor_add(elab_serial_t *serial)
+{
+    elab_assert(serial != NULL);
+    elab_assert(serial->ops->get_fd != NULL);
+    elab_assert(serial->ops->read != NULL);
+
+    int ret = pthread_once(&_reactor_once, _reactor_init);
+    elab_assert(ret == 0);
+
+    osStatus_t ret_os = osMutexAcquire(_reactor.mutex, osWaitForever);
+    elab_assert(ret_os == osOK);
+
+    elab_assert(serial->reactor_slot < 0);
+    int32_t slot = 0;
+    while (slot < EDF_REACTOR_PORT_MAX && _reactor.port[slot] != NULL)
+    {
+        slot ++;
+    }
+    elab_assert(slot < EDF_REACTOR_PORT_MAX);
+
+    _reactor.port[slot] = serial;
+    _reactor.gen[slot] ++;
+    serial->reactor_slot = slot;
+    __atomic_store_n(&serial->rx_full, 0, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&serial->tx_busy, 0, __ATOMIC_SEQ_CST);
+
+    struct epoll_event event =
+    {
+        .events = EPOLLIN,
+        .data.u64 = _reactor_data(slot),
+    };
+    ret = epoll_ctl(_reactor.fd_epoll, EPOLL_CTL_ADD,
+                        serial->ops->get_fd(serial), &event);
+    assert_name(ret == 0, serial->super.attr.name);
+
+    ret_os = osMutexRelease(_reactor.mutex);
+    elab_assert(ret_os == osOK);
+}
+
+/**
+  * @brief  Remove the serial port from the reactor, before it is closed.
+  * @param  serial      elab serial device handle.
+  * @retval None.
+  */
+void __serial_reactor_remove(elab_serial_t *serial)
+{
+    elab_assert(serial != NULL);
+
+    if (serial->reactor_slot < 0)
+    {
+        return;
+    }
+
+    osStatus_t ret_os = osMutexAcquire(_reactor.mutex, osWaitForever);
+    elab_assert(ret_os == osOK);
+
+    int ret = epoll_ctl(_reactor.fd_epoll, EPOLL_CTL_DEL,
+                        serial->ops->get_fd(serial), NULL);
+    assert_name(ret == 0, serial->super.attr.name);
+    _reactor.port[serial->reactor_slot] = NULL;
+    serial->reactor_slot = -1;
+    if (serial->ring_tx.buffer != NULL)
+    {
+        /* The data not sent in flushing is dropped. */
+        elib_ring_clear(&serial->ring_tx);
+        __serial_tx_commit(serial, 0, true);
+    }
+
+    ret_os = osMutexRelease(_reactor.mutex);
+    elab_assert(ret_os == osOK);
+}
+
+/**
+  * @brief  Receive the serial port again, which is paused for the full rx ring.
+  *         Called in reading once enough space is free.
+  * @param  serial      elab serial device handle.
+  * @retval None.
+  */
+void __serial_reactor_resume(elab_serial_t *serial)
+{
+    elab_assert(serial != NULL);
+
+    osStatus_t ret_os = osMutexAcquire(_reactor.mutex, osWaitForever);
+    elab_assert(ret_os == osOK);
+
+    if (serial->reactor_slot >= 0)
+    {
+        _reactor_update(serial);
+    }
+
+    ret_os = osMutexRelease(_reactor.mutex);
+    elab_assert(ret_os == osOK);
+}
+
+/**
+  * @brief  Send the data in the tx ring of the serial port in the reactor.
+  *         Called by the writing thread which sets the tx ring busy.
+  * @param  serial      elab serial device handle.
+  * @retval None.
+  */
+void __serial_reactor_kick_tx(elab_serial_t *serial)
+{
+    __serial_reactor_resume(serial);
+}
+
+/* private functions -------------------------------------------------------- */
+/**
+  * @brief  Create the epoll set and the reactor thread in the first adding,
+  *         only once even if the ports are opened in more threads at once.
+  */
+static void _reactor_init(void)
+{
+    _reactor.mutex = osMutexNew(NULL);
+    elab_assert(_reactor.mutex != NULL);
+    _reactor.fd_epoll = epoll_create1(EPOLL_CLOEXEC);
+    elab_assert(_reactor.fd_epoll >= 0);
+    _reactor.thread = osThreadNew(_entry_reactor, NULL, &_thread_attr_reactor);
+    elab_assert(_reactor.thread != NULL);
+}
+
+/**
+  * @brief  The epoll data of the slot, with its generation in the high half.
+  *         Called with the reactor mutex held.
+  */
+static uint64_t _reactor_data(int32_t slot)
+{
+    return ((uint64_t)_reactor.gen[slot] << 32) | (uint32_t)slot;
+}
+
+/**
+  * @brief  Watch the port for the events decided by its flags. Called with the
+  *         reactor mutex held.
+  */
+static void _reactor_update(elab_serial_t *serial)
+{
+    uint32_t events = 0;
+
+    if (__atomic_load_n(&serial->rx_full, __ATOMIC_SEQ_CST) == 0)
+    {
+        events |= EPOLLIN;
+    }
+    if (__atomic_load_n(&serial->tx_busy, __ATOMIC_SEQ_CST) != 0)
+    {
+        events |= EPOLLOUT;
+    }
+    _reactor_ctl(serial, events);
+}
+
+/**
+  * @brief  Watch the port for the given events. Called with the reactor mutex
+  *         held.
+  */
+static void _reactor_ctl(elab_serial_t *serial, uint32_t events)
+{
+    struct epoll_event event =
+    {
+        .events = events,
+        .data.u64 = _reactor_data(serial->reactor_slot),
+    };
+    int ret = epoll_ctl(_reactor.fd_epoll, EPOLL_CTL_MOD,
+                        serial->ops->get_fd(serial), &event);
+    assert_name(ret == 0, serial->super.attr.name);
+}
+
+/**
+  * @brief  Read all the received data of the ready port into its rx ring, in
+  *         the linear blocks of the free space. Called with the reactor mutex
+  *         held.
+  */
+static void _reactor_read(elab_serial_t *serial, uint32_t events)
+{
+    uint32_t count = 0;
+    int32_t ret = 0;
+    uint32_t pos = serial->ring_rx.head;
+    uint32_t time_last = 0;
+
+    /* The data in testing mode is dropped, as the ISR receiving does. */
+    if (elab_device_is_test_mode(&serial->super))
+    {
+        uint8_t buffer[EDF_REACTOR_DISCARD_SIZE];
+        do
+        {
+            ret = serial->ops->read(serial, buffer, EDF_REACTOR_DISCARD_SIZE);
+        } while (ret == EDF_REACTOR_DISCARD_SIZE);
+        goto exit;
+    }
+
+    while (1)
+    {
+        uint32_t size = 0;
+        void *block = elib_ring_write_block(&serial->ring_rx, &size);
+        if (size == 0)
+        {
+            /* Full, paused until the reading thread frees half of the ring,
+               which is checked again after the flag is set, so only one of
+               the two resumes the port. */
+            __atomic_store_n(&serial->rx_full, 1, __ATOMIC_SEQ_CST);
+            _reactor_update(serial);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            if (elib_ring_free_size(&serial->ring_rx) <
+                    (serial->ring_rx.capacity / 2) ||
+                __atomic_exchange_n(&serial->rx_full, 0, __ATOMIC_SEQ_CST) == 0)
+            {
+                break;
+            }
+            _reactor_update(serial);
+            continue;
+        }
+
+        ret = serial->ops->read(serial, block, size);
+        if (ret <= 0)
+        {
+            break;
+        }
+        if (count == 0)
+        {
+            time_last = __atomic_exchange_n(&serial->rx_time_last,
+                                            (uint32_t)elab_time_us(),
+                                            __ATOMIC_SEQ_CST);
+        }
+        elib_ring_write_commit(&serial->ring_rx, (uint32_t)ret);
+        count += (uint32_t)ret;
+        if ((uint32_t)ret < size)
+        {
+            /* All the received data is read. */
+            break;
+        }
+    }
+
+    if (count != 0)
+    {
+        /* All the data read at once is one batch for the gap. */
+        __serial_rx_frame_gap(serial, pos, count, time_last,
+                                __atomic_load_n(&serial->rx_time_last,
+                                                __ATOMIC_SEQ_CST));
+        __serial_rx_notify(serial);
+    }
+
+exit:
+    if (ret < 0 || (count == 0 && (events & (EPOLLERR | EPOLLHUP)) != 0))
+    {
+        /* Paused, or the broken port keeps the reactor busy. */
+        elog_error("Serial port %s receiving fails.", serial->super.attr.name);
+        _reactor_ctl(serial, 0);
+    }
+}
+
+/**
+  * @brief  Send the data in the tx ring of the ready port, in the contiguous
+  *         segments at one time, until the port is busy or the ring is empty.
+  *         Called with the reactor mutex held.
+  */
+static void _reactor_write(elab_serial_t *serial)
+{
+    while (1)
+    {
+        elab_iovec_t iov[2];
+        uint32_t num = __serial_tx_segments(serial, iov);
+        if (num == 0)
+        {
+            /* Empty, and checked again after it is not busy, so only one of
+               the reactor and the writing thread sends the new data. */
+            uint32_t busy = 0;
+            __serial_tx_commit(serial, 0, true);
+            if (elib_ring_count(&serial->ring_tx) != 0 &&
+                __atomic_compare_exchange_n(&serial->tx_busy, &busy, 1, false,
+                                            __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+            {
+                continue;
+            }
+            break;
+        }
+
+        int32_t ret = serial->ops->writev(serial, iov, num);
+        if (ret < 0)
+        {
+            /* The data is dropped, not to block the writing threads. */
+            elog_error("Serial port %s sending fails.", serial->super.attr.name);
+            ret = (int32_t)iov[0].size + ((num > 1) ? (int32_t)iov[1].size : 0);
+        }
+        else if (ret == 0)
+        {
+            /* Waiting for the port to be writable. */
+            break;
+        }
+        __serial_tx_commit(serial, (uint32_t)ret, false);
+    }
+
+    _reactor_update(serial);
+}
+
+/**
+  * @brief  The reactor thread receiving all the serial ports.
+  */
+static void _entry_reactor(void *para)
+{
+    (void)para;
+
+    struct epoll_event events[EDF_REACTOR_EVENT_MAX];
+
+    while (1)
+    {
+        int num = epoll_wait(_reactor.fd_epoll, events, EDF_REACTOR_EVENT_MAX, -1);
+        if (num < 0)
+        {
+            elab_assert(errno == EINTR);
+            continue;
+        }
+
+        osStatus_t ret_os = osMutexAcquire(_reactor.mutex, osWaitForever);
+        elab_assert(ret_os == osOK);
+        for (int i = 0; i < num; i ++)
+        {
+            /* The port may be removed after the epoll waiting, and the slot
+               may be taken by another port then. */
+            uint32_t slot = (uint32_t)events[i].data.u64;
+            uint32_t gen = (uint32_t)(events[i].data.u64 >> 32);
+            elab_serial_t *serial = (gen == _reactor.gen[slot]) ?
+                                        _reactor.port[slot] : NULL;
+            if (serial != NULL && (events[i].events & EPOLLOUT) != 0)
+            {
+                _reactor_write(serial);
+            }
+            if (serial != NULL && (events[i].events & ~EPOLLOUT) != 0)
+            {
+                _reactor_read(serial, events[i].events);
+            }
+        }
+        ret_os = osMutexRelease(_reactor.mutex);
+        elab_assert(ret_os == osOK);
+    }
+}
+
+#endif
+
+/* ----------------------------- end of file -------------------------------- */
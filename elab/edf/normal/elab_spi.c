@@ -15,6 +15,16 @@ extern "C" {
 
 ELAB_TAG("Edf_SPI");
 
+/* Private function prototypes -----------------------------------------------*/
+static elab_err_t _spi_xfer_iov(elab_spi_t *spi,
+                                const elab_iovec_t *iov, uint32_t num,
+                                bool send, uint32_t timeout);
+static elab_err_t _device_enable(elab_device_t *me, bool status);
+static int32_t _device_readv(elab_device_t *me, uint32_t pos,
+                                const elab_iovec_t *iov, uint32_t num);
+static int32_t _device_writev(elab_device_t *me, uint32_t pos,
+                                const elab_iovec_t *iov, uint32_t num);
+
 /* Private variables ---------------------------------------------------------*/
 static const elab_dev_ops_t spi_ops =
 {
@@ -26,6 +36,18 @@ static const elab_dev_ops_t spi_ops =
 #endif
 };
 
+static const elab_dev_ops_t spi_dev_ops =
+{
+    .enable = _device_enable,
+    .read = NULL,
+    .write = NULL,
+    .readv = _device_readv,
+    .writev = _device_writev,
+#if (ELAB_DEV_PALTFORM == ELAB_PALTFORM_POLL)
+    .poll = NULL,
+#endif
+};
+
 /* Exported functions --------------------------------------------------------*/
 /**
   * @brief  SPI bus device initialization and registering.
@@ -96,6 +118,7 @@ void elab_spi_register(elab_spi_t *device, const char *name,
     device->bus = (elab_spi_bus_t *)elab_device_find(bus_name);
     device->pin_cs = elab_device_find(pin_name_cs);
     device->config = config;
+    device->super.ops = &spi_dev_ops;
     device->super.user_data = NULL;
 
     /* Register to device manager. */
@@ -140,72 +163,56 @@ elab_err_t elab_spi_send_twice(elab_device_t *me,
     assert(buff1 != NULL);
     assert(buff2 != NULL);
     assert(size1 != 0);
-    assert(size1 != 0);
+    assert(size2 != 0);
     assert(timeout != 0);
 
-    elab_err_t ret = ELAB_OK;
-    osStatus_t ret_os = osOK;
-    elab_spi_t *spi = (elab_spi_t *)me;
-    elab_spi_msg_t msg;
-
-    assert(spi->bus != NULL);
-
-    ret_os = osMutexAcquire(spi->bus->mutex, osWaitForever);
-    assert(ret_os == osOK);
-
-    /* Not the same config as current, re-configure SPI bus */
-    if (memcmp(&spi->bus->config_owner,
-                &spi->config, sizeof(elab_spi_config_t)) != 0)
+    elab_iovec_t iov[2] =
     {
-        /* not the same owner as current, re-configure SPI bus */
-        ret = spi->bus->ops->config(spi, &spi->config);
-
-        if (ret != ELAB_OK)
-        {
-            goto exit_release_mutex;
-        }
-
-        /* Set SPI bus's config */
-        spi->bus->config_owner = spi->config;
-    }
+        { .buffer = (void *)buff1, .size = size1 },
+        { .buffer = (void *)buff2, .size = size2 },
+    };
 
-    /* send data1 */
-    msg.buff_send = buff1;
-    msg.buff_recv = NULL;
-    msg.size = size1;
+    return elab_spi_writev(me, iov, 2, timeout);
+}
 
-    ret = spi->bus->ops->xfer(spi, &msg);
-    if (ret != ELAB_OK)
-    {
-        goto exit_release_mutex;
-    }
+/**
+  * @brief  Send the segments to SPI device in one transfer, in which the chip
+  *         select keeps enabled, like the command and the data of it.
+  * @param  me      The EDF device handle.
+  * @param  iov     The segments array.
+  * @param  num     The number of the segments.
+  * @retval See elab_err_t
+  */
+elab_err_t elab_spi_writev(elab_device_t *me,
+                            const elab_iovec_t *iov, uint32_t num,
+                            uint32_t timeout)
+{
+    assert(me != NULL);
+    assert(iov != NULL);
+    assert(num != 0);
+    assert(timeout != 0);
 
-    /* send data2 */
-    msg.buff_send = buff2;
-    msg.buff_recv = NULL;
-    msg.size = size2;
+    return _spi_xfer_iov((elab_spi_t *)me, iov, num, true, timeout);
+}
 
-    /* Enable the SPI device. */
-    elab_pin_set_status(spi->pin_cs, false);
-    /* Transfer msg */
-    ret = spi->bus->ops->xfer(spi, &msg);
-    if (ret == ELAB_OK)
-    {
-        ret_os = osSemaphoreAcquire(spi->bus->sem, timeout);
-        if (ret_os == osErrorTimeout)
-        {
-            ret = ELAB_ERR_TIMEOUT;
-        }
-    }
-    /* Disable the SPI device. */
-    elab_pin_set_status(spi->pin_cs, true);
-    
-exit_release_mutex:
-    ret_os = osMutexRelease(spi->bus->mutex);
-    assert(ret_os == osOK);
-    (void)ret_os;
+/**
+  * @brief  Receive data from SPI device into the segments in one transfer, in
+  *         which the chip select keeps enabled.
+  * @param  me      The EDF device handle.
+  * @param  iov     The segments array.
+  * @param  num     The number of the segments.
+  * @retval See elab_err_t
+  */
+elab_err_t elab_spi_readv(elab_device_t *me,
+                            const elab_iovec_t *iov, uint32_t num,
+                            uint32_t timeout)
+{
+    assert(me != NULL);
+    assert(iov != NULL);
+    assert(num != 0);
+    assert(timeout != 0);
 
-    return ret;
+    return _spi_xfer_iov((elab_spi_t *)me, iov, num, false, timeout);
 }
 
 /**
@@ -481,6 +488,138 @@ elab_err_t elab_spi_send(elab_device_t *me,
     return elab_spi_xfer(me, buffer, NULL, size, timeout);
 }
 
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Transfer the segments in one direction, one message for every one,
+  *         with the chip select enabled from the first to the last.
+  */
+static elab_err_t _spi_xfer_iov(elab_spi_t *spi,
+                                const elab_iovec_t *iov, uint32_t num,
+                                bool send, uint32_t timeout)
+{
+    elab_err_t ret = ELAB_OK;
+    osStatus_t ret_os = osOK;
+    elab_spi_msg_t msg;
+    uint32_t time_start = 0;
+
+    assert(spi->bus != NULL);
+
+    ret_os = osMutexAcquire(spi->bus->mutex, osWaitForever);
+    assert(ret_os == osOK);
+
+    /* If not the same config as current, re-configure SPI bus */
+    if (memcmp(&spi->bus->config_owner,
+                &spi->config, sizeof(elab_spi_config_t)) != 0)
+    {
+        ret = spi->bus->ops->config(spi, &spi->config);
+        if (ret != ELAB_OK)
+        {
+            goto exit_release_mutex;
+        }
+
+        /* Set SPI bus owner */
+        spi->bus->config_owner = spi->config;
+    }
+
+    time_start = osKernelGetTickCount();
+    /* Enable the SPI device. */
+    elab_pin_set_status(spi->pin_cs, false);
+    for (uint32_t i = 0; i < num; i ++)
+    {
+        if (iov[i].size == 0)
+        {
+            continue;
+        }
+
+        msg.buff_send = send ? iov[i].buffer : NULL;
+        msg.buff_recv = send ? NULL : iov[i].buffer;
+        msg.size = iov[i].size;
+
+        /* Transfer msg */
+        ret = spi->bus->ops->xfer(spi, &msg);
+        if (ret != ELAB_OK)
+        {
+            break;
+        }
+
+        ret_os = osSemaphoreAcquire(spi->bus->sem, timeout);
+        if (ret_os == osErrorTimeout)
+        {
+            ret = ELAB_ERR_TIMEOUT;
+            break;
+        }
+        if (timeout != osWaitForever && i < (num - 1))
+        {
+            int32_t _timeout = timeout - (osKernelGetTickCount() - time_start);
+            if (_timeout <= 0)
+            {
+                ret = ELAB_ERR_TIMEOUT;
+                break;
+            }
+            timeout = _timeout;
+            time_start = osKernelGetTickCount();
+        }
+    }
+    /* Disable the SPI device. */
+    elab_pin_set_status(spi->pin_cs, true);
+
+exit_release_mutex:
+    ret_os = osMutexRelease(spi->bus->mutex);
+    assert(ret_os == osOK);
+    (void)ret_os;
+
+    return ret;
+}
+
+/**
+  * @brief  The SPI device is always ready in the device framework.
+  */
+static elab_err_t _device_enable(elab_device_t *me, bool status)
+{
+    (void)me;
+    (void)status;
+
+    return ELAB_OK;
+}
+
+/**
+  * @brief  The SPI device vectored reading function in the device framework.
+  * @retval Auctual read length in total or error ID.
+  */
+static int32_t _device_readv(elab_device_t *me, uint32_t pos,
+                                const elab_iovec_t *iov, uint32_t num)
+{
+    (void)pos;
+
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < num; i ++)
+    {
+        size += iov[i].size;
+    }
+    elab_err_t ret = elab_spi_readv(me, iov, num, osWaitForever);
+
+    return (ret == ELAB_OK) ? (int32_t)size : (int32_t)ret;
+}
+
+/**
+  * @brief  The SPI device vectored writting function in the device framework.
+  * @retval Auctual write length in total or error ID.
+  */
+static int32_t _device_writev(elab_device_t *me, uint32_t pos,
+                                const elab_iovec_t *iov, uint32_t num)
+{
+    (void)pos;
+
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < num; i ++)
+    {
+        size += iov[i].size;
+    }
+    elab_err_t ret = elab_spi_writev(me, iov, num, osWaitForever);
+
+    return (ret == ELAB_OK) ? (int32_t)size : (int32_t)ret;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -105,6 +105,12 @@ elab_err_t elab_spi_send_twice(elab_device_t *me,
                                 const void *buff1, uint32_t size1,
                                 const void *buff2, uint32_t size2,
                                 uint32_t timeout);
+elab_err_t elab_spi_writev(elab_device_t *me,
+                            const elab_iovec_t *iov, uint32_t num,
+                            uint32_t timeout);
+elab_err_t elab_spi_readv(elab_device_t *me,
+                            const elab_iovec_t *iov, uint32_t num,
+                            uint32_t timeout);
 elab_err_t elab_spi_xfer(elab_device_t *me,
                             const void *buff_send, void *buff_recv,
                             uint32_t size, uint32_t timeout);
@@ -0,0 +1,189 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+/* includes ----------------------------------------------------------------- */
+#include <string.h>
+#include "elib_ring.h"
+#include "../common/elab_assert.h"
+
+ELAB_TAG("ElibRing");
+
+/* public functions --------------------------------------------------------- */
+/**
+  * @brief  Ring initialization.
+  * @param  me          this pointer
+  * @param  buffer      Ring's buffer memory.
+  * @param  capacity    Ring's capacity, in power of 2.
+  * @retval None
+  */
+void elib_ring_init(elib_ring_t * const me, void *buffer, uint32_t capacity)
+{
+    elab_assert(me != NULL);
+    elab_assert(buffer != NULL);
+    elab_assert(capacity != 0 && (capacity & (capacity - 1)) == 0);
+
+    me->buffer = (uint8_t *)buffer;
+    me->capacity = capacity;
+    me->head = 0;
+    me->tail = 0;
+}
+
+/**
+  * @brief  Get the data size in the ring.
+  * @param  me          this pointer
+  * @retval Data size.
+  */
+uint32_t elib_ring_count(elib_ring_t * const me)
+{
+    uint32_t tail = __atomic_load_n(&me->tail, __ATOMIC_ACQUIRE);
+    uint32_t head = __atomic_load_n(&me->head, __ATOMIC_ACQUIRE);
+
+    return head - tail;
+}
+
+/**
+  * @brief  Get the free size of the ring.
+  * @param  me          this pointer
+  * @retval Free size.
+  */
+uint32_t elib_ring_free_size(elib_ring_t * const me)
+{
+    return me->capacity - elib_ring_count(me);
+}
+
+/**
+  * @brief  Write data into the ring, as much as the free size.
+  * @param  me      this pointer
+  * @param  buffer  data buffer memory.
+  * @param  size    data's size.
+  * @retval Actual written data size.
+  */
+uint32_t elib_ring_write(elib_ring_t * const me, const void *buffer, uint32_t size)
+{
+    uint32_t count = 0;
+
+    /* At most two linear blocks, before and after the wrapping. */
+    for (uint32_t i = 0; i < 2 && count < size; i ++)
+    {
+        uint32_t size_block = 0;
+        uint8_t *block = elib_ring_write_block(me, &size_block);
+        if (size_block == 0)
+        {
+            break;
+        }
+        size_block = (size_block < (size - count)) ? size_block : (size - count);
+        memcpy(block, &((const uint8_t *)buffer)[count], size_block);
+        elib_ring_write_commit(me, size_block);
+        count += size_block;
+    }
+
+    return count;
+}
+
+/**
+  * @brief  Get the linear free block of the ring, to be filled in place.
+  * @param  me      this pointer
+  * @param  size    The block size, returned.
+  * @retval The block memory.
+  */
+void *elib_ring_write_block(elib_ring_t * const me, uint32_t *size)
+{
+    uint32_t head = __atomic_load_n(&me->head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&me->tail, __ATOMIC_ACQUIRE);
+    uint32_t offset = head & (me->capacity - 1);
+    uint32_t size_free = me->capacity - (head - tail);
+    uint32_t size_linear = me->capacity - offset;
+
+    *size = (size_free < size_linear) ? size_free : size_linear;
+
+    return &me->buffer[offset];
+}
+
+/**
+  * @brief  Publish the data filled in the linear free block.
+  * @param  me      this pointer
+  * @param  size    The filled size.
+  * @retval None
+  */
+void elib_ring_write_commit(elib_ring_t * const me, uint32_t size)
+{
+    uint32_t head = __atomic_load_n(&me->head, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&me->head, head + size, __ATOMIC_RELEASE);
+}
+
+/**
+  * @brief  Read data from the ring, as much as the data size.
+  * @param  me      this pointer
+  * @param  buffer  data buffer memory.
+  * @param  size    data's size.
+  * @retval Actual read data size.
+  */
+uint32_t elib_ring_read(elib_ring_t * const me, void *buffer, uint32_t size)
+{
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < 2 && count < size; i ++)
+    {
+        uint32_t size_block = 0;
+        uint8_t *block = elib_ring_read_block(me, &size_block);
+        if (size_block == 0)
+        {
+            break;
+        }
+        size_block = (size_block < (size - count)) ? size_block : (size - count);
+        memcpy(&((uint8_t *)buffer)[count], block, size_block);
+        elib_ring_read_commit(me, size_block);
+        count += size_block;
+    }
+
+    return count;
+}
+
+/**
+  * @brief  Get the linear data block of the ring, to be used in place.
+  * @param  me      this pointer
+  * @param  size    The block size, returned.
+  * @retval The block memory.
+  */
+void *elib_ring_read_block(elib_ring_t * const me, uint32_t *size)
+{
+    uint32_t tail = __atomic_load_n(&me->tail, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&me->head, __ATOMIC_ACQUIRE);
+    uint32_t offset = tail & (me->capacity - 1);
+    uint32_t size_data = head - tail;
+    uint32_t size_linear = me->capacity - offset;
+
+    *size = (size_data < size_linear) ? size_data : size_linear;
+
+    return &me->buffer[offset];
+}
+
+/**
+  * @brief  Give back the used data of the linear data block.
+  * @param  me      this pointer
+  * @param  size    The used size.
+  * @retval None
+  */
+void elib_ring_read_commit(elib_ring_t * const me, uint32_t size)
+{
+    uint32_t tail = __atomic_load_n(&me->tail, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&me->tail, tail + size, __ATOMIC_RELEASE);
+}
+
+/**
+  * @brief  Drop all the data in the ring.
+  * @param  me      this pointer
+  * @retval None
+  */
+void elib_ring_clear(elib_ring_t * const me)
+{
+    uint32_t head = __atomic_load_n(&me->head, __ATOMIC_ACQUIRE);
+
+    __atomic_store_n(&me->tail, head, __ATOMIC_RELEASE);
+}
+
+/* ----------------------------- end of file -------------------------------- */
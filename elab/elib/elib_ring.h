@@ -0,0 +1,54 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+#ifndef ELIB_RING_H
+#define ELIB_RING_H
+
+/* includes ----------------------------------------------------------------- */
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* public typedef ----------------------------------------------------------- */
+/*
+ * The lock-free byte ring of one producer and one consumer, like one thread
+ * or ISR receiving data and one thread reading it. The head is only moved by
+ * the producer, and the tail only by the consumer. Both of them run freely
+ * and wrap around, so the capacity is in power of 2.
+ */
+typedef struct elib_ring
+{
+    uint8_t *buffer;
+    uint32_t capacity;                          /* Power of 2 */
+    uint32_t head;                              /* Atomic, the producer */
+    uint32_t tail;                              /* Atomic, the consumer */
+} elib_ring_t;
+
+/* public functions --------------------------------------------------------- */
+void elib_ring_init(elib_ring_t * const me, void *buffer, uint32_t capacity);
+uint32_t elib_ring_count(elib_ring_t * const me);
+uint32_t elib_ring_free_size(elib_ring_t * const me);
+
+/* For the producer only. */
+uint32_t elib_ring_write(elib_ring_t * const me, const void *buffer, uint32_t size);
+void *elib_ring_write_block(elib_ring_t * const me, uint32_t *size);
+void elib_ring_write_commit(elib_ring_t * const me, uint32_t size);
+
+/* For the consumer only. */
+uint32_t elib_ring_read(elib_ring_t * const me, void *buffer, uint32_t size);
+void *elib_ring_read_block(elib_ring_t * const me, uint32_t *size);
+void elib_ring_read_commit(elib_ring_t * const me, uint32_t size);
+void elib_ring_clear(elib_ring_t * const me);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/* ----------------------------- end of file -------------------------------- */
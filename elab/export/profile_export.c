@@ -0,0 +1,56 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "../3rd/Shell/shell.h"
+#include "../common/elab_common.h"
+
+#if defined(__linux__) && (ELAB_RTOS_PROFILE_EN != 0)
+#include <fcntl.h>
+#include <unistd.h>
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Print the contention profile of the RTOS objects, or clear it, or
+  *         save it into the CSV file, like the normal exit does.
+  *         Usage: profile [reset | csv | save]
+  */
+static int profile_export(int argc, char *argv[])
+{
+    if (argc >= 2 && strcmp(argv[1], "reset") == 0)
+    {
+        osKernelProfileReset();
+        return 0;
+    }
+    if (argc >= 2 && strcmp(argv[1], "save") == 0)
+    {
+        int fd = open(ELAB_RTOS_PROFILE_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+        {
+            printf("Failed to open %s.\n", ELAB_RTOS_PROFILE_FILE);
+            return -1;
+        }
+        osKernelProfilePrint(fd, 1);
+        close(fd);
+        return 0;
+    }
+
+    fflush(stdout);
+    osKernelProfilePrint(STDOUT_FILENO,
+                            (argc >= 2 && strcmp(argv[1], "csv") == 0) ? 1 : 0);
+
+    return 0;
+}
+
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+                    profile,
+                    profile_export,
+                    RTOS object contention profile [reset | csv | save]);
+
+#endif
+
+/* ----------------------------- end of file -------------------------------- */
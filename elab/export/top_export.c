@@ -0,0 +1,121 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../3rd/Shell/shell.h"
+#include "../common/elab_common.h"
+
+#if defined(__linux__) && (ELAB_RTOS_CMSIS_OS_EN != 0)
+#include <sched.h>
+#include <time.h>
+
+/* Private config ------------------------------------------------------------*/
+#define TOP_THREAD_MAX                      (128)
+#define TOP_INTERVAL_DEFAULT                (1000)          /* ms */
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct top_thread
+{
+    osThreadId_t thread;
+    uint64_t cpu_time;
+    uint64_t cpu_delta;
+} top_thread_t;
+
+/* Private function prototypes -----------------------------------------------*/
+static int _top_compare(const void *a, const void *b);
+static uint64_t _real_time_ns(void);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Print the CPU usage in the interval, the CPU time and the stack
+  *         high-water mark of every thread, the busiest thread first.
+  *         Usage: top [interval_ms]
+  */
+static int top_export(int argc, char *argv[])
+{
+    osThreadId_t thread_id[TOP_THREAD_MAX];
+    top_thread_t top[TOP_THREAD_MAX];
+    uint32_t interval = TOP_INTERVAL_DEFAULT;
+
+    if (argc >= 2)
+    {
+        interval = (uint32_t)atoi(argv[1]);
+    }
+
+    uint32_t count = osThreadEnumerate(thread_id, TOP_THREAD_MAX);
+    for (uint32_t i = 0; i < count; i ++)
+    {
+        top[i].thread = thread_id[i];
+        top[i].cpu_time = osThreadGetCpuTimeNs(thread_id[i]);
+    }
+    uint64_t time_start = _real_time_ns();
+    osDelay(interval);
+    uint64_t time_real = _real_time_ns() - time_start;
+    for (uint32_t i = 0; i < count; i ++)
+    {
+        uint64_t cpu_time = osThreadGetCpuTimeNs(top[i].thread);
+        top[i].cpu_delta = (cpu_time > top[i].cpu_time) ?
+                            (cpu_time - top[i].cpu_time) : 0;
+        top[i].cpu_time = cpu_time;
+    }
+    qsort(top, count, sizeof(top_thread_t), _top_compare);
+
+    printf("%u threads, %u ms.\n", count, interval);
+    printf("%-24s %-11s %4s %7s %12s %10s %10s\n",
+            "name", "policy", "prio", "CPU %", "CPU time(s)",
+            "stack used", "stack size");
+    for (uint32_t i = 0; i < count; i ++)
+    {
+        int32_t policy = SCHED_OTHER, priority = 0;
+        const char *name = osThreadGetName(top[i].thread);
+        uint32_t stack_size = osThreadGetStackSize(top[i].thread);
+
+        osThreadGetSched(top[i].thread, &policy, &priority);
+        printf("%-24s %-11s %4d %7.1f %12.3f %10u %10u\n",
+                (name != NULL) ? name : "(null)",
+                (policy == SCHED_FIFO) ? "SCHED_FIFO" :
+                    ((policy == SCHED_RR) ? "SCHED_RR" : "SCHED_OTHER"),
+                priority,
+                (time_real == 0) ? 0.0 :
+                    ((double)top[i].cpu_delta * 100.0 / (double)time_real),
+                (double)top[i].cpu_time / 1e9,
+                stack_size - osThreadGetStackSpace(top[i].thread),
+                stack_size);
+    }
+
+    return 0;
+}
+
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+                    top,
+                    top_export,
+                    CPU usage and stack of the threads [interval_ms]);
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  The busiest thread first.
+  */
+static int _top_compare(const void *a, const void *b)
+{
+    uint64_t delta_a = ((const top_thread_t *)a)->cpu_delta;
+    uint64_t delta_b = ((const top_thread_t *)b)->cpu_delta;
+
+    return (delta_a < delta_b) ? 1 : ((delta_a > delta_b) ? -1 : 0);
+}
+
+static uint64_t _real_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+#endif
+
+/* ----------------------------- end of file -------------------------------- */
@@ -11,6 +11,11 @@
 
 ELAB_TAG("Modbus");
 
+/* Private config ------------------------------------------------------------*/
+/* The RTU frames are split by the gap of 3.5 characters in 11 bits. */
+#define MODBUS_RTU_GAP_BITS                 (39)
+#define MODBUS_RTU_FRAME_SIZE_MAX           (256)
+
 /* Exported function prototypes ----------------------------------------------*/
 #if (MODBUS_CFG_ASCII_EN != 0)
 uint8_t *mb_ascii_bin_to_hex(uint8_t value, uint8_t *pbuf);
@@ -93,6 +98,17 @@ mb_channel_t *mb_channel_create(const char *serial,
     pch->serial = elab_device_find(serial);
     elab_assert(pch->serial != NULL);
 
+#if (MODBUS_CFG_SLAVE_EN != 0) && (MODBUS_CFG_RTU_EN != 0)
+    /* The slave receives the RTU requests in frames. */
+    if (pch->m_or_s == MODBUS_SLAVE && pch->mode == MODBUS_MODE_RTU)
+    {
+        elab_serial_attr_t attr = elab_serial_get_attr(pch->serial);
+        elab_serial_set_frame(pch->serial, MODBUS_RTU_GAP_BITS,
+                                (attr.rx_bufsz < MODBUS_RTU_FRAME_SIZE_MAX) ?
+                                    attr.rx_bufsz : MODBUS_RTU_FRAME_SIZE_MAX);
+    }
+#endif
+
     /* Open the serial device. */
     elab_err_t ret = elab_device_open(pch->serial);
     elab_assert(ret == ELAB_OK);
@@ -114,15 +130,6 @@ mb_channel_t *mb_channel_create(const char *serial,
         elab_assert(pch->thread_slave != NULL);
     }
 
-    /* Freq * 5 char * 10 bits/char * 1 / baud_rate */
-    elab_serial_attr_t config = elab_serial_get_attr(pch->serial);
-    uint16_t cnts = ((uint32_t)1000 * 5L * 10L) / config.baud_rate;
-    if (cnts <= 1)
-    {
-        cnts = 5;
-    }
-    pch->rtu_timeout = cnts;
-
     pch->cb.coil_read = NULL;
     pch->cb.coil_write = NULL;
     pch->cb.di_read = NULL;
@@ -445,25 +452,26 @@ bool mb_rtu_rx(mb_channel_t *pch)
 void mb_rtu_tx(mb_channel_t *pch)
 {
     elab_err_t ret = ELAB_OK;
+    uint16_t size = (uint16_t)pch->tx_frame_ndata_bytes + 2;
 
-    /* Include the actual data in the buffer. */
-    pch->tx_buff_byte_count = (uint8_t)pch->tx_frame_ndata_bytes + 2;
-    memcpy(pch->tx_buff, pch->tx_frame_data, pch->tx_buff_byte_count);
     /* Save the calculated CRC in the channel. */
     pch->tx_frame_crc = mb_rtu_tx_calc_crc(pch);
-    /* Add in the CRC checksum.  Low byte first! */
-    pch->tx_buff[pch->tx_buff_byte_count ++] = (uint8_t)(pch->tx_frame_crc & 0x00FF);
-    pch->tx_buff[pch->tx_buff_byte_count ++] = (uint8_t)(pch->tx_frame_crc >> 8);
+    /* Add in the CRC checksum just after the frame data, low byte first, so
+       the frame is sent in place without copying. It is sent in one writing,
+       as any gap longer than 1.5 characters in the frame breaks it. */
+    pch->tx_frame_data[size] = (uint8_t)(pch->tx_frame_crc & 0x00FF);
+    pch->tx_frame_data[size + 1] = (uint8_t)(pch->tx_frame_crc >> 8);
+    pch->tx_buff_byte_count = size + 2;
 
     /* Send it out the communication driver. */
-    ret = elab_serial_write(pch->serial, pch->tx_buff, pch->tx_buff_byte_count);
+    ret = elab_serial_write(pch->serial, pch->tx_frame_data, pch->tx_buff_byte_count);
     elab_assert(ret == pch->tx_buff_byte_count);
 
 #if 0
     printf("Tx %u.\n", pch->tx_buff_byte_count);
     for (uint32_t i = 0; i < pch->tx_buff_byte_count; i ++)
     {
-        printf("0x%02x ", pch->tx_buff[i]);
+        printf("0x%02x ", pch->tx_frame_data[i]);
         if ((i + 1) % 16 == 0)
         {
             printf("\n");
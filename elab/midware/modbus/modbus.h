@@ -37,7 +37,6 @@ typedef struct mb_channel
     uint16_t error;                             /* Code error */
 
 #if (MODBUS_CFG_RTU_EN != 0)
-    uint16_t rtu_timeout;
     osThreadId_t thread_slave;
     mb_channel_cb_t cb;
 #endif
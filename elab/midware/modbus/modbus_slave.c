@@ -166,28 +166,29 @@ void entry_slave_rx(void *paras)
     mb_channel_t *pch = (mb_channel_t *)paras;
     uint8_t c = 0;
     int32_t ret = 0;
-    int32_t ret_bkp = ELAB_ERR_TIMEOUT;
-    uint32_t timeout = osWaitForever;
-
-    if (pch->mode == MODBUS_MODE_RTU)
-    {
-        timeout = pch->rtu_timeout;
-    }
 
     while (1)
     {
-        ret = elab_serial_read(pch->serial, &c, 1, timeout);
-        if (ret > 0)
+        if (pch->mode == MODBUS_MODE_RTU)
         {
-            mb_rx_byte(pch, c);
+            /* One whole request split by the serial device in the gap. */
+            ret = elab_serial_read_frame(pch->serial, pch->rx_buff,
+                                            MODBUS_CFG_BUF_SIZE, osWaitForever);
+            if (ret > 0)
+            {
+                pch->rx_count += ret;
+                pch->rx_buff_byte_count = ret;
+                pch->p_rx_buff = &pch->rx_buff[ret];
+                mbs_rx_task(pch);
+            }
+            continue;
         }
-        else if (pch->mode == MODBUS_MODE_RTU &&
-                    ret == ELAB_ERR_TIMEOUT && ret_bkp > 0)
+
+        ret = elab_serial_read(pch->serial, &c, 1, osWaitForever);
+        if (ret > 0)
         {
-            mbs_rx_task(pch);
+            mb_rx_byte(pch, c);
         }
-
-        ret_bkp = ret;
     }
 }
 
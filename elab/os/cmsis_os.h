@@ -45,7 +45,23 @@
 #if defined(__linux__) || defined(ELAB_OS_POSIX)
 
 #include <pthread.h>
-typedef pthread_t                       osThreadBlock_t;
+typedef struct { uint64_t reserved[16]; } osThreadBlock_t;
+typedef struct { uint64_t reserved[8]; } osTimerBlock_t;
+typedef struct { uint64_t reserved[16]; } osMutexBlock_t;
+typedef struct { uint64_t reserved[10]; } osSemaphoreBlock_t;
+typedef struct { uint64_t reserved[32]; } __attribute__((aligned(64))) osMessageQueueBlock_t;
+typedef struct { uint64_t reserved[10]; } osMemoryPoolBlock_t;
+typedef struct { uint64_t reserved[4]; } osEventFlagsBlock_t;
+
+/* Define size of the byte array required to create count of blocks of given size */
+#define MEMPOOL_ARR_SIZE(bl_count, bl_size) (((((bl_size) + (8 - 1)) / 8) * 8)*(bl_count))
+
+/* Define size of the byte array required to create the message queue. The
+   slots are rounded up to the power of two, and every slot has one sequence
+   number besides the message. The priority mode needs the header of the
+   priority lanes in addition. */
+#define MESSAGEQUEUE_ARR_SIZE(msg_count, msg_size)                             \
+                                    (2 * (msg_count) * ((msg_size) + 4) + 320)
 
 #elif defined(ELAB_OS_FREERTOS)
 
@@ -197,11 +213,20 @@ typedef enum {
 #define osThreadDetached      0x00000000U ///< Thread created in detached mode (default)
 #define osThreadJoinable      0x00000001U ///< Thread created in joinable mode
 
+// Real-time profile (attr_bits in \ref osKernelRtProfile_t), eLab extension (POSIX).
+#define osKernelRtMemLock     0x00000001U ///< Lock the current and the future memory in RAM.
+#define osKernelRtPrefault    0x00000002U ///< Prefault the whole stack when the thread starts, always done by the stack painting on POSIX.
+#define osKernelRtSched       0x00000004U ///< SCHED_FIFO for the real-time threads, SCHED_OTHER for the others.
+
 // Mutex attributes (attr_bits in \ref osMutexAttr_t).
 #define osMutexRecursive      0x00000001U ///< Recursive mutex.
 #define osMutexPrioInherit    0x00000002U ///< Priority inherit protocol.
 #define osMutexRobust         0x00000008U ///< Robust mutex.
 
+// Message queue attributes (attr_bits in \ref osMessageQueueAttr_t), eLab extension.
+#define osMessageQueueSpsc    0x00000001U ///< Single producer and single consumer.
+#define osMessageQueuePrio    0x00000002U ///< Messages ordered by priority, FIFO in one priority.
+
 /// Status code values returned by CMSIS-RTOS functions.
 typedef enum {
   osOK                      =  0,         ///< Operation completed successfully.
@@ -254,9 +279,16 @@ typedef struct {
   uint32_t                stack_size;   ///< size of stack
   osPriority_t              priority;   ///< initial thread priority (default: osPriorityNormal)
   TZ_ModuleId_t            tz_module;   ///< TrustZone module identifier
-  uint32_t                  reserved;   ///< reserved (must be 0)
+  uint32_t             affinity_mask;   ///< CPUs the thread runs on, bit n for CPU n (default: 0 - the kernel decides)
 } osThreadAttr_t;
 
+/// Real-time profile of the kernel, eLab extension (POSIX).
+typedef struct {
+  uint32_t                 attr_bits;   ///< osKernelRtMemLock, osKernelRtPrefault and osKernelRtSched
+  uint32_t             affinity_mask;   ///< CPUs for the real-time threads, the others are kept off them; 0 - not isolated
+  osPriority_t           priority_rt;   ///< the lowest priority of the real-time threads (default: osPriorityHigh7)
+} osKernelRtProfile_t;
+
 /// Attributes structure for timer.
 typedef struct {
   const char                   *name;   ///< name of the timer
@@ -335,6 +367,13 @@ osStatus_t osKernelStart (void);
 /// \return previous lock state (1 - locked, 0 - not locked, error code if negative).
 int32_t osKernelLock (void);
 
+/// Forbid the dynamic memory allocation of the RTOS objects, eLab extension (POSIX).
+/// The objects created after it must be given the memory in their attributes.
+void osKernelHeapLock (void);
+
+/// Allow the dynamic memory allocation of the RTOS objects again, eLab extension (POSIX).
+void osKernelHeapUnlock (void);
+
 /// Unlock the RTOS Kernel scheduler.
 /// \return previous lock state (1 - locked, 0 - not locked, error code if negative).
 int32_t osKernelUnlock (void);
@@ -368,6 +407,33 @@ uint32_t osKernelGetSysTimerCount (void);
 /// \return frequency of the system timer in hertz, i.e. timer ticks per second.
 uint32_t osKernelGetSysTimerFreq (void);
 
+/// Get the RTOS kernel time in nano-second as 64-bit value, eLab extension (POSIX).
+/// \return RTOS kernel current time, which follows the virtual time if switched on.
+uint64_t osKernelGetTimeNs (void);
+
+/// Switch the virtual time of the RTOS kernel on or off, eLab extension (POSIX).
+/// Once all the threads created by \ref osThreadNew are blocked, the time jumps
+/// to the earliest deadline of them, so delays, timeouts and timers take no real time.
+/// \param[in]     enable        1 - virtual time, 0 - real time.
+/// \param[in]     scale         virtual time passing per real time when any thread runs; 0 - stopped.
+/// \return status code that indicates the execution status of the function.
+osStatus_t osKernelSetVirtualTime (uint32_t enable, uint32_t scale);
+
+/// Print the contention profile of the Mutexes, Semaphores and Message Queues per name, eLab extension (POSIX).
+/// The profile is recorded if ELAB_RTOS_PROFILE_EN is enabled, the most waited object first.
+/// \param[in]     fd            file descriptor to print to.
+/// \param[in]     csv           0 - table for reading, 1 - CSV for tools.
+void osKernelProfilePrint (int fd, uint32_t csv);
+
+/// Clear the contention profile of all the objects, eLab extension (POSIX).
+void osKernelProfileReset (void);
+
+/// Select the real-time profile of the threads created later, eLab extension (POSIX).
+/// Any part of the profile without the privilege falls back to the normal scheduling with one warning.
+/// \param[in]     profile       real-time profile; NULL: back to the default scheduling.
+/// \return status code that indicates the execution status of the function.
+osStatus_t osKernelSetRtProfile (const osKernelRtProfile_t *profile);
+
 //  ==== Thread Management Functions ====
 
 /// Create a thread and add it to Active Threads.
@@ -412,6 +478,29 @@ osStatus_t osThreadSetPriority (osThreadId_t thread_id, osPriority_t priority);
 /// \return current priority value of the specified thread.
 osPriority_t osThreadGetPriority (osThreadId_t thread_id);
 
+/// Get the scheduling policy and priority achieved by a thread, eLab extension (POSIX).
+/// \param[in]     thread_id     thread ID obtained by \ref osThreadNew or \ref osThreadGetId.
+/// \param[out]    policy        SCHED_OTHER, SCHED_FIFO or SCHED_RR of <sched.h>.
+/// \param[out]    priority      priority in the policy, 0 for SCHED_OTHER.
+/// \return status code that indicates the execution status of the function.
+osStatus_t osThreadGetSched (osThreadId_t thread_id, int32_t *policy, int32_t *priority);
+
+/// Get the CPU time used by a thread, eLab extension (POSIX).
+/// \param[in]     thread_id     thread ID obtained by \ref osThreadNew or \ref osThreadGetId.
+/// \return CPU time in nano-second, 0 if the thread has exited.
+uint64_t osThreadGetCpuTimeNs (osThreadId_t thread_id);
+
+/// Set the CPUs a thread runs on, eLab extension (POSIX).
+/// \param[in]     thread_id     thread ID obtained by \ref osThreadNew or \ref osThreadGetId.
+/// \param[in]     affinity_mask bit n for CPU n; 0: all the CPUs.
+/// \return status code that indicates the execution status of the function.
+osStatus_t osThreadSetAffinityMask (osThreadId_t thread_id, uint32_t affinity_mask);
+
+/// Get the CPUs a thread runs on, eLab extension (POSIX).
+/// \param[in]     thread_id     thread ID obtained by \ref osThreadNew or \ref osThreadGetId.
+/// \return affinity mask of the thread, bit n for CPU n.
+uint32_t osThreadGetAffinityMask (osThreadId_t thread_id);
+
 /// Pass control to next thread that is in state \b READY.
 /// \return status code that indicates the execution status of the function.
 osStatus_t osThreadYield (void);
@@ -691,6 +780,11 @@ uint32_t osMemoryPoolGetCount (osMemoryPoolId_t mp_id);
 /// \return number of memory blocks available.
 uint32_t osMemoryPoolGetSpace (osMemoryPoolId_t mp_id);
 
+/// Get the maximum number of memory blocks ever used in a Memory Pool, eLab extension (POSIX).
+/// \param[in]     mp_id         memory pool ID obtained by \ref osMemoryPoolNew.
+/// \return peak number of memory blocks used.
+uint32_t osMemoryPoolGetCountMax (osMemoryPoolId_t mp_id);
+
 /// Delete a Memory Pool object.
 /// \param[in]     mp_id         memory pool ID obtained by \ref osMemoryPoolNew.
 /// \return status code that indicates the execution status of the function.
@@ -727,6 +821,54 @@ osStatus_t osMessageQueuePut (osMessageQueueId_t mq_id, const void *msg_ptr, uin
 /// \return status code that indicates the execution status of the function.
 osStatus_t osMessageQueueGet (osMessageQueueId_t mq_id, void *msg_ptr, uint8_t *msg_prio, uint32_t timeout);
 
+/// Put up to msg_count Messages into a Queue or timeout if Queue is full, eLab extension.
+/// It waits until one Message at least could be put, and puts the others without waiting.
+/// \param[in]     mq_id         message queue ID obtained by \ref osMessageQueueNew.
+/// \param[in]     msg_ptr       pointer to buffer with msg_count messages to put into a queue.
+/// \param[in]     msg_count     number of the messages in the buffer.
+/// \param[in]     msg_prio      message priority.
+/// \param[in]     timeout       \ref CMSIS_RTOS_TimeOutValue or 0 in case of no time-out.
+/// \return number of the messages put into the queue, 0 in case of error or time-out.
+uint32_t osMessageQueuePutN (osMessageQueueId_t mq_id, const void *msg_ptr, uint32_t msg_count, uint8_t msg_prio, uint32_t timeout);
+
+/// Get up to msg_count Messages from a Queue or timeout if Queue is empty, eLab extension.
+/// It waits until one Message at least could be got, and gets the others without waiting.
+/// \param[in]     mq_id         message queue ID obtained by \ref osMessageQueueNew.
+/// \param[out]    msg_ptr       pointer to buffer for msg_count messages to get from a queue.
+/// \param[in]     msg_count     number of the messages the buffer could hold.
+/// \param[out]    msg_prio      pointer to buffer for message priority or NULL.
+/// \param[in]     timeout       \ref CMSIS_RTOS_TimeOutValue or 0 in case of no time-out.
+/// \return number of the messages got from the queue, 0 in case of error or time-out.
+uint32_t osMessageQueueGetN (osMessageQueueId_t mq_id, void *msg_ptr, uint32_t msg_count, uint8_t *msg_prio, uint32_t timeout);
+
+/// Reserve the slot of one Message in a Queue to fill it in place, or timeout if Queue is full, eLab extension.
+/// The Message is put into the Queue by \ref osMessageQueueCommit.
+/// \param[in]     mq_id         message queue ID obtained by \ref osMessageQueueNew.
+/// \param[in]     timeout       \ref CMSIS_RTOS_TimeOutValue or 0 in case of no time-out.
+/// \return pointer to the slot of the message, NULL in case of error or time-out.
+void *osMessageQueueReserve (osMessageQueueId_t mq_id, uint32_t timeout);
+
+/// Put the Message reserved by \ref osMessageQueueReserve into a Queue, eLab extension.
+/// \param[in]     mq_id         message queue ID obtained by \ref osMessageQueueNew.
+/// \param[in]     msg_ptr       pointer to the slot given by \ref osMessageQueueReserve.
+/// \param[in]     msg_prio      message priority.
+/// \return status code that indicates the execution status of the function.
+osStatus_t osMessageQueueCommit (osMessageQueueId_t mq_id, void *msg_ptr, uint8_t msg_prio);
+
+/// Get a Message from a Queue in place, or timeout if Queue is empty, eLab extension.
+/// The slot of the Message is given back to the Queue by \ref osMessageQueueRelease.
+/// \param[in]     mq_id         message queue ID obtained by \ref osMessageQueueNew.
+/// \param[out]    msg_prio      pointer to buffer for message priority or NULL.
+/// \param[in]     timeout       \ref CMSIS_RTOS_TimeOutValue or 0 in case of no time-out.
+/// \return pointer to the message, NULL in case of error or time-out.
+void *osMessageQueuePeek (osMessageQueueId_t mq_id, uint8_t *msg_prio, uint32_t timeout);
+
+/// Give the slot of the Message got by \ref osMessageQueuePeek back to a Queue, eLab extension.
+/// \param[in]     mq_id         message queue ID obtained by \ref osMessageQueueNew.
+/// \param[in]     msg_ptr       pointer to the message given by \ref osMessageQueuePeek.
+/// \return status code that indicates the execution status of the function.
+osStatus_t osMessageQueueRelease (osMessageQueueId_t mq_id, void *msg_ptr);
+
 /// Get maximum number of messages in a Message Queue.
 /// \param[in]     mq_id         message queue ID obtained by \ref osMessageQueueNew.
 /// \return maximum number of messages.
@@ -1789,6 +1789,151 @@ osStatus_t osMessageQueueGet (osMessageQueueId_t mq_id, void *msg_ptr, uint8_t *
   return (stat);
 }
 
+uint32_t osMessageQueuePutN (osMessageQueueId_t mq_id, const void *msg_ptr, uint32_t msg_count, uint8_t msg_prio, uint32_t timeout) {
+  StaticQueue_t *mq = (StaticQueue_t *)mq_id;
+  const uint8_t *msg = (const uint8_t *)msg_ptr;
+  uint32_t size;
+  uint32_t count;
+
+  count = 0U;
+
+  if ((mq != NULL) && (msg_ptr != NULL) && (msg_count > 0U)) {
+    /* size = pxQueue->uxItemSize */
+    size = mq->uxDummy4[2];
+
+    /* Per-element fallback, only the first message waits */
+    if (osMessageQueuePut (mq_id, msg, msg_prio, timeout) == osOK) {
+      count = 1U;
+      while (count < msg_count) {
+        if (osMessageQueuePut (mq_id, &msg[count * size], msg_prio, 0U) != osOK) {
+          break;
+        }
+        count++;
+      }
+    }
+  }
+
+  return (count);
+}
+
+uint32_t osMessageQueueGetN (osMessageQueueId_t mq_id, void *msg_ptr, uint32_t msg_count, uint8_t *msg_prio, uint32_t timeout) {
+  StaticQueue_t *mq = (StaticQueue_t *)mq_id;
+  uint8_t *msg = (uint8_t *)msg_ptr;
+  uint32_t size;
+  uint32_t count;
+
+  count = 0U;
+
+  if ((mq != NULL) && (msg_ptr != NULL) && (msg_count > 0U)) {
+    /* size = pxQueue->uxItemSize */
+    size = mq->uxDummy4[2];
+
+    /* Per-element fallback, only the first message waits */
+    if (osMessageQueueGet (mq_id, msg, msg_prio, timeout) == osOK) {
+      count = 1U;
+      while (count < msg_count) {
+        if (osMessageQueueGet (mq_id, &msg[count * size], NULL, 0U) != osOK) {
+          break;
+        }
+        count++;
+      }
+    }
+  }
+
+  return (count);
+}
+
+/* Copy-based fallback of the in-place functions, the message is in one buffer
+   from the heap and copied into or out of the queue, so it is not zero-copy
+   and allocates in every reserving or peeking. The reserved buffer keeps the
+   timeout in its header, and the space is waited for in the committing with
+   it, since FreeRTOS can not wait for the space without putting. */
+typedef union {
+  uint32_t timeout;
+  uint64_t align;
+} os_mq_reserve_t;
+
+void *osMessageQueueReserve (osMessageQueueId_t mq_id, uint32_t timeout) {
+  StaticQueue_t *mq = (StaticQueue_t *)mq_id;
+  os_mq_reserve_t *header;
+  void *msg;
+
+  msg = NULL;
+
+  if ((mq != NULL) && !IS_IRQ()) {
+    /* Full with no waiting, the same as the put */
+    if ((timeout != 0U) || (osMessageQueueGetSpace (mq_id) != 0U)) {
+      /* size = pxQueue->uxItemSize */
+      header = pvPortMalloc (sizeof(os_mq_reserve_t) + mq->uxDummy4[2]);
+
+      if (header != NULL) {
+        header->timeout = timeout;
+        msg = &header[1];
+      }
+    }
+  }
+
+  return (msg);
+}
+
+osStatus_t osMessageQueueCommit (osMessageQueueId_t mq_id, void *msg_ptr, uint8_t msg_prio) {
+  os_mq_reserve_t *header;
+  osStatus_t stat;
+
+  if ((mq_id == NULL) || (msg_ptr == NULL)) {
+    stat = osErrorParameter;
+  }
+  else if (IS_IRQ()) {
+    stat = osErrorISR;
+  }
+  else {
+    /* The message is dropped if the space is taken by the other threads */
+    header = &((os_mq_reserve_t *)msg_ptr)[-1];
+    stat = osMessageQueuePut (mq_id, msg_ptr, msg_prio, header->timeout);
+    vPortFree (header);
+  }
+
+  return (stat);
+}
+
+void *osMessageQueuePeek (osMessageQueueId_t mq_id, uint8_t *msg_prio, uint32_t timeout) {
+  StaticQueue_t *mq = (StaticQueue_t *)mq_id;
+  void *msg;
+
+  msg = NULL;
+
+  if ((mq != NULL) && !IS_IRQ()) {
+    /* size = pxQueue->uxItemSize */
+    msg = pvPortMalloc (mq->uxDummy4[2]);
+
+    if (msg != NULL) {
+      if (osMessageQueueGet (mq_id, msg, msg_prio, timeout) != osOK) {
+        vPortFree (msg);
+        msg = NULL;
+      }
+    }
+  }
+
+  return (msg);
+}
+
+osStatus_t osMessageQueueRelease (osMessageQueueId_t mq_id, void *msg_ptr) {
+  osStatus_t stat;
+
+  if ((mq_id == NULL) || (msg_ptr == NULL)) {
+    stat = osErrorParameter;
+  }
+  else if (IS_IRQ()) {
+    stat = osErrorISR;
+  }
+  else {
+    vPortFree (msg_ptr);
+    stat = osOK;
+  }
+
+  return (stat);
+}
+
 uint32_t osMessageQueueGetCapacity (osMessageQueueId_t mq_id) {
   StaticQueue_t *mq = (StaticQueue_t *)mq_id;
   uint32_t capacity;
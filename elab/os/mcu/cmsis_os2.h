@@ -696,6 +696,54 @@ osStatus_t osMessageQueuePut (osMessageQueueId_t mq_id, const void *msg_ptr, uin
 /// \return status code that indicates the execution status of the function.
 osStatus_t osMessageQueueGet (osMessageQueueId_t mq_id, void *msg_ptr, uint8_t *msg_prio, uint32_t timeout);
 
+/// Put up to msg_count Messages into a Queue or timeout if Queue is full, eLab extension.
+/// It waits until one Message at least could be put, and puts the others without waiting.
+/// \param[in]     mq_id         message queue ID obtained by \ref osMessageQueueNew.
+/// \param[in]     msg_ptr       pointer to buffer with msg_count messages to put into a queue.
+/// \param[in]     msg_count     number of the messages in the buffer.
+/// \param[in]     msg_prio      message priority.
+/// \param[in]     timeout       \ref CMSIS_RTOS_TimeOutValue or 0 in case of no time-out.
+/// \return number of the messages put into the queue, 0 in case of error or time-out.
+uint32_t osMessageQueuePutN (osMessageQueueId_t mq_id, const void *msg_ptr, uint32_t msg_count, uint8_t msg_prio, uint32_t timeout);
+
+/// Get up to msg_count Messages from a Queue or timeout if Queue is empty, eLab extension.
+/// It waits until one Message at least could be got, and gets the others without waiting.
+/// \param[in]     mq_id         message queue ID obtained by \ref osMessageQueueNew.
+/// \param[out]    msg_ptr       pointer to buffer for msg_count messages to get from a queue.
+/// \param[in]     msg_count     number of the messages the buffer could hold.
+/// \param[out]    msg_prio      pointer to buffer for message priority or NULL.
+/// \param[in]     timeout       \ref CMSIS_RTOS_TimeOutValue or 0 in case of no time-out.
+/// \return number of the messages got from the queue, 0 in case of error or time-out.
+uint32_t osMessageQueueGetN (osMessageQueueId_t mq_id, void *msg_ptr, uint32_t msg_count, uint8_t *msg_prio, uint32_t timeout);
+
+/// Reserve the slot of one Message in a Queue to fill it in place, or timeout if Queue is full, eLab extension.
+/// The Message is put into the Queue by \ref osMessageQueueCommit.
+/// \param[in]     mq_id         message queue ID obtained by \ref osMessageQueueNew.
+/// \param[in]     timeout       \ref CMSIS_RTOS_TimeOutValue or 0 in case of no time-out.
+/// \return pointer to the slot of the message, NULL in case of error or time-out.
+void *osMessageQueueReserve (osMessageQueueId_t mq_id, uint32_t timeout);
+
+/// Put the Message reserved by \ref osMessageQueueReserve into a Queue, eLab extension.
+/// \param[in]     mq_id         message queue ID obtained by \ref osMessageQueueNew.
+/// \param[in]     msg_ptr       pointer to the slot given by \ref osMessageQueueReserve.
+/// \param[in]     msg_prio      message priority.
+/// \return status code that indicates the execution status of the function.
+osStatus_t osMessageQueueCommit (osMessageQueueId_t mq_id, void *msg_ptr, uint8_t msg_prio);
+
+/// Get a Message from a Queue in place, or timeout if Queue is empty, eLab extension.
+/// The slot of the Message is given back to the Queue by \ref osMessageQueueRelease.
+/// \param[in]     mq_id         message queue ID obtained by \ref osMessageQueueNew.
+/// \param[out]    msg_prio      pointer to buffer for message priority or NULL.
+/// \param[in]     timeout       \ref CMSIS_RTOS_TimeOutValue or 0 in case of no time-out.
+/// \return pointer to the message, NULL in case of error or time-out.
+void *osMessageQueuePeek (osMessageQueueId_t mq_id, uint8_t *msg_prio, uint32_t timeout);
+
+/// Give the slot of the Message got by \ref osMessageQueuePeek back to a Queue, eLab extension.
+/// \param[in]     mq_id         message queue ID obtained by \ref osMessageQueueNew.
+/// \param[in]     msg_ptr       pointer to the message given by \ref osMessageQueuePeek.
+/// \return status code that indicates the execution status of the function.
+osStatus_t osMessageQueueRelease (osMessageQueueId_t mq_id, void *msg_ptr);
+
 /// Get maximum number of messages in a Message Queue.
 /// \param[in]     mq_id         message queue ID obtained by \ref osMessageQueueNew.
 /// \return maximum number of messages.
@@ -6,6 +6,10 @@
 
 #if defined(__linux__)
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE                             /* sem_clockwait, pthread_mutex_clocklock */
+#endif
+
 /* includes ----------------------------------------------------------------- */
 #include <stdlib.h>
 #include <signal.h>
@@ -13,69 +17,114 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <unistd.h>
-#include <sys/time.h>
 #include <errno.h>
 #include <string.h>
 #include <assert.h>
 #include <termios.h>
 #include <semaphore.h>
+#include <limits.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 #include "../cmsis_os.h"
+#include "elab_config.h"                        /* ELAB_RTOS_PROFILE_EN */
+
+/* The running timers, and the threads not created by osThreadNew but calling
+   the RTOS functions, whose memory is reserved at the start, so they need no
+   allocation after osKernelHeapLock. The timer heap still grows before it. */
+#ifndef ELAB_RTOS_TIMER_MAX
+#define ELAB_RTOS_TIMER_MAX                     (64)
+#endif
+#ifndef ELAB_RTOS_FOREIGN_THREAD_MAX
+#define ELAB_RTOS_FOREIGN_THREAD_MAX            (16)
+#endif
 
-#define RTOS_TIMER_NUM_MAX                      (32)
 #define RTOS_TIMER_VALUE_MIN                    (1)
+#define RTOS_TIMER_INDEX_NONE                   (UINT32_MAX)
+#define RTOS_CACHE_LINE_SIZE                    (64)
+#define RTOS_CACHE_ALIGNED                      __attribute__((aligned(RTOS_CACHE_LINE_SIZE)))
+#define RTOS_MQ_SPIN_COUNT                      (100)
+#define RTOS_MUTEX_SPIN_COUNT                   (100)
+#define RTOS_MQ_PRIO_LANES                      (32)
+#define RTOS_MQ_PRIO_HEADER_MAX                 (320)
+#define RTOS_PROFILE_HOLD_SAMPLE                (64)
+#define RTOS_STACK_PAINT_RESERVE                (1024)
+#define RTOS_STACK_PAINT_PATTERN                (0xa5a5a5a5a5a5a5a5ULL)
+
+typedef struct os_thread os_thread_t;
 
 static int get_pthread_priority(osPriority_t prio);
 static void _thread_entry_timer(void *para);
+static uint64_t _clock_ns(void);
+static uint64_t _time_ns(void);
+static bool _time_to_clock(uint64_t time_ns, struct timespec *ts);
+static void _sleep_until(uint64_t time_ns);
+static void _time_init(void) __attribute__((constructor));
+static void _vt_base_set(uint64_t time_ns, uint64_t rate);
+static void _vt_wake(os_thread_t **link);
+static void _vt_poke(void);
+static void _vt_advance(void);
+static void _vt_block(void);
+static void _vt_unblock(void);
+static bool _vt_wait(uint32_t *futex, uint32_t value, uint64_t deadline);
+static bool _futex_wait(uint32_t *futex, uint32_t value,
+                        const struct timespec *deadline);
+static void *_os_malloc(size_t size);
+static void _timer_heap_grow(uint32_t capacity);
 
 /* -----------------------------------------------------------------------------
 Data structure
 ----------------------------------------------------------------------------- */
-static const osMutexAttr_t mutex_attr_queue =
-{
-    "mutex_queue", 
-    osMutexRecursive | osMutexPrioInherit, 
-    NULL,
-    0U 
-};
-
-static const osMutexAttr_t mutex_attr_timer =
-{
-    "mutex_timer",
-    osMutexRecursive | osMutexPrioInherit,
-    NULL,
-    0U 
-};
-
-static const osMutexAttr_t mutex_attr_event_flag =
-{
-    "mutex_event_flag",
-    osMutexRecursive | osMutexPrioInherit,
-    NULL,
-    0U 
-};
-
-enum timer_state
-{
-    TIMER_STATE_IDLE = 0,
-    TIMER_STATE_RUN,
-    TIMER_STATE_UNUSED,
-};
-
-typedef struct os_timer_data
+/* The running timers are kept in one binary min-heap ordered by deadline. The
+   timer thread sleeps until the earliest deadline, so the idle cost does not
+   depend on the timer number. */
+typedef struct os_timer
 {
     osTimerFunc_t func;
     osTimerType_t type;
-    osTimerAttr_t attr;
     void *argument;
-    uint32_t timeout;
+    const char *name;
     uint32_t ticks;
-    uint8_t state;
-} os_timer_data_t;
-
-static os_timer_data_t timer[RTOS_TIMER_NUM_MAX];
-static uint32_t timeout_min = 0;
-
-static osMutexId_t mutex_timer = NULL;
+    uint32_t index;                             /* Heap index, or NONE if stopped */
+    uint64_t deadline;                          /* CLOCK_MONOTONIC, in ns */
+    bool cb_dynamic;
+} os_timer_t;
+
+_Static_assert(sizeof(os_timer_t) <= sizeof(osTimerBlock_t),
+                "osTimerBlock_t is too small.");
+
+static pthread_mutex_t mutex_timer = PTHREAD_MUTEX_INITIALIZER;
+static os_timer_t **timer_heap = NULL;
+static uint32_t timer_count = 0;
+static uint32_t timer_capacity = 0;
+static uint32_t timer_event = 0;                /* Futex, earliest deadline changed */
+static bool kernel_initialized = false;
+static bool heap_locked = false;
+static uint64_t time_init = 0;                  /* OS time, in ns */
+
+/* The OS time is base + (CLOCK_MONOTONIC - real_base) * rate. The rate is 1 in
+   the real time mode, and the scale of the virtual time in the virtual time
+   mode. The time base is read by one seqlock, and only written in the mutex,
+   so the time keeps monotonic across the mode switching. */
+typedef struct os_vtime
+{
+    pthread_mutex_t mutex;
+    os_thread_t *sleeping;                      /* The sleeping threads */
+    uint32_t running;                           /* The running threads */
+    uint32_t seq;                               /* Seqlock of the time base */
+    uint64_t base;                              /* OS time at real_base */
+    uint64_t real_base;                         /* CLOCK_MONOTONIC, in ns */
+    uint64_t rate;
+    uint32_t scale;
+    bool enabled;
+} os_vtime_t;
+
+static os_vtime_t vtime =
+{
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .rate = 1,
+};
 
 /* -----------------------------------------------------------------------------
 OS Basic
@@ -89,17 +138,20 @@ static const osThreadAttr_t thread_attr_timer =
 
 osStatus_t osKernelInitialize(void)
 {
-    for (uint32_t i = 0; i < RTOS_TIMER_NUM_MAX; i ++)
+    if (kernel_initialized)
     {
-        timer[i].state = TIMER_STATE_UNUSED;
+        return osOK;
     }
+    kernel_initialized = true;
 
-    /* Create one thread for mutex function. */
-    mutex_timer = osMutexNew(&mutex_attr_timer);
-    assert(mutex_timer != NULL);
+    /* The timer heap is reserved before the heap is locked. */
+    pthread_mutex_lock(&mutex_timer);
+    _timer_heap_grow(ELAB_RTOS_TIMER_MAX);
+    pthread_mutex_unlock(&mutex_timer);
 
     /* Create one thread for timer function. */
-    osThreadId_t thread = osThreadNew(_thread_entry_timer, NULL, NULL);
+    osThreadId_t thread = osThreadNew(_thread_entry_timer, NULL,
+                                        &thread_attr_timer);
     assert(thread != NULL);
 
     return osOK;
@@ -107,30 +159,41 @@ osStatus_t osKernelInitialize(void)
 
 osStatus_t osDelay(uint32_t ticks)
 {
-    struct timeval ts;
-    ts.tv_usec = (ticks % 1000) * 1000;
-    ts.tv_sec = ticks / 1000;
-    select(0, NULL, NULL, NULL, &ts);
+    _sleep_until(_time_ns() + (uint64_t)ticks * 1000000);
 
     return osOK;
 }
 
 osStatus_t osDelayMs (uint32_t ms)
 {
-    struct timeval ts;
-    ts.tv_usec = (ms % 1000) * 1000;
-    ts.tv_sec = ms / 1000;
-    select(0, NULL, NULL, NULL, &ts);
+    _sleep_until(_time_ns() + (uint64_t)ms * 1000000);
 
     return osOK;
 }
 
 osStatus_t osDelayUs (uint32_t us)
 {
-    struct timeval ts;
-    ts.tv_usec = us % 1000000;
-    ts.tv_sec = us / 1000000;
-    select(0, NULL, NULL, NULL, &ts);
+    _sleep_until(_time_ns() + (uint64_t)us * 1000);
+
+    return osOK;
+}
+
+osStatus_t osDelayUntil(uint32_t ticks)
+{
+    /* The 32-bit tick is extended into the 64-bit time base, so the absolute
+       deadline is right even if the tick count wraps around. */
+    uint64_t time_current = _time_ns();
+    uint32_t tick_current = (uint32_t)((time_current - time_init) / 1000000);
+    int32_t delay = (int32_t)(ticks - tick_current);
+
+    if (delay <= 0)
+    {
+        /* No delay or already expired */
+        return osErrorParameter;
+    }
+
+    uint64_t time_tick = time_init + ((time_current - time_init) / 1000000) * 1000000;
+    _sleep_until(time_tick + (uint64_t)delay * 1000000);
 
     return osOK;
 }
@@ -147,28 +210,71 @@ int32_t osKernelUnlock(void)
     return 0;
 }
 
-static uint64_t time_init = UINT64_MAX;
 uint32_t osKernelGetTickCount(void)
 {
-    /* Get the current time. */
-    struct timeval tt;
-    gettimeofday(&tt, NULL);
-    uint64_t time_current = (tt.tv_sec * 1000) + (tt.tv_usec / 1000);
+    return (uint32_t)((_time_ns() - time_init) / 1000000);
+}
+
+uint32_t osKernelGetTickFreq(void)
+{
+    return 1000;
+}
+
+uint32_t osKernelGetSysTimerCount(void)
+{
+    return (uint32_t)(_time_ns() - time_init);
+}
+
+uint32_t osKernelGetSysTimerFreq(void)
+{
+    return 1000000000;
+}
+
+uint64_t osKernelGetTimeNs(void)
+{
+    return _time_ns();
+}
+
+osStatus_t osKernelSetVirtualTime(uint32_t enable, uint32_t scale)
+{
+    int state;
+
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &state);
+    pthread_mutex_lock(&vtime.mutex);
+
+    _vt_base_set(_time_ns(), (enable != 0) ? scale : 1);
+    vtime.scale = scale;
+    __atomic_store_n(&vtime.enabled, enable != 0, __ATOMIC_RELEASE);
 
-    if (time_init == UINT64_MAX)
+    /* The sleeping threads go on waiting in the real time if disabled, or
+       reload their real deadlines in the new scale. */
+    while (enable == 0 && vtime.sleeping != NULL)
     {
-        time_init = time_current;
+        _vt_wake(&vtime.sleeping);
+    }
+    _vt_poke();
+    if (enable != 0)
+    {
+        _vt_advance();
     }
 
-    return (uint32_t)(time_current - time_init);
+    pthread_mutex_unlock(&vtime.mutex);
+    pthread_setcancelstate(state, NULL);
+
+    return osOK;
 }
 
-uint32_t osKernelGetSysTimerCount(void)
+int16_t elab_debug_uart_receive(void *buffer, uint16_t size);
+
+void osKernelHeapLock(void)
 {
-    return osKernelGetTickCount();
+    __atomic_store_n(&heap_locked, true, __ATOMIC_RELEASE);
 }
 
-int16_t elab_debug_uart_receive(void *buffer, uint16_t size);
+void osKernelHeapUnlock(void)
+{
+    __atomic_store_n(&heap_locked, false, __ATOMIC_RELEASE);
+}
 
 osStatus_t osKernelStart(void)
 {
@@ -183,35 +289,202 @@ osStatus_t osKernelStart(void)
 /* -----------------------------------------------------------------------------
 Thread
 ----------------------------------------------------------------------------- */
-typedef void *(*os_pthread_func_t) (void *argument);
+/* The thread ID is the pointer of the thread control block. The threads which
+   are not created by osThreadNew, like the main thread, get one control block
+   when they call the thread functions at the first time. In the virtual time
+   mode, the blocked thread sleeps on its own futex word in the sleeping list,
+   and the futex waking on the word waited is forwarded to it.
+   The threads created by osThreadNew are in the thread list until they exit.
+   The free stack is painted with the pattern when the thread starts, which
+   prefaults it as well, and the high-water mark is the lowest word of the
+   pattern overwritten. */
+struct os_thread
+{
+    pthread_t thread;
+    osThreadFunc_t func;
+    void *argument;
+    const char *name;
+    uint32_t flags;                             /* Thread flags, futex */
+    uint32_t waiters;
+    uint32_t exited;                            /* Futex, 1 if exited */
+    bool foreign;                               /* Not created by osThreadNew */
+    bool cb_dynamic;
+    bool detached;                              /* Not joinable */
+    bool reaping;                               /* Freed by the terminator */
+    bool vt_blocked;                            /* Not counted as running */
+    bool listed;                                /* In the thread list */
+    uint32_t vt_wake;                           /* Futex, bit 0 if woken up */
+    uint32_t *vt_futex;                         /* NULL if not sleeping */
+    uint64_t vt_deadline;                       /* UINT64_MAX for ever */
+    os_thread_t *vt_next;
+    os_thread_t *list_next;                     /* Thread list */
+    os_thread_t *list_prev;
+    uint8_t *stack_low;                         /* NULL if not painted */
+    uint8_t *stack_paint;                       /* Lowest painted byte */
+    uint32_t stack_size;
+};
+
+_Static_assert(sizeof(os_thread_t) <= sizeof(osThreadBlock_t),
+                "osThreadBlock_t is too small.");
+
+static __thread os_thread_t *thread_self = NULL;
+static pthread_key_t thread_key;
+static pthread_once_t thread_key_once = PTHREAD_ONCE_INIT;
+static os_thread_t thread_foreign[ELAB_RTOS_FOREIGN_THREAD_MAX];
+static bool thread_foreign_used[ELAB_RTOS_FOREIGN_THREAD_MAX];
+static pthread_mutex_t mutex_thread_list = PTHREAD_MUTEX_INITIALIZER;
+static os_thread_t *thread_list = NULL;
+static uint32_t thread_count = 0;
+
+/* The real-time profile is selected before the threads are created, and read
+   by osThreadNew only. The threads at or above priority_rt are the real-time
+   ones. Every part of the profile failing for the privilege falls back to the
+   normal scheduling, with one warning. */
+static struct
+{
+    bool enabled;
+    bool warned_sched;
+    osKernelRtProfile_t profile;
+} rt =
+{
+    false, false, { 0, 0, osPriorityNone },
+};
+
+static void *_thread_entry(void *para);
+static void _thread_exit(void *para);
+static os_thread_t *_thread_self(void);
+static void _thread_stack_paint(os_thread_t *thread);
+static void _thread_list_remove(os_thread_t *thread);
+static uint32_t _cpu_mask_online(void);
+static void _cpu_mask_to_set(uint32_t mask, cpu_set_t *cpu_set);
+static const char *_sched_policy_name(int policy);
+
+osStatus_t osKernelSetRtProfile(const osKernelRtProfile_t *profile)
+{
+    if (profile == NULL)
+    {
+        if (rt.enabled && (rt.profile.attr_bits & osKernelRtMemLock) != 0)
+        {
+            munlockall();
+        }
+        rt.enabled = false;
+
+        return osOK;
+    }
+    if (profile->affinity_mask != 0 &&
+        (profile->affinity_mask & _cpu_mask_online()) == 0)
+    {
+        return osErrorParameter;
+    }
+
+    rt.profile = *profile;
+    if (rt.profile.priority_rt == osPriorityNone)
+    {
+        rt.profile.priority_rt = osPriorityHigh7;
+    }
+    if ((rt.profile.attr_bits & osKernelRtMemLock) != 0 &&
+        mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+    {
+        fprintf(stderr, "eLab warning: mlockall failed (%s), the memory is not "
+                        "locked.\n", strerror(errno));
+        rt.profile.attr_bits &= ~osKernelRtMemLock;
+    }
+    rt.warned_sched = false;
+    rt.enabled = true;
+
+    return osOK;
+}
 
 osThreadId_t osThreadNew(osThreadFunc_t func, void *argument, const osThreadAttr_t *attr)
 {
     int ret = 0;
-    pthread_t thread = 0;
     pthread_attr_t thread_attr;
     struct sched_param param;
+    cpu_set_t cpu_set;
+
+    os_thread_t *thread = NULL;
+    if (attr != NULL && attr->cb_mem != NULL)
+    {
+        assert(attr->cb_size >= sizeof(os_thread_t));
+        thread = (os_thread_t *)attr->cb_mem;
+        memset(thread, 0, sizeof(os_thread_t));
+    }
+    else
+    {
+        thread = _os_malloc(sizeof(os_thread_t));
+        memset(thread, 0, sizeof(os_thread_t));
+        thread->cb_dynamic = true;
+    }
+    thread->func = func;
+    thread->argument = argument;
+    thread->name = (attr != NULL) ? attr->name : NULL;
+    thread->detached = (attr == NULL ||
+                        (attr->attr_bits & osThreadJoinable) == 0);
 
     ret = pthread_attr_init(&thread_attr);
     assert(ret == 0);
 
-    ret = pthread_attr_setinheritsched(&thread_attr, PTHREAD_EXPLICIT_SCHED);
-    assert(ret == 0);
+    /* The detached thread frees its control block itself when it exits. */
+    if (thread->detached)
+    {
+        ret = pthread_attr_setdetachstate(&thread_attr, PTHREAD_CREATE_DETACHED);
+        assert(ret == 0);
+    }
 
-    ret = pthread_attr_setschedpolicy(&thread_attr, SCHED_RR);
+    ret = pthread_attr_setinheritsched(&thread_attr, PTHREAD_EXPLICIT_SCHED);
     assert(ret == 0);
 
     uint32_t stack_size = 40960;
+    osPriority_t priority = osPriorityNormal;
     if (attr != NULL)
     {
-        param.sched_priority = get_pthread_priority(attr->priority);
-        stack_size = attr->stack_size * 20;
+        priority = attr->priority;
+        if (attr->stack_size != 0)
+        {
+            stack_size = attr->stack_size * 20;
+        }
+    }
+
+    /* The real-time threads run in SCHED_FIFO on their CPUs, and the others
+       are kept off these CPUs in the normal scheduling. */
+    int policy = SCHED_RR;
+    param.sched_priority = get_pthread_priority(priority);
+    uint32_t affinity_mask = (attr != NULL) ? attr->affinity_mask : 0;
+    if (rt.enabled)
+    {
+        bool realtime = (priority >= rt.profile.priority_rt);
+        if ((rt.profile.attr_bits & osKernelRtSched) != 0)
+        {
+            policy = realtime ? SCHED_FIFO : SCHED_OTHER;
+            param.sched_priority = realtime ? param.sched_priority : 0;
+        }
+        if (affinity_mask == 0 && rt.profile.affinity_mask != 0)
+        {
+            affinity_mask = realtime ? rt.profile.affinity_mask :
+                                        (~rt.profile.affinity_mask);
+        }
+    }
+    affinity_mask &= _cpu_mask_online();
+    if (affinity_mask != 0)
+    {
+        _cpu_mask_to_set(affinity_mask, &cpu_set);
+        ret = pthread_attr_setaffinity_np(&thread_attr,
+                                            sizeof(cpu_set_t), &cpu_set);
+        assert(ret == 0);
+    }
+    ret = pthread_attr_setschedpolicy(&thread_attr, policy);
+    assert(ret == 0);
+    if (attr != NULL && attr->stack_mem != NULL)
+    {
+        /* The given stack is used as it is, which should not be smaller than
+           PTHREAD_STACK_MIN. */
+        ret = pthread_attr_setstack(&thread_attr,
+                                    attr->stack_mem, attr->stack_size);
     }
     else
     {
-        param.sched_priority = get_pthread_priority(osPriorityNormal);
+        ret = pthread_attr_setstacksize(&thread_attr, stack_size);
     }
-    ret = pthread_attr_setstacksize(&thread_attr, stack_size);
     assert(ret == 0);
     ret = pthread_attr_setschedparam(&thread_attr, &param);
     assert(ret == 0);
@@ -219,739 +492,3377 @@ osThreadId_t osThreadNew(osThreadFunc_t func, void *argument, const osThreadAttr
     assert(ret == 0);
     ret = pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, NULL);
     assert(ret == 0);
-    ret = pthread_create(&thread, &thread_attr, (os_pthread_func_t)func, argument);
+    /* Counted before running, so the virtual time never jumps over it. */
+    __atomic_add_fetch(&vtime.running, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&mutex_thread_list);
+    thread->list_next = thread_list;
+    if (thread_list != NULL)
+    {
+        thread_list->list_prev = thread;
+    }
+    thread_list = thread;
+    thread->listed = true;
+    thread_count ++;
+    pthread_mutex_unlock(&mutex_thread_list);
+    ret = pthread_create(&thread->thread, &thread_attr, _thread_entry, thread);
+    if (ret == EPERM && policy != SCHED_OTHER)
+    {
+        /* No privilege for the real-time scheduling. */
+        if (!__atomic_exchange_n(&rt.warned_sched, true, __ATOMIC_RELAXED))
+        {
+            fprintf(stderr, "eLab warning: no privilege for %s, the threads "
+                            "run in SCHED_OTHER.\n", _sched_policy_name(policy));
+        }
+        param.sched_priority = 0;
+        ret = pthread_attr_setschedpolicy(&thread_attr, SCHED_OTHER);
+        assert(ret == 0);
+        ret = pthread_attr_setschedparam(&thread_attr, &param);
+        assert(ret == 0);
+        ret = pthread_create(&thread->thread, &thread_attr, _thread_entry, thread);
+    }
     assert(ret == 0);
 
     pthread_attr_destroy(&thread_attr);
 
+    /* The real-time threads report what they really get. */
+    if (rt.enabled && priority >= rt.profile.priority_rt)
+    {
+        int32_t policy_achieved = SCHED_OTHER, priority_achieved = 0;
+        osThreadGetSched(thread, &policy_achieved, &priority_achieved);
+        printf("eLab RT profile: thread %-20s %-11s %2d, CPUs 0x%x.\n",
+                (thread->name != NULL) ? thread->name : "(null)",
+                _sched_policy_name(policy_achieved), priority_achieved,
+                osThreadGetAffinityMask(thread));
+    }
+
     return (osThreadId_t)thread;
 }
 
-osThreadId_t osThreadGetId(void)
+osStatus_t osThreadGetSched(osThreadId_t thread_id,
+                            int32_t *policy, int32_t *priority)
 {
-    return (osThreadId_t)pthread_self();
-}
+    assert(thread_id != NULL);
+    assert(policy != NULL && priority != NULL);
 
-osStatus_t osThreadTerminate(osThreadId_t thread_id)
-{
-    int ret = 0;
-    for (uint32_t i = 0; i < 100; i ++)
+    struct sched_param param;
+    int policy_get = 0;
+    int ret = pthread_getschedparam(((os_thread_t *)thread_id)->thread,
+                                    &policy_get, &param);
+    if (ret != 0)
     {
-        pthread_cancel((pthread_t)thread_id);
-        ret = pthread_kill((pthread_t)thread_id, 0);
-        if (ret != 0)
-        {
-            goto exit;
-        }
-        osDelay(1);
+        return osErrorResource;
     }
-    printf("pthread_kill ret: %d.\n", ret);
-    assert(false);
+    *policy = policy_get;
+    *priority = param.sched_priority;
 
-exit:
     return osOK;
 }
 
-void osThreadExit(void)
+osStatus_t osThreadSetAffinityMask(osThreadId_t thread_id, uint32_t affinity_mask)
 {
-    pthread_exit(NULL);
+    assert(thread_id != NULL);
+
+    cpu_set_t cpu_set;
+    affinity_mask = (affinity_mask == 0) ? _cpu_mask_online() :
+                                    (affinity_mask & _cpu_mask_online());
+    if (affinity_mask == 0)
+    {
+        return osErrorParameter;
+    }
+    _cpu_mask_to_set(affinity_mask, &cpu_set);
+    int ret = pthread_setaffinity_np(((os_thread_t *)thread_id)->thread,
+                                        sizeof(cpu_set_t), &cpu_set);
+
+    return (ret == 0) ? osOK : osErrorResource;
 }
 
-osStatus_t osThreadJoin(osThreadId_t thread_id)
+uint32_t osThreadGetAffinityMask(osThreadId_t thread_id)
 {
     assert(thread_id != NULL);
 
-    int ret = pthread_join((pthread_t)thread_id, NULL);
-    assert(ret == 0);
+    cpu_set_t cpu_set;
+    uint32_t affinity_mask = 0;
+    int ret = pthread_getaffinity_np(((os_thread_t *)thread_id)->thread,
+                                        sizeof(cpu_set_t), &cpu_set);
+    for (uint32_t i = 0; ret == 0 && i < 32; i ++)
+    {
+        affinity_mask |= CPU_ISSET(i, &cpu_set) ? (1U << i) : 0;
+    }
 
-    return osOK;
+    return affinity_mask;
 }
 
-/* -----------------------------------------------------------------------------
-Message queue
------------------------------------------------------------------------------ */
-typedef struct os_mq
+uint32_t osThreadGetCount(void)
 {
-    osMutexId_t mutex;
-    osSemaphoreId_t sem_empty;
-    osSemaphoreId_t sem_full;
-    uint8_t *memory;
-    uint32_t msg_size;
-    uint32_t capacity;
-    uint32_t head;
-    uint32_t tail;
-    bool empty;
-    bool full;
-} os_mq_t;
+    return __atomic_load_n(&thread_count, __ATOMIC_RELAXED);
+}
 
-osMessageQueueId_t osMessageQueueNew(uint32_t msg_count,
-                                     uint32_t msg_size,
-                                     const osMessageQueueAttr_t *attr)
+uint32_t osThreadEnumerate(osThreadId_t *thread_array, uint32_t array_items)
 {
-    assert(attr == NULL);
-    assert(msg_count != 0);
-    assert(msg_size != 0);
+    assert(thread_array != NULL);
 
-    os_mq_t *mq = malloc(sizeof(os_mq_t));
-    assert(mq != NULL);
+    uint32_t count = 0;
+    pthread_mutex_lock(&mutex_thread_list);
+    for (os_thread_t *thread = thread_list;
+            thread != NULL && count < array_items; thread = thread->list_next)
+    {
+        thread_array[count ++] = (osThreadId_t)thread;
+    }
+    pthread_mutex_unlock(&mutex_thread_list);
 
-    mq->mutex = osMutexNew(&mutex_attr_queue);
-    assert(mq->mutex != NULL);
-    mq->sem_full = osSemaphoreNew(msg_count, msg_count, NULL);
-    assert(mq->sem_full != NULL);
-    mq->sem_empty = osSemaphoreNew(msg_count, 0, NULL);
-    assert(mq->sem_empty != NULL);
+    return count;
+}
 
-    mq->capacity = msg_count;
-    mq->msg_size = msg_size;
-    mq->memory = (uint8_t *)malloc(msg_size * msg_count);
-    assert(mq->memory != NULL);
+uint32_t osThreadGetStackSize(osThreadId_t thread_id)
+{
+    assert(thread_id != NULL);
 
-    mq->head = 0;
-    mq->tail = 0;
-    mq->empty = true;
-    mq->full = false;
+    os_thread_t *thread = (os_thread_t *)thread_id;
 
-    return (osMessageQueueId_t)mq;
+    return (__atomic_load_n(&thread->stack_low, __ATOMIC_ACQUIRE) != NULL) ?
+            thread->stack_size : 0;
 }
 
-osStatus_t osMessageQueueDelete(osMessageQueueId_t mq_id)
+uint32_t osThreadGetStackSpace(osThreadId_t thread_id)
 {
-    os_mq_t *mq = (os_mq_t *)mq_id;
+    assert(thread_id != NULL);
+
+    os_thread_t *thread = (os_thread_t *)thread_id;
+    uint8_t *stack_low = __atomic_load_n(&thread->stack_low, __ATOMIC_ACQUIRE);
+    if (stack_low == NULL ||
+        __atomic_load_n(&thread->exited, __ATOMIC_ACQUIRE) != 0)
+    {
+        return 0;
+    }
 
-    osMutexDelete(mq->mutex);
-    free(mq->memory);
-    free(mq);
+    /* The stack grows down, so the pattern left at the bottom is never used. */
+    volatile uint64_t *word = (volatile uint64_t *)thread->stack_paint;
+    volatile uint64_t *word_end =
+        (volatile uint64_t *)(stack_low + thread->stack_size);
+    while (word < word_end && *word == RTOS_STACK_PAINT_PATTERN)
+    {
+        word ++;
+    }
 
-    return osOK;
+    return (uint32_t)((uint8_t *)word - stack_low);
 }
 
-osStatus_t osMessageQueueReset(osMessageQueueId_t mq_id)
+uint64_t osThreadGetCpuTimeNs(osThreadId_t thread_id)
 {
-    os_mq_t *mq = (os_mq_t *)mq_id;
+    assert(thread_id != NULL);
+
+    os_thread_t *thread = (os_thread_t *)thread_id;
+    clockid_t clock_id;
+    struct timespec ts;
+
+    if (__atomic_load_n(&thread->exited, __ATOMIC_ACQUIRE) != 0 ||
+        pthread_getcpuclockid(thread->thread, &clock_id) != 0 ||
+        clock_gettime(clock_id, &ts) != 0)
+    {
+        return 0;
+    }
+
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+const char *osThreadGetName(osThreadId_t thread_id)
+{
+    assert(thread_id != NULL);
 
-    osMutexAcquire(mq->mutex, osWaitForever);
+    return ((os_thread_t *)thread_id)->name;
+}
 
-    mq->head = 0;
-    mq->tail = 0;
-    mq->empty = true;
-    mq->full = false;
+osThreadId_t osThreadGetId(void)
+{
+    return (osThreadId_t)_thread_self();
+}
 
-    osMutexRelease(mq->mutex);
+osStatus_t osThreadYield(void)
+{
+    sched_yield();
 
     return osOK;
 }
 
-osStatus_t osMessageQueuePut(osMessageQueueId_t mq_id,
-                             const void *msg_ptr,
-                             uint8_t msg_prio,
-                             uint32_t timeout)
+osStatus_t osThreadTerminate(osThreadId_t thread_id)
 {
-    (void)msg_prio;
+    assert(thread_id != NULL);
 
-    osStatus_t ret_os = osOK;
+    os_thread_t *thread = (os_thread_t *)thread_id;
 
-    if (timeout != osWaitForever)
+    if (thread == _thread_self())
     {
-        assert(timeout < (1000 * 60 * 60 * 24));
+        pthread_exit(NULL);
     }
 
-    os_mq_t *mq = (os_mq_t *)mq_id;
-    ret_os = osSemaphoreAcquire(mq->sem_full, timeout);
-    assert(ret_os == osOK);
+    /* The detached thread can not be joined. It is cancelled only if it is not
+       exiting yet, and then its control block is freed here after it exits,
+       not by itself. */
+    if (!thread->foreign && thread->detached)
+    {
+        pthread_mutex_lock(&mutex_thread_list);
+        bool listed = thread->listed;
+        if (listed)
+        {
+            thread->reaping = true;
+            pthread_cancel(thread->thread);
+        }
+        pthread_mutex_unlock(&mutex_thread_list);
+        if (!listed)
+        {
+            return osErrorResource;
+        }
+        while (__atomic_load_n(&thread->exited, __ATOMIC_ACQUIRE) == 0)
+        {
+            _futex_wait(&thread->exited, 0, NULL);
+        }
+        if (thread->cb_dynamic)
+        {
+            free(thread);
+        }
 
-    ret_os = osMutexAcquire(mq->mutex, osWaitForever);
-    assert(ret_os == osOK);
-    assert(mq->full == false || mq->empty == false);
-    memcpy(&mq->memory[mq->head * mq->msg_size], msg_ptr, mq->msg_size);
-    mq->head = (mq->head + 1) % mq->capacity;
-    mq->empty = false;
-    if (mq->head == mq->tail)
+        return osOK;
+    }
+
+    /* pthread_kill(thread, 0) still succeeds on a cancelled thread which is
+       not joined yet, so join it to make sure it has really terminated. The
+       control block of the foreign thread is freed when it exits. */
+    bool cb_dynamic = !thread->foreign && thread->cb_dynamic;
+    int ret = pthread_cancel(thread->thread);
+    if (ret != 0)
     {
-        mq->full = true;
+        return osErrorResource;
+    }
+    _vt_block();
+    ret = pthread_join(thread->thread, NULL);
+    _vt_unblock();
+    assert(ret == 0);
+    if (cb_dynamic)
+    {
+        free(thread);
     }
-    ret_os = osMutexRelease(mq->mutex);
-    assert(ret_os == osOK);
-    ret_os = osSemaphoreRelease(mq->sem_empty);
-    assert(ret_os == osOK);
 
     return osOK;
 }
 
-osStatus_t osMessageQueueGet(osMessageQueueId_t mq_id,
-                             void *msg_ptr,
-                             uint8_t *msg_prio,
-                             uint32_t timeout)
+void osThreadExit(void)
 {
-    (void)msg_prio;
+    pthread_exit(NULL);
+}
 
-    osStatus_t ret_os = osOK;
+osStatus_t osThreadJoin(osThreadId_t thread_id)
+{
+    assert(thread_id != NULL);
 
-    if (timeout != osWaitForever)
+    os_thread_t *thread = (os_thread_t *)thread_id;
+    if (!thread->foreign && thread->detached)
     {
-        assert(timeout < (1000 * 60 * 60 * 24));
+        return osErrorResource;
     }
-
-    os_mq_t *mq = (os_mq_t *)mq_id;
-    osStatus_t ret = osSemaphoreAcquire(mq->sem_empty, timeout);
-    if (ret == osErrorTimeout)
+    bool cb_dynamic = !thread->foreign && thread->cb_dynamic;
+    /* Wait for the exiting on the futex, which follows the virtual time. */
+    while (!thread->foreign &&
+            __atomic_load_n(&thread->exited, __ATOMIC_ACQUIRE) == 0)
     {
-        return osErrorTimeout;
+        _futex_wait(&thread->exited, 0, NULL);
     }
-
-    ret_os = osMutexAcquire(mq->mutex, osWaitForever);
-    assert(ret_os == osOK);
-    assert(mq->full == false || mq->empty == false);
-    memcpy(msg_ptr, &mq->memory[mq->tail * mq->msg_size], mq->msg_size);
-    mq->tail = (mq->tail + 1) % mq->capacity;
-    mq->full = false;
-    if (mq->head == mq->tail)
+    _vt_block();
+    int ret = pthread_join(thread->thread, NULL);
+    _vt_unblock();
+    assert(ret == 0);
+    /* The control block of the foreign thread is freed when it exits. */
+    if (cb_dynamic)
     {
-        mq->empty = true;
+        free(thread);
     }
-    ret_os = osMutexRelease(mq->mutex);
-    assert(ret_os == osOK);
-    ret_os = osSemaphoreRelease(mq->sem_full);
-    assert(ret_os == osOK);
 
     return osOK;
 }
 
 /* -----------------------------------------------------------------------------
-Mutex
+Futex
 ----------------------------------------------------------------------------- */
-typedef struct os_mutex_data
-{
-    osMutexAttr_t attr;
-    pthread_mutex_t mutex;
-} os_mutex_data_t;
-
-osMutexId_t osMutexNew(const osMutexAttr_t *attr)
+/**
+  * @brief  Get the absolute deadline in the OS time after the given ticks.
+  */
+static void _deadline_get(struct timespec *deadline, uint32_t timeout)
 {
-    (void)attr;
+    uint64_t time_ns = _time_ns() + (uint64_t)timeout * 1000000;
 
-    os_mutex_data_t *data = malloc(sizeof(os_mutex_data_t));
-    assert(data != NULL);
+    deadline->tv_sec = time_ns / 1000000000;
+    deadline->tv_nsec = time_ns % 1000000000;
+}
 
-    int ret = pthread_mutex_init(&data->mutex, NULL);
-    assert(ret == 0);
+/**
+  * @brief  Wait on the futex word in the kernel while it equals to the given
+  *         value. The thread may be cancelled during the waiting.
+  * @param  deadline    Absolute CLOCK_MONOTONIC time, NULL for ever.
+  * @retval false if timeout, true if woken up or the value changed.
+  */
+static bool _futex_sleep(uint32_t *futex, uint32_t value,
+                            const struct timespec *deadline)
+{
+    int type_old;
+    long ret;
 
-    memcpy(&data->attr, attr, sizeof(osMutexAttr_t));
+    pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, &type_old);
+    ret = syscall(SYS_futex, futex, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG,
+                    value, deadline, NULL, FUTEX_BITSET_MATCH_ANY);
+    pthread_setcanceltype(type_old, NULL);
 
-    return (osMutexId_t)data;
+    return (ret == -1 && errno == ETIMEDOUT) ? false : true;
 }
 
-osStatus_t osMutexDelete(osMutexId_t mutex_id)
+/**
+  * @brief  Wait on the futex word while it equals to the given value. The
+  *         thread may be cancelled during the waiting, just like sem_wait.
+  * @param  deadline    Absolute OS time, NULL for ever.
+  * @retval false if timeout, true if woken up or the value changed.
+  */
+static bool _futex_wait(uint32_t *futex, uint32_t value,
+                        const struct timespec *deadline)
 {
-    os_mutex_data_t *data = (os_mutex_data_t *)mutex_id;
+    uint64_t time_deadline = UINT64_MAX;
+    struct timespec clock_deadline;
 
-    int ret = pthread_mutex_destroy(&data->mutex);
-    assert(ret == 0);
+    if (deadline != NULL)
+    {
+        time_deadline = (uint64_t)deadline->tv_sec * 1000000000 +
+                        (uint64_t)deadline->tv_nsec;
+    }
+    /* No real deadline if the virtual time is switched on in the meantime. */
+    if (__atomic_load_n(&vtime.enabled, __ATOMIC_ACQUIRE) ||
+        (deadline != NULL && !_time_to_clock(time_deadline, &clock_deadline)))
+    {
+        return _vt_wait(futex, value, time_deadline);
+    }
 
-    free(data);
+    _vt_block();
+    bool ret = _futex_sleep(futex, value,
+                            (deadline == NULL) ? NULL : &clock_deadline);
+    _vt_unblock();
 
-    return osOK;
+    return ret;
+}
+
+/**
+  * @brief  Wake up all the threads waiting on the futex word.
+  */
+static void _futex_wake(uint32_t *futex)
+{
+    syscall(SYS_futex, futex, FUTEX_WAKE | FUTEX_PRIVATE_FLAG,
+            INT_MAX, NULL, NULL, 0);
+
+    /* Pairs with the sleeper registering before checking the futex word. */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&vtime.sleeping, __ATOMIC_RELAXED) != NULL)
+    {
+        int state;
+        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &state);
+        pthread_mutex_lock(&vtime.mutex);
+        os_thread_t **link = &vtime.sleeping;
+        while (*link != NULL)
+        {
+            if ((*link)->vt_futex == futex)
+            {
+                _vt_wake(link);
+            }
+            else
+            {
+                link = &(*link)->vt_next;
+            }
+        }
+        pthread_mutex_unlock(&vtime.mutex);
+        pthread_setcancelstate(state, NULL);
+    }
+}
+
+/**
+  * @brief  Bump the event futex and wake up the waiters, only if any of them
+  *         has registered in the waiter count.
+  */
+static void _futex_notify(uint32_t *event, uint32_t *waiters)
+{
+    /* Pairs with the waiter registering before checking the state again, so
+       either the waiter sees the new state or we see the waiter. */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(waiters, __ATOMIC_RELAXED) != 0)
+    {
+        __atomic_add_fetch(event, 1, __ATOMIC_SEQ_CST);
+        _futex_wake(event);
+    }
+}
+
+/**
+  * @brief  Unregister the waiter when the thread is cancelled in waiting.
+  */
+static void _futex_waiter_cleanup(void *para)
+{
+    __atomic_sub_fetch((uint32_t *)para, 1, __ATOMIC_SEQ_CST);
+}
+
+/* -----------------------------------------------------------------------------
+Profile
+----------------------------------------------------------------------------- */
+#if (ELAB_RTOS_PROFILE_EN != 0)
+/* The contention profile is kept per object type and name, so the objects of
+   the same name, like the mutexes of the devices, are summed up in one record.
+   The acquiring is counted in the object itself, by the owner of the mutex
+   without any atomic operation, and the live objects are summed up when
+   printing, so the fast path never writes the shared record. The clock is only
+   read in the contended path, and the holding time of the mutex is sampled
+   once in every RTOS_PROFILE_HOLD_SAMPLE acquiring. */
+typedef struct os_profile_obj
+{
+    struct os_profile_obj *next;
+    struct os_profile *profile;
+    uint64_t acquire;
+    uint64_t acquire_reset;                     /* Acquiring at last reset */
+} os_profile_obj_t;
+
+typedef struct os_profile
+{
+    struct os_profile *next;
+    os_profile_obj_t *obj_list;                 /* Live objects */
+    const char *type;
+    char *name;
+    uint64_t acquire;                           /* Of deleted objects */
+    uint64_t contended;
+    uint64_t wait_total;                        /* In ns */
+    uint64_t wait_max;
+    uint64_t hold_total;                        /* Sampled, in ns */
+    uint64_t hold_max;
+    uint64_t hold_count;                        /* Number of samples */
+} os_profile_t;
+
+static pthread_mutex_t mutex_profile = PTHREAD_MUTEX_INITIALIZER;
+static os_profile_t *profile_list = NULL;
+static uint32_t profile_count = 0;
+
+/**
+  * @brief  Attach the object to the profile record of its type and name, one
+  *         record is created for the new name and never freed.
+  */
+static void _profile_attach(os_profile_obj_t *obj,
+                            const char *type, const char *name)
+{
+    if (name == NULL)
+    {
+        name = "(null)";
+    }
+
+    pthread_mutex_lock(&mutex_profile);
+    os_profile_t *profile = profile_list;
+    while (profile != NULL &&
+            (profile->type != type || strcmp(profile->name, name) != 0))
+    {
+        profile = profile->next;
+    }
+    if (profile == NULL)
+    {
+        profile = calloc(1, sizeof(os_profile_t));
+        assert(profile != NULL);
+        profile->type = type;
+        profile->name = strdup(name);
+        assert(profile->name != NULL);
+        profile->next = profile_list;
+        profile_list = profile;
+        profile_count ++;
+    }
+    obj->profile = profile;
+    obj->acquire = 0;
+    obj->acquire_reset = 0;
+    obj->next = profile->obj_list;
+    profile->obj_list = obj;
+    pthread_mutex_unlock(&mutex_profile);
+}
+
+/**
+  * @brief  Detach the deleted object, and keep its acquiring in the record.
+  */
+static void _profile_detach(os_profile_obj_t *obj)
+{
+    pthread_mutex_lock(&mutex_profile);
+    os_profile_obj_t **link = &obj->profile->obj_list;
+    while (*link != obj)
+    {
+        link = &(*link)->next;
+    }
+    *link = obj->next;
+    obj->profile->acquire += obj->acquire - obj->acquire_reset;
+    pthread_mutex_unlock(&mutex_profile);
+}
+
+/**
+  * @brief  Count one acquiring of the object which is only written by one
+  *         thread at a time, like the mutex by its owner.
+  * @retval The acquiring count after.
+  */
+static inline uint64_t _profile_acquire_owned(os_profile_obj_t *obj)
+{
+    uint64_t count = __atomic_load_n(&obj->acquire, __ATOMIC_RELAXED) + 1;
+    __atomic_store_n(&obj->acquire, count, __ATOMIC_RELAXED);
+
+    return count;
+}
+
+/**
+  * @brief  Count one acquiring of the object shared by many threads.
+  */
+static inline void _profile_acquire(os_profile_obj_t *obj)
+{
+    __atomic_add_fetch(&obj->acquire, 1, __ATOMIC_RELAXED);
+}
+
+static void _profile_max(uint64_t *max, uint64_t value)
+{
+    uint64_t value_max = __atomic_load_n(max, __ATOMIC_RELAXED);
+    while (value > value_max &&
+            !__atomic_compare_exchange_n(max, &value_max, value, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+/**
+  * @brief  Count one contended acquiring and its waiting time.
+  */
+static void _profile_wait(os_profile_t *profile, uint64_t time_start)
+{
+    uint64_t time = _clock_ns() - time_start;
+
+    __atomic_add_fetch(&profile->contended, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&profile->wait_total, time, __ATOMIC_RELAXED);
+    _profile_max(&profile->wait_max, time);
+}
+
+/**
+  * @brief  Count one sample of the holding time.
+  */
+static void _profile_hold(os_profile_t *profile, uint64_t time_start)
+{
+    uint64_t time = _clock_ns() - time_start;
+
+    __atomic_add_fetch(&profile->hold_count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&profile->hold_total, time, __ATOMIC_RELAXED);
+    _profile_max(&profile->hold_max, time);
+}
+
+/**
+  * @brief  The most waited object first.
+  */
+static int _profile_compare(const void *a, const void *b)
+{
+    uint64_t wait_a = (*(os_profile_t * const *)a)->wait_total;
+    uint64_t wait_b = (*(os_profile_t * const *)b)->wait_total;
+
+    return (wait_a < wait_b) ? 1 : ((wait_a > wait_b) ? -1 : 0);
+}
+#endif
+
+void osKernelProfilePrint(int fd, uint32_t csv)
+{
+#if (ELAB_RTOS_PROFILE_EN != 0)
+    pthread_mutex_lock(&mutex_profile);
+    uint32_t count = profile_count;
+    os_profile_t *profile = profile_list;
+    os_profile_t *snapshot = malloc(sizeof(os_profile_t) * (count + 1));
+    os_profile_t **sorted = malloc(sizeof(os_profile_t *) * (count + 1));
+    assert(snapshot != NULL && sorted != NULL);
+    for (uint32_t i = 0; i < count; i ++)
+    {
+        snapshot[i] = *profile;
+        for (os_profile_obj_t *obj = profile->obj_list; obj != NULL;
+                obj = obj->next)
+        {
+            snapshot[i].acquire +=
+                __atomic_load_n(&obj->acquire, __ATOMIC_RELAXED) -
+                obj->acquire_reset;
+        }
+        sorted[i] = &snapshot[i];
+        profile = profile->next;
+    }
+    pthread_mutex_unlock(&mutex_profile);
+    qsort(sorted, count, sizeof(os_profile_t *), _profile_compare);
+
+    if (csv != 0)
+    {
+        dprintf(fd, "type,name,acquire,contended,wait_total_ns,wait_max_ns,"
+                    "hold_avg_ns,hold_max_ns,hold_samples\n");
+    }
+    else
+    {
+        dprintf(fd, "%-10s %-24s %12s %12s %12s %12s %12s %12s\n",
+                "type", "name", "acquire", "contended", "wait (ms)",
+                "wait max(us)", "hold avg(us)", "hold max(us)");
+    }
+    for (uint32_t i = 0; i < count; i ++)
+    {
+        profile = sorted[i];
+        uint64_t hold_avg = (profile->hold_count == 0) ? 0 :
+                            (profile->hold_total / profile->hold_count);
+        if (csv != 0)
+        {
+            dprintf(fd, "%s,%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n",
+                    profile->type, profile->name,
+                    profile->acquire, profile->contended,
+                    profile->wait_total, profile->wait_max,
+                    hold_avg, profile->hold_max, profile->hold_count);
+        }
+        else
+        {
+            dprintf(fd, "%-10s %-24s %12lu %12lu %12.3f %12.1f %12.2f %12.1f\n",
+                    profile->type, profile->name,
+                    profile->acquire, profile->contended,
+                    (double)profile->wait_total / 1e6,
+                    (double)profile->wait_max / 1e3,
+                    (double)hold_avg / 1e3,
+                    (double)profile->hold_max / 1e3);
+        }
+    }
+
+    free(sorted);
+    free(snapshot);
+#else
+    if (csv == 0)
+    {
+        dprintf(fd, "The profile is disabled by ELAB_RTOS_PROFILE_EN.\n");
+    }
+#endif
+}
+
+void osKernelProfileReset(void)
+{
+#if (ELAB_RTOS_PROFILE_EN != 0)
+    pthread_mutex_lock(&mutex_profile);
+    for (os_profile_t *profile = profile_list; profile != NULL;
+            profile = profile->next)
+    {
+        profile->acquire = 0;
+        for (os_profile_obj_t *obj = profile->obj_list; obj != NULL;
+                obj = obj->next)
+        {
+            obj->acquire_reset = __atomic_load_n(&obj->acquire, __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&profile->contended, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&profile->wait_total, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&profile->wait_max, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&profile->hold_total, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&profile->hold_max, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&profile->hold_count, 0, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&mutex_profile);
+#endif
+}
+
+/* -----------------------------------------------------------------------------
+Message queue
+----------------------------------------------------------------------------- */
+/* The message queue is one bounded ring with atomic head and tail positions.
+   Positions are free-running counters, and the slot index is the position
+   masked by the power-of-two slot number. The SPSC mode just publishes the
+   positions. The default MPMC mode uses one sequence number per slot (Dmitry
+   Vyukov's bounded queue), so producers and consumers never take a lock. The
+   futex is only used when the queue is empty or full.
+   The priority mode keeps one FIFO list of message nodes per priority lane,
+   and one bitmap of the non-empty lanes, so the highest lane is found by
+   counting the leading zeros. Putting and getting are O(1) under one mutex,
+   and the head and tail positions are still counted for the message count. */
+typedef struct os_mq_prio
+{
+    pthread_mutex_t mutex;
+    uint32_t bitmap;                            /* Non-empty lanes */
+    uint32_t free;                              /* Free nodes, index + 1 */
+    uint32_t head[RTOS_MQ_PRIO_LANES];          /* Index + 1, 0 if empty */
+    uint32_t tail[RTOS_MQ_PRIO_LANES];
+    uint32_t next[];                            /* Index + 1 of next node */
+} os_mq_prio_t;
+
+_Static_assert(sizeof(os_mq_prio_t) <= RTOS_MQ_PRIO_HEADER_MAX,
+                "RTOS_MQ_PRIO_HEADER_MAX is too small.");
+
+typedef struct os_mq
+{
+    uint32_t tail RTOS_CACHE_ALIGNED;           /* Producer position */
+    uint32_t event_put;                         /* Futex, space available */
+    uint32_t waiters_put;
+
+    uint32_t head RTOS_CACHE_ALIGNED;           /* Consumer position */
+    uint32_t event_get;                         /* Futex, message available */
+    uint32_t waiters_get;
+
+    uint8_t *memory RTOS_CACHE_ALIGNED;
+    uint32_t *sequence;                         /* NULL in SPSC mode */
+    os_mq_prio_t *prio;                         /* NULL if not priority mode */
+    uint32_t msg_size;
+    uint32_t capacity;
+    uint32_t mask;
+    uint32_t spin;                              /* 0 on one CPU */
+    const char *name;
+#if (ELAB_RTOS_PROFILE_EN != 0)
+    os_profile_obj_t profile;
+#endif
+    bool cb_dynamic;
+    bool mq_dynamic;
+} os_mq_t;
+
+_Static_assert(sizeof(os_mq_t) <= sizeof(osMessageQueueBlock_t),
+                "osMessageQueueBlock_t is too small.");
+
+/* The reserving and peeking take one slot in place, which is published later
+   by committing and releasing. */
+typedef enum os_mq_op
+{
+    MQ_OP_PUT = 0,
+    MQ_OP_GET,
+    MQ_OP_RESERVE,
+    MQ_OP_PEEK,
+} os_mq_op_t;
+
+static void _mq_prio_link(os_mq_prio_t *prio, uint32_t node, uint8_t msg_prio);
+static void _mq_publish(os_mq_t *mq, uint32_t pos, uint32_t num, bool put);
+static uint32_t _mq_slot_index(os_mq_t *mq, const void *msg_ptr);
+static uint32_t _mq_transfer(os_mq_t *mq, os_mq_op_t op, void *msg_ptr,
+                                uint32_t count, uint8_t *msg_prio,
+                                uint32_t timeout);
+
+osMessageQueueId_t osMessageQueueNew(uint32_t msg_count,
+                                     uint32_t msg_size,
+                                     const osMessageQueueAttr_t *attr)
+{
+    assert(msg_count != 0);
+    assert(msg_size != 0);
+
+    os_mq_t *mq = NULL;
+    bool cb_dynamic = false;
+    if (attr != NULL && attr->cb_mem != NULL)
+    {
+        assert(attr->cb_size >= sizeof(os_mq_t));
+        assert(((uintptr_t)attr->cb_mem % sizeof(uint64_t)) == 0);
+        mq = (os_mq_t *)attr->cb_mem;
+    }
+    else
+    {
+        assert(!__atomic_load_n(&heap_locked, __ATOMIC_ACQUIRE));
+        int ret = posix_memalign((void **)&mq, RTOS_CACHE_LINE_SIZE, sizeof(os_mq_t));
+        assert(ret == 0);
+        cb_dynamic = true;
+    }
+    memset(mq, 0, sizeof(os_mq_t));
+    mq->cb_dynamic = cb_dynamic;
+
+    uint32_t slots = 1;
+    while (slots < msg_count)
+    {
+        slots <<= 1;
+    }
+    mq->capacity = msg_count;
+    mq->mask = slots - 1;
+    mq->msg_size = msg_size;
+    mq->name = (attr != NULL) ? attr->name : NULL;
+    mq->spin = (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? RTOS_MQ_SPIN_COUNT : 0;
+#if (ELAB_RTOS_PROFILE_EN != 0)
+    _profile_attach(&mq->profile, "mq", mq->name);
+#endif
+
+    /* The sequence numbers, or the priority lanes and the node links, are in
+       front of the messages in one memory. */
+    uint32_t attr_bits = (attr != NULL) ? attr->attr_bits : 0;
+    bool spsc = ((attr_bits & osMessageQueueSpsc) != 0);
+    bool prio = ((attr_bits & osMessageQueuePrio) != 0);
+    uint32_t size_header = spsc ? 0 : (sizeof(uint32_t) * slots);
+    if (prio)
+    {
+        size_header = sizeof(os_mq_prio_t) + sizeof(uint32_t) * msg_count;
+        size_header = (size_header + 7) & ~7;
+    }
+    uint32_t size_memory = size_header + msg_size * slots;
+    uint8_t *memory = NULL;
+    if (attr != NULL && attr->mq_mem != NULL)
+    {
+        assert(attr->mq_size >= size_memory);
+        assert(((uintptr_t)attr->mq_mem %
+                    (prio ? sizeof(uint64_t) : sizeof(uint32_t))) == 0);
+        memory = (uint8_t *)attr->mq_mem;
+    }
+    else
+    {
+        memory = _os_malloc(size_memory);
+        mq->mq_dynamic = true;
+    }
+    mq->memory = &memory[size_header];
+
+    mq->sequence = NULL;
+    mq->prio = NULL;
+    if (prio)
+    {
+        mq->prio = (os_mq_prio_t *)memory;
+        memset(mq->prio, 0, sizeof(os_mq_prio_t));
+        int ret = pthread_mutex_init(&mq->prio->mutex, NULL);
+        assert(ret == 0);
+        for (uint32_t i = 0; i < msg_count; i ++)
+        {
+            mq->prio->next[i] = (i + 1 < msg_count) ? (i + 2) : 0;
+        }
+        mq->prio->free = 1;
+    }
+    else if (!spsc)
+    {
+        mq->sequence = (uint32_t *)memory;
+        for (uint32_t i = 0; i < slots; i ++)
+        {
+            mq->sequence[i] = i;
+        }
+    }
+
+    return (osMessageQueueId_t)mq;
+}
+
+const char *osMessageQueueGetName(osMessageQueueId_t mq_id)
+{
+    assert(mq_id != NULL);
+
+    return ((os_mq_t *)mq_id)->name;
+}
+
+osStatus_t osMessageQueueDelete(osMessageQueueId_t mq_id)
+{
+    assert(mq_id != NULL);
+
+    os_mq_t *mq = (os_mq_t *)mq_id;
+
+#if (ELAB_RTOS_PROFILE_EN != 0)
+    _profile_detach(&mq->profile);
+#endif
+    if (mq->prio != NULL)
+    {
+        pthread_mutex_destroy(&mq->prio->mutex);
+    }
+    if (mq->mq_dynamic)
+    {
+        if (mq->prio != NULL)
+        {
+            free(mq->prio);
+        }
+        else
+        {
+            free((mq->sequence != NULL) ? (void *)mq->sequence : (void *)mq->memory);
+        }
+    }
+    if (mq->cb_dynamic)
+    {
+        free(mq);
+    }
+
+    return osOK;
+}
+
+osStatus_t osMessageQueueReset(osMessageQueueId_t mq_id)
+{
+    os_mq_t *mq = (os_mq_t *)mq_id;
+    uint8_t msg[mq->msg_size];
+
+    /* Discarding all the messages keeps the ring consistent even if other
+       threads are putting or getting at the same time. */
+    while (osMessageQueueGet(mq_id, msg, NULL, 0) == osOK)
+    {
+    }
+
+    return osOK;
+}
+
+osStatus_t osMessageQueuePut(osMessageQueueId_t mq_id,
+                             const void *msg_ptr,
+                             uint8_t msg_prio,
+                             uint32_t timeout)
+{
+    assert(mq_id != NULL);
+    assert(msg_ptr != NULL);
+    if (timeout != osWaitForever)
+    {
+        assert(timeout < (1000 * 60 * 60 * 24));
+    }
+
+    if (_mq_transfer((os_mq_t *)mq_id, MQ_OP_PUT, (void *)msg_ptr, 1,
+                        &msg_prio, timeout) == 0)
+    {
+        return (timeout == 0) ? osErrorResource : osErrorTimeout;
+    }
+
+    return osOK;
+}
+
+osStatus_t osMessageQueueGet(osMessageQueueId_t mq_id,
+                             void *msg_ptr,
+                             uint8_t *msg_prio,
+                             uint32_t timeout)
+{
+    assert(mq_id != NULL);
+    assert(msg_ptr != NULL);
+    if (timeout != osWaitForever)
+    {
+        assert(timeout < (1000 * 60 * 60 * 24));
+    }
+
+    if (msg_prio != NULL)
+    {
+        *msg_prio = 0;
+    }
+
+    if (_mq_transfer((os_mq_t *)mq_id, MQ_OP_GET, msg_ptr, 1,
+                        msg_prio, timeout) == 0)
+    {
+        return (timeout == 0) ? osErrorResource : osErrorTimeout;
+    }
+
+    return osOK;
+}
+
+uint32_t osMessageQueuePutN(osMessageQueueId_t mq_id,
+                            const void *msg_ptr,
+                            uint32_t msg_count,
+                            uint8_t msg_prio,
+                            uint32_t timeout)
+{
+    assert(mq_id != NULL);
+    assert(msg_ptr != NULL);
+    if (timeout != osWaitForever)
+    {
+        assert(timeout < (1000 * 60 * 60 * 24));
+    }
+
+    return _mq_transfer((os_mq_t *)mq_id, MQ_OP_PUT, (void *)msg_ptr,
+                        msg_count, &msg_prio, timeout);
+}
+
+uint32_t osMessageQueueGetN(osMessageQueueId_t mq_id,
+                            void *msg_ptr,
+                            uint32_t msg_count,
+                            uint8_t *msg_prio,
+                            uint32_t timeout)
+{
+    assert(mq_id != NULL);
+    assert(msg_ptr != NULL);
+    if (timeout != osWaitForever)
+    {
+        assert(timeout < (1000 * 60 * 60 * 24));
+    }
+
+    if (msg_prio != NULL)
+    {
+        *msg_prio = 0;
+    }
+
+    return _mq_transfer((os_mq_t *)mq_id, MQ_OP_GET, msg_ptr,
+                        msg_count, msg_prio, timeout);
+}
+
+void *osMessageQueueReserve(osMessageQueueId_t mq_id, uint32_t timeout)
+{
+    assert(mq_id != NULL);
+    if (timeout != osWaitForever)
+    {
+        assert(timeout < (1000 * 60 * 60 * 24));
+    }
+
+    void *msg_ptr = NULL;
+    _mq_transfer((os_mq_t *)mq_id, MQ_OP_RESERVE, &msg_ptr, 1, NULL, timeout);
+
+    return msg_ptr;
+}
+
+osStatus_t osMessageQueueCommit(osMessageQueueId_t mq_id,
+                                void *msg_ptr,
+                                uint8_t msg_prio)
+{
+    assert(mq_id != NULL);
+    assert(msg_ptr != NULL);
+
+    os_mq_t *mq = (os_mq_t *)mq_id;
+    uint32_t index = _mq_slot_index(mq, msg_ptr);
+
+    if (mq->prio != NULL)
+    {
+        pthread_mutex_lock(&mq->prio->mutex);
+        _mq_prio_link(mq->prio, index, msg_prio);
+        __atomic_add_fetch(&mq->tail, 1, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&mq->prio->mutex);
+    }
+    else if (mq->sequence == NULL)
+    {
+        uint32_t pos = __atomic_load_n(&mq->tail, __ATOMIC_RELAXED);
+        assert((pos & mq->mask) == index);
+        _mq_publish(mq, pos, 1, true);
+    }
+    else
+    {
+        /* The sequence number of the reserved slot is still its position. */
+        uint32_t pos = __atomic_load_n(&mq->sequence[index], __ATOMIC_RELAXED);
+        _mq_publish(mq, pos, 1, true);
+    }
+    _futex_notify(&mq->event_get, &mq->waiters_get);
+
+    return osOK;
+}
+
+void *osMessageQueuePeek(osMessageQueueId_t mq_id,
+                            uint8_t *msg_prio,
+                            uint32_t timeout)
+{
+    assert(mq_id != NULL);
+    if (timeout != osWaitForever)
+    {
+        assert(timeout < (1000 * 60 * 60 * 24));
+    }
+
+    if (msg_prio != NULL)
+    {
+        *msg_prio = 0;
+    }
+
+    void *msg_ptr = NULL;
+    _mq_transfer((os_mq_t *)mq_id, MQ_OP_PEEK, &msg_ptr, 1, msg_prio, timeout);
+
+    return msg_ptr;
+}
+
+osStatus_t osMessageQueueRelease(osMessageQueueId_t mq_id, void *msg_ptr)
+{
+    assert(mq_id != NULL);
+    assert(msg_ptr != NULL);
+
+    os_mq_t *mq = (os_mq_t *)mq_id;
+    uint32_t index = _mq_slot_index(mq, msg_ptr);
+
+    if (mq->prio != NULL)
+    {
+        pthread_mutex_lock(&mq->prio->mutex);
+        mq->prio->next[index] = mq->prio->free;
+        mq->prio->free = index + 1;
+        pthread_mutex_unlock(&mq->prio->mutex);
+    }
+    else if (mq->sequence == NULL)
+    {
+        uint32_t pos = __atomic_load_n(&mq->head, __ATOMIC_RELAXED);
+        assert((pos & mq->mask) == index);
+        _mq_publish(mq, pos, 1, false);
+    }
+    else
+    {
+        /* The sequence number of the peeked slot is its position plus one. */
+        uint32_t pos = __atomic_load_n(&mq->sequence[index], __ATOMIC_RELAXED) - 1;
+        _mq_publish(mq, pos, 1, false);
+    }
+    _futex_notify(&mq->event_put, &mq->waiters_put);
+
+    return osOK;
+}
+
+uint32_t osMessageQueueGetCapacity(osMessageQueueId_t mq_id)
+{
+    assert(mq_id != NULL);
+
+    return ((os_mq_t *)mq_id)->capacity;
+}
+
+uint32_t osMessageQueueGetMsgSize(osMessageQueueId_t mq_id)
+{
+    assert(mq_id != NULL);
+
+    return ((os_mq_t *)mq_id)->msg_size;
+}
+
+uint32_t osMessageQueueGetCount(osMessageQueueId_t mq_id)
+{
+    assert(mq_id != NULL);
+
+    os_mq_t *mq = (os_mq_t *)mq_id;
+    uint32_t head = __atomic_load_n(&mq->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = __atomic_load_n(&mq->tail, __ATOMIC_ACQUIRE);
+    int32_t count = (int32_t)(tail - head);
+
+    if (count < 0)
+    {
+        count = 0;
+    }
+    else if ((uint32_t)count > mq->capacity)
+    {
+        count = mq->capacity;
+    }
+
+    return (uint32_t)count;
+}
+
+uint32_t osMessageQueueGetSpace(osMessageQueueId_t mq_id)
+{
+    return osMessageQueueGetCapacity(mq_id) - osMessageQueueGetCount(mq_id);
+}
+
+/* -----------------------------------------------------------------------------
+Memory pool
+----------------------------------------------------------------------------- */
+/* The free blocks are linked in one lock-free stack. The link is the index of
+   the next free block stored in the first word of the block. The stack head
+   holds the block index in the low 32 bits and a tag in the high 32 bits,
+   which is increased in every change, so the CAS fails if the head has been
+   popped and pushed back in between (the ABA problem). */
+typedef struct os_mp
+{
+    uint64_t head;                              /* Tag << 32 | (index + 1) */
+    uint32_t event;                             /* Futex, block freed */
+    uint32_t waiters;
+    uint32_t count;                             /* Blocks used */
+    uint32_t count_max;                         /* Peak of blocks used */
+    uint8_t *memory;
+    uint32_t block_size;
+    uint32_t stride;
+    uint32_t capacity;
+    const char *name;
+    bool cb_dynamic;
+    bool mp_dynamic;
+} os_mp_t;
+
+_Static_assert(sizeof(os_mp_t) <= sizeof(osMemoryPoolBlock_t),
+                "osMemoryPoolBlock_t is too small.");
+
+static void *_mp_pop(os_mp_t *mp);
+
+osMemoryPoolId_t osMemoryPoolNew(uint32_t block_count,
+                                    uint32_t block_size,
+                                    const osMemoryPoolAttr_t *attr)
+{
+    assert(block_count != 0);
+    assert(block_size != 0);
+
+    os_mp_t *mp = NULL;
+    uint32_t stride = MEMPOOL_ARR_SIZE(1, block_size);
+
+    if (attr != NULL && attr->cb_mem != NULL)
+    {
+        assert(attr->cb_size >= sizeof(os_mp_t));
+        assert(((uintptr_t)attr->cb_mem % sizeof(uint64_t)) == 0);
+        mp = (os_mp_t *)attr->cb_mem;
+        memset(mp, 0, sizeof(os_mp_t));
+    }
+    else
+    {
+        mp = _os_malloc(sizeof(os_mp_t));
+        memset(mp, 0, sizeof(os_mp_t));
+        mp->cb_dynamic = true;
+    }
+
+    if (attr != NULL && attr->mp_mem != NULL)
+    {
+        assert(attr->mp_size >= MEMPOOL_ARR_SIZE(block_count, block_size));
+        assert(((uintptr_t)attr->mp_mem % sizeof(uint32_t)) == 0);
+        mp->memory = (uint8_t *)attr->mp_mem;
+    }
+    else
+    {
+        mp->memory = _os_malloc(MEMPOOL_ARR_SIZE(block_count, block_size));
+        mp->mp_dynamic = true;
+    }
+
+    mp->name = (attr != NULL) ? attr->name : NULL;
+    mp->block_size = block_size;
+    mp->stride = stride;
+    mp->capacity = block_count;
+
+    /* Link all the blocks in order, 0 means the end of the list. */
+    for (uint32_t i = 0; i < block_count; i ++)
+    {
+        *(uint32_t *)&mp->memory[i * stride] = (i + 1 < block_count) ? (i + 2) : 0;
+    }
+    mp->head = 1;
+
+    return (osMemoryPoolId_t)mp;
+}
+
+const char *osMemoryPoolGetName(osMemoryPoolId_t mp_id)
+{
+    assert(mp_id != NULL);
+
+    return ((os_mp_t *)mp_id)->name;
+}
+
+void *osMemoryPoolAlloc(osMemoryPoolId_t mp_id, uint32_t timeout)
+{
+    assert(mp_id != NULL);
+
+    os_mp_t *mp = (os_mp_t *)mp_id;
+    struct timespec deadline;
+    bool awake = true;
+
+    void *block = _mp_pop(mp);
+    if (block == NULL && timeout != 0)
+    {
+        if (timeout != osWaitForever)
+        {
+            _deadline_get(&deadline, timeout);
+        }
+
+        while (block == NULL && awake)
+        {
+            __atomic_add_fetch(&mp->waiters, 1, __ATOMIC_SEQ_CST);
+            uint32_t value = __atomic_load_n(&mp->event, __ATOMIC_SEQ_CST);
+            block = _mp_pop(mp);
+            if (block == NULL)
+            {
+                pthread_cleanup_push(_futex_waiter_cleanup, &mp->waiters);
+                awake = _futex_wait(&mp->event, value,
+                                    timeout == osWaitForever ? NULL : &deadline);
+                pthread_cleanup_pop(0);
+            }
+            __atomic_sub_fetch(&mp->waiters, 1, __ATOMIC_SEQ_CST);
+        }
+
+        if (block == NULL)
+        {
+            block = _mp_pop(mp);
+        }
+    }
+
+    if (block != NULL)
+    {
+        uint32_t count = __atomic_add_fetch(&mp->count, 1, __ATOMIC_RELAXED);
+        uint32_t count_max = __atomic_load_n(&mp->count_max, __ATOMIC_RELAXED);
+        while (count > count_max &&
+                !__atomic_compare_exchange_n(&mp->count_max, &count_max, count,
+                                    true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+        }
+    }
+
+    return block;
+}
+
+osStatus_t osMemoryPoolFree(osMemoryPoolId_t mp_id, void *block)
+{
+    assert(mp_id != NULL);
+
+    os_mp_t *mp = (os_mp_t *)mp_id;
+    uint8_t *memory = (uint8_t *)block;
+
+    if (memory < mp->memory ||
+        memory >= &mp->memory[mp->capacity * mp->stride] ||
+        ((memory - mp->memory) % mp->stride) != 0)
+    {
+        return osErrorParameter;
+    }
+
+    uint32_t index = (uint32_t)((memory - mp->memory) / mp->stride);
+    uint64_t head = __atomic_load_n(&mp->head, __ATOMIC_RELAXED);
+    uint64_t head_new;
+    do
+    {
+        __atomic_store_n((uint32_t *)memory, (uint32_t)head, __ATOMIC_RELAXED);
+        head_new = (((head >> 32) + 1) << 32) | (uint64_t)(index + 1);
+    } while (!__atomic_compare_exchange_n(&mp->head, &head, head_new, true,
+                                            __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+    __atomic_sub_fetch(&mp->count, 1, __ATOMIC_RELAXED);
+
+    /* The seq_cst CAS above orders the pushing before checking the waiters,
+       which pairs with the waiter registering in osMemoryPoolAlloc, so the
+       fence in _futex_notify is not needed here. */
+    if (__atomic_load_n(&mp->waiters, __ATOMIC_SEQ_CST) != 0)
+    {
+        __atomic_add_fetch(&mp->event, 1, __ATOMIC_SEQ_CST);
+        _futex_wake(&mp->event);
+    }
+
+    return osOK;
+}
+
+uint32_t osMemoryPoolGetCapacity(osMemoryPoolId_t mp_id)
+{
+    assert(mp_id != NULL);
+
+    return ((os_mp_t *)mp_id)->capacity;
+}
+
+uint32_t osMemoryPoolGetBlockSize(osMemoryPoolId_t mp_id)
+{
+    assert(mp_id != NULL);
+
+    return ((os_mp_t *)mp_id)->block_size;
+}
+
+uint32_t osMemoryPoolGetCount(osMemoryPoolId_t mp_id)
+{
+    assert(mp_id != NULL);
+
+    return __atomic_load_n(&((os_mp_t *)mp_id)->count, __ATOMIC_RELAXED);
+}
+
+uint32_t osMemoryPoolGetSpace(osMemoryPoolId_t mp_id)
+{
+    return osMemoryPoolGetCapacity(mp_id) - osMemoryPoolGetCount(mp_id);
+}
+
+uint32_t osMemoryPoolGetCountMax(osMemoryPoolId_t mp_id)
+{
+    assert(mp_id != NULL);
+
+    return __atomic_load_n(&((os_mp_t *)mp_id)->count_max, __ATOMIC_RELAXED);
+}
+
+osStatus_t osMemoryPoolDelete(osMemoryPoolId_t mp_id)
+{
+    assert(mp_id != NULL);
+
+    os_mp_t *mp = (os_mp_t *)mp_id;
+
+    if (mp->mp_dynamic)
+    {
+        free(mp->memory);
+    }
+    if (mp->cb_dynamic)
+    {
+        free(mp);
+    }
+
+    return osOK;
+}
+
+/* -----------------------------------------------------------------------------
+Mutex
+----------------------------------------------------------------------------- */
+/* The mutex is one pthread mutex with the CMSIS attributes, recursive one and
+   priority inheritance. The owner and the nesting count are only written by
+   the owner itself. The locking tries some times before sleeping, since the
+   critical sections in EDF are very short in most cases. In the virtual time
+   mode, the locking is tried again on every releasing, which is notified by
+   the event futex. */
+typedef struct os_mutex
+{
+    pthread_mutex_t mutex;
+    osThreadId_t owner;
+    uint32_t count;                             /* Nesting count */
+    uint32_t spin;                              /* 0 on one CPU */
+    const char *name;
+    uint32_t event;                             /* Futex, released */
+    uint32_t waiters;                           /* Virtual time waiters */
+#if (ELAB_RTOS_PROFILE_EN != 0)
+    os_profile_obj_t profile;
+    uint64_t hold_start;                        /* 0 if not sampled */
+#endif
+    bool cb_dynamic;
+} os_mutex_t;
+
+_Static_assert(sizeof(os_mutex_t) <= sizeof(osMutexBlock_t),
+                "osMutexBlock_t is too small.");
+
+static int _mutex_timedlock(os_mutex_t *mutex, uint32_t timeout);
+static int _trylock_wait(os_mutex_t *mutex, sem_t *sem,
+                            uint32_t *event, uint32_t *waiters, uint32_t timeout);
+
+osMutexId_t osMutexNew(const osMutexAttr_t *attr)
+{
+    pthread_mutexattr_t mutex_attr;
+    int ret = 0;
+
+    os_mutex_t *mutex = NULL;
+    bool cb_dynamic = false;
+    if (attr != NULL && attr->cb_mem != NULL)
+    {
+        assert(attr->cb_size >= sizeof(os_mutex_t));
+        mutex = (os_mutex_t *)attr->cb_mem;
+    }
+    else
+    {
+        mutex = _os_malloc(sizeof(os_mutex_t));
+        cb_dynamic = true;
+    }
+
+    ret = pthread_mutexattr_init(&mutex_attr);
+    assert(ret == 0);
+    /* The non-recursive mutex reports the relocking instead of deadlock. */
+    ret = pthread_mutexattr_settype(&mutex_attr,
+            (attr != NULL && (attr->attr_bits & osMutexRecursive) != 0) ?
+                PTHREAD_MUTEX_RECURSIVE : PTHREAD_MUTEX_ERRORCHECK);
+    assert(ret == 0);
+    if (attr != NULL && (attr->attr_bits & osMutexPrioInherit) != 0)
+    {
+        ret = pthread_mutexattr_setprotocol(&mutex_attr, PTHREAD_PRIO_INHERIT);
+        assert(ret == 0);
+    }
+    ret = pthread_mutex_init(&mutex->mutex, &mutex_attr);
+    assert(ret == 0);
+    pthread_mutexattr_destroy(&mutex_attr);
+
+    mutex->owner = NULL;
+    mutex->count = 0;
+    mutex->event = 0;
+    mutex->waiters = 0;
+    mutex->spin = (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? RTOS_MUTEX_SPIN_COUNT : 0;
+    mutex->name = (attr != NULL) ? attr->name : NULL;
+    mutex->cb_dynamic = cb_dynamic;
+#if (ELAB_RTOS_PROFILE_EN != 0)
+    _profile_attach(&mutex->profile, "mutex", mutex->name);
+    mutex->hold_start = 0;
+#endif
+
+    return (osMutexId_t)mutex;
+}
+
+const char *osMutexGetName(osMutexId_t mutex_id)
+{
+    assert(mutex_id != NULL);
+
+    return ((os_mutex_t *)mutex_id)->name;
+}
+
+osStatus_t osMutexDelete(osMutexId_t mutex_id)
+{
+    assert(mutex_id != NULL);
+
+    os_mutex_t *mutex = (os_mutex_t *)mutex_id;
+
+    int ret = pthread_mutex_destroy(&mutex->mutex);
+    if (ret != 0)
+    {
+        return osErrorResource;
+    }
+#if (ELAB_RTOS_PROFILE_EN != 0)
+    _profile_detach(&mutex->profile);
+#endif
+    if (mutex->cb_dynamic)
+    {
+        free(mutex);
+    }
+
+    return osOK;
 }
 
 osStatus_t osMutexAcquire(osMutexId_t mutex_id, uint32_t timeout)
 {
-    assert(mutex_id != NULL);
+    assert(mutex_id != NULL);
+
+    os_mutex_t *mutex = (os_mutex_t *)mutex_id;
+
+    int ret = pthread_mutex_trylock(&mutex->mutex);
+    if (ret == EBUSY && timeout != 0)
+    {
+#if (ELAB_RTOS_PROFILE_EN != 0)
+        uint64_t time_wait = _clock_ns();
+#endif
+        for (uint32_t i = 0; ret == EBUSY && i < mutex->spin; i ++)
+        {
+            ret = pthread_mutex_trylock(&mutex->mutex);
+        }
+        if (ret == EBUSY && __atomic_load_n(&vtime.enabled, __ATOMIC_ACQUIRE))
+        {
+            /* The non-recursive mutex relocked by the owner. */
+            ret = (__atomic_load_n(&mutex->owner, __ATOMIC_RELAXED) ==
+                    osThreadGetId()) ? EDEADLK :
+                    _trylock_wait(mutex, NULL, &mutex->event, &mutex->waiters,
+                                    timeout);
+        }
+        else if (ret == EBUSY)
+        {
+            _vt_block();
+            ret = (timeout == osWaitForever) ?
+                    pthread_mutex_lock(&mutex->mutex) :
+                    _mutex_timedlock(mutex, timeout);
+            _vt_unblock();
+        }
+#if (ELAB_RTOS_PROFILE_EN != 0)
+        _profile_wait(mutex->profile.profile, time_wait);
+#endif
+    }
+
+    if (ret == 0)
+    {
+        if (mutex->count ++ == 0)
+        {
+            __atomic_store_n(&mutex->owner, osThreadGetId(), __ATOMIC_RELAXED);
+        }
+#if (ELAB_RTOS_PROFILE_EN != 0)
+        /* The first one of the nesting acquiring is sampled only. */
+        uint64_t count_acquire = _profile_acquire_owned(&mutex->profile);
+        if (mutex->count == 1 &&
+            (count_acquire & (RTOS_PROFILE_HOLD_SAMPLE - 1)) == 0)
+        {
+            mutex->hold_start = _clock_ns();
+        }
+#endif
+        return osOK;
+    }
+    else if (ret == ETIMEDOUT)
+    {
+        return osErrorTimeout;
+    }
+    else if (ret == EBUSY || ret == EDEADLK || ret == EAGAIN)
+    {
+        return osErrorResource;
+    }
+    else
+    {
+        return osError;
+    }
+}
+
+osStatus_t osMutexRelease(osMutexId_t mutex_id)
+{
+    assert(mutex_id != NULL);
+
+    os_mutex_t *mutex = (os_mutex_t *)mutex_id;
+    if (__atomic_load_n(&mutex->owner, __ATOMIC_RELAXED) != osThreadGetId())
+    {
+        return osErrorResource;
+    }
+
+    if (-- mutex->count == 0)
+    {
+        __atomic_store_n(&mutex->owner, NULL, __ATOMIC_RELAXED);
+#if (ELAB_RTOS_PROFILE_EN != 0)
+        if (mutex->hold_start != 0)
+        {
+            _profile_hold(mutex->profile.profile, mutex->hold_start);
+            mutex->hold_start = 0;
+        }
+#endif
+    }
+    int ret = pthread_mutex_unlock(&mutex->mutex);
+    _futex_notify(&mutex->event, &mutex->waiters);
+
+    return (ret == 0) ? osOK : osError;
+}
+
+osThreadId_t osMutexGetOwner(osMutexId_t mutex_id)
+{
+    assert(mutex_id != NULL);
+
+    return __atomic_load_n(&((os_mutex_t *)mutex_id)->owner, __ATOMIC_RELAXED);
+}
+
+/* -----------------------------------------------------------------------------
+Semaphore
+----------------------------------------------------------------------------- */
+typedef struct os_sem
+{
+    sem_t sem;
+    uint32_t event;                             /* Futex, released */
+    uint32_t waiters;                           /* Virtual time waiters */
+#if (ELAB_RTOS_PROFILE_EN != 0)
+    os_profile_obj_t profile;
+#endif
+    bool cb_dynamic;
+} os_sem_t;
+
+_Static_assert(sizeof(os_sem_t) <= sizeof(osSemaphoreBlock_t),
+                "osSemaphoreBlock_t is too small.");
+
+osSemaphoreId_t osSemaphoreNew(uint32_t max_count, uint32_t initial_count, const osSemaphoreAttr_t *attr)
+{
+    assert(initial_count <= max_count);
+
+    os_sem_t *sem = NULL;
+    bool cb_dynamic = false;
+    if (attr != NULL && attr->cb_mem != NULL)
+    {
+        assert(attr->cb_size >= sizeof(os_sem_t));
+        sem = (os_sem_t *)attr->cb_mem;
+    }
+    else
+    {
+        sem = _os_malloc(sizeof(os_sem_t));
+        cb_dynamic = true;
+    }
+    sem->cb_dynamic = cb_dynamic;
+    sem->event = 0;
+    sem->waiters = 0;
+#if (ELAB_RTOS_PROFILE_EN != 0)
+    _profile_attach(&sem->profile, "semaphore",
+                    (attr != NULL) ? attr->name : NULL);
+#endif
+
+    int ret = sem_init(&sem->sem, 0, initial_count);
+    assert(ret == 0);
+
+    return (osSemaphoreId_t)sem;
+}
+
+osStatus_t osSemaphoreDelete(osSemaphoreId_t semaphore_id)
+{
+    assert(semaphore_id != NULL);
+
+    os_sem_t *sem = (os_sem_t *)semaphore_id;
+    sem_destroy(&sem->sem);
+#if (ELAB_RTOS_PROFILE_EN != 0)
+    _profile_detach(&sem->profile);
+#endif
+    if (sem->cb_dynamic)
+    {
+        free(sem);
+    }
+
+    return osOK;
+}
+
+osStatus_t osSemaphoreRelease(osSemaphoreId_t semaphore_id)
+{
+    assert(semaphore_id != NULL);
+
+    os_sem_t *sem = (os_sem_t *)semaphore_id;
+    int ret = sem_post(&sem->sem);
+    assert(ret == 0);
+    _futex_notify(&sem->event, &sem->waiters);
+
+    return osOK;
+}
+
+osStatus_t osSemaphoreAcquire(osSemaphoreId_t semaphore_id, uint32_t timeout)
+{
+    assert(semaphore_id != NULL);
+
+    os_sem_t *os_sem = (os_sem_t *)semaphore_id;
+    sem_t *sem = &os_sem->sem;
+    osStatus_t status = osOK;
+    int ret;
+
+    /* Only the blocked waiting is slow. */
+    if (sem_trywait(sem) == 0)
+    {
+#if (ELAB_RTOS_PROFILE_EN != 0)
+        _profile_acquire(&os_sem->profile);
+#endif
+        return osOK;
+    }
+    if (timeout == 0)
+    {
+        return osErrorResource;
+    }
+
+#if (ELAB_RTOS_PROFILE_EN != 0)
+    uint64_t time_wait = _clock_ns();
+#endif
+    if (__atomic_load_n(&vtime.enabled, __ATOMIC_ACQUIRE))
+    {
+        ret = _trylock_wait(NULL, sem, &os_sem->event, &os_sem->waiters,
+                            timeout);
+        status = (ret == ETIMEDOUT) ? osErrorTimeout : osOK;
+    }
+    else if (timeout == osWaitForever)
+    {
+        /* Waiting again if interrupted by a signal. */
+        _vt_block();
+        do
+        {
+            ret = sem_wait(sem);
+        } while (ret == -1 && errno == EINTR);
+        _vt_unblock();
+        assert(ret == 0);
+    }
+    else
+    {
+        /* The deadline is on CLOCK_MONOTONIC, so the timeout is not affected
+           by the wall clock changing. */
+        struct timespec ts;
+        _deadline_get(&ts, timeout);
+        _time_to_clock((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec, &ts);
+
+        /* The deadline is absolute, so the rest of the timeout is kept in
+           waiting again after a signal. */
+        _vt_block();
+        do
+        {
+            ret = sem_clockwait(sem, CLOCK_MONOTONIC, &ts);
+        } while (ret == -1 && errno == EINTR);
+        _vt_unblock();
+        if (ret == -1)
+        {
+            assert(errno == ETIMEDOUT);
+            status = osErrorTimeout;
+        }
+    }
+#if (ELAB_RTOS_PROFILE_EN != 0)
+    _profile_wait(os_sem->profile.profile, time_wait);
+    if (status == osOK)
+    {
+        _profile_acquire(&os_sem->profile);
+    }
+#endif
+
+    return status;
+}
+
+/* -----------------------------------------------------------------------------
+Timer
+----------------------------------------------------------------------------- */
+static bool _timer_heap_push(os_timer_t *timer);
+static void _timer_heap_remove(os_timer_t *timer);
+
+osTimerId_t osTimerNew(osTimerFunc_t func,
+                        osTimerType_t type,
+                        void *argument,
+                        const osTimerAttr_t *attr)
+{
+    assert(func != NULL);
+    assert(type == osTimerOnce || type == osTimerPeriodic);
+
+    os_timer_t *timer = NULL;
+    bool cb_dynamic = false;
+    if (attr != NULL && attr->cb_mem != NULL)
+    {
+        assert(attr->cb_size >= sizeof(os_timer_t));
+        timer = (os_timer_t *)attr->cb_mem;
+    }
+    else
+    {
+        timer = _os_malloc(sizeof(os_timer_t));
+        cb_dynamic = true;
+    }
+
+    timer->cb_dynamic = cb_dynamic;
+    timer->func = func;
+    timer->type = type;
+    timer->argument = argument;
+    timer->name = (attr != NULL) ? attr->name : NULL;
+    timer->ticks = 0;
+    timer->index = RTOS_TIMER_INDEX_NONE;
+    timer->deadline = 0;
+
+    return (osTimerId_t)timer;
+}
+
+const char *osTimerGetName (osTimerId_t timer_id)
+{
+    assert(timer_id != NULL);
+
+    return ((os_timer_t *)timer_id)->name;
+}
+
+uint32_t osTimerIsRunning(osTimerId_t timer_id)
+{
+    assert(timer_id != NULL);
+
+    os_timer_t *timer = (os_timer_t *)timer_id;
+    uint32_t ret = 0;
+
+    pthread_mutex_lock(&mutex_timer);
+    ret = (timer->index != RTOS_TIMER_INDEX_NONE) ? 1 : 0;
+    pthread_mutex_unlock(&mutex_timer);
+
+    return ret;
+}
+
+osStatus_t osTimerStart(osTimerId_t timer_id, uint32_t ticks)
+{
+    assert(timer_id != NULL);
+    assert(ticks >= RTOS_TIMER_VALUE_MIN);
+
+    os_timer_t *timer = (os_timer_t *)timer_id;
+    osStatus_t ret = osOK;
+
+    pthread_mutex_lock(&mutex_timer);
+
+    /* Restart the timer if it is running. */
+    if (timer->index != RTOS_TIMER_INDEX_NONE)
+    {
+        _timer_heap_remove(timer);
+    }
+    timer->ticks = ticks;
+    timer->deadline = _time_ns() + (uint64_t)ticks * 1000000;
+    if (!_timer_heap_push(timer))
+    {
+        /* The timer heap is full, and can not grow after the heap lock. */
+        ret = osErrorResource;
+    }
+    /* Wake up the timer thread only if the earliest deadline changes. */
+    else if (timer_heap[0] == timer)
+    {
+        timer_event ++;
+        _futex_wake(&timer_event);
+    }
+
+    pthread_mutex_unlock(&mutex_timer);
+
+    return ret;
+}
+
+osStatus_t osTimerStop(osTimerId_t timer_id)
+{
+    assert(timer_id != NULL);
+
+    os_timer_t *timer = (os_timer_t *)timer_id;
+    osStatus_t ret = osOK;
+
+    /* The timer thread wakes up at the old deadline at most once, and then
+       sleeps until the next one, so it is not woken up here. */
+    pthread_mutex_lock(&mutex_timer);
+    if (timer->index != RTOS_TIMER_INDEX_NONE)
+    {
+        _timer_heap_remove(timer);
+    }
+    else
+    {
+        ret = osErrorResource;
+    }
+    pthread_mutex_unlock(&mutex_timer);
+
+    return ret;
+}
+
+osStatus_t osTimerDelete(osTimerId_t timer_id)
+{
+    assert(timer_id != NULL);
+
+    os_timer_t *timer = (os_timer_t *)timer_id;
+
+    pthread_mutex_lock(&mutex_timer);
+    if (timer->index != RTOS_TIMER_INDEX_NONE)
+    {
+        _timer_heap_remove(timer);
+    }
+    pthread_mutex_unlock(&mutex_timer);
+
+    /* The timer thread does not touch the timer after releasing the lock, so
+       it is safe to free it even if its callback is running. */
+    if (timer->cb_dynamic)
+    {
+        free(timer);
+    }
+
+    return osOK;
+}
+
+/* -----------------------------------------------------------------------------
+Event Flag
+----------------------------------------------------------------------------- */
+/* The flags word is also the futex word, so any setting or clearing wakes up
+   the waiters to check their conditions again. All the waiters are woken up
+   together, since every of them may wait for different flags. */
+typedef struct os_ef
+{
+    uint32_t flags;                             /* Futex */
+    uint32_t waiters;
+    const char *name;
+    bool cb_dynamic;
+} os_ef_t;
+
+_Static_assert(sizeof(os_ef_t) <= sizeof(osEventFlagsBlock_t),
+                "osEventFlagsBlock_t is too small.");
+
+static uint32_t _flags_set(uint32_t *flags_word, uint32_t *waiters,
+                            uint32_t flags);
+static uint32_t _flags_wait(uint32_t *flags_word, uint32_t *waiters,
+                            uint32_t flags, uint32_t options, uint32_t timeout);
+
+osEventFlagsId_t osEventFlagsNew(const osEventFlagsAttr_t *attr)
+{
+    os_ef_t *ef = NULL;
+    bool cb_dynamic = true;
+
+    if (attr != NULL && attr->cb_mem != NULL)
+    {
+        assert(attr->cb_size >= sizeof(os_ef_t));
+        ef = (os_ef_t *)attr->cb_mem;
+        cb_dynamic = false;
+    }
+    else
+    {
+        ef = _os_malloc(sizeof(os_ef_t));
+    }
+
+    ef->flags = 0;
+    ef->waiters = 0;
+    ef->name = (attr != NULL) ? attr->name : NULL;
+    ef->cb_dynamic = cb_dynamic;
+
+    return (osEventFlagsId_t)ef;
+}
+
+const char *osEventFlagsGetName(osEventFlagsId_t ef_id)
+{
+    assert(ef_id != NULL);
+
+    return ((os_ef_t *)ef_id)->name;
+}
+
+uint32_t osEventFlagsWait(osEventFlagsId_t ef_id,
+                            uint32_t flags, uint32_t options, uint32_t timeout)
+{
+    assert(ef_id != NULL);
+
+    os_ef_t *ef = (os_ef_t *)ef_id;
+
+    return _flags_wait(&ef->flags, &ef->waiters, flags, options, timeout);
+}
+
+uint32_t osEventFlagsSet(osEventFlagsId_t ef_id, uint32_t flags)
+{
+    assert(ef_id != NULL);
+
+    os_ef_t *ef = (os_ef_t *)ef_id;
+
+    return _flags_set(&ef->flags, &ef->waiters, flags);
+}
+
+uint32_t osEventFlagsGet(osEventFlagsId_t ef_id)
+{
+    assert(ef_id != NULL);
+
+    return __atomic_load_n(&((os_ef_t *)ef_id)->flags, __ATOMIC_ACQUIRE);
+}
+
+uint32_t osEventFlagsClear(osEventFlagsId_t ef_id, uint32_t flags)
+{
+    assert(ef_id != NULL);
+
+    if ((flags & osFlagsError) != 0)
+    {
+        return osFlagsErrorParameter;
+    }
+
+    os_ef_t *ef = (os_ef_t *)ef_id;
+
+    return __atomic_fetch_and(&ef->flags, ~flags, __ATOMIC_ACQ_REL);
+}
+
+osStatus_t osEventFlagsDelete(osEventFlagsId_t ef_id)
+{
+    assert(ef_id != NULL);
+
+    os_ef_t *ef = (os_ef_t *)ef_id;
+    if (__atomic_load_n(&ef->waiters, __ATOMIC_ACQUIRE) != 0)
+    {
+        return osErrorResource;
+    }
+    if (ef->cb_dynamic)
+    {
+        free(ef);
+    }
+
+    return osOK;
+}
+
+/* -----------------------------------------------------------------------------
+Thread Flags
+----------------------------------------------------------------------------- */
+uint32_t osThreadFlagsSet(osThreadId_t thread_id, uint32_t flags)
+{
+    assert(thread_id != NULL);
+
+    os_thread_t *thread = (os_thread_t *)thread_id;
+
+    return _flags_set(&thread->flags, &thread->waiters, flags);
+}
+
+uint32_t osThreadFlagsClear(uint32_t flags)
+{
+    if ((flags & osFlagsError) != 0)
+    {
+        return osFlagsErrorParameter;
+    }
+
+    os_thread_t *thread = _thread_self();
+
+    return __atomic_fetch_and(&thread->flags, ~flags, __ATOMIC_ACQ_REL);
+}
+
+uint32_t osThreadFlagsGet(void)
+{
+    return __atomic_load_n(&_thread_self()->flags, __ATOMIC_ACQUIRE);
+}
+
+uint32_t osThreadFlagsWait(uint32_t flags, uint32_t options, uint32_t timeout)
+{
+    os_thread_t *thread = _thread_self();
+
+    return _flags_wait(&thread->flags, &thread->waiters,
+                        flags, options, timeout);
+}
+
+/* private function --------------------------------------------------------- */
+
+static int get_pthread_priority(osPriority_t prio)
+{
+    if (prio > osPriorityRealtime7)
+    {
+        prio = osPriorityRealtime7;
+    }
+
+    return (osPriorityISR + 8 - (osPriorityRealtime7 - (prio)));
+}
+
+static void _thread_entry_timer(void *para)
+{
+    (void)para;
+
+    struct timespec deadline;
+    os_timer_t *timer = NULL;
+    osTimerFunc_t func = NULL;
+    void *argument = NULL;
+
+    while (1)
+    {
+        pthread_mutex_lock(&mutex_timer);
+
+        uint32_t event = timer_event;
+        uint64_t time_current = _time_ns();
+        timer = (timer_count != 0) ? timer_heap[0] : NULL;
+        if (timer != NULL && timer->deadline <= time_current)
+        {
+            _timer_heap_remove(timer);
+            if (timer->type == osTimerPeriodic)
+            {
+                /* Keep the period phase, and skip the missed periods. */
+                uint64_t period = (uint64_t)timer->ticks * 1000000;
+                timer->deadline +=
+                    ((time_current - timer->deadline) / period + 1) * period;
+                /* Never full, as the timer is just removed. */
+                _timer_heap_push(timer);
+            }
+            func = timer->func;
+            argument = timer->argument;
+            pthread_mutex_unlock(&mutex_timer);
+
+            /* The callback runs without the lock, so it can call the timer
+               functions, even for its own timer. */
+            func(argument);
+            continue;
+        }
+
+        if (timer != NULL)
+        {
+            deadline.tv_sec = timer->deadline / 1000000000;
+            deadline.tv_nsec = timer->deadline % 1000000000;
+        }
+        pthread_mutex_unlock(&mutex_timer);
+
+        _futex_wait(&timer_event, event, (timer == NULL) ? NULL : &deadline);
+    }
+}
+
+/**
+  * @brief  Get the CLOCK_MONOTONIC time in nano-second, which never jumps when
+  *         the wall clock is changed.
+  */
+static uint64_t _clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+/**
+  * @brief  Get the OS time in nano-second, which follows CLOCK_MONOTONIC in the
+  *         real time mode, and the virtual time in the virtual time mode.
+  */
+static uint64_t _time_ns(void)
+{
+    uint64_t base, real_base, rate;
+    uint32_t seq;
+
+    do
+    {
+        seq = __atomic_load_n(&vtime.seq, __ATOMIC_ACQUIRE);
+        base = __atomic_load_n(&vtime.base, __ATOMIC_RELAXED);
+        real_base = __atomic_load_n(&vtime.real_base, __ATOMIC_RELAXED);
+        rate = __atomic_load_n(&vtime.rate, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) != 0 || seq != __atomic_load_n(&vtime.seq, __ATOMIC_RELAXED));
+
+    return base + (_clock_ns() - real_base) * rate;
+}
+
+/**
+  * @brief  Convert the OS time into the absolute CLOCK_MONOTONIC time.
+  * @retval false if the time is stopped, in the virtual time mode of scale 0.
+  */
+static bool _time_to_clock(uint64_t time_ns, struct timespec *ts)
+{
+    uint64_t base, real_base, rate;
+    uint32_t seq;
+
+    do
+    {
+        seq = __atomic_load_n(&vtime.seq, __ATOMIC_ACQUIRE);
+        base = __atomic_load_n(&vtime.base, __ATOMIC_RELAXED);
+        real_base = __atomic_load_n(&vtime.real_base, __ATOMIC_RELAXED);
+        rate = __atomic_load_n(&vtime.rate, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) != 0 || seq != __atomic_load_n(&vtime.seq, __ATOMIC_RELAXED));
+
+    if (rate == 0)
+    {
+        return false;
+    }
+    uint64_t clock_ns = real_base;
+    if (time_ns > base)
+    {
+        clock_ns += (time_ns - base + rate - 1) / rate;
+    }
+    ts->tv_sec = clock_ns / 1000000000;
+    ts->tv_nsec = clock_ns % 1000000000;
+
+    return true;
+}
+
+/**
+  * @brief  Record the time base of the tick count before main function, so the
+  *         tick count starts from 0 and no lazy initialization is needed.
+  */
+static void _time_init(void)
+{
+    time_init = _time_ns();
+}
+
+/**
+  * @brief  Sleep until the absolute OS time, the sleeping is restarted to the
+  *         same deadline if interrupted by signals.
+  */
+static void _sleep_until(uint64_t time_ns)
+{
+    uint32_t futex = 0;
+    struct timespec ts;
+    ts.tv_sec = time_ns / 1000000000;
+    ts.tv_nsec = time_ns % 1000000000;
+
+    while (_time_ns() < time_ns)
+    {
+        _futex_wait(&futex, 0, &ts);
+    }
+}
+
+/**
+  * @brief  Set the time base, only in the virtual time mutex.
+  */
+static void _vt_base_set(uint64_t time_ns, uint64_t rate)
+{
+    uint32_t seq = vtime.seq;
+
+    __atomic_store_n(&vtime.seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&vtime.base, time_ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&vtime.real_base, _clock_ns(), __ATOMIC_RELAXED);
+    __atomic_store_n(&vtime.rate, rate, __ATOMIC_RELAXED);
+    __atomic_store_n(&vtime.seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/**
+  * @brief  Unlink the sleeping thread from the list and wake it up, it is
+  *         counted as running at once, so the time does not jump again before
+  *         it runs.
+  */
+static void _vt_wake(os_thread_t **link)
+{
+    os_thread_t *thread = *link;
+
+    *link = thread->vt_next;
+    thread->vt_next = NULL;
+    thread->vt_futex = NULL;
+    if (!thread->foreign)
+    {
+        thread->vt_blocked = false;
+        __atomic_add_fetch(&vtime.running, 1, __ATOMIC_SEQ_CST);
+    }
+    __atomic_or_fetch(&thread->vt_wake, 1, __ATOMIC_RELEASE);
+    syscall(SYS_futex, &thread->vt_wake, FUTEX_WAKE | FUTEX_PRIVATE_FLAG,
+            1, NULL, NULL, 0);
+}
+
+/**
+  * @brief  Make the sleeping threads reload their real deadlines after the time
+  *         base is changed.
+  */
+static void _vt_poke(void)
+{
+    for (os_thread_t *thread = vtime.sleeping; thread != NULL;
+            thread = thread->vt_next)
+    {
+        __atomic_add_fetch(&thread->vt_wake, 2, __ATOMIC_RELEASE);
+        syscall(SYS_futex, &thread->vt_wake, FUTEX_WAKE | FUTEX_PRIVATE_FLAG,
+                1, NULL, NULL, 0);
+    }
+}
+
+/**
+  * @brief  Jump to the earliest deadline of the sleeping threads and wake them
+  *         up, once no thread is running. The threads not created by
+  *         osThreadNew are not counted, so the jumping goes on if only they are
+  *         woken up.
+  */
+static void _vt_advance(void)
+{
+    while (__atomic_load_n(&vtime.running, __ATOMIC_SEQ_CST) == 0)
+    {
+        uint64_t deadline = UINT64_MAX;
+        for (os_thread_t *thread = vtime.sleeping; thread != NULL;
+                thread = thread->vt_next)
+        {
+            if (thread->vt_deadline < deadline)
+            {
+                deadline = thread->vt_deadline;
+            }
+        }
+        if (deadline == UINT64_MAX)
+        {
+            /* Deadlock, or waiting for the foreign threads. */
+            break;
+        }
+
+        if (deadline > _time_ns())
+        {
+            _vt_base_set(deadline, vtime.scale);
+            if (vtime.scale != 0)
+            {
+                _vt_poke();
+            }
+        }
+
+        os_thread_t **link = &vtime.sleeping;
+        while (*link != NULL)
+        {
+            if ((*link)->vt_deadline <= deadline)
+            {
+                _vt_wake(link);
+            }
+            else
+            {
+                link = &(*link)->vt_next;
+            }
+        }
+    }
+}
+
+/**
+  * @brief  Stop counting the current thread as running before blocking in the
+  *         kernel in the real time mode.
+  */
+static void _vt_block(void)
+{
+    os_thread_t *self = thread_self;
+    int state;
+
+    if (self != NULL && !self->foreign)
+    {
+        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &state);
+        self->vt_blocked = true;
+        if (__atomic_sub_fetch(&vtime.running, 1, __ATOMIC_SEQ_CST) == 0 &&
+            __atomic_load_n(&vtime.enabled, __ATOMIC_ACQUIRE))
+        {
+            pthread_mutex_lock(&vtime.mutex);
+            _vt_advance();
+            pthread_mutex_unlock(&vtime.mutex);
+        }
+        pthread_setcancelstate(state, NULL);
+    }
+}
+
+/**
+  * @brief  Count the current thread as running again after blocking.
+  */
+static void _vt_unblock(void)
+{
+    os_thread_t *self = thread_self;
+    int state;
+
+    if (self != NULL && !self->foreign)
+    {
+        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &state);
+        __atomic_add_fetch(&vtime.running, 1, __ATOMIC_SEQ_CST);
+        self->vt_blocked = false;
+        pthread_setcancelstate(state, NULL);
+    }
+}
+
+/**
+  * @brief  Unlink the sleeping thread from the list, and count it as running
+  *         unless it is cancelled.
+  */
+static void _vt_unlink(os_thread_t *self, bool running)
+{
+    if (self->vt_futex == NULL)
+    {
+        /* Woken up and counted by others already. */
+        return;
+    }
+
+    os_thread_t **link = &vtime.sleeping;
+    while (*link != self)
+    {
+        link = &(*link)->vt_next;
+    }
+    *link = self->vt_next;
+    self->vt_next = NULL;
+    self->vt_futex = NULL;
+    if (running && !self->foreign && self->vt_blocked)
+    {
+        self->vt_blocked = false;
+        __atomic_add_fetch(&vtime.running, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+/**
+  * @brief  Unlink the thread cancelled in the virtual time sleeping.
+  */
+static void _vt_wait_cleanup(void *para)
+{
+    pthread_mutex_lock(&vtime.mutex);
+    _vt_unlink((os_thread_t *)para, false);
+    pthread_mutex_unlock(&vtime.mutex);
+}
+
+/**
+  * @brief  Wait on the futex word in the virtual time mode. The thread sleeps
+  *         in the list until the futex word is woken up, or the virtual time
+  *         reaches the deadline.
+  * @param  deadline    Absolute OS time, UINT64_MAX for ever.
+  * @retval false if timeout, true if woken up or the value changed.
+  */
+static bool _vt_wait(uint32_t *futex, uint32_t value, uint64_t deadline)
+{
+    os_thread_t *self = _thread_self();
+    struct timespec ts;
+    bool woken = true;
+    int state;
+
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &state);
+    pthread_mutex_lock(&vtime.mutex);
+    if (!vtime.enabled)
+    {
+        /* Switched off in the meantime, the caller waits again. */
+        pthread_mutex_unlock(&vtime.mutex);
+        pthread_setcancelstate(state, NULL);
+        return true;
+    }
+
+    /* Registered before checking the futex word, pairs with _futex_wake. */
+    self->vt_futex = futex;
+    self->vt_deadline = deadline;
+    __atomic_store_n(&self->vt_wake, 0, __ATOMIC_RELAXED);
+    self->vt_next = vtime.sleeping;
+    __atomic_store_n(&vtime.sleeping, self, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(futex, __ATOMIC_SEQ_CST) != value ||
+        deadline <= _time_ns())
+    {
+        woken = (deadline > _time_ns());
+        _vt_unlink(self, false);
+        pthread_mutex_unlock(&vtime.mutex);
+        pthread_setcancelstate(state, NULL);
+        return woken;
+    }
+    if (!self->foreign && !self->vt_blocked)
+    {
+        self->vt_blocked = true;
+        __atomic_sub_fetch(&vtime.running, 1, __ATOMIC_SEQ_CST);
+    }
+    _vt_advance();
+    pthread_mutex_unlock(&vtime.mutex);
+
+    pthread_cleanup_push(_vt_wait_cleanup, self);
+    pthread_setcancelstate(state, NULL);
+    while (1)
+    {
+        uint32_t wake = __atomic_load_n(&self->vt_wake, __ATOMIC_ACQUIRE);
+        if ((wake & 1) != 0)
+        {
+            break;
+        }
+        /* The real deadline only exists in the scaled virtual time. */
+        bool timed = (deadline != UINT64_MAX && _time_to_clock(deadline, &ts));
+        if (timed && _time_ns() >= deadline)
+        {
+            break;
+        }
+        _futex_sleep(&self->vt_wake, wake, timed ? &ts : NULL);
+    }
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &state);
+    pthread_cleanup_pop(0);
+
+    pthread_mutex_lock(&vtime.mutex);
+    _vt_unlink(self, true);
+    woken = (_time_ns() < deadline);
+    pthread_mutex_unlock(&vtime.mutex);
+    pthread_setcancelstate(state, NULL);
+
+    return woken;
+}
+
+/**
+  * @brief  Swap two timers in the heap.
+  */
+static void _timer_heap_swap(uint32_t a, uint32_t b)
+{
+    os_timer_t *timer = timer_heap[a];
+
+    timer_heap[a] = timer_heap[b];
+    timer_heap[b] = timer;
+    timer_heap[a]->index = a;
+    timer_heap[b]->index = b;
+}
+
+/**
+  * @brief  Move the timer in the heap to its ordered position.
+  */
+static void _timer_heap_fix(uint32_t index)
+{
+    /* Sift up. */
+    while (index > 0 &&
+            timer_heap[index]->deadline < timer_heap[(index - 1) / 2]->deadline)
+    {
+        _timer_heap_swap(index, (index - 1) / 2);
+        index = (index - 1) / 2;
+    }
+
+    /* Sift down. */
+    while (1)
+    {
+        uint32_t min = index;
+        uint32_t left = index * 2 + 1;
+        uint32_t right = index * 2 + 2;
+        if (left < timer_count &&
+            timer_heap[left]->deadline < timer_heap[min]->deadline)
+        {
+            min = left;
+        }
+        if (right < timer_count &&
+            timer_heap[right]->deadline < timer_heap[min]->deadline)
+        {
+            min = right;
+        }
+        if (min == index)
+        {
+            break;
+        }
+        _timer_heap_swap(index, min);
+        index = min;
+    }
+}
+
+/**
+  * @brief  Grow the timer heap to the given capacity, if less than it.
+  */
+static void _timer_heap_grow(uint32_t capacity)
+{
+    if (timer_capacity < capacity)
+    {
+        os_timer_t **heap = _os_malloc(sizeof(os_timer_t *) * capacity);
+        if (timer_count != 0)
+        {
+            memcpy(heap, timer_heap, sizeof(os_timer_t *) * timer_count);
+        }
+        free(timer_heap);
+        timer_heap = heap;
+        timer_capacity = capacity;
+    }
+}
+
+/**
+  * @brief  Add the timer into the heap, the heap grows if it is full and not
+  *         locked.
+  * @retval false if the heap is full.
+  */
+static bool _timer_heap_push(os_timer_t *timer)
+{
+    if (timer_count >= timer_capacity)
+    {
+        if (__atomic_load_n(&heap_locked, __ATOMIC_ACQUIRE))
+        {
+            return false;
+        }
+        _timer_heap_grow((timer_capacity == 0) ?
+                            ELAB_RTOS_TIMER_MAX : (timer_capacity * 2));
+    }
+
+    timer->index = timer_count;
+    timer_heap[timer_count ++] = timer;
+    _timer_heap_fix(timer->index);
+
+    return true;
+}
+
+/**
+  * @brief  Remove the timer from the heap.
+  */
+static void _timer_heap_remove(os_timer_t *timer)
+{
+    uint32_t index = timer->index;
+
+    timer_count --;
+    if (index != timer_count)
+    {
+        timer_heap[index] = timer_heap[timer_count];
+        timer_heap[index]->index = index;
+        _timer_heap_fix(index);
+    }
+    timer->index = RTOS_TIMER_INDEX_NONE;
+}
+
+/**
+  * @brief  Copy messages between the user buffer and the ring slots starting
+  *         at the given position, wrapping around the ring end.
+  */
+static void _mq_copy(os_mq_t *mq, uint32_t pos, void *msg_ptr, uint32_t count,
+                        bool put)
+{
+    uint32_t index = pos & mq->mask;
+    uint32_t first = mq->mask + 1 - index;
+    uint8_t *buffer = (uint8_t *)msg_ptr;
+
+    if (first > count)
+    {
+        first = count;
+    }
+    for (uint32_t i = 0; i < 2 && count > 0; i ++)
+    {
+        uint8_t *slot = &mq->memory[index * mq->msg_size];
+        uint32_t size = first * mq->msg_size;
+        if (put)
+        {
+            memcpy(slot, buffer, size);
+        }
+        else
+        {
+            memcpy(buffer, slot, size);
+        }
+        buffer += size;
+        count -= first;
+        index = 0;
+        first = count;
+    }
+}
+
+/**
+  * @brief  Link the node to the tail of the lane of the given priority, with
+  *         the queue locked. The priorities higher than the lanes share the
+  *         highest lane.
+  */
+static void _mq_prio_link(os_mq_prio_t *prio, uint32_t node, uint8_t msg_prio)
+{
+    uint32_t lane = (msg_prio < RTOS_MQ_PRIO_LANES) ?
+                        msg_prio : (RTOS_MQ_PRIO_LANES - 1);
+
+    prio->next[node] = 0;
+    if (prio->tail[lane] != 0)
+    {
+        prio->next[prio->tail[lane] - 1] = node + 1;
+    }
+    else
+    {
+        prio->head[lane] = node + 1;
+        prio->bitmap |= (1U << lane);
+    }
+    prio->tail[lane] = node + 1;
+}
+
+/**
+  * @brief  Unlink the head node of the highest non-empty lane, with the queue
+  *         locked and not empty.
+  * @retval The node.
+  */
+static uint32_t _mq_prio_unlink(os_mq_prio_t *prio, uint8_t *msg_prio)
+{
+    uint32_t lane = 31 - __builtin_clz(prio->bitmap);
+    uint32_t node = prio->head[lane] - 1;
+
+    prio->head[lane] = prio->next[node];
+    if (prio->head[lane] == 0)
+    {
+        prio->tail[lane] = 0;
+        prio->bitmap &= ~(1U << lane);
+    }
+    if (msg_prio != NULL)
+    {
+        *msg_prio = (uint8_t)lane;
+    }
+
+    return node;
+}
+
+/**
+  * @brief  Put up to count messages into the lane of the given priority.
+  * @retval The number of the messages put, 0 if the queue is full.
+  */
+static uint32_t _mq_prio_put(os_mq_t *mq, const void *msg_ptr, uint32_t count,
+                                uint8_t msg_prio)
+{
+    os_mq_prio_t *prio = mq->prio;
+    const uint8_t *buffer = (const uint8_t *)msg_ptr;
+    uint32_t num = 0;
+
+    pthread_mutex_lock(&prio->mutex);
+    while (num < count && prio->free != 0)
+    {
+        uint32_t node = prio->free - 1;
+        prio->free = prio->next[node];
+        memcpy(&mq->memory[node * mq->msg_size],
+                &buffer[num * mq->msg_size], mq->msg_size);
+        _mq_prio_link(prio, node, msg_prio);
+        num ++;
+    }
+    __atomic_add_fetch(&mq->tail, num, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&prio->mutex);
+
+    return num;
+}
+
+/**
+  * @brief  Get up to count messages from the highest non-empty lanes.
+  * @retval The number of the messages got, 0 if the queue is empty.
+  */
+static uint32_t _mq_prio_get(os_mq_t *mq, void *msg_ptr, uint32_t count,
+                                uint8_t *msg_prio)
+{
+    os_mq_prio_t *prio = mq->prio;
+    uint8_t *buffer = (uint8_t *)msg_ptr;
+    uint32_t num = 0;
+
+    pthread_mutex_lock(&prio->mutex);
+    while (num < count && prio->bitmap != 0)
+    {
+        uint32_t node = _mq_prio_unlink(prio, (num == 0) ? msg_prio : NULL);
+        memcpy(&buffer[num * mq->msg_size],
+                &mq->memory[node * mq->msg_size], mq->msg_size);
+        prio->next[node] = prio->free;
+        prio->free = node + 1;
+        num ++;
+    }
+    __atomic_add_fetch(&mq->head, num, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&prio->mutex);
+
+    return num;
+}
+
+/**
+  * @brief  Take one free node for reserving, or unlink the highest message
+  *         for peeking, in the priority mode.
+  * @retval The node + 1, 0 if the queue is full or empty.
+  */
+static uint32_t _mq_prio_take(os_mq_t *mq, bool put, uint8_t *msg_prio)
+{
+    os_mq_prio_t *prio = mq->prio;
+    uint32_t node = 0;
+
+    pthread_mutex_lock(&prio->mutex);
+    if (put && prio->free != 0)
+    {
+        node = prio->free;
+        prio->free = prio->next[node - 1];
+    }
+    else if (!put && prio->bitmap != 0)
+    {
+        node = _mq_prio_unlink(prio, msg_prio) + 1;
+        __atomic_add_fetch(&mq->head, 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&prio->mutex);
+
+    return node;
+}
+
+/**
+  * @brief  Claim up to count free slots from the tail position, or published
+  *         slots from the head position, without blocking. The slot is free
+  *         when its sequence number equals the position, and published when
+  *         it is one more.
+  * @retval The number of the slots claimed, 0 if the queue is full or empty.
+  */
+static uint32_t _mq_claim(os_mq_t *mq, uint32_t count, bool put, uint32_t *pos)
+{
+    uint32_t *position = put ? &mq->tail : &mq->head;
+    uint32_t offset = put ? 0 : 1;
+    uint32_t num = 0;
+
+    *pos = __atomic_load_n(position, __ATOMIC_RELAXED);
+
+    /* In the SPSC mode, the position is moved when publishing. */
+    if (mq->sequence == NULL)
+    {
+        if (put)
+        {
+            uint32_t head = __atomic_load_n(&mq->head, __ATOMIC_ACQUIRE);
+            num = mq->capacity - (*pos - head);
+        }
+        else
+        {
+            num = __atomic_load_n(&mq->tail, __ATOMIC_ACQUIRE) - *pos;
+        }
+
+        return (num > count) ? count : num;
+    }
+
+    while (1)
+    {
+        /* Claim the run of slots from the position at one time, but the ring
+           may have more slots than the queue capacity. */
+        uint32_t head = put ? __atomic_load_n(&mq->head, __ATOMIC_ACQUIRE) : 0;
+        for (num = 0; num < count; num ++)
+        {
+            uint32_t seq = __atomic_load_n(&mq->sequence[(*pos + num) & mq->mask],
+                                            __ATOMIC_ACQUIRE);
+            if (seq != *pos + num + offset ||
+                (put && (*pos + num - head) >= mq->capacity))
+            {
+                break;
+            }
+        }
+
+        if (num != 0)
+        {
+            if (__atomic_compare_exchange_n(position, pos, *pos + num, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+        else
+        {
+            uint32_t seq = __atomic_load_n(&mq->sequence[*pos & mq->mask],
+                                            __ATOMIC_ACQUIRE);
+            if ((int32_t)(seq - *pos) <= 0)
+            {
+                return 0;
+            }
+            *pos = __atomic_load_n(position, __ATOMIC_RELAXED);
+        }
+    }
 
-    os_mutex_data_t *data = (os_mutex_data_t *)mutex_id;
-    assert(timeout == osWaitForever);
+    return num;
+}
 
-    int ret = pthread_mutex_lock(&data->mutex);
-    if (ret != 0)
+/**
+  * @brief  Publish the claimed slots to the peers, the messages to the
+  *         consumers when putting, and the free slots to the producers when
+  *         getting.
+  */
+static void _mq_publish(os_mq_t *mq, uint32_t pos, uint32_t num, bool put)
+{
+    if (mq->sequence == NULL)
     {
-        return osError;
+        __atomic_store_n(put ? &mq->tail : &mq->head, pos + num, __ATOMIC_RELEASE);
+        return;
     }
-    else
+
+    for (uint32_t i = 0; i < num; i ++)
     {
-        return osOK;
+        __atomic_store_n(&mq->sequence[(pos + i) & mq->mask],
+                            put ? (pos + i + 1) : (pos + i + mq->mask + 1),
+                            __ATOMIC_RELEASE);
     }
 }
 
-osStatus_t osMutexRelease(osMutexId_t mutex_id)
+/**
+  * @brief  Put up to count messages into the ring without blocking.
+  * @retval The number of the messages put, 0 if the queue is full.
+  */
+static uint32_t _mq_put(os_mq_t *mq, const void *msg_ptr, uint32_t count,
+                        uint8_t *msg_prio)
 {
-    os_mutex_data_t *data = (os_mutex_data_t *)mutex_id;
+    uint32_t pos = 0;
 
-    int ret = pthread_mutex_unlock(&data->mutex);
-    if (ret != 0)
+    if (mq->prio != NULL)
     {
-        return osError;
+        return _mq_prio_put(mq, msg_ptr, count, *msg_prio);
     }
-    else
+
+    uint32_t num = _mq_claim(mq, count, true, &pos);
+    if (num != 0)
     {
-        return osOK;
+        _mq_copy(mq, pos, (void *)msg_ptr, num, true);
+        _mq_publish(mq, pos, num, true);
     }
-}
 
-/* -----------------------------------------------------------------------------
-Semaphore
------------------------------------------------------------------------------ */
-#include <semaphore.h>
+    return num;
+}
 
-osSemaphoreId_t osSemaphoreNew(uint32_t max_count, uint32_t initial_count, const osSemaphoreAttr_t *attr)
+/**
+  * @brief  Get up to count messages from the ring without blocking.
+  * @retval The number of the messages got, 0 if the queue is empty.
+  */
+static uint32_t _mq_get(os_mq_t *mq, void *msg_ptr, uint32_t count,
+                        uint8_t *msg_prio)
 {
-    assert(initial_count <= max_count);
+    uint32_t pos = 0;
 
-    sem_t *sem = malloc(sizeof(sem_t));
-    assert(sem != NULL);
-
-    int ret = sem_init(sem, 0, max_count);
-    assert(ret == 0);
+    if (mq->prio != NULL)
+    {
+        return _mq_prio_get(mq, msg_ptr, count, msg_prio);
+    }
 
-    for (uint32_t i = initial_count; i < max_count; i ++)
+    uint32_t num = _mq_claim(mq, count, false, &pos);
+    if (num != 0)
     {
-        ret = sem_wait(sem);
-        assert(ret == 0);
+        _mq_copy(mq, pos, msg_ptr, num, false);
+        _mq_publish(mq, pos, num, false);
     }
 
-    return (osSemaphoreId_t)sem;
+    return num;
 }
 
-osStatus_t osSemaphoreDelete(osSemaphoreId_t semaphore_id)
+/**
+  * @brief  Claim one slot in place without blocking, a free one for reserving
+  *         or a published one for peeking. The slot is published later by
+  *         osMessageQueueCommit or osMessageQueueRelease.
+  * @retval 1 if the slot is claimed and given in msg_ptr, otherwise 0.
+  */
+static uint32_t _mq_take(os_mq_t *mq, void **msg_ptr, uint8_t *msg_prio,
+                            bool put)
 {
-    sem_destroy((sem_t *)semaphore_id);
-    free((sem_t *)semaphore_id);
+    uint32_t index = 0;
+    uint32_t pos = 0;
 
-    return osOK;
+    if (mq->prio != NULL)
+    {
+        index = _mq_prio_take(mq, put, msg_prio);
+        if (index == 0)
+        {
+            return 0;
+        }
+        index --;
+    }
+    else
+    {
+        if (_mq_claim(mq, 1, put, &pos) == 0)
+        {
+            return 0;
+        }
+        index = pos & mq->mask;
+    }
+    *msg_ptr = &mq->memory[index * mq->msg_size];
+
+    return 1;
 }
 
-osStatus_t osSemaphoreRelease(osSemaphoreId_t semaphore_id)
+/**
+  * @brief  Get the index of the slot given by _mq_take.
+  * @retval The slot index.
+  */
+static uint32_t _mq_slot_index(os_mq_t *mq, const void *msg_ptr)
 {
-    int ret = sem_post((sem_t *)semaphore_id);
-    assert(ret == 0);
+    uint32_t offset = (uint32_t)((const uint8_t *)msg_ptr - mq->memory);
 
-    return osOK;
+    assert((const uint8_t *)msg_ptr >= mq->memory);
+    assert((offset % mq->msg_size) == 0);
+    assert((offset / mq->msg_size) <= mq->mask);
+
+    return offset / mq->msg_size;
 }
 
-osStatus_t osSemaphoreAcquire(osSemaphoreId_t semaphore_id, uint32_t timeout)
+/**
+  * @brief  Try the operation on the queue once without blocking.
+  * @retval The number of the messages transferred.
+  */
+static uint32_t _mq_try(os_mq_t *mq, os_mq_op_t op, void *msg_ptr,
+                        uint32_t count, uint8_t *msg_prio)
 {
-    assert(semaphore_id != NULL);
-
-    int ret;
-    if (timeout == osWaitForever)
+    if (op == MQ_OP_PUT)
     {
-        ret = sem_wait((sem_t *)semaphore_id);
-        assert(ret == 0);
+        return _mq_put(mq, msg_ptr, count, msg_prio);
     }
-    else if (timeout == 0)
+    else if (op == MQ_OP_GET)
     {
-        ret = sem_trywait((sem_t *)semaphore_id);
-        if (ret != 0)
-        {
-            return osErrorResource;
-        }
+        return _mq_get(mq, msg_ptr, count, msg_prio);
     }
-    else
-    {
-        struct timeval tt;
-        gettimeofday(&tt, NULL);
 
-        uint32_t second = timeout / 1000;
-        uint32_t ns = (timeout % 1000) * 1000 * 1000;
+    return _mq_take(mq, (void **)msg_ptr, msg_prio, (op == MQ_OP_RESERVE));
+}
 
-        struct timespec ts;
-        ts.tv_sec = tt.tv_sec + second;
-        ts.tv_nsec = tt.tv_usec * 1000 + ns;
-        ts.tv_sec += (ts.tv_nsec / (1000 * 1000 * 1000));
-        ts.tv_nsec %= (1000 * 1000 * 1000);
+/**
+  * @brief  Transfer up to count messages, spin a little and then sleep on
+  *         the futex when the queue is full or empty. It returns as soon as
+  *         one message at least is transferred. The peers are woken up once
+  *         when the messages are copied, or later when the slots taken in
+  *         place are published.
+  * @retval The number of the messages transferred.
+  */
+static uint32_t _mq_transfer(os_mq_t *mq, os_mq_op_t op, void *msg_ptr,
+                                uint32_t count, uint8_t *msg_prio,
+                                uint32_t timeout)
+{
+    bool put = (op == MQ_OP_PUT || op == MQ_OP_RESERVE);
+    uint32_t *event = put ? &mq->event_put : &mq->event_get;
+    uint32_t *waiters = put ? &mq->waiters_put : &mq->waiters_get;
+    struct timespec deadline;
+    uint32_t num = 0;
+    bool awake = true;
+
+    if (count == 0)
+    {
+        return 0;
+    }
 
-        ret = sem_timedwait((sem_t *)semaphore_id, &ts);
-        if (ret == -1)
+    num = _mq_try(mq, op, msg_ptr, count, msg_prio);
+    if (num == 0 && timeout != 0)
+    {
+#if (ELAB_RTOS_PROFILE_EN != 0)
+        uint64_t time_wait = _clock_ns();
+#endif
+        for (uint32_t i = 0; num == 0 && i < mq->spin; i ++)
+        {
+            num = _mq_try(mq, op, msg_ptr, count, msg_prio);
+        }
+        if (num == 0 && timeout != osWaitForever)
+        {
+            _deadline_get(&deadline, timeout);
+        }
+
+        while (num == 0 && awake)
         {
-            if (errno == ETIMEDOUT)
+            __atomic_add_fetch(waiters, 1, __ATOMIC_SEQ_CST);
+            uint32_t value = __atomic_load_n(event, __ATOMIC_SEQ_CST);
+            num = _mq_try(mq, op, msg_ptr, count, msg_prio);
+            if (num == 0)
             {
-                return osErrorTimeout;
+                pthread_cleanup_push(_futex_waiter_cleanup, waiters);
+                awake = _futex_wait(event, value,
+                                    timeout == osWaitForever ? NULL : &deadline);
+                pthread_cleanup_pop(0);
             }
+            __atomic_sub_fetch(waiters, 1, __ATOMIC_SEQ_CST);
+        }
+
+        if (num == 0)
+        {
+            num = _mq_try(mq, op, msg_ptr, count, msg_prio);
         }
+#if (ELAB_RTOS_PROFILE_EN != 0)
+        _profile_wait(mq->profile.profile, time_wait);
+#endif
+    }
+#if (ELAB_RTOS_PROFILE_EN != 0)
+    if (num != 0)
+    {
+        _profile_acquire(&mq->profile);
+    }
+#endif
+
+    if (num != 0 && op == MQ_OP_PUT)
+    {
+        _futex_notify(&mq->event_get, &mq->waiters_get);
+    }
+    else if (num != 0 && op == MQ_OP_GET)
+    {
+        _futex_notify(&mq->event_put, &mq->waiters_put);
     }
 
-    return osOK;
+    return num;
 }
 
-/* -----------------------------------------------------------------------------
-Timer
------------------------------------------------------------------------------ */
-osTimerId_t osTimerNew(osTimerFunc_t func,
-                        osTimerType_t type,
-                        void *argument,
-                        const osTimerAttr_t *attr)
+/**
+  * @brief  Pop one free block from the lock-free stack.
+  * @retval The block, or NULL if the pool is empty.
+  */
+static void *_mp_pop(os_mp_t *mp)
 {
-    assert(func != NULL);
-    assert(type == osTimerOnce || type == osTimerPeriodic);
-    assert(attr != NULL);
-
-    osStatus_t ret_os = osOK;
+    uint64_t head = __atomic_load_n(&mp->head, __ATOMIC_SEQ_CST);
+    uint64_t head_new;
+    uint8_t *block;
 
-    ret_os = osMutexAcquire(mutex_timer, osWaitForever);
-    assert(ret_os == osOK);
-
-    uint32_t i = 0;
-    for (i = 0; i < RTOS_TIMER_NUM_MAX; i ++)
+    do
     {
-        if (timer[i].state == (uint8_t)TIMER_STATE_UNUSED)
+        if ((uint32_t)head == 0)
         {
-            break;
+            return NULL;
         }
-    }
-    timer[i].func = func;
-    timer[i].type = type;
-    timer[i].argument = argument;
-    timer[i].state = (uint8_t)TIMER_STATE_IDLE;
-    memcpy(&timer[i].attr, attr, sizeof(osTimerAttr_t));
 
-    ret_os = osMutexRelease(mutex_timer);
-    assert(ret_os == osOK);
+        /* The block may be popped and written by other threads right now, but
+           it is still in the pool memory, and the CAS fails in that case. */
+        block = &mp->memory[((uint32_t)head - 1) * mp->stride];
+        uint32_t next = __atomic_load_n((uint32_t *)block, __ATOMIC_RELAXED);
+        head_new = (((head >> 32) + 1) << 32) | (uint64_t)next;
+    } while (!__atomic_compare_exchange_n(&mp->head, &head, head_new, true,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
 
-    return (osTimerId_t)&timer[i];
+    return block;
 }
 
-const char *osTimerGetName (osTimerId_t timer_id)
+/**
+  * @brief  The entry of all the threads created by osThreadNew.
+  */
+static void *_thread_entry(void *para)
 {
-    assert(timer_id != NULL);
-    
-    osStatus_t ret_os = osOK;
-    os_timer_data_t *timer = (os_timer_data_t *)timer_id;
-    const char *name;
-
-    /* Lock the mutex. */
-    ret_os = osMutexAcquire(mutex_timer, osWaitForever);
-    assert(ret_os == osOK);
-
-    name = timer->attr.name;
-
-    /* Unlock the mutex. */
-    ret_os = osMutexRelease(mutex_timer);
-    assert(ret_os == osOK);
-
-    return name;
+    os_thread_t *thread = (os_thread_t *)para;
+
+    /* Not cancelled before the exiting handler is pushed, or the detached
+       thread would never be freed. */
+    int state;
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &state);
+    thread_self = thread;
+    _thread_stack_paint(thread);
+    pthread_cleanup_push(_thread_exit, thread);
+    pthread_setcancelstate(state, NULL);
+    thread->func(thread->argument);
+    pthread_cleanup_pop(1);
+
+    return NULL;
 }
 
-uint32_t osTimerIsRunning(osTimerId_t timer_id)
+/**
+  * @brief  Stop counting the thread as running when it returns, exits or is
+  *         cancelled, and wake up the joining thread. The detached thread
+  *         frees its control block, unless it is being terminated.
+  */
+static void _thread_exit(void *para)
 {
-    assert(timer_id != NULL);
-    
-    osStatus_t ret_os = osOK;
-    os_timer_data_t *timer = (os_timer_data_t *)timer_id;
-    uint32_t ret = 0;
-
-    /* Lock the mutex. */
-    ret_os = osMutexAcquire(mutex_timer, osWaitForever);
-    assert(ret_os == osOK);
+    os_thread_t *thread = (os_thread_t *)para;
 
-    ret = timer->state == TIMER_STATE_RUN ? 1 : 0;
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+    _thread_list_remove(thread);
+    /* The terminator marks the reaping before the removing, in the lock. */
+    bool cb_free = thread->detached && thread->cb_dynamic && !thread->reaping;
 
-    /* Unlock the mutex. */
-    ret_os = osMutexRelease(mutex_timer);
-    assert(ret_os == osOK);
+    pthread_mutex_lock(&vtime.mutex);
+    if (!thread->vt_blocked)
+    {
+        thread->vt_blocked = true;
+        __atomic_sub_fetch(&vtime.running, 1, __ATOMIC_SEQ_CST);
+    }
+    if (vtime.enabled)
+    {
+        _vt_advance();
+    }
+    pthread_mutex_unlock(&vtime.mutex);
 
-    return ret;
+    __atomic_store_n(&thread->exited, 1, __ATOMIC_RELEASE);
+    _futex_wake(&thread->exited);
+    if (cb_free)
+    {
+        thread_self = NULL;
+        free(thread);
+    }
 }
 
-osStatus_t osTimerStart(osTimerId_t timer_id, uint32_t ticks)
+/**
+  * @brief  Remove the thread from the thread list if it is still in.
+  */
+static void _thread_list_remove(os_thread_t *thread)
 {
-    assert(timer_id != NULL);
-    assert(ticks >= RTOS_TIMER_VALUE_MIN);
-
-    osStatus_t ret_os = osOK;
-    os_timer_data_t *timer = (os_timer_data_t *)timer_id;
-
-    /* Lock the mutex. */
-    ret_os = osMutexAcquire(mutex_timer, osWaitForever);
-    assert(ret_os == osOK);
-
-    /* Start the timer. */
-    timer->timeout = ticks + osKernelGetTickCount();
-    timer->ticks = ticks;
-    timer->state = TIMER_STATE_RUN;
-    timeout_min = timeout_min > timer->timeout ? timer->timeout : timeout_min;
-
-    /* Unlock the mutex. */
-    ret_os = osMutexRelease(mutex_timer);
-    assert(ret_os == osOK);
-
-    return osOK;
+    pthread_mutex_lock(&mutex_thread_list);
+    if (thread->listed)
+    {
+        if (thread->list_prev != NULL)
+        {
+            thread->list_prev->list_next = thread->list_next;
+        }
+        else
+        {
+            thread_list = thread->list_next;
+        }
+        if (thread->list_next != NULL)
+        {
+            thread->list_next->list_prev = thread->list_prev;
+        }
+        thread->listed = false;
+        thread_count --;
+    }
+    pthread_mutex_unlock(&mutex_thread_list);
 }
 
-osStatus_t osTimerStop(osTimerId_t timer_id)
+/**
+  * @brief  Paint the free stack of the current thread with the pattern, which
+  *         also prefaults every page of it.
+  */
+static void __attribute__((noinline)) _thread_stack_paint(os_thread_t *thread)
 {
-    assert(timer_id != NULL);
-
-    osStatus_t ret_os = osOK;
-    os_timer_data_t *timer = (os_timer_data_t *)timer_id;
+    pthread_attr_t attr;
+    void *stack_addr = NULL;
+    size_t stack_size = 0;
 
-    /* Lock the mutex. */
-    ret_os = osMutexAcquire(mutex_timer, osWaitForever);
-    assert(ret_os == osOK);
+    if (pthread_getattr_np(pthread_self(), &attr) != 0)
+    {
+        return;
+    }
+    pthread_attr_getstack(&attr, &stack_addr, &stack_size);
+    pthread_attr_destroy(&attr);
 
-    timer->state = TIMER_STATE_IDLE;
-    if (timeout_min <= timer->timeout &&
-        timer->state == (uint8_t)TIMER_STATE_RUN)
+    /* The stack grows down, and the painting buffer is on the stack itself,
+       above the reserved bottom. */
+    size_t size = (size_t)((uint8_t *)&attr - (uint8_t *)stack_addr);
+    if (size > RTOS_STACK_PAINT_RESERVE)
     {
-        timeout_min = UINT32_MAX;
-        for (uint32_t i = 0; i < RTOS_TIMER_NUM_MAX; i ++)
+        size = (size - RTOS_STACK_PAINT_RESERVE) & ~(sizeof(uint64_t) - 1);
+        volatile uint64_t buffer[size / sizeof(uint64_t)];
+        for (size_t i = 0; i < size / sizeof(uint64_t); i ++)
         {
-            if (timer[i].state == (uint8_t)TIMER_STATE_RUN &&
-                timeout_min > timer[i].timeout)
-            {
-                timeout_min = timer[i].timeout;
-            }
+            buffer[i] = RTOS_STACK_PAINT_PATTERN;
         }
+        thread->stack_paint = (uint8_t *)buffer;
+        thread->stack_size = (uint32_t)stack_size;
+        __atomic_store_n(&thread->stack_low, (uint8_t *)stack_addr,
+                            __ATOMIC_RELEASE);
     }
-
-    /* Unlock the mutex. */
-    ret_os = osMutexRelease(mutex_timer);
-    assert(ret_os == osOK);
-
-    return osOK;
 }
 
-osStatus_t osTimerDelete(osTimerId_t timer_id)
+/**
+  * @brief  Get the CPUs the process is allowed to run on, up to 32 CPUs.
+  */
+static uint32_t _cpu_mask_online(void)
 {
-    assert(timer_id != NULL);
+    cpu_set_t cpu_set;
+    uint32_t mask = 0;
 
-    osStatus_t ret_os = osOK;
-    os_timer_data_t *timer = (os_timer_data_t *)timer_id;
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &cpu_set) != 0)
+    {
+        return 1;
+    }
+    for (uint32_t i = 0; i < 32; i ++)
+    {
+        mask |= CPU_ISSET(i, &cpu_set) ? (1U << i) : 0;
+    }
 
-    /* Lock the mutex. */
-    ret_os = osMutexAcquire(mutex_timer, osWaitForever);
-    assert(ret_os == osOK);
+    return mask;
+}
 
-    timer->state = TIMER_STATE_UNUSED;
-    if (timeout_min <= timer->timeout &&
-        timer->state == (uint8_t)TIMER_STATE_RUN)
+static void _cpu_mask_to_set(uint32_t mask, cpu_set_t *cpu_set)
+{
+    CPU_ZERO(cpu_set);
+    for (uint32_t i = 0; i < 32; i ++)
     {
-        timeout_min = UINT32_MAX;
-        for (uint32_t i = 0; i < RTOS_TIMER_NUM_MAX; i ++)
+        if ((mask & (1U << i)) != 0)
         {
-            if (timer[i].state == (uint8_t)TIMER_STATE_RUN &&
-                timeout_min > timer[i].timeout)
-            {
-                timeout_min = timer[i].timeout;
-            }
+            CPU_SET(i, cpu_set);
         }
     }
-
-    /* Unlock the mutex. */
-    ret_os = osMutexRelease(mutex_timer);
-    assert(ret_os == osOK);
-
-    return osOK;
 }
 
-/* -----------------------------------------------------------------------------
-Event Flag
------------------------------------------------------------------------------ */
-typedef struct os_event_flags
+static const char *_sched_policy_name(int policy)
 {
-    osSemaphoreId_t sem;
-    osMutexId_t mutex;
-    uint32_t flags;
-    uint32_t flags_set;
-    osEventFlagsAttr_t attr;
-    uint32_t time_start;
-} os_event_flags_t;
+    return (policy == SCHED_FIFO) ? "SCHED_FIFO" :
+            ((policy == SCHED_RR) ? "SCHED_RR" : "SCHED_OTHER");
+}
 
-osEventFlagsId_t osEventFlagsNew(const osEventFlagsAttr_t *attr)
+/**
+  * @brief  Free the control block of the foreign thread when it exits.
+  */
+static void _thread_key_destructor(void *para)
 {
-    os_event_flags_t *evt_flags = malloc(sizeof(os_event_flags_t));
-    assert(evt_flags != NULL);
-
-    evt_flags->sem = osSemaphoreNew(1, 0, NULL);
-    assert(evt_flags->sem != NULL);
-    evt_flags->mutex = osMutexNew(&mutex_attr_event_flag);
-    assert(evt_flags->mutex != NULL);
+    os_thread_t *thread = (os_thread_t *)para;
 
-    evt_flags->flags = 0;
-    evt_flags->flags_set = 0;
-    memcpy(&evt_flags->attr, attr, sizeof(osEventFlagsAttr_t));
-
-    return (osEventFlagsId_t)evt_flags;
+    if (thread >= &thread_foreign[0] &&
+        thread < &thread_foreign[ELAB_RTOS_FOREIGN_THREAD_MAX])
+    {
+        __atomic_store_n(&thread_foreign_used[thread - &thread_foreign[0]],
+                            false, __ATOMIC_RELEASE);
+    }
+    else
+    {
+        free(thread);
+    }
 }
 
-const char *osEventFlagsGetName (osEventFlagsId_t ef_id)
+static void _thread_key_create(void)
 {
-    os_event_flags_t *evt_flags = (os_event_flags_t *)ef_id;
-    return evt_flags->attr.name;
+    int ret = pthread_key_create(&thread_key, _thread_key_destructor);
+    assert(ret == 0);
 }
 
-uint32_t osEventFlagsWait (osEventFlagsId_t ef_id, uint32_t flags, uint32_t options, uint32_t timeout)
+/**
+  * @brief  Get the control block of the current thread, create one for the
+  *         thread not created by osThreadNew.
+  */
+static os_thread_t *_thread_self(void)
 {
-    /* TODO osFlagsNoClear */
-
-    assert((options & osFlagsNoClear) == 0);
-    assert(ef_id != NULL);
-    assert((flags & 0x80000000) == 0);
-
-    osStatus_t ret_os = osOK;
-    os_event_flags_t *evt_flags = (os_event_flags_t *)ef_id;
-    evt_flags->time_start = osKernelGetTickCount();
-    evt_flags->flags = flags;
-    uint32_t ret = flags;
-    uint32_t _timeout = timeout;
-
-    while (1)
+    if (thread_self == NULL)
     {
-        ret_os = osSemaphoreAcquire(evt_flags->sem, _timeout);
-        if (ret_os == osErrorTimeout)
-        {
-            ret = (uint32_t)ret_os;
-        }
-        else if (ret_os == osOK)
-        {
-            ret = evt_flags->flags;
-            evt_flags->flags &=~ evt_flags->flags_set;
+        pthread_once(&thread_key_once, _thread_key_create);
 
-            if (options & osFlagsWaitAll)
-            {
-                if (evt_flags->flags != 0)
-                {
-                    if (timeout > 0U)
-                    {
-                        ret = (uint32_t)osErrorTimeout;
-                    }
-                    else
-                    {
-                        ret = (uint32_t)osErrorResource;
-                    }
-
-                    _timeout = timeout - (osKernelGetTickCount() - evt_flags->time_start);
-                }
-                else
-                {
-                    break;
-                }
-            }
-            else
+        /* From the reserved ones first, so no allocation after the heap is
+           locked, unless too many foreign threads. */
+        os_thread_t *thread = NULL;
+        for (uint32_t i = 0; i < ELAB_RTOS_FOREIGN_THREAD_MAX; i ++)
+        {
+            bool used = false;
+            if (__atomic_compare_exchange_n(&thread_foreign_used[i], &used, true,
+                                            false, __ATOMIC_ACQUIRE,
+                                            __ATOMIC_RELAXED))
             {
-                if (evt_flags->flags == flags)
-                {
-                    if (timeout > 0U)
-                    {
-                        ret = (uint32_t)osErrorTimeout;
-                    }
-                    else
-                    {
-                        ret = (uint32_t)osErrorResource;
-                    }
-
-                    _timeout = timeout - (osKernelGetTickCount() - evt_flags->time_start);
-                }
-                else
-                {
-                    break;
-                }
+                thread = &thread_foreign[i];
+                break;
             }
         }
+        if (thread == NULL)
+        {
+            thread = _os_malloc(sizeof(os_thread_t));
+        }
+        memset(thread, 0, sizeof(os_thread_t));
+        thread->thread = pthread_self();
+        thread->foreign = true;
+        int ret = pthread_setspecific(thread_key, thread);
+        assert(ret == 0);
+        thread_self = thread;
     }
 
-    return ret;
+    return thread_self;
 }
 
-uint32_t osEventFlagsSet(osEventFlagsId_t ef_id, uint32_t flags)
+/**
+  * @brief  Set the flags and wake up all the waiters if any.
+  * @retval The flags after setting.
+  */
+static uint32_t _flags_set(uint32_t *flags_word, uint32_t *waiters,
+                            uint32_t flags)
 {
-    assert(ef_id != NULL);
-    assert((flags & 0x80000000) == 0);
-
-    osStatus_t ret_os = osOK;
-    os_event_flags_t *evt_flags = (os_event_flags_t *)ef_id;
-    evt_flags->flags_set = flags;
-    ret_os = osSemaphoreRelease(evt_flags->sem);
-    assert(ret_os == osOK);
+    if ((flags & osFlagsError) != 0)
+    {
+        return osFlagsErrorParameter;
+    }
 
-    return evt_flags->flags_set;
-}
+    uint32_t flags_new = __atomic_or_fetch(flags_word, flags, __ATOMIC_SEQ_CST);
+    /* The seq_cst RMW pairs with the waiter registering before loading the
+       flags, so either the waiter sees the new flags or we see the waiter. */
+    if (__atomic_load_n(waiters, __ATOMIC_SEQ_CST) != 0)
+    {
+        _futex_wake(flags_word);
+    }
 
-uint32_t osEventFlagsGet (osEventFlagsId_t ef_id)
-{
-    os_event_flags_t *evt_flags = (os_event_flags_t *)ef_id;
-    return evt_flags->flags_set;
+    return flags_new;
 }
 
-uint32_t osEventFlagsClear(osEventFlagsId_t ef_id, uint32_t flags)
+/**
+  * @brief  Wait for any or all of the flags. The matched flags are cleared in
+  *         one CAS unless osFlagsNoClear is given.
+  * @retval The flags before clearing, or the error code.
+  */
+static uint32_t _flags_wait(uint32_t *flags_word, uint32_t *waiters,
+                            uint32_t flags, uint32_t options, uint32_t timeout)
 {
-    os_event_flags_t *evt_flags = (os_event_flags_t *)ef_id;
-    uint32_t ret = evt_flags->flags_set;
-    evt_flags->flags_set &=~ flags;
+    struct timespec deadline;
+    uint32_t ret = osFlagsErrorTimeout;
+    bool waiting = true;
 
-    return ret;
-}
+    if ((flags & osFlagsError) != 0)
+    {
+        return osFlagsErrorParameter;
+    }
+    if (timeout != 0 && timeout != osWaitForever)
+    {
+        _deadline_get(&deadline, timeout);
+    }
 
-osStatus_t osEventFlagsDelete (osEventFlagsId_t ef_id)
-{
-    osStatus_t ret_os = osOK;
-    os_event_flags_t *evt_flags = (os_event_flags_t *)ef_id;
-    ret_os = osSemaphoreDelete(evt_flags->sem);
-    assert(ret_os == osOK);
+    __atomic_add_fetch(waiters, 1, __ATOMIC_SEQ_CST);
+    pthread_cleanup_push(_futex_waiter_cleanup, waiters);
+    while (1)
+    {
+        uint32_t value = __atomic_load_n(flags_word, __ATOMIC_SEQ_CST);
+        bool matched = ((options & osFlagsWaitAll) != 0) ?
+                        ((value & flags) == flags) : ((value & flags) != 0);
+        if (matched)
+        {
+            if ((options & osFlagsNoClear) != 0 ||
+                __atomic_compare_exchange_n(flags_word, &value, value & ~flags,
+                                            false, __ATOMIC_ACQ_REL,
+                                            __ATOMIC_RELAXED))
+            {
+                ret = value;
+                break;
+            }
+            /* The flags changed in the meantime, check them again. */
+            continue;
+        }
 
-    free(evt_flags);
+        if (timeout == 0)
+        {
+            ret = osFlagsErrorResource;
+            break;
+        }
+        if (!waiting)
+        {
+            ret = osFlagsErrorTimeout;
+            break;
+        }
+        /* Check the flags once more after the timeout. */
+        waiting = _futex_wait(flags_word, value,
+                            (timeout == osWaitForever) ? NULL : &deadline);
+    }
+    pthread_cleanup_pop(1);
 
-    return osOK;
+    return ret;
 }
 
-/* private function --------------------------------------------------------- */
 
-static int get_pthread_priority(osPriority_t prio)
+/**
+  * @brief  Lock the mutex with timeout in CLOCK_MONOTONIC. The kernel without
+  *         FUTEX_LOCK_PI2 refuses the monotonic clock on the priority
+  *         inheritance mutex, then CLOCK_REALTIME is used instead.
+  */
+static int _mutex_timedlock(os_mutex_t *mutex, uint32_t timeout)
 {
-    if (prio > osPriorityRealtime7)
+    struct timespec deadline;
+
+    _deadline_get(&deadline, timeout);
+    _time_to_clock((uint64_t)deadline.tv_sec * 1000000000 + deadline.tv_nsec,
+                    &deadline);
+    int ret = pthread_mutex_clocklock(&mutex->mutex, CLOCK_MONOTONIC, &deadline);
+    if (ret == EINVAL)
     {
-        prio = osPriorityRealtime7;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout / 1000;
+        deadline.tv_nsec += (timeout % 1000) * 1000 * 1000;
+        if (deadline.tv_nsec >= (1000 * 1000 * 1000))
+        {
+            deadline.tv_sec ++;
+            deadline.tv_nsec -= (1000 * 1000 * 1000);
+        }
+        ret = pthread_mutex_timedlock(&mutex->mutex, &deadline);
     }
 
-    return (osPriorityISR + 8 - (osPriorityRealtime7 - (prio)));
+    return ret;
 }
 
-static void _thread_entry_timer(void *para)
+/**
+  * @brief  Lock the mutex or take the semaphore in the virtual time mode, by
+  *         trying it again on every releasing until the deadline.
+  * @retval 0 if done, ETIMEDOUT if timeout, or the error of trying.
+  */
+static int _trylock_wait(os_mutex_t *mutex, sem_t *sem,
+                            uint32_t *event, uint32_t *waiters, uint32_t timeout)
 {
-    osStatus_t ret_os = osOK;
+    struct timespec deadline;
+    bool waiting = true;
+    int ret = EBUSY;
 
-    while (1)
+    if (timeout != osWaitForever)
     {
-        ret_os = osMutexAcquire(mutex_timer, osWaitForever);
-        assert(ret_os == osOK);
+        _deadline_get(&deadline, timeout);
+    }
 
-        if (timeout_min <= osKernelGetTickCount())
+    __atomic_add_fetch(waiters, 1, __ATOMIC_SEQ_CST);
+    pthread_cleanup_push(_futex_waiter_cleanup, waiters);
+    while (1)
+    {
+        uint32_t value = __atomic_load_n(event, __ATOMIC_SEQ_CST);
+        if (mutex != NULL)
         {
-            for (uint32_t i = 0; i < RTOS_TIMER_NUM_MAX; i ++)
-            {
-                if (timer[i].state != TIMER_STATE_RUN)
-                {
-                    continue;
-                }
-
-                if (osKernelGetTickCount() >= timer[i].timeout)
-                {
-                    timer[i].func(timer[i].argument);
-                    if (timer[i].type == osTimerPeriodic)
-                    {
-                        timer[i].timeout += timer[i].ticks;
-                    }
-                    else
-                    {
-                        timer[i].state = TIMER_STATE_IDLE;
-                    }
-                }
-            }
-
-            /* Update the timeout_min. */
-            timeout_min = UINT32_MAX;
-            for (uint32_t i = 0; i < RTOS_TIMER_NUM_MAX; i ++)
-            {
-                if (timeout_min > timer[i].timeout &&
-                    timer[i].state == TIMER_STATE_RUN)
-                {
-                    timeout_min = timer[i].timeout;
-                }
-            }
+            ret = pthread_mutex_trylock(&mutex->mutex);
         }
-        
-        ret_os = osMutexRelease(mutex_timer);
-        assert(ret_os == osOK);
-
-        osDelay(RTOS_TIMER_VALUE_MIN);
+        else
+        {
+            ret = (sem_trywait(sem) == 0) ? 0 : EBUSY;
+        }
+        if (ret != EBUSY)
+        {
+            break;
+        }
+        if (!waiting)
+        {
+            ret = ETIMEDOUT;
+            break;
+        }
+        /* Try once more after the timeout. */
+        waiting = _futex_wait(event, value,
+                                (timeout == osWaitForever) ? NULL : &deadline);
     }
+    pthread_cleanup_pop(1);
+
+    return ret;
+}
+
+
+/**
+  * @brief  Allocate the memory of the RTOS objects, which is forbidden after
+  *         osKernelHeapLock is called.
+  */
+static void *_os_malloc(size_t size)
+{
+    assert(!__atomic_load_n(&heap_locked, __ATOMIC_ACQUIRE));
+
+    void *memory = malloc(size);
+    assert(memory != NULL);
+
+    return memory;
 }
 
 #endif
@@ -0,0 +1,258 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+#if defined(__linux__)
+
+/* includes ----------------------------------------------------------------- */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../3rd/Shell/shell.h"
+#include "../common/elab_assert.h"
+#include "../common/elab_common.h"
+#include "../common/elab_log.h"
+#include "../edf/elab_device.h"
+#include "../os/cmsis_os.h"
+
+ELAB_TAG("EdfFindPerfTest");
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* private config ----------------------------------------------------------- */
+#define TEST_EDF_FIND_DEVICE_NUM            (1000)
+#define TEST_EDF_FIND_THREAD_MAX            (8)
+#define TEST_EDF_FIND_COUNT_DEFAULT         (200000)
+#define TEST_EDF_FIND_ROUND                 (3)
+#define TEST_EDF_FIND_NAME_SIZE             (16)
+#define TEST_EDF_FIND_FLAG_START            (0x01)
+
+/* private typedef ---------------------------------------------------------- */
+typedef struct edf_find_device
+{
+    elab_device_t device;
+    char name[TEST_EDF_FIND_NAME_SIZE];
+} edf_find_device_t;
+
+typedef struct edf_find_perf
+{
+    osEventFlagsId_t event;
+    uint32_t count;
+    uint32_t threads;
+    uint32_t done;
+    uint32_t churn;
+} edf_find_perf_t;
+
+/* private function prototype ----------------------------------------------- */
+static void _entry_find(void *para);
+static void _entry_churn(void *para);
+static double _perf_run(uint32_t threads, uint32_t count, uint32_t *churn);
+static void _device_register(edf_find_device_t *dev, const char *prefix,
+                                uint32_t id);
+
+/* exported function prototypes --------------------------------------------- */
+void elab_device_unregister(elab_device_t *me);
+
+/* private variables -------------------------------------------------------- */
+static edf_find_device_t *perf_device = NULL;
+
+static const osThreadAttr_t thread_attr_edf_find_perf =
+{
+    .name = "ThreadEdfFindPerf",
+    .attr_bits = osThreadJoinable,
+    .priority = osPriorityNormal,
+    .stack_size = 2048,
+};
+
+static const osThreadAttr_t thread_attr_edf_churn_perf =
+{
+    .name = "ThreadEdfChurnPerf",
+    .attr_bits = osThreadJoinable,
+    .priority = osPriorityAboveNormal,
+    .stack_size = 2048,
+};
+
+/* private functions -------------------------------------------------------- */
+/**
+  * @brief  Device finding benchmark, some threads find the devices among 1k
+  *         registered ones at the same time, and at last one more thread
+  *         registers and unregisters devices periodically beside them.
+  * @retval None
+  */
+static int32_t test_edf_find_perf(int32_t argc, char *argv[])
+{
+    static const uint32_t threads[] = { 1, 2, 4, TEST_EDF_FIND_THREAD_MAX };
+    uint32_t count = TEST_EDF_FIND_COUNT_DEFAULT;
+    uint32_t churn = 0;
+
+    if (argc >= 2)
+    {
+        count = (uint32_t)atoi(argv[1]);
+        elab_assert(count != 0);
+    }
+
+    perf_device = elab_malloc(sizeof(edf_find_device_t) *
+                                TEST_EDF_FIND_DEVICE_NUM);
+    elab_assert(perf_device != NULL);
+    for (uint32_t i = 0; i < TEST_EDF_FIND_DEVICE_NUM; i ++)
+    {
+        _device_register(&perf_device[i], "perf", i);
+    }
+
+    printf("Device finding benchmark, %u devices, %u finding per thread, "
+            "best of %u rounds.\n", TEST_EDF_FIND_DEVICE_NUM, count,
+            TEST_EDF_FIND_ROUND);
+    printf("%10s %10s %16s %16s\n",
+            "threads", "churn", "ns per finding", "Mfinding/s");
+    for (uint32_t i = 0; i < sizeof(threads) / sizeof(uint32_t); i ++)
+    {
+        /* The best round filters out the noise of the other processes. */
+        double time_best = _perf_run(threads[i], count, NULL);
+        for (uint32_t j = 1; j < TEST_EDF_FIND_ROUND; j ++)
+        {
+            double time = _perf_run(threads[i], count, NULL);
+            time_best = (time < time_best) ? time : time_best;
+        }
+        printf("%10u %10s %16.1f %16.2f\n", threads[i], "-", time_best,
+                1000.0 * threads[i] / time_best);
+    }
+    double time = _perf_run(TEST_EDF_FIND_THREAD_MAX, count, &churn);
+    printf("%10u %10u %16.1f %16.2f\n", TEST_EDF_FIND_THREAD_MAX, churn, time,
+            1000.0 * TEST_EDF_FIND_THREAD_MAX / time);
+
+    for (uint32_t i = 0; i < TEST_EDF_FIND_DEVICE_NUM; i ++)
+    {
+        elab_device_unregister(&perf_device[i].device);
+    }
+    elab_free(perf_device);
+    perf_device = NULL;
+
+    return 0;
+}
+
+/**
+  * @brief  Run one round of the benchmark.
+  * @param  churn   The count of the registering and unregistering beside the
+  *                 finding, or NULL for no churning thread.
+  * @retval Nano-seconds per finding in every thread.
+  */
+static double _perf_run(uint32_t threads, uint32_t count, uint32_t *churn)
+{
+    edf_find_perf_t perf;
+    osThreadId_t thread[TEST_EDF_FIND_THREAD_MAX];
+    osThreadId_t thread_churn = NULL;
+
+    /* All the threads start at once, since the shell thread may get no CPU
+       time any more when the finding threads run. */
+    memset(&perf, 0, sizeof(edf_find_perf_t));
+    perf.count = count;
+    perf.threads = threads;
+    perf.event = osEventFlagsNew(NULL);
+    elab_assert(perf.event != NULL);
+    for (uint32_t i = 0; i < threads; i ++)
+    {
+        thread[i] = osThreadNew(_entry_find, &perf, &thread_attr_edf_find_perf);
+        elab_assert(thread[i] != NULL);
+    }
+    if (churn != NULL)
+    {
+        thread_churn = osThreadNew(_entry_churn, &perf,
+                                    &thread_attr_edf_churn_perf);
+        elab_assert(thread_churn != NULL);
+    }
+
+    uint64_t time_start = elab_time_ns();
+    osEventFlagsSet(perf.event, TEST_EDF_FIND_FLAG_START);
+    for (uint32_t i = 0; i < threads; i ++)
+    {
+        osThreadJoin(thread[i]);
+    }
+    uint64_t time_end = elab_time_ns();
+
+    if (churn != NULL)
+    {
+        osThreadJoin(thread_churn);
+        *churn = perf.churn;
+    }
+    osEventFlagsDelete(perf.event);
+
+    return (double)(time_end - time_start) / count;
+}
+
+/**
+  * @brief  The finding thread of the benchmark.
+  */
+static void _entry_find(void *para)
+{
+    edf_find_perf_t *perf = (edf_find_perf_t *)para;
+    char name[TEST_EDF_FIND_NAME_SIZE];
+    uint32_t seed = (uint32_t)(uintptr_t)osThreadGetId();
+
+    osEventFlagsWait(perf->event, TEST_EDF_FIND_FLAG_START,
+                        osFlagsWaitAny | osFlagsNoClear, osWaitForever);
+    for (uint32_t i = 0; i < perf->count; i ++)
+    {
+        seed = seed * 1103515245 + 12345;
+        uint32_t id = (seed >> 8) % TEST_EDF_FIND_DEVICE_NUM;
+        snprintf(name, sizeof(name), "perf_%u", id);
+        elab_device_t *dev = elab_device_find(name);
+        elab_assert(dev == &perf_device[id].device);
+    }
+    __atomic_fetch_add(&perf->done, 1, __ATOMIC_RELEASE);
+}
+
+/**
+  * @brief  The thread registering and unregistering one device every tick,
+  *         preempting the finding threads.
+  */
+static void _entry_churn(void *para)
+{
+    edf_find_perf_t *perf = (edf_find_perf_t *)para;
+    edf_find_device_t dev;
+
+    osEventFlagsWait(perf->event, TEST_EDF_FIND_FLAG_START,
+                        osFlagsWaitAny | osFlagsNoClear, osWaitForever);
+    /* It stops by itself, as the shell thread may get no CPU time. */
+    while (__atomic_load_n(&perf->done, __ATOMIC_ACQUIRE) < perf->threads)
+    {
+        _device_register(&dev, "churn", perf->churn);
+        elab_device_unregister(&dev.device);
+        perf->churn ++;
+        osDelay(1);
+    }
+}
+
+static void _device_register(edf_find_device_t *dev, const char *prefix,
+                                uint32_t id)
+{
+    elab_device_attr_t attr =
+    {
+        .name = dev->name,
+        .sole = false,
+        .type = ELAB_DEVICE_UNKNOWN,
+    };
+
+    memset(dev, 0, sizeof(edf_find_device_t));
+    snprintf(dev->name, sizeof(dev->name), "%s_%u", prefix, id);
+    elab_device_register(&dev->device, &attr);
+}
+
+/**
+  * @brief  Test shell command export
+  */
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+                    test_edf_find_perf,
+                    test_edf_find_perf,
+                    device finding benchmark);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/* ----------------------------- end of file -------------------------------- */
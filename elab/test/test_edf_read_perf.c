@@ -0,0 +1,175 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+#if defined(__linux__)
+
+/* includes ----------------------------------------------------------------- */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../3rd/Shell/shell.h"
+#include "../common/elab_assert.h"
+#include "../common/elab_common.h"
+#include "../common/elab_log.h"
+#include "../edf/elab_device.h"
+#include "../os/cmsis_os.h"
+
+ELAB_TAG("EdfReadPerfTest");
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* private config ----------------------------------------------------------- */
+#define TEST_EDF_READ_THREAD_MAX            (4)
+#define TEST_EDF_READ_COUNT_DEFAULT         (200000)
+#define TEST_EDF_READ_ROUND                 (3)
+#define TEST_EDF_READ_DEVICE                "SerialNull"
+#define TEST_EDF_READ_FLAG_START            (0x01)
+
+/* private typedef ---------------------------------------------------------- */
+typedef struct edf_read_perf
+{
+    elab_device_t *dev;
+    osEventFlagsId_t event;
+    uint32_t count;
+    bool check;
+} edf_read_perf_t;
+
+/* private function prototype ----------------------------------------------- */
+static void _entry_read(void *para);
+static double _perf_run(elab_device_t *dev, uint32_t threads, uint32_t count,
+                        bool check);
+
+/* private variables -------------------------------------------------------- */
+static const osThreadAttr_t thread_attr_edf_read_perf =
+{
+    .name = "ThreadEdfReadPerf",
+    .attr_bits = osThreadJoinable,
+    .priority = osPriorityNormal,
+    .stack_size = 2048,
+};
+
+/* private functions -------------------------------------------------------- */
+/**
+  * @brief  Device reading benchmark on the null device, the bare reading and
+  *         the reading with the state checking of the serial device.
+  * @retval None
+  */
+static int32_t test_edf_read_perf(int32_t argc, char *argv[])
+{
+    static const uint32_t threads[] = { 1, 2, TEST_EDF_READ_THREAD_MAX };
+    uint32_t count = TEST_EDF_READ_COUNT_DEFAULT;
+
+    if (argc >= 2)
+    {
+        count = (uint32_t)atoi(argv[1]);
+        elab_assert(count != 0);
+    }
+
+    elab_device_t *dev = elab_device_find(TEST_EDF_READ_DEVICE);
+    elab_assert(dev != NULL);
+    elab_device_open(dev);
+
+    printf("Device reading benchmark on %s, %u reading per thread, "
+            "best of %u rounds.\n", TEST_EDF_READ_DEVICE, count,
+            TEST_EDF_READ_ROUND);
+    printf("%10s %16s %24s\n", "threads", "ns per reading",
+            "ns per checked reading");
+    for (uint32_t i = 0; i < sizeof(threads) / sizeof(uint32_t); i ++)
+    {
+        double time_best[2];
+        for (uint32_t k = 0; k < 2; k ++)
+        {
+            /* The best round filters out the noise of the other processes. */
+            time_best[k] = _perf_run(dev, threads[i], count, (k != 0));
+            for (uint32_t j = 1; j < TEST_EDF_READ_ROUND; j ++)
+            {
+                double time = _perf_run(dev, threads[i], count, (k != 0));
+                time_best[k] = (time < time_best[k]) ? time : time_best[k];
+            }
+        }
+        printf("%10u %16.1f %24.1f\n", threads[i], time_best[0], time_best[1]);
+    }
+
+    elab_device_close(dev);
+
+    return 0;
+}
+
+/**
+  * @brief  Run one round of the benchmark.
+  * @retval Nano-seconds per reading.
+  */
+static double _perf_run(elab_device_t *dev, uint32_t threads, uint32_t count,
+                        bool check)
+{
+    edf_read_perf_t perf;
+    osThreadId_t thread[TEST_EDF_READ_THREAD_MAX];
+
+    /* All the threads start at once, since the shell thread may get no CPU
+       time any more when the reading threads run. */
+    perf.dev = dev;
+    perf.count = count;
+    perf.check = check;
+    perf.event = osEventFlagsNew(NULL);
+    elab_assert(perf.event != NULL);
+    for (uint32_t i = 0; i < threads; i ++)
+    {
+        thread[i] = osThreadNew(_entry_read, &perf, &thread_attr_edf_read_perf);
+        elab_assert(thread[i] != NULL);
+    }
+
+    uint64_t time_start = elab_time_ns();
+    osEventFlagsSet(perf.event, TEST_EDF_READ_FLAG_START);
+    for (uint32_t i = 0; i < threads; i ++)
+    {
+        osThreadJoin(thread[i]);
+    }
+    uint64_t time_end = elab_time_ns();
+    osEventFlagsDelete(perf.event);
+
+    return (double)(time_end - time_start) / count / threads;
+}
+
+/**
+  * @brief  The reading thread, which checks the device state before every
+  *         reading like elab_serial_read, or not.
+  */
+static void _entry_read(void *para)
+{
+    edf_read_perf_t *perf = (edf_read_perf_t *)para;
+    uint8_t buffer[16];
+
+    osEventFlagsWait(perf->event, TEST_EDF_READ_FLAG_START,
+                        osFlagsWaitAny | osFlagsNoClear, osWaitForever);
+    for (uint32_t i = 0; i < perf->count; i ++)
+    {
+        if (perf->check)
+        {
+            elab_assert(elab_device_is_enabled(perf->dev));
+            elab_assert(!elab_device_is_test_mode(perf->dev));
+            elab_assert(!elab_device_is_sole(perf->dev));
+        }
+        elab_device_read(perf->dev, 0, buffer, sizeof(buffer));
+    }
+}
+
+/**
+  * @brief  Test shell command export
+  */
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+                    test_edf_read_perf,
+                    test_edf_read_perf,
+                    device reading benchmark);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/* ----------------------------- end of file -------------------------------- */
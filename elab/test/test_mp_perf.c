@@ -0,0 +1,171 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+#if defined(__linux__)
+
+/* includes ----------------------------------------------------------------- */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../3rd/Shell/shell.h"
+#include "../common/elab_assert.h"
+#include "../common/elab_common.h"
+#include "../common/elab_log.h"
+#include "../os/cmsis_os.h"
+
+ELAB_TAG("MpPerfTest");
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* private config ----------------------------------------------------------- */
+#define TEST_MP_PERF_BLOCK_COUNT            (256)
+#define TEST_MP_PERF_BLOCK_SIZE             (64)
+#define TEST_MP_PERF_BATCH                  (16)
+#define TEST_MP_PERF_THREAD_MAX             (4)
+#define TEST_MP_PERF_COUNT_DEFAULT          (200000)
+
+/* private typedef ---------------------------------------------------------- */
+typedef struct mp_perf
+{
+    osMemoryPoolId_t mp;                    /* NULL for malloc */
+    uint32_t count;
+} mp_perf_t;
+
+/* private function prototype ----------------------------------------------- */
+static void _entry_alloc_free(void *para);
+static double _perf_run(osMemoryPoolId_t mp, uint32_t threads, uint32_t count);
+
+/* private variables -------------------------------------------------------- */
+static const osThreadAttr_t thread_attr_mp_perf =
+{
+    .name = "ThreadMpPerf",
+    .attr_bits = osThreadJoinable,
+    .priority = osPriorityNormal,
+    .stack_size = 2048,
+};
+
+/* private functions -------------------------------------------------------- */
+/**
+  * @brief  Fixed-size block allocation benchmark, osMemoryPool against malloc.
+  * @retval None
+  */
+static int32_t test_mp_perf(int32_t argc, char *argv[])
+{
+    static const uint32_t threads[] = { 1, TEST_MP_PERF_THREAD_MAX };
+    uint32_t count = TEST_MP_PERF_COUNT_DEFAULT;
+
+    if (argc >= 2)
+    {
+        count = (uint32_t)atoi(argv[1]);
+        elab_assert(count != 0);
+    }
+
+    osMemoryPoolId_t mp = osMemoryPoolNew(TEST_MP_PERF_BLOCK_COUNT,
+                                            TEST_MP_PERF_BLOCK_SIZE, NULL);
+    elab_assert(mp != NULL);
+
+    printf("Memory pool benchmark, %u blocks of %u bytes per thread, "
+            "%u blocks in batch.\n",
+            count, TEST_MP_PERF_BLOCK_SIZE, TEST_MP_PERF_BATCH);
+    printf("%10s %18s %18s %8s\n", "threads", "malloc (op/s)",
+            "osMp (op/s)", "speedup");
+    for (uint32_t i = 0; i < sizeof(threads) / sizeof(uint32_t); i ++)
+    {
+        double rate_malloc = _perf_run(NULL, threads[i], count);
+        double rate_mp = _perf_run(mp, threads[i], count);
+        printf("%10u %18.0f %18.0f %7.2fx\n",
+                threads[i], rate_malloc, rate_mp, rate_mp / rate_malloc);
+    }
+    printf("Pool peak usage: %u / %u blocks.\n",
+            osMemoryPoolGetCountMax(mp), osMemoryPoolGetCapacity(mp));
+
+    osMemoryPoolDelete(mp);
+
+    return 0;
+}
+
+/**
+  * @brief  Run one round of the benchmark.
+  * @retval Allocating and freeing pairs per second.
+  */
+static double _perf_run(osMemoryPoolId_t mp, uint32_t threads, uint32_t count)
+{
+    mp_perf_t perf;
+    osThreadId_t thread[TEST_MP_PERF_THREAD_MAX];
+
+    perf.mp = mp;
+    perf.count = count;
+
+    uint64_t time_start = elab_time_ns();
+    for (uint32_t i = 0; i < threads; i ++)
+    {
+        thread[i] = osThreadNew(_entry_alloc_free, &perf, &thread_attr_mp_perf);
+        elab_assert(thread[i] != NULL);
+    }
+    for (uint32_t i = 0; i < threads; i ++)
+    {
+        osThreadJoin(thread[i]);
+    }
+    uint64_t time_end = elab_time_ns();
+
+    return (double)count * threads * 1e9 / (double)(time_end - time_start);
+}
+
+/**
+  * @brief  The thread of the benchmark, allocate one batch of blocks, touch
+  *         them and free them.
+  */
+static void _entry_alloc_free(void *para)
+{
+    mp_perf_t *perf = (mp_perf_t *)para;
+    void *block[TEST_MP_PERF_BATCH];
+
+    for (uint32_t i = 0; i < perf->count; i += TEST_MP_PERF_BATCH)
+    {
+        for (uint32_t j = 0; j < TEST_MP_PERF_BATCH; j ++)
+        {
+            if (perf->mp == NULL)
+            {
+                block[j] = malloc(TEST_MP_PERF_BLOCK_SIZE);
+            }
+            else
+            {
+                block[j] = osMemoryPoolAlloc(perf->mp, osWaitForever);
+            }
+            elab_assert(block[j] != NULL);
+            *(volatile uint8_t *)block[j] = (uint8_t)j;
+        }
+        for (uint32_t j = 0; j < TEST_MP_PERF_BATCH; j ++)
+        {
+            if (perf->mp == NULL)
+            {
+                free(block[j]);
+            }
+            else
+            {
+                osMemoryPoolFree(perf->mp, block[j]);
+            }
+        }
+    }
+}
+
+/**
+  * @brief  Test shell command export
+  */
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+                    test_mp_perf,
+                    test_mp_perf,
+                    memory pool allocation benchmark);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,275 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+#if defined(__linux__)
+
+/* includes ----------------------------------------------------------------- */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include "../3rd/Shell/shell.h"
+#include "../common/elab_assert.h"
+#include "../common/elab_log.h"
+#include "../os/cmsis_os.h"
+
+ELAB_TAG("MqPerfTest");
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* private config ----------------------------------------------------------- */
+#define TEST_MQ_PERF_CAPACITY               (1024)
+#define TEST_MQ_PERF_MSG_SIZE_MAX           (64)
+#define TEST_MQ_PERF_COUNT_DEFAULT          (200000)
+
+/* private typedef ---------------------------------------------------------- */
+/* The former POSIX message queue, one mutex and two semaphores, which is kept
+   here as the reference of the benchmark. */
+typedef struct mq_legacy
+{
+    osMutexId_t mutex;
+    osSemaphoreId_t sem_empty;
+    osSemaphoreId_t sem_full;
+    uint8_t *memory;
+    uint32_t msg_size;
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t tail;
+} mq_legacy_t;
+
+typedef struct mq_perf
+{
+    bool legacy;
+    void *queue;
+    uint32_t msg_size;
+    uint32_t count;
+    osSemaphoreId_t sem_done;
+} mq_perf_t;
+
+/* private function prototype ----------------------------------------------- */
+static void _entry_producer(void *para);
+static void _entry_consumer(void *para);
+static void _queue_put(mq_perf_t *perf, const void *msg);
+static void _queue_get(mq_perf_t *perf, void *msg);
+static double _perf_run(bool legacy, uint32_t msg_size, uint32_t count);
+
+/* private variables -------------------------------------------------------- */
+static const osThreadAttr_t thread_attr_producer =
+{
+    .name = "ThreadMqPerfProducer",
+    .attr_bits = osThreadJoinable,
+    .priority = osPriorityNormal,
+    .stack_size = 2048,
+};
+
+static const osThreadAttr_t thread_attr_consumer =
+{
+    .name = "ThreadMqPerfConsumer",
+    .attr_bits = osThreadJoinable,
+    .priority = osPriorityNormal,
+    .stack_size = 2048,
+};
+
+static const osMutexAttr_t mutex_attr_legacy =
+{
+    "mutex_mq_legacy",
+    osMutexRecursive | osMutexPrioInherit,
+    NULL,
+    0U
+};
+
+/* private functions -------------------------------------------------------- */
+/**
+  * @brief  Message queue throughput benchmark, the lock-free osMessageQueue
+  *         against the former mutex and semaphores based one.
+  * @retval None
+  */
+static int32_t test_mq_perf(int32_t argc, char *argv[])
+{
+    static const uint32_t msg_size[] = { 1, 4, 64 };
+    uint32_t count = TEST_MQ_PERF_COUNT_DEFAULT;
+
+    if (argc >= 2)
+    {
+        count = (uint32_t)atoi(argv[1]);
+        elab_assert(count != 0);
+    }
+
+    printf("Message queue benchmark, %u messages, 1 producer, 1 consumer.\n",
+            count);
+    printf("%10s %18s %18s %8s\n", "msg_size", "legacy (msg/s)",
+            "osMq (msg/s)", "speedup");
+    for (uint32_t i = 0; i < sizeof(msg_size) / sizeof(uint32_t); i ++)
+    {
+        double rate_legacy = _perf_run(true, msg_size[i], count);
+        double rate_mq = _perf_run(false, msg_size[i], count);
+        printf("%10u %18.0f %18.0f %7.2fx\n",
+                msg_size[i], rate_legacy, rate_mq, rate_mq / rate_legacy);
+    }
+
+    return 0;
+}
+
+/**
+  * @brief  Run one round of the benchmark.
+  * @retval Messages per second.
+  */
+static double _perf_run(bool legacy, uint32_t msg_size, uint32_t count)
+{
+    mq_perf_t perf;
+    mq_legacy_t mq_legacy;
+    struct timespec time_start, time_end;
+    osStatus_t ret_os = osOK;
+
+    perf.legacy = legacy;
+    perf.msg_size = msg_size;
+    perf.count = count;
+    perf.sem_done = osSemaphoreNew(1, 0, NULL);
+    elab_assert(perf.sem_done != NULL);
+
+    if (legacy)
+    {
+        mq_legacy.mutex = osMutexNew(&mutex_attr_legacy);
+        mq_legacy.sem_full = osSemaphoreNew(TEST_MQ_PERF_CAPACITY,
+                                            TEST_MQ_PERF_CAPACITY, NULL);
+        mq_legacy.sem_empty = osSemaphoreNew(TEST_MQ_PERF_CAPACITY, 0, NULL);
+        mq_legacy.memory = malloc(msg_size * TEST_MQ_PERF_CAPACITY);
+        elab_assert(mq_legacy.mutex != NULL && mq_legacy.memory != NULL);
+        elab_assert(mq_legacy.sem_full != NULL && mq_legacy.sem_empty != NULL);
+        mq_legacy.msg_size = msg_size;
+        mq_legacy.capacity = TEST_MQ_PERF_CAPACITY;
+        mq_legacy.head = 0;
+        mq_legacy.tail = 0;
+        perf.queue = &mq_legacy;
+    }
+    else
+    {
+        perf.queue = osMessageQueueNew(TEST_MQ_PERF_CAPACITY, msg_size, NULL);
+        elab_assert(perf.queue != NULL);
+    }
+
+    /* The producer and the consumer run in the same priority. */
+    clock_gettime(CLOCK_MONOTONIC, &time_start);
+    osThreadId_t consumer = osThreadNew(_entry_consumer, &perf,
+                                        &thread_attr_consumer);
+    elab_assert(consumer != NULL);
+    osThreadId_t producer = osThreadNew(_entry_producer, &perf,
+                                        &thread_attr_producer);
+    elab_assert(producer != NULL);
+    ret_os = osSemaphoreAcquire(perf.sem_done, osWaitForever);
+    elab_assert(ret_os == osOK);
+    clock_gettime(CLOCK_MONOTONIC, &time_end);
+    osThreadJoin(producer);
+    osThreadJoin(consumer);
+
+    if (legacy)
+    {
+        osMutexDelete(mq_legacy.mutex);
+        osSemaphoreDelete(mq_legacy.sem_full);
+        osSemaphoreDelete(mq_legacy.sem_empty);
+        free(mq_legacy.memory);
+    }
+    else
+    {
+        osMessageQueueDelete(perf.queue);
+    }
+    osSemaphoreDelete(perf.sem_done);
+
+    double seconds = (double)(time_end.tv_sec - time_start.tv_sec) +
+                        (double)(time_end.tv_nsec - time_start.tv_nsec) / 1e9;
+
+    return (double)count / seconds;
+}
+
+/**
+  * @brief  The producer thread of the benchmark.
+  */
+static void _entry_producer(void *para)
+{
+    mq_perf_t *perf = (mq_perf_t *)para;
+    uint8_t msg[TEST_MQ_PERF_MSG_SIZE_MAX];
+
+    memset(msg, 0x5a, sizeof(msg));
+    for (uint32_t i = 0; i < perf->count; i ++)
+    {
+        _queue_put(perf, msg);
+    }
+}
+
+/**
+  * @brief  The consumer thread of the benchmark.
+  */
+static void _entry_consumer(void *para)
+{
+    mq_perf_t *perf = (mq_perf_t *)para;
+    uint8_t msg[TEST_MQ_PERF_MSG_SIZE_MAX];
+
+    for (uint32_t i = 0; i < perf->count; i ++)
+    {
+        _queue_get(perf, msg);
+    }
+    osSemaphoreRelease(perf->sem_done);
+}
+
+static void _queue_put(mq_perf_t *perf, const void *msg)
+{
+    osStatus_t ret_os = osOK;
+
+    if (!perf->legacy)
+    {
+        ret_os = osMessageQueuePut(perf->queue, msg, 0, osWaitForever);
+        elab_assert(ret_os == osOK);
+        return;
+    }
+
+    mq_legacy_t *mq = (mq_legacy_t *)perf->queue;
+    ret_os = osSemaphoreAcquire(mq->sem_full, osWaitForever);
+    elab_assert(ret_os == osOK);
+    osMutexAcquire(mq->mutex, osWaitForever);
+    memcpy(&mq->memory[mq->head * mq->msg_size], msg, mq->msg_size);
+    mq->head = (mq->head + 1) % mq->capacity;
+    osMutexRelease(mq->mutex);
+    osSemaphoreRelease(mq->sem_empty);
+}
+
+static void _queue_get(mq_perf_t *perf, void *msg)
+{
+    osStatus_t ret_os = osOK;
+
+    if (!perf->legacy)
+    {
+        ret_os = osMessageQueueGet(perf->queue, msg, NULL, osWaitForever);
+        elab_assert(ret_os == osOK);
+        return;
+    }
+
+    mq_legacy_t *mq = (mq_legacy_t *)perf->queue;
+    ret_os = osSemaphoreAcquire(mq->sem_empty, osWaitForever);
+    elab_assert(ret_os == osOK);
+    osMutexAcquire(mq->mutex, osWaitForever);
+    memcpy(msg, &mq->memory[mq->tail * mq->msg_size], mq->msg_size);
+    mq->tail = (mq->tail + 1) % mq->capacity;
+    osMutexRelease(mq->mutex);
+    osSemaphoreRelease(mq->sem_full);
+}
+
+/**
+  * @brief  Test shell command export
+  */
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+                    test_mq_perf,
+                    test_mq_perf,
+                    message queue throughput benchmark);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/* ----------------------------- end of file -------------------------------- */
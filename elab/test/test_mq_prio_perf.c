@@ -0,0 +1,184 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+#if defined(__linux__)
+
+/* includes ----------------------------------------------------------------- */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../3rd/Shell/shell.h"
+#include "../common/elab_assert.h"
+#include "../common/elab_common.h"
+#include "../common/elab_log.h"
+#include "../os/cmsis_os.h"
+
+ELAB_TAG("MqPrioPerfTest");
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* private config ----------------------------------------------------------- */
+#define TEST_MQ_PRIO_PERF_CAPACITY          (256)
+#define TEST_MQ_PRIO_PERF_URGENT_PERIOD     (64)
+#define TEST_MQ_PRIO_PERF_WORK_NS           (1000)
+#define TEST_MQ_PRIO_PERF_COUNT_DEFAULT     (100000)
+#define TEST_MQ_PRIO_PERF_PRIO_BULK         (0)
+#define TEST_MQ_PRIO_PERF_PRIO_URGENT       (16)
+
+/* private typedef ---------------------------------------------------------- */
+typedef struct mq_prio_msg
+{
+    uint64_t time;
+    uint32_t urgent;
+    uint32_t seq;
+} mq_prio_msg_t;
+
+typedef struct mq_prio_perf
+{
+    osMessageQueueId_t mq;
+    uint32_t count;
+    uint32_t urgent;
+    uint64_t latency_sum;
+    uint64_t latency_max;
+} mq_prio_perf_t;
+
+/* private function prototype ----------------------------------------------- */
+static void _entry_producer(void *para);
+static void _perf_run(mq_prio_perf_t *perf, uint32_t attr_bits, uint32_t count);
+
+/* private variables -------------------------------------------------------- */
+static const osThreadAttr_t thread_attr_mq_prio_perf =
+{
+    .name = "ThreadMqPrioPerf",
+    .attr_bits = osThreadJoinable,
+    .priority = osPriorityNormal,
+    .stack_size = 2048,
+};
+
+/* private functions -------------------------------------------------------- */
+/**
+  * @brief  Head-of-line latency benchmark of the urgent messages behind a
+  *         backlog of the bulk messages, FIFO queue against priority queue.
+  * @retval None
+  */
+static int32_t test_mq_prio_perf(int32_t argc, char *argv[])
+{
+    uint32_t count = TEST_MQ_PRIO_PERF_COUNT_DEFAULT;
+    mq_prio_perf_t perf_fifo, perf_prio;
+
+    if (argc >= 2)
+    {
+        count = (uint32_t)atoi(argv[1]);
+        elab_assert(count != 0);
+    }
+
+    printf("Message queue head-of-line latency, %u messages, "
+            "1 urgent in %u, %u ns work per message.\n",
+            count, TEST_MQ_PRIO_PERF_URGENT_PERIOD, TEST_MQ_PRIO_PERF_WORK_NS);
+    _perf_run(&perf_fifo, 0, count);
+    _perf_run(&perf_prio, osMessageQueuePrio, count);
+
+    printf("%10s %16s %16s\n", "queue", "avg (us)", "max (us)");
+    printf("%10s %16.1f %16.1f\n", "FIFO",
+            (double)perf_fifo.latency_sum / perf_fifo.urgent / 1000.0,
+            (double)perf_fifo.latency_max / 1000.0);
+    printf("%10s %16.1f %16.1f\n", "priority",
+            (double)perf_prio.latency_sum / perf_prio.urgent / 1000.0,
+            (double)perf_prio.latency_max / 1000.0);
+
+    return 0;
+}
+
+/**
+  * @brief  Run one round of the benchmark, the current thread is the consumer.
+  * @retval None
+  */
+static void _perf_run(mq_prio_perf_t *perf, uint32_t attr_bits, uint32_t count)
+{
+    const osMessageQueueAttr_t attr =
+    {
+        .name = "mq_prio_perf",
+        .attr_bits = attr_bits,
+    };
+    mq_prio_msg_t msg;
+
+    memset(perf, 0, sizeof(mq_prio_perf_t));
+    perf->count = count;
+    perf->mq = osMessageQueueNew(TEST_MQ_PRIO_PERF_CAPACITY,
+                                    sizeof(mq_prio_msg_t), &attr);
+    elab_assert(perf->mq != NULL);
+
+    osThreadId_t thread = osThreadNew(_entry_producer, perf,
+                                        &thread_attr_mq_prio_perf);
+    elab_assert(thread != NULL);
+
+    for (uint32_t i = 0; i < count; i ++)
+    {
+        osStatus_t ret_os = osMessageQueueGet(perf->mq, &msg, NULL, osWaitForever);
+        elab_assert(ret_os == osOK);
+
+        uint64_t time = elab_time_ns();
+        if (msg.urgent != 0)
+        {
+            uint64_t latency = time - msg.time;
+            perf->latency_sum += latency;
+            if (latency > perf->latency_max)
+            {
+                perf->latency_max = latency;
+            }
+            perf->urgent ++;
+        }
+
+        /* Some work for every message. */
+        while ((elab_time_ns() - time) < TEST_MQ_PRIO_PERF_WORK_NS)
+        {
+        }
+    }
+
+    osThreadJoin(thread);
+    osMessageQueueDelete(perf->mq);
+}
+
+/**
+  * @brief  The producer floods the bulk messages and puts one urgent message
+  *         with the time stamp periodically.
+  */
+static void _entry_producer(void *para)
+{
+    mq_prio_perf_t *perf = (mq_prio_perf_t *)para;
+    mq_prio_msg_t msg;
+
+    for (uint32_t i = 0; i < perf->count; i ++)
+    {
+        msg.urgent = ((i % TEST_MQ_PRIO_PERF_URGENT_PERIOD) ==
+                        (TEST_MQ_PRIO_PERF_URGENT_PERIOD - 1)) ? 1 : 0;
+        msg.seq = i;
+        msg.time = elab_time_ns();
+        osStatus_t ret_os = osMessageQueuePut(perf->mq, &msg,
+                                    msg.urgent ? TEST_MQ_PRIO_PERF_PRIO_URGENT :
+                                                    TEST_MQ_PRIO_PERF_PRIO_BULK,
+                                    osWaitForever);
+        elab_assert(ret_os == osOK);
+    }
+}
+
+/**
+  * @brief  Test shell command export
+  */
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+                    test_mq_prio_perf,
+                    test_mq_prio_perf,
+                    message queue priority latency benchmark);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/* ----------------------------- end of file -------------------------------- */
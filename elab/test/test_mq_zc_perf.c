@@ -0,0 +1,196 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+#if defined(__linux__)
+
+/* includes ----------------------------------------------------------------- */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../3rd/Shell/shell.h"
+#include "../common/elab_assert.h"
+#include "../common/elab_common.h"
+#include "../common/elab_log.h"
+#include "../os/cmsis_os.h"
+
+ELAB_TAG("MqZcPerfTest");
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* private config ----------------------------------------------------------- */
+#define TEST_MQ_ZC_PERF_CAPACITY            (256)
+#define TEST_MQ_ZC_PERF_MSG_SIZE_MAX        (512)
+#define TEST_MQ_ZC_PERF_COUNT_DEFAULT       (200000)
+
+/* private typedef ---------------------------------------------------------- */
+typedef struct mq_zc_perf
+{
+    osMessageQueueId_t mq;
+    bool zero_copy;
+    uint32_t msg_size;
+    uint32_t count;
+    uint32_t checksum;
+} mq_zc_perf_t;
+
+/* private function prototype ----------------------------------------------- */
+static void _entry_producer(void *para);
+static void _msg_fill(uint8_t *msg, uint32_t size, uint32_t seq);
+static uint32_t _msg_sum(const uint8_t *msg, uint32_t size);
+static double _perf_run(bool zero_copy, uint32_t msg_size, uint32_t count);
+
+/* private variables -------------------------------------------------------- */
+static const osThreadAttr_t thread_attr_mq_zc_perf =
+{
+    .name = "ThreadMqZcPerf",
+    .attr_bits = osThreadJoinable,
+    .priority = osPriorityNormal,
+    .stack_size = 4096,
+};
+
+/* private functions -------------------------------------------------------- */
+/**
+  * @brief  Message queue benchmark of the large messages, putting and getting
+  *         by copying against reserving and peeking in place.
+  * @retval None
+  */
+static int32_t test_mq_zc_perf(int32_t argc, char *argv[])
+{
+    static const uint32_t msg_size[] = { 64, 128, 256, 512 };
+    uint32_t count = TEST_MQ_ZC_PERF_COUNT_DEFAULT;
+
+    if (argc >= 2)
+    {
+        count = (uint32_t)atoi(argv[1]);
+        elab_assert(count != 0);
+    }
+
+    printf("Message queue zero-copy benchmark, %u messages, "
+            "1 producer, 1 consumer.\n", count);
+    printf("%10s %18s %18s %8s\n", "msg_size", "copy (msg/s)",
+            "in place (msg/s)", "speedup");
+    for (uint32_t i = 0; i < sizeof(msg_size) / sizeof(uint32_t); i ++)
+    {
+        double rate_copy = _perf_run(false, msg_size[i], count);
+        double rate_zc = _perf_run(true, msg_size[i], count);
+        printf("%10u %18.0f %18.0f %7.2fx\n",
+                msg_size[i], rate_copy, rate_zc, rate_zc / rate_copy);
+    }
+
+    return 0;
+}
+
+/**
+  * @brief  Run one round of the benchmark, the current thread is the consumer.
+  * @retval Messages per second.
+  */
+static double _perf_run(bool zero_copy, uint32_t msg_size, uint32_t count)
+{
+    mq_zc_perf_t perf;
+    uint8_t buffer[TEST_MQ_ZC_PERF_MSG_SIZE_MAX];
+    uint32_t checksum = 0;
+
+    perf.zero_copy = zero_copy;
+    perf.msg_size = msg_size;
+    perf.count = count;
+    perf.checksum = 0;
+    perf.mq = osMessageQueueNew(TEST_MQ_ZC_PERF_CAPACITY, msg_size, NULL);
+    elab_assert(perf.mq != NULL);
+
+    uint64_t time_start = elab_time_ns();
+    osThreadId_t thread = osThreadNew(_entry_producer, &perf,
+                                        &thread_attr_mq_zc_perf);
+    elab_assert(thread != NULL);
+
+    for (uint32_t i = 0; i < count; i ++)
+    {
+        if (zero_copy)
+        {
+            uint8_t *msg = osMessageQueuePeek(perf.mq, NULL, osWaitForever);
+            elab_assert(msg != NULL);
+            checksum += _msg_sum(msg, msg_size);
+            osMessageQueueRelease(perf.mq, msg);
+        }
+        else
+        {
+            osStatus_t ret_os = osMessageQueueGet(perf.mq, buffer, NULL,
+                                                    osWaitForever);
+            elab_assert(ret_os == osOK);
+            checksum += _msg_sum(buffer, msg_size);
+        }
+    }
+    uint64_t time_end = elab_time_ns();
+
+    osThreadJoin(thread);
+    elab_assert(checksum == perf.checksum);
+    osMessageQueueDelete(perf.mq);
+
+    return (double)count * 1e9 / (double)(time_end - time_start);
+}
+
+/**
+  * @brief  The producer thread of the benchmark.
+  */
+static void _entry_producer(void *para)
+{
+    mq_zc_perf_t *perf = (mq_zc_perf_t *)para;
+    uint8_t buffer[TEST_MQ_ZC_PERF_MSG_SIZE_MAX];
+
+    for (uint32_t i = 0; i < perf->count; i ++)
+    {
+        if (perf->zero_copy)
+        {
+            uint8_t *msg = osMessageQueueReserve(perf->mq, osWaitForever);
+            elab_assert(msg != NULL);
+            _msg_fill(msg, perf->msg_size, i);
+            perf->checksum += _msg_sum(msg, perf->msg_size);
+            osMessageQueueCommit(perf->mq, msg, 0);
+        }
+        else
+        {
+            _msg_fill(buffer, perf->msg_size, i);
+            perf->checksum += _msg_sum(buffer, perf->msg_size);
+            osStatus_t ret_os = osMessageQueuePut(perf->mq, buffer, 0,
+                                                    osWaitForever);
+            elab_assert(ret_os == osOK);
+        }
+    }
+}
+
+/**
+  * @brief  Fill the message like one data block from the driver.
+  */
+static void _msg_fill(uint8_t *msg, uint32_t size, uint32_t seq)
+{
+    memset(msg, (int)(uint8_t)seq, size);
+}
+
+/**
+  * @brief  Check the message like the consumer handling the header and the
+  *         trailer of it.
+  * @retval The sum of the first and the last byte.
+  */
+static uint32_t _msg_sum(const uint8_t *msg, uint32_t size)
+{
+    return (uint32_t)msg[0] + (uint32_t)msg[size - 1];
+}
+
+/**
+  * @brief  Test shell command export
+  */
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+                    test_mq_zc_perf,
+                    test_mq_zc_perf,
+                    message queue zero-copy benchmark);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,159 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+#if defined(__linux__)
+
+/* includes ----------------------------------------------------------------- */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../3rd/Shell/shell.h"
+#include "../common/elab_assert.h"
+#include "../common/elab_common.h"
+#include "../common/elab_log.h"
+#include "../os/cmsis_os.h"
+
+ELAB_TAG("MutexPerfTest");
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* private config ----------------------------------------------------------- */
+#define TEST_MUTEX_PERF_THREAD_MAX          (4)
+#define TEST_MUTEX_PERF_WORK                (16)
+#define TEST_MUTEX_PERF_COUNT_DEFAULT       (1000000)
+#define TEST_MUTEX_PERF_ROUND               (5)
+
+/* private typedef ---------------------------------------------------------- */
+typedef struct mutex_perf
+{
+    osMutexId_t mutex;
+    uint32_t count;
+    volatile uint32_t shared;
+} mutex_perf_t;
+
+/* private function prototype ----------------------------------------------- */
+static void _entry_lock_unlock(void *para);
+static double _perf_run(uint32_t threads, uint32_t count);
+
+/* private variables -------------------------------------------------------- */
+static const osMutexAttr_t mutex_attr_perf =
+{
+    .name = "mutex_perf",
+    .attr_bits = osMutexRecursive | osMutexPrioInherit,
+};
+
+static const osThreadAttr_t thread_attr_mutex_perf =
+{
+    .name = "ThreadMutexPerf",
+    .attr_bits = osThreadJoinable,
+    .priority = osPriorityNormal,
+    .stack_size = 2048,
+};
+
+/* private functions -------------------------------------------------------- */
+/**
+  * @brief  Mutex acquiring and releasing benchmark with short critical
+  *         sections, like the ones of eLog and the device framework.
+  * @retval None
+  */
+static int32_t test_mutex_perf(int32_t argc, char *argv[])
+{
+    static const uint32_t threads[] = { 1, 2, TEST_MUTEX_PERF_THREAD_MAX };
+    uint32_t count = TEST_MUTEX_PERF_COUNT_DEFAULT;
+
+    if (argc >= 2)
+    {
+        count = (uint32_t)atoi(argv[1]);
+        elab_assert(count != 0);
+    }
+
+    printf("Mutex benchmark, %u acquiring per thread, best of %u rounds, "
+            "profile %s.\n", count, TEST_MUTEX_PERF_ROUND,
+            (ELAB_RTOS_PROFILE_EN != 0) ? "on" : "off");
+    printf("%10s %18s\n", "threads", "ns per acquiring");
+    for (uint32_t i = 0; i < sizeof(threads) / sizeof(uint32_t); i ++)
+    {
+        /* The best round filters out the noise of the other processes. */
+        double time_best = _perf_run(threads[i], count);
+        for (uint32_t j = 1; j < TEST_MUTEX_PERF_ROUND; j ++)
+        {
+            double time = _perf_run(threads[i], count);
+            time_best = (time < time_best) ? time : time_best;
+        }
+        printf("%10u %18.1f\n", threads[i], time_best);
+    }
+
+    return 0;
+}
+
+/**
+  * @brief  Run one round of the benchmark.
+  * @retval Nano-seconds per acquiring and releasing pair.
+  */
+static double _perf_run(uint32_t threads, uint32_t count)
+{
+    mutex_perf_t perf;
+    osThreadId_t thread[TEST_MUTEX_PERF_THREAD_MAX];
+
+    perf.mutex = osMutexNew(&mutex_attr_perf);
+    elab_assert(perf.mutex != NULL);
+    perf.count = count;
+    perf.shared = 0;
+
+    uint64_t time_start = elab_time_ns();
+    for (uint32_t i = 0; i < threads; i ++)
+    {
+        thread[i] = osThreadNew(_entry_lock_unlock, &perf,
+                                &thread_attr_mutex_perf);
+        elab_assert(thread[i] != NULL);
+    }
+    for (uint32_t i = 0; i < threads; i ++)
+    {
+        osThreadJoin(thread[i]);
+    }
+    uint64_t time_end = elab_time_ns();
+
+    elab_assert(perf.shared == count * threads * TEST_MUTEX_PERF_WORK);
+    osMutexDelete(perf.mutex);
+
+    return (double)(time_end - time_start) / count / threads;
+}
+
+/**
+  * @brief  The thread of the benchmark, some work in every critical section.
+  */
+static void _entry_lock_unlock(void *para)
+{
+    mutex_perf_t *perf = (mutex_perf_t *)para;
+
+    for (uint32_t i = 0; i < perf->count; i ++)
+    {
+        osMutexAcquire(perf->mutex, osWaitForever);
+        for (uint32_t j = 0; j < TEST_MUTEX_PERF_WORK; j ++)
+        {
+            perf->shared ++;
+        }
+        osMutexRelease(perf->mutex);
+    }
+}
+
+/**
+  * @brief  Test shell command export
+  */
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+                    test_mutex_perf,
+                    test_mutex_perf,
+                    mutex acquiring benchmark);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,269 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+#if defined(__linux__)
+
+/* includes ----------------------------------------------------------------- */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <sched.h>
+#include "../3rd/Shell/shell.h"
+#include "../common/elab_assert.h"
+#include "../common/elab_common.h"
+#include "../common/elab_log.h"
+#include "../os/cmsis_os.h"
+
+ELAB_TAG("RtJitterTest");
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* private config ----------------------------------------------------------- */
+#define TEST_RT_JITTER_LOAD_MAX             (8)
+#define TEST_RT_JITTER_HIST_NUM             (6)
+#define TEST_RT_JITTER_TIME_DEFAULT         (2000)          /* ms */
+#define TEST_RT_JITTER_INTERVAL_DEFAULT     (1000)          /* us */
+#define TEST_RT_JITTER_LOAD_DEFAULT         (2)
+#define TEST_RT_JITTER_FLAG_START           (0x01)
+
+/* private typedef ---------------------------------------------------------- */
+typedef struct rt_jitter
+{
+    uint32_t time_ms;
+    uint32_t interval_us;
+    osEventFlagsId_t event;
+    volatile bool stop;
+    int32_t policy;
+    int32_t priority;
+    uint32_t count;
+    uint64_t latency_min;
+    uint64_t latency_max;
+    uint64_t latency_sum;
+    uint32_t hist[TEST_RT_JITTER_HIST_NUM];
+} rt_jitter_t;
+
+/* private function prototype ----------------------------------------------- */
+static void _entry_measure(void *para);
+static void _entry_load(void *para);
+static void _jitter_run(rt_jitter_t *jitter, osPriority_t priority,
+                        uint32_t load);
+static uint64_t _clock_ns(void);
+
+/* private variables -------------------------------------------------------- */
+static const uint64_t hist_limit_us[TEST_RT_JITTER_HIST_NUM - 1] =
+{
+    10, 50, 100, 500, 1000,
+};
+
+static const osThreadAttr_t thread_attr_load =
+{
+    .name = "ThreadRtLoad",
+    .attr_bits = osThreadJoinable,
+    .priority = osPriorityNormal,
+    .stack_size = 2048,
+};
+
+/* private functions -------------------------------------------------------- */
+/**
+  * @brief  Cyclictest-like benchmark, one thread wakes up periodically on the
+  *         absolute deadline beside some busy threads, and the latency of
+  *         the waking is measured, for the normal and the real-time thread.
+  * @retval None
+  */
+static int32_t test_rt_jitter(int32_t argc, char *argv[])
+{
+    static const osPriority_t priority[] =
+    {
+        osPriorityNormal, osPriorityRealtime,
+    };
+    rt_jitter_t jitter;
+    uint32_t time_ms = TEST_RT_JITTER_TIME_DEFAULT;
+    uint32_t interval_us = TEST_RT_JITTER_INTERVAL_DEFAULT;
+    uint32_t load = TEST_RT_JITTER_LOAD_DEFAULT;
+
+    if (argc >= 2)
+    {
+        time_ms = (uint32_t)atoi(argv[1]);
+        elab_assert(time_ms != 0);
+    }
+    if (argc >= 3)
+    {
+        interval_us = (uint32_t)atoi(argv[2]);
+        elab_assert(interval_us != 0);
+    }
+    if (argc >= 4)
+    {
+        load = (uint32_t)atoi(argv[3]);
+        elab_assert(load <= TEST_RT_JITTER_LOAD_MAX);
+    }
+
+    printf("Wake-up latency, %u ms, %u us interval, %u busy threads.\n",
+            time_ms, interval_us, load);
+    printf("%-10s %-12s %4s %8s %10s %10s %10s",
+            "priority", "policy", "prio", "samples",
+            "min (us)", "avg (us)", "max (us)");
+    char label[16];
+    for (uint32_t i = 0; i < TEST_RT_JITTER_HIST_NUM - 1; i ++)
+    {
+        snprintf(label, sizeof(label), "<%luus", hist_limit_us[i]);
+        printf(" %10s", label);
+    }
+    snprintf(label, sizeof(label), ">=%luus",
+                hist_limit_us[TEST_RT_JITTER_HIST_NUM - 2]);
+    printf(" %10s\n", label);
+
+    for (uint32_t i = 0; i < sizeof(priority) / sizeof(osPriority_t); i ++)
+    {
+        memset(&jitter, 0, sizeof(rt_jitter_t));
+        jitter.time_ms = time_ms;
+        jitter.interval_us = interval_us;
+        jitter.latency_min = UINT64_MAX;
+        _jitter_run(&jitter, priority[i], load);
+
+        printf("%-10s %-12s %4d %8u %10.1f %10.1f %10.1f",
+                (priority[i] == osPriorityNormal) ? "normal" : "realtime",
+                (jitter.policy == SCHED_FIFO) ? "SCHED_FIFO" :
+                    ((jitter.policy == SCHED_RR) ? "SCHED_RR" : "SCHED_OTHER"),
+                jitter.priority, jitter.count,
+                (double)jitter.latency_min / 1000.0,
+                (double)jitter.latency_sum / jitter.count / 1000.0,
+                (double)jitter.latency_max / 1000.0);
+        for (uint32_t j = 0; j < TEST_RT_JITTER_HIST_NUM; j ++)
+        {
+            printf(" %10u", jitter.hist[j]);
+        }
+        printf("\n");
+    }
+
+    return 0;
+}
+
+/**
+  * @brief  Run one round of the benchmark.
+  * @retval None
+  */
+static void _jitter_run(rt_jitter_t *jitter, osPriority_t priority,
+                        uint32_t load)
+{
+    const osThreadAttr_t attr =
+    {
+        .name = "ThreadRtMeasure",
+        .attr_bits = osThreadJoinable,
+        .priority = priority,
+        .stack_size = 2048,
+    };
+    osThreadId_t thread_load[TEST_RT_JITTER_LOAD_MAX];
+
+    /* All the threads start at once, since the shell thread may get no CPU
+       time any more when the busy threads run. */
+    jitter->event = osEventFlagsNew(NULL);
+    elab_assert(jitter->event != NULL);
+    for (uint32_t i = 0; i < load; i ++)
+    {
+        thread_load[i] = osThreadNew(_entry_load, jitter, &thread_attr_load);
+        elab_assert(thread_load[i] != NULL);
+    }
+    osThreadId_t thread = osThreadNew(_entry_measure, jitter, &attr);
+    elab_assert(thread != NULL);
+    osEventFlagsSet(jitter->event, TEST_RT_JITTER_FLAG_START);
+
+    osThreadJoin(thread);
+    for (uint32_t i = 0; i < load; i ++)
+    {
+        osThreadJoin(thread_load[i]);
+    }
+    osEventFlagsDelete(jitter->event);
+}
+
+/**
+  * @brief  The measuring thread, which stops the busy threads at the end.
+  */
+static void _entry_measure(void *para)
+{
+    rt_jitter_t *jitter = (rt_jitter_t *)para;
+    struct timespec ts;
+
+    osEventFlagsWait(jitter->event, TEST_RT_JITTER_FLAG_START,
+                        osFlagsWaitAny | osFlagsNoClear, osWaitForever);
+    osThreadGetSched(osThreadGetId(), &jitter->policy, &jitter->priority);
+
+    uint64_t time_next = _clock_ns();
+    uint64_t time_end = time_next + (uint64_t)jitter->time_ms * 1000000;
+    while (time_next < time_end)
+    {
+        time_next += (uint64_t)jitter->interval_us * 1000;
+        ts.tv_sec = time_next / 1000000000;
+        ts.tv_nsec = time_next % 1000000000;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+
+        uint64_t time = _clock_ns();
+        uint64_t latency = (time > time_next) ? (time - time_next) : 0;
+        jitter->count ++;
+        jitter->latency_sum += latency;
+        jitter->latency_min = (latency < jitter->latency_min) ?
+                                latency : jitter->latency_min;
+        jitter->latency_max = (latency > jitter->latency_max) ?
+                                latency : jitter->latency_max;
+        uint32_t index = 0;
+        while (index < (TEST_RT_JITTER_HIST_NUM - 1) &&
+                latency >= hist_limit_us[index] * 1000)
+        {
+            index ++;
+        }
+        jitter->hist[index] ++;
+
+        /* The late wake-ups are skipped, like cyclictest. */
+        if (time > time_next)
+        {
+            time_next += ((time - time_next) /
+                    ((uint64_t)jitter->interval_us * 1000)) *
+                    ((uint64_t)jitter->interval_us * 1000);
+        }
+    }
+
+    jitter->stop = true;
+}
+
+/**
+  * @brief  The busy thread as the load of the CPU.
+  */
+static void _entry_load(void *para)
+{
+    rt_jitter_t *jitter = (rt_jitter_t *)para;
+
+    osEventFlagsWait(jitter->event, TEST_RT_JITTER_FLAG_START,
+                        osFlagsWaitAny | osFlagsNoClear, osWaitForever);
+    while (!jitter->stop)
+    {
+    }
+}
+
+static uint64_t _clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+/**
+  * @brief  Test shell command export
+  */
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+                    test_rt_jitter,
+                    test_rt_jitter,
+                    cyclictest-like wake-up latency benchmark);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/* ----------------------------- end of file -------------------------------- */
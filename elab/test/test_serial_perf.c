@@ -0,0 +1,217 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+#if defined(__linux__)
+
+/* includes ----------------------------------------------------------------- */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../3rd/Shell/shell.h"
+#include "../common/elab_assert.h"
+#include "../common/elab_common.h"
+#include "../common/elab_log.h"
+#include "../edf/normal/elab_serial.h"
+#include "../edf/driver/simulator/simu_serial.h"
+#include "../os/cmsis_os.h"
+
+ELAB_TAG("SerialPerfTest");
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* private config ----------------------------------------------------------- */
+#define TEST_SERIAL_PERF_NAME_TX            "perf_serial_tx"
+#define TEST_SERIAL_PERF_NAME_RX            "perf_serial_rx"
+#define TEST_SERIAL_PERF_SIZE_DEFAULT       (4 * 1024 * 1024)
+#define TEST_SERIAL_PERF_CHUNK              (64)
+#define TEST_SERIAL_PERF_READ_MAX           (1024)
+#define TEST_SERIAL_PERF_ROUND              (3)
+#define TEST_SERIAL_PERF_FLAG_START         (0x01)
+
+/* private typedef ---------------------------------------------------------- */
+typedef struct serial_perf
+{
+    osEventFlagsId_t event;
+    elab_device_t *dev_tx;
+    elab_device_t *dev_rx;
+    uint32_t size;
+    uint32_t size_read;
+    uint32_t count_read;
+} serial_perf_t;
+
+/* private function prototype ----------------------------------------------- */
+static void _entry_write(void *para);
+static void _entry_read(void *para);
+static double _perf_run(serial_perf_t *perf, uint32_t size_read);
+
+/* private variables -------------------------------------------------------- */
+static const osThreadAttr_t thread_attr_serial_perf =
+{
+    .name = "ThreadSerialPerf",
+    .attr_bits = osThreadJoinable,
+    .priority = osPriorityNormal,
+    .stack_size = 4096,
+};
+
+/* private functions -------------------------------------------------------- */
+/**
+  * @brief  Serial receiving throughput benchmark over a pair of simulated
+  *         serial ports, one thread writing small chunks, and the other one
+  *         reading all the data available at most 1, 64 or 1k bytes at one
+  *         time.
+  * @retval None
+  */
+static int32_t test_serial_perf(int32_t argc, char *argv[])
+{
+    static const uint32_t size_read[] =
+    {
+        1, TEST_SERIAL_PERF_CHUNK, TEST_SERIAL_PERF_READ_MAX,
+    };
+    serial_perf_t perf;
+
+    memset(&perf, 0, sizeof(serial_perf_t));
+    perf.size = TEST_SERIAL_PERF_SIZE_DEFAULT;
+    if (argc >= 2)
+    {
+        perf.size = (uint32_t)atoi(argv[1]);
+        elab_assert(perf.size != 0);
+    }
+
+    simu_serial_new_pair(TEST_SERIAL_PERF_NAME_TX, TEST_SERIAL_PERF_NAME_RX,
+                            115200);
+    perf.dev_tx = elab_device_find(TEST_SERIAL_PERF_NAME_TX);
+    perf.dev_rx = elab_device_find(TEST_SERIAL_PERF_NAME_RX);
+    elab_assert(perf.dev_tx != NULL && perf.dev_rx != NULL);
+    elab_device_open(perf.dev_tx);
+    elab_device_open(perf.dev_rx);
+
+    printf("Serial receiving benchmark, %u bytes in %u-byte chunks, "
+            "best of %u rounds.\n", perf.size, TEST_SERIAL_PERF_CHUNK,
+            TEST_SERIAL_PERF_ROUND);
+    printf("%12s %12s %16s\n", "read max", "MB/s", "bytes per read");
+    for (uint32_t i = 0; i < sizeof(size_read) / sizeof(uint32_t); i ++)
+    {
+        /* The best round filters out the noise of the other processes. */
+        double time_best = _perf_run(&perf, size_read[i]);
+        uint32_t count_read = perf.count_read;
+        for (uint32_t j = 1; j < TEST_SERIAL_PERF_ROUND; j ++)
+        {
+            double time = _perf_run(&perf, size_read[i]);
+            if (time < time_best)
+            {
+                time_best = time;
+                count_read = perf.count_read;
+            }
+        }
+        printf("%12u %12.2f %16.1f\n", size_read[i],
+                (double)perf.size / time_best / 1e6,
+                (double)perf.size / count_read);
+    }
+
+    elab_device_close(perf.dev_tx);
+    elab_device_close(perf.dev_rx);
+    simu_serial_destroy(TEST_SERIAL_PERF_NAME_TX);
+    simu_serial_destroy(TEST_SERIAL_PERF_NAME_RX);
+
+    return 0;
+}
+
+/**
+  * @brief  Run one round of the benchmark.
+  * @param  size_read   The most size of every reading.
+  * @retval Time in seconds.
+  */
+static double _perf_run(serial_perf_t *perf, uint32_t size_read)
+{
+    perf->size_read = size_read;
+    perf->count_read = 0;
+    perf->event = osEventFlagsNew(NULL);
+    elab_assert(perf->event != NULL);
+
+    /* Both threads start at once, since the shell thread may get no CPU time
+       any more when they run. */
+    osThreadId_t thread_wr = osThreadNew(_entry_write, perf,
+                                            &thread_attr_serial_perf);
+    elab_assert(thread_wr != NULL);
+    osThreadId_t thread_rd = osThreadNew(_entry_read, perf,
+                                            &thread_attr_serial_perf);
+    elab_assert(thread_rd != NULL);
+
+    uint64_t time_start = elab_time_ns();
+    osEventFlagsSet(perf->event, TEST_SERIAL_PERF_FLAG_START);
+    osThreadJoin(thread_rd);
+    uint64_t time_end = elab_time_ns();
+    osThreadJoin(thread_wr);
+    osEventFlagsDelete(perf->event);
+
+    return (double)(time_end - time_start) / 1e9;
+}
+
+/**
+  * @brief  The writing thread of the benchmark.
+  */
+static void _entry_write(void *para)
+{
+    serial_perf_t *perf = (serial_perf_t *)para;
+    uint8_t buffer[TEST_SERIAL_PERF_CHUNK];
+
+    for (uint32_t i = 0; i < TEST_SERIAL_PERF_CHUNK; i ++)
+    {
+        buffer[i] = (uint8_t)i;
+    }
+
+    osEventFlagsWait(perf->event, TEST_SERIAL_PERF_FLAG_START,
+                        osFlagsWaitAny | osFlagsNoClear, osWaitForever);
+    for (uint32_t count = 0; count < perf->size;)
+    {
+        uint32_t size = perf->size - count;
+        size = (size < TEST_SERIAL_PERF_CHUNK) ? size : TEST_SERIAL_PERF_CHUNK;
+        int32_t ret = elab_serial_write(perf->dev_tx, buffer, size);
+        elab_assert(ret == (int32_t)size);
+        count += size;
+    }
+}
+
+/**
+  * @brief  The reading thread of the benchmark.
+  */
+static void _entry_read(void *para)
+{
+    serial_perf_t *perf = (serial_perf_t *)para;
+    uint8_t buffer[TEST_SERIAL_PERF_READ_MAX];
+
+    osEventFlagsWait(perf->event, TEST_SERIAL_PERF_FLAG_START,
+                        osFlagsWaitAny | osFlagsNoClear, osWaitForever);
+    for (uint32_t count = 0; count < perf->size;)
+    {
+        uint32_t size = perf->size - count;
+        size = (size < perf->size_read) ? size : perf->size_read;
+        int32_t ret = elab_serial_read_range(perf->dev_rx, buffer, 1, size,
+                                                osWaitForever);
+        elab_assert(ret > 0);
+        elab_assert(buffer[0] == (uint8_t)(count % TEST_SERIAL_PERF_CHUNK));
+        count += ret;
+        perf->count_read ++;
+    }
+}
+
+/**
+  * @brief  Test shell command export
+  */
+SHELL_EXPORT_CMD(SHELL_CMD_PERMISSION(0) | SHELL_CMD_TYPE(SHELL_TYPE_CMD_MAIN),
+                    test_serial_perf,
+                    test_serial_perf,
+                    serial receiving benchmark [size]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/* ----------------------------- end of file -------------------------------- */
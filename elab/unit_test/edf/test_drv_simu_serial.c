@@ -26,6 +26,10 @@ ELAB_TAG("ut_drv_simu_serial");
 
 #define UT_SIMU_SERIAL_BUFF_SIZE                    (256)
 #define UT_SIMU_SERIAL_TIMES                        (100)
+#define UT_SIMU_SERIAL_FRAME_GAP_BITS               (576)   /* 5ms in 115200 */
+#define UT_SIMU_SERIAL_MODBUS_GAP_BITS              (39)    /* 3.5 characters */
+#define UT_SIMU_SERIAL_MODBUS_FRAME_SIZE            (100)   /* 8.7ms in 115200 */
+#define UT_SIMU_SERIAL_MODBUS_TIMES                 (20)
 
 #define UT_STR_READ                                 "dev_read_data"
 #define UT_STR_WRITE                                "dev_write_data"
@@ -196,6 +200,229 @@ TEST(simu_serial, make_rx_data)
     TEST_ASSERT_NULL(dev);
 }
 
+/**
+  * @brief  The rx data received in the circular DMA mode.
+  */
+TEST(simu_serial, make_rx_data_dma)
+{
+    elab_device_t *dev = NULL;
+    simu_serial_new_dma("simu_serial", 115200);
+    dev = elab_device_find("simu_serial");
+    TEST_ASSERT_NOT_NULL(dev);
+    elab_device_open(dev);
+
+    /* The data sizes are different, so the data crosses the half and the end
+       of the DMA buffer in different positions. */
+    int32_t ret = 0;
+    for (uint32_t i = 0; i < UT_SIMU_SERIAL_TIMES; i ++)
+    {
+        uint32_t size = 1 + (i * 37) % (SIMU_SERIAL_DMA_SIZE - 1);
+        for (uint32_t j = 0; j < size; j ++)
+        {
+            buff_tx[j] = rand() % UINT8_MAX;
+        }
+        memset(buff_rx, 0, UT_SIMU_SERIAL_BUFF_SIZE);
+        simu_serial_make_rx_data("simu_serial", buff_tx, size);
+        ret = elab_serial_read(dev, buff_rx, size, 100);
+        TEST_ASSERT_EQUAL_INT32(size, ret);
+        TEST_ASSERT_EQUAL_MEMORY(buff_tx, buff_rx, size);
+    }
+
+    /* No data. */
+    ret = elab_serial_read(dev, buff_rx, UT_SIMU_SERIAL_BUFF_SIZE, 10);
+    TEST_ASSERT_EQUAL_INT32(ELAB_ERR_TIMEOUT, ret);
+
+    /* The DMA starts from the beginning of the buffer again after reopening. */
+    elab_device_close(dev);
+    elab_device_open(dev);
+    memset(buff_rx, 0, UT_SIMU_SERIAL_BUFF_SIZE);
+    simu_serial_make_rx_data("simu_serial", UT_STR_READ, strlen(UT_STR_READ));
+    ret = elab_serial_read(dev, buff_rx, strlen(UT_STR_READ), 100);
+    TEST_ASSERT_EQUAL_INT32(strlen(UT_STR_READ), ret);
+    TEST_ASSERT_EQUAL_MEMORY(UT_STR_READ, buff_rx, ret);
+
+    elab_device_close(dev);
+    simu_serial_destroy("simu_serial");
+    dev = elab_device_find("simu_serial");
+    TEST_ASSERT_NULL(dev);
+}
+
+/**
+  * @brief  The data not read is overwritten by the circular DMA, which is
+  *         dropped and counted, and the data after it is read well.
+  */
+TEST(simu_serial, rx_dma_overrun)
+{
+    elab_device_t *dev = NULL;
+    simu_serial_new_dma("simu_serial", 115200);
+    dev = elab_device_find("simu_serial");
+    TEST_ASSERT_NOT_NULL(dev);
+    elab_device_open(dev);
+    TEST_ASSERT_EQUAL_UINT32(0, elab_serial_get_rx_dropped(dev));
+
+    /* More than one DMA buffer of data without reading. */
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < 3; i ++)
+    {
+        for (uint32_t j = 0; j < (SIMU_SERIAL_DMA_SIZE / 2); j ++)
+        {
+            buff_tx[j] = rand() % UINT8_MAX;
+        }
+        simu_serial_make_rx_data("simu_serial", buff_tx, (SIMU_SERIAL_DMA_SIZE / 2));
+        size += (SIMU_SERIAL_DMA_SIZE / 2);
+    }
+    osDelay(50);                /* 384 bytes in about 34 ms at 115200. */
+
+    int32_t ret = elab_serial_read(dev, buff_rx, UT_SIMU_SERIAL_BUFF_SIZE, 10);
+    TEST_ASSERT_EQUAL_INT32(ELAB_ERR_TIMEOUT, ret);
+    TEST_ASSERT_EQUAL_UINT32(size, elab_serial_get_rx_dropped(dev));
+
+    memset(buff_rx, 0, UT_SIMU_SERIAL_BUFF_SIZE);
+    simu_serial_make_rx_data("simu_serial", UT_STR_READ, strlen(UT_STR_READ));
+    ret = elab_serial_read(dev, buff_rx, strlen(UT_STR_READ), 100);
+    TEST_ASSERT_EQUAL_INT32(strlen(UT_STR_READ), ret);
+    TEST_ASSERT_EQUAL_MEMORY(UT_STR_READ, buff_rx, ret);
+    TEST_ASSERT_EQUAL_UINT32(size, elab_serial_get_rx_dropped(dev));
+
+    elab_device_close(dev);
+    simu_serial_destroy("simu_serial");
+    dev = elab_device_find("simu_serial");
+    TEST_ASSERT_NULL(dev);
+}
+
+/**
+  * @brief  The frames in the circular DMA mode, ended by the idle line.
+  */
+TEST(simu_serial, read_frame_dma)
+{
+    elab_device_t *dev = NULL;
+    simu_serial_new_dma("simu_serial", 115200);
+    dev = elab_device_find("simu_serial");
+    TEST_ASSERT_NOT_NULL(dev);
+    elab_serial_set_frame(dev, UT_SIMU_SERIAL_FRAME_GAP_BITS,
+                            (SIMU_SERIAL_DMA_SIZE / 2));
+    elab_device_open(dev);
+
+    int32_t ret = 0;
+    for (uint32_t i = 0; i < UT_SIMU_SERIAL_TIMES; i ++)
+    {
+        /* Two frames split by the idle line, read after both of them. */
+        simu_serial_make_rx_data("simu_serial", UT_STR_READ, strlen(UT_STR_READ));
+        osDelay(10);
+        simu_serial_make_rx_data("simu_serial", UT_STR_WRITE, strlen(UT_STR_WRITE));
+        osDelay(10);
+
+        memset(buff_rx, 0, UT_SIMU_SERIAL_BUFF_SIZE);
+        ret = elab_serial_read_frame(dev, buff_rx, UT_SIMU_SERIAL_BUFF_SIZE, 100);
+        TEST_ASSERT_EQUAL_INT32(strlen(UT_STR_READ), ret);
+        TEST_ASSERT_EQUAL_MEMORY(UT_STR_READ, buff_rx, ret);
+        memset(buff_rx, 0, UT_SIMU_SERIAL_BUFF_SIZE);
+        ret = elab_serial_read_frame(dev, buff_rx, UT_SIMU_SERIAL_BUFF_SIZE, 100);
+        TEST_ASSERT_EQUAL_INT32(strlen(UT_STR_WRITE), ret);
+        TEST_ASSERT_EQUAL_MEMORY(UT_STR_WRITE, buff_rx, ret);
+    }
+
+    elab_device_close(dev);
+    simu_serial_destroy("simu_serial");
+    dev = elab_device_find("simu_serial");
+    TEST_ASSERT_NULL(dev);
+}
+
+/**
+  * @brief  The frames split by the Modbus RTU gap on the simulated line, which
+  *         are much longer than one polling of the receiving thread.
+  */
+TEST(simu_serial, read_frame_line_timing)
+{
+    elab_device_t *dev = NULL;
+    simu_serial_new("simu_serial", SIMU_SERIAL_MODE_SINGLE, 115200);
+    simu_serial_set_line_timing("simu_serial", true);
+    dev = elab_device_find("simu_serial");
+    TEST_ASSERT_NOT_NULL(dev);
+    elab_serial_set_frame(dev, UT_SIMU_SERIAL_MODBUS_GAP_BITS,
+                            UT_SIMU_SERIAL_BUFF_SIZE);
+    elab_device_open(dev);
+
+    int32_t ret = 0;
+    for (uint32_t i = 0; i < UT_SIMU_SERIAL_MODBUS_TIMES; i ++)
+    {
+        for (uint32_t j = 0; j < UT_SIMU_SERIAL_BUFF_SIZE; j ++)
+        {
+            buff_tx[j] = rand() % UINT8_MAX;
+        }
+
+        /* Two frames split by the gap of about 20 ms, read while arriving. */
+        simu_serial_make_rx_data("simu_serial", buff_tx,
+                                    UT_SIMU_SERIAL_MODBUS_FRAME_SIZE);
+        osDelay(30);
+        simu_serial_make_rx_data("simu_serial",
+                                    &buff_tx[UT_SIMU_SERIAL_MODBUS_FRAME_SIZE],
+                                    (UT_SIMU_SERIAL_MODBUS_FRAME_SIZE / 2));
+
+        memset(buff_rx, 0, UT_SIMU_SERIAL_BUFF_SIZE);
+        ret = elab_serial_read_frame(dev, buff_rx, UT_SIMU_SERIAL_BUFF_SIZE, 100);
+        TEST_ASSERT_EQUAL_INT32(UT_SIMU_SERIAL_MODBUS_FRAME_SIZE, ret);
+        TEST_ASSERT_EQUAL_MEMORY(buff_tx, buff_rx, ret);
+        memset(buff_rx, 0, UT_SIMU_SERIAL_BUFF_SIZE);
+        ret = elab_serial_read_frame(dev, buff_rx, UT_SIMU_SERIAL_BUFF_SIZE, 100);
+        TEST_ASSERT_EQUAL_INT32((UT_SIMU_SERIAL_MODBUS_FRAME_SIZE / 2), ret);
+        TEST_ASSERT_EQUAL_MEMORY(&buff_tx[UT_SIMU_SERIAL_MODBUS_FRAME_SIZE],
+                                    buff_rx, ret);
+    }
+
+    elab_device_close(dev);
+    simu_serial_destroy("simu_serial");
+    dev = elab_device_find("simu_serial");
+    TEST_ASSERT_NULL(dev);
+}
+
+/**
+  * @brief  The frames split by the Modbus RTU gap in the circular DMA mode,
+  *         crossing the half and the end of the DMA buffer.
+  */
+TEST(simu_serial, read_frame_dma_line_timing)
+{
+    elab_device_t *dev = NULL;
+    simu_serial_new_dma("simu_serial", 115200);
+    simu_serial_set_line_timing("simu_serial", true);
+    dev = elab_device_find("simu_serial");
+    TEST_ASSERT_NOT_NULL(dev);
+    elab_serial_set_frame(dev, UT_SIMU_SERIAL_MODBUS_GAP_BITS,
+                            UT_SIMU_SERIAL_BUFF_SIZE);
+    elab_device_open(dev);
+
+    int32_t ret = 0;
+    for (uint32_t i = 0; i < UT_SIMU_SERIAL_MODBUS_TIMES; i ++)
+    {
+        for (uint32_t j = 0; j < UT_SIMU_SERIAL_BUFF_SIZE; j ++)
+        {
+            buff_tx[j] = rand() % UINT8_MAX;
+        }
+
+        /* Each frame is read in time, before the DMA overwrites it. */
+        simu_serial_make_rx_data("simu_serial", buff_tx,
+                                    UT_SIMU_SERIAL_MODBUS_FRAME_SIZE);
+        memset(buff_rx, 0, UT_SIMU_SERIAL_BUFF_SIZE);
+        ret = elab_serial_read_frame(dev, buff_rx, UT_SIMU_SERIAL_BUFF_SIZE, 100);
+        TEST_ASSERT_EQUAL_INT32(UT_SIMU_SERIAL_MODBUS_FRAME_SIZE, ret);
+        TEST_ASSERT_EQUAL_MEMORY(buff_tx, buff_rx, ret);
+
+        simu_serial_make_rx_data("simu_serial",
+                                    &buff_tx[UT_SIMU_SERIAL_MODBUS_FRAME_SIZE],
+                                    (UT_SIMU_SERIAL_MODBUS_FRAME_SIZE / 2));
+        memset(buff_rx, 0, UT_SIMU_SERIAL_BUFF_SIZE);
+        ret = elab_serial_read_frame(dev, buff_rx, UT_SIMU_SERIAL_BUFF_SIZE, 100);
+        TEST_ASSERT_EQUAL_INT32((UT_SIMU_SERIAL_MODBUS_FRAME_SIZE / 2), ret);
+        TEST_ASSERT_EQUAL_MEMORY(&buff_tx[UT_SIMU_SERIAL_MODBUS_FRAME_SIZE],
+                                    buff_rx, ret);
+    }
+
+    elab_device_close(dev);
+    simu_serial_destroy("simu_serial");
+    dev = elab_device_find("simu_serial");
+    TEST_ASSERT_NULL(dev);
+}
+
 /**
   * @brief  Assert failures in device framework functions.
   */
@@ -372,6 +599,11 @@ TEST(simu_serial, rx_tx_pair_uart_mqtt_cross_thread)
 TEST_GROUP_RUNNER(simu_serial)
 {
     RUN_TEST_CASE(simu_serial, new_destroy_single_mode);
+    RUN_TEST_CASE(simu_serial, make_rx_data_dma);
+    RUN_TEST_CASE(simu_serial, rx_dma_overrun);
+    RUN_TEST_CASE(simu_serial, read_frame_dma);
+    RUN_TEST_CASE(simu_serial, read_frame_dma_line_timing);
+    RUN_TEST_CASE(simu_serial, read_frame_line_timing);
     RUN_TEST_CASE(simu_serial, new_destroy_pair_uart_mqtt);
     RUN_TEST_CASE(simu_serial, make_rx_data);
     RUN_TEST_CASE(simu_serial, read_tx_data);
@@ -0,0 +1,407 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "../../edf/elab_device.h"
+#include "../../3rd/Unity/unity.h"
+#include "../../3rd/Unity/unity_fixture.h"
+#include "../../common/elab_common.h"
+#include "../../common/elab_assert.h"
+
+#define TAG                         "ut_elab_device_async"
+#include "../../common/elab_log.h"
+
+/* Private config ------------------------------------------------------------*/
+#define UT_ASYNC_BUFF_SIZE                          (64)
+#define UT_ASYNC_QUEUE_SIZE                         (8)
+#define UT_ASYNC_DRIVER_SIZE                        (5)
+
+#define UT_STR_READ                                 "dev_read_data"
+#define UT_STR_WRITE                                "dev_write_data"
+
+/* Exported function prototypes ----------------------------------------------*/
+void elab_device_unregister(elab_device_t *me);
+
+/* Private function prototypes -----------------------------------------------*/
+static elab_err_t ops_enable(elab_device_t *dev, bool status);
+static int32_t ops_read(elab_device_t *dev,
+                        uint32_t pos, void *buffer, uint32_t size);
+static int32_t ops_write(elab_device_t *dev,
+                            uint32_t pos, const void *buffer, uint32_t size);
+static elab_err_t ops_submit(elab_device_t *dev, elab_device_req_t *req);
+static elab_err_t ops_cancel(elab_device_t *dev, elab_device_req_t *req);
+static void req_cb(elab_device_req_t *req);
+static void timer_func_unblock(void *para);
+static elab_device_t *device_new(const char *name, const elab_dev_ops_t *ops);
+static void device_free(elab_device_t *dev);
+
+/* Private variables ---------------------------------------------------------*/
+static const elab_dev_ops_t ops_thread =
+{
+    .enable = ops_enable,
+    .read = ops_read,
+    .write = ops_write,
+};
+
+static const elab_dev_ops_t ops_driver =
+{
+    .enable = ops_enable,
+    .read = ops_read,
+    .write = ops_write,
+    .submit = ops_submit,
+    .cancel = ops_cancel,
+};
+
+static uint8_t buff_rd[UT_ASYNC_BUFF_SIZE];
+static uint8_t buff_wr[UT_ASYNC_BUFF_SIZE];
+static osSemaphoreId_t sem_read_block = NULL;
+static elab_device_req_t *req_submitted = NULL;
+static uint32_t count_cb = 0;
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Define test group of device asynchronous requests
+  */
+TEST_GROUP(edf_async);
+
+/**
+  * @brief  Define test fixture setup function of device asynchronous requests
+  */
+TEST_SETUP(edf_async)
+{
+    memset(buff_rd, 0, sizeof(buff_rd));
+    memset(buff_wr, 0, sizeof(buff_wr));
+    sem_read_block = NULL;
+    req_submitted = NULL;
+    count_cb = 0;
+}
+
+/**
+  * @brief  Define test fixture tear down function of device asynchronous
+  *         requests
+  */
+TEST_TEAR_DOWN(edf_async)
+{
+
+}
+
+/**
+  * @brief  Reading and writing by the thread-backed requests, informed by the
+  *         callback, the completion queue and the waiting.
+  */
+TEST(edf_async, thread_read_write)
+{
+    elab_device_t *dev = device_new("dev_async", &ops_thread);
+    osMessageQueueId_t queue =
+        osMessageQueueNew(UT_ASYNC_QUEUE_SIZE, sizeof(elab_device_req_t *), NULL);
+    TEST_ASSERT_NOT_NULL(queue);
+
+    elab_device_req_t req_rd =
+    {
+        .type = ELAB_DEVICE_REQ_READ,
+        .buffer = buff_rd,
+        .size = UT_ASYNC_BUFF_SIZE,
+        .timeout = osWaitForever,
+        .cb = req_cb,
+        .queue = queue,
+    };
+    elab_device_req_t req_wr =
+    {
+        .type = ELAB_DEVICE_REQ_WRITE,
+        .buffer = UT_STR_WRITE,
+        .size = strlen(UT_STR_WRITE),
+        .timeout = osWaitForever,
+        .queue = queue,
+    };
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_submit(dev, &req_rd));
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_submit(dev, &req_wr));
+
+    /* Completed in the submitting order. */
+    elab_device_req_t *req = NULL;
+    TEST_ASSERT_EQUAL_INT32(osOK, osMessageQueueGet(queue, &req, NULL, 1000));
+    TEST_ASSERT_EQUAL_PTR(&req_rd, req);
+    TEST_ASSERT_EQUAL_INT32(osOK, osMessageQueueGet(queue, &req, NULL, 1000));
+    TEST_ASSERT_EQUAL_PTR(&req_wr, req);
+
+    TEST_ASSERT_TRUE(elab_device_req_is_done(&req_rd));
+    TEST_ASSERT_EQUAL_INT32(strlen(UT_STR_READ), req_rd.result);
+    TEST_ASSERT_EQUAL_STRING(UT_STR_READ, (char *)buff_rd);
+    TEST_ASSERT_EQUAL_UINT32(1, count_cb);
+    TEST_ASSERT_EQUAL_INT32(strlen(UT_STR_WRITE), req_wr.result);
+    TEST_ASSERT_EQUAL_STRING(UT_STR_WRITE, (char *)buff_wr);
+
+    /* The request can be submitted again once done. */
+    req_rd.queue = NULL;
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_submit(dev, &req_rd));
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_req_wait(&req_rd, 1000));
+    TEST_ASSERT_EQUAL_INT32(strlen(UT_STR_READ), req_rd.result);
+    TEST_ASSERT_EQUAL_UINT32(2, count_cb);
+    TEST_ASSERT_EQUAL_INT32(ELAB_ERROR, elab_device_cancel(&req_rd));
+
+    TEST_ASSERT_EQUAL_INT32(osOK, osMessageQueueDelete(queue));
+    device_free(dev);
+}
+
+/**
+  * @brief  Cancelling and timeout of the thread-backed requests, the queued
+  *         ones can be cancelled and the transferring one can not.
+  */
+TEST(edf_async, thread_cancel_timeout)
+{
+    sem_read_block = osSemaphoreNew(1, 0, NULL);
+    TEST_ASSERT_NOT_NULL(sem_read_block);
+    elab_device_t *dev = device_new("dev_async", &ops_thread);
+
+    elab_device_req_t req[3];
+    for (uint32_t i = 0; i < 3; i ++)
+    {
+        memset(&req[i], 0, sizeof(elab_device_req_t));
+        req[i].type = ELAB_DEVICE_REQ_READ;
+        req[i].buffer = buff_rd;
+        req[i].size = UT_ASYNC_BUFF_SIZE;
+        req[i].timeout = (i == 2) ? 10 : osWaitForever;
+        TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_submit(dev, &req[i]));
+    }
+
+    /* The first one is blocked in the reading. */
+    TEST_ASSERT_EQUAL_INT32(ELAB_ERR_TIMEOUT, elab_device_req_wait(&req[0], 20));
+    TEST_ASSERT_EQUAL_INT32(ELAB_ERR_BUSY, elab_device_cancel(&req[0]));
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_cancel(&req[1]));
+    TEST_ASSERT_TRUE(elab_device_req_is_done(&req[1]));
+    TEST_ASSERT_EQUAL_INT32(ELAB_ERR_CANCEL, req[1].result);
+
+    TEST_ASSERT_EQUAL_INT32(osOK, osSemaphoreRelease(sem_read_block));
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_req_wait(&req[0], 1000));
+    TEST_ASSERT_EQUAL_INT32(strlen(UT_STR_READ), req[0].result);
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_req_wait(&req[2], 1000));
+    TEST_ASSERT_EQUAL_INT32(ELAB_ERR_TIMEOUT, req[2].result);
+
+    device_free(dev);
+    TEST_ASSERT_EQUAL_INT32(osOK, osSemaphoreDelete(sem_read_block));
+    sem_read_block = NULL;
+}
+
+/**
+  * @brief  The queued requests are cancelled in unregistering.
+  */
+TEST(edf_async, thread_unregister)
+{
+    sem_read_block = osSemaphoreNew(1, 0, NULL);
+    TEST_ASSERT_NOT_NULL(sem_read_block);
+    elab_device_t *dev = device_new("dev_async", &ops_thread);
+
+    elab_device_req_t req[2];
+    for (uint32_t i = 0; i < 2; i ++)
+    {
+        memset(&req[i], 0, sizeof(elab_device_req_t));
+        req[i].type = ELAB_DEVICE_REQ_READ;
+        req[i].buffer = buff_rd;
+        req[i].size = UT_ASYNC_BUFF_SIZE;
+        req[i].timeout = osWaitForever;
+        TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_submit(dev, &req[i]));
+    }
+    TEST_ASSERT_EQUAL_INT32(ELAB_ERR_TIMEOUT, elab_device_req_wait(&req[0], 20));
+
+    /* The transferring one finishes before the thread stops, in unregistering. */
+    osTimerId_t timer = osTimerNew(timer_func_unblock, osTimerOnce, NULL, NULL);
+    TEST_ASSERT_NOT_NULL(timer);
+    TEST_ASSERT_EQUAL_INT32(osOK, osTimerStart(timer, 20));
+    device_free(dev);
+    TEST_ASSERT_EQUAL_INT32(osOK, osTimerDelete(timer));
+    TEST_ASSERT_TRUE(elab_device_req_is_done(&req[0]));
+    TEST_ASSERT_TRUE(elab_device_req_is_done(&req[1]));
+    TEST_ASSERT_EQUAL_INT32(ELAB_ERR_CANCEL, req[1].result);
+
+    TEST_ASSERT_EQUAL_INT32(osOK, osSemaphoreDelete(sem_read_block));
+    sem_read_block = NULL;
+}
+
+/**
+  * @brief  The queued requests are cancelled in closing, and the transferring
+  *         one finishes.
+  */
+TEST(edf_async, thread_close)
+{
+    sem_read_block = osSemaphoreNew(1, 0, NULL);
+    TEST_ASSERT_NOT_NULL(sem_read_block);
+    elab_device_t *dev = device_new("dev_async", &ops_thread);
+
+    elab_device_req_t req[2];
+    for (uint32_t i = 0; i < 2; i ++)
+    {
+        memset(&req[i], 0, sizeof(elab_device_req_t));
+        req[i].type = ELAB_DEVICE_REQ_READ;
+        req[i].buffer = buff_rd;
+        req[i].size = UT_ASYNC_BUFF_SIZE;
+        req[i].timeout = osWaitForever;
+        TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_submit(dev, &req[i]));
+    }
+    TEST_ASSERT_EQUAL_INT32(ELAB_ERR_TIMEOUT, elab_device_req_wait(&req[0], 20));
+
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_close(dev));
+    TEST_ASSERT_TRUE(elab_device_req_is_done(&req[1]));
+    TEST_ASSERT_EQUAL_INT32(ELAB_ERR_CANCEL, req[1].result);
+    TEST_ASSERT_FALSE(elab_device_req_is_done(&req[0]));
+
+    TEST_ASSERT_EQUAL_INT32(osOK, osSemaphoreRelease(sem_read_block));
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_req_wait(&req[0], 1000));
+    TEST_ASSERT_EQUAL_INT32(strlen(UT_STR_READ), req[0].result);
+
+    elab_device_unregister(dev);
+    elab_free(dev);
+    TEST_ASSERT_EQUAL_INT32(osOK, osSemaphoreDelete(sem_read_block));
+    sem_read_block = NULL;
+}
+
+/**
+  * @brief  The requests taken by the driver's submit interface.
+  */
+TEST(edf_async, driver_submit)
+{
+    elab_device_t *dev = device_new("dev_async", &ops_driver);
+    elab_device_req_t req =
+    {
+        .type = ELAB_DEVICE_REQ_WRITE,
+        .buffer = UT_STR_WRITE,
+        .size = strlen(UT_STR_WRITE),
+        .timeout = osWaitForever,
+        .cb = req_cb,
+    };
+
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_submit(dev, &req));
+    TEST_ASSERT_EQUAL_PTR(&req, req_submitted);
+    TEST_ASSERT_FALSE(elab_device_req_is_done(&req));
+    elab_device_req_complete(&req, UT_ASYNC_DRIVER_SIZE);
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_req_wait(&req, 0));
+    TEST_ASSERT_EQUAL_INT32(UT_ASYNC_DRIVER_SIZE, req.result);
+    TEST_ASSERT_EQUAL_UINT32(1, count_cb);
+
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_submit(dev, &req));
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_cancel(&req));
+    TEST_ASSERT_NULL(req_submitted);
+    TEST_ASSERT_EQUAL_INT32(ELAB_ERR_CANCEL, req.result);
+    TEST_ASSERT_EQUAL_UINT32(2, count_cb);
+
+    device_free(dev);
+}
+
+/**
+  * @brief  Define run test cases of device asynchronous requests
+  */
+TEST_GROUP_RUNNER(edf_async)
+{
+    RUN_TEST_CASE(edf_async, thread_read_write);
+    RUN_TEST_CASE(edf_async, thread_cancel_timeout);
+    RUN_TEST_CASE(edf_async, thread_unregister);
+    RUN_TEST_CASE(edf_async, thread_close);
+    RUN_TEST_CASE(edf_async, driver_submit);
+}
+
+/* Private functions ---------------------------------------------------------*/
+static elab_err_t ops_enable(elab_device_t *dev, bool status)
+{
+    (void)dev;
+    (void)status;
+
+    return ELAB_OK;
+}
+
+/**
+  * @brief  Simulated driver reading function, which is blocked if the test
+  *         gives the semaphore.
+  */
+static int32_t ops_read(elab_device_t *dev,
+                        uint32_t pos, void *buffer, uint32_t size)
+{
+    (void)dev;
+    (void)pos;
+    (void)size;
+
+    if (sem_read_block != NULL)
+    {
+        osSemaphoreAcquire(sem_read_block, osWaitForever);
+    }
+    memcpy(buffer, UT_STR_READ, strlen(UT_STR_READ));
+
+    return strlen(UT_STR_READ);
+}
+
+static int32_t ops_write(elab_device_t *dev,
+                            uint32_t pos, const void *buffer, uint32_t size)
+{
+    (void)dev;
+    (void)pos;
+
+    memcpy(buff_wr, buffer, size);
+
+    return size;
+}
+
+/**
+  * @brief  Simulated driver submitting function, which keeps the request for
+  *         the test to complete it.
+  */
+static elab_err_t ops_submit(elab_device_t *dev, elab_device_req_t *req)
+{
+    (void)dev;
+
+    req_submitted = req;
+
+    return ELAB_OK;
+}
+
+static elab_err_t ops_cancel(elab_device_t *dev, elab_device_req_t *req)
+{
+    (void)dev;
+
+    TEST_ASSERT_EQUAL_PTR(req_submitted, req);
+    req_submitted = NULL;
+
+    return ELAB_OK;
+}
+
+static void req_cb(elab_device_req_t *req)
+{
+    (void)req;
+
+    count_cb ++;
+}
+
+static void timer_func_unblock(void *para)
+{
+    (void)para;
+
+    osSemaphoreRelease(sem_read_block);
+}
+
+static elab_device_t *device_new(const char *name, const elab_dev_ops_t *ops)
+{
+    elab_device_t *dev = elab_malloc(sizeof(elab_device_t));
+    TEST_ASSERT_NOT_NULL(dev);
+    memset(dev, 0, sizeof(elab_device_t));
+    elab_device_attr_t attr =
+    {
+        .name = name,
+        .sole = true,
+        .type = ELAB_DEVICE_UNKNOWN,
+    };
+    dev->ops = ops;
+    elab_device_register(dev, &attr);
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_open(dev));
+
+    return dev;
+}
+
+static void device_free(elab_device_t *dev)
+{
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_close(dev));
+    elab_device_unregister(dev);
+    elab_free(dev);
+}
+
+/* ----------------------------- end of file -------------------------------- */
@@ -22,6 +22,7 @@
 #define UT_DEVICE_BUFF_SIZE                         (256)
 #define UT_HEAP_SIZE                                (1024 * 10)
 #define UT_OPEN_TIMES_MAX                           (250)
+#define UT_EDF_MANY_NUM                             (2000)
 
 #define UT_STR_READ                                 "dev_read_data"
 #define UT_STR_WRITE                                "dev_write_data"
@@ -39,6 +40,7 @@ static int32_t ops_write(elab_device_t *dev,
 static elab_err_t ops_control(elab_device_t *dev, int32_t cmd, void *args);
 static void thread_func_read(void *paras);
 static void thread_func_write(void *paras);
+static void foreach_check_order(elab_device_t *dev, void *para);
 
 /* Private variables ---------------------------------------------------------*/
 static const elab_dev_ops_t serial_ops =
@@ -142,6 +144,64 @@ TEST(edf_core, register_unregister)
     }
 }
 
+/**
+  * @brief  Finding among many devices, after some of them are unregistered.
+  */
+TEST(edf_core, find_many)
+{
+    static char dev_name[UT_EDF_MANY_NUM][16];
+    elab_device_t *dev = elab_malloc(sizeof(elab_device_t) * UT_EDF_MANY_NUM);
+    TEST_ASSERT_NOT_NULL(dev);
+    elab_device_attr_t attr =
+    {
+        .sole = true,
+        .type = ELAB_DEVICE_UART,
+        .name = NULL,
+    };
+
+    uint32_t count_num_init = elab_device_get_number();
+    uint32_t count_adc_init = elab_device_foreach(ELAB_DEVICE_ADC,
+                                                    foreach_check_order, NULL);
+    for (uint32_t i = 0; i < UT_EDF_MANY_NUM; i ++)
+    {
+        sprintf(dev_name[i], "dev_many_%u", i);
+        attr.name = dev_name[i];
+        attr.type = (i % 4 == 0) ? ELAB_DEVICE_ADC : ELAB_DEVICE_UART;
+        elab_device_register(&dev[i], &attr);
+    }
+    TEST_ASSERT_EQUAL_UINT32(UT_EDF_MANY_NUM + count_num_init,
+                                elab_device_get_number());
+
+    /* Unregister the odd ones, the even ones are still found. */
+    for (uint32_t i = 1; i < UT_EDF_MANY_NUM; i += 2)
+    {
+        elab_device_unregister(&dev[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(UT_EDF_MANY_NUM / 2 + count_num_init,
+                                elab_device_get_number());
+    for (uint32_t i = 0; i < UT_EDF_MANY_NUM; i ++)
+    {
+        TEST_ASSERT_EQUAL_PTR((i % 2 == 0) ? &dev[i] : NULL,
+                                elab_device_find(dev_name[i]));
+    }
+
+    /* The devices of the type are walked in the registering order. */
+    elab_device_t *dev_last = NULL;
+    TEST_ASSERT_EQUAL_UINT32(UT_EDF_MANY_NUM / 4 + count_adc_init,
+                                elab_device_foreach(ELAB_DEVICE_ADC,
+                                                    foreach_check_order,
+                                                    &dev_last));
+    TEST_ASSERT_EQUAL_PTR(&dev[UT_EDF_MANY_NUM - 4], dev_last);
+
+    for (uint32_t i = 0; i < UT_EDF_MANY_NUM; i += 2)
+    {
+        elab_device_unregister(&dev[i]);
+        TEST_ASSERT_NULL(elab_device_find(dev_name[i]));
+    }
+    TEST_ASSERT_EQUAL_UINT32(count_num_init, elab_device_get_number());
+    elab_free(dev);
+}
+
 /**
   * @brief  Open & close functions for standalone device.
   */
@@ -286,6 +346,72 @@ TEST(edf_core, write_non_test_mode)
     elab_free(dev);
 }
 
+/**
+  * @brief  Vectored reading and writting functions of the driver without them,
+  *         in which the segments are gathered and scattered.
+  */
+TEST(edf_core, readv_writev_gather)
+{
+    int32_t ret = 0;
+    uint8_t buff[200];
+    elab_device_t *dev = elab_malloc(sizeof(elab_device_t));
+    TEST_ASSERT_NOT_NULL(dev);
+    elab_device_attr_t attr =
+    {
+        .sole = true,
+        .type = ELAB_DEVICE_UART,
+        .name = "dev_name",
+    };
+    dev->ops = &serial_ops;
+    elab_device_register(dev, &attr);
+    elab_device_open(dev);
+
+    /* Writting in one time, with the data on the stack. */
+    elab_iovec_t iov_wr[3] =
+    {
+        { .buffer = "dev_", .size = 4 },
+        { .buffer = "write_", .size = 6 },
+        { .buffer = "data", .size = 4 },
+    };
+    memset(buff_wr, 0, UT_DEVICE_BUFF_SIZE);
+    ret = elab_device_writev(dev, 0, iov_wr, 3);
+    TEST_ASSERT_EQUAL_INT32(strlen(UT_STR_WRITE), ret);
+    TEST_ASSERT_EQUAL_MEMORY(UT_STR_WRITE, buff_wr, ret);
+
+    /* Writting chunk by chunk at the position moving on, the big segment in
+       place, and the small ones gathered on the stack. */
+    for (uint32_t i = 0; i < sizeof(buff); i ++)
+    {
+        buff[i] = (uint8_t)i;
+    }
+    elab_iovec_t iov_large[3] =
+    {
+        { .buffer = buff, .size = 20 },
+        { .buffer = &buff[20], .size = 150 },
+        { .buffer = &buff[170], .size = 30 },
+    };
+    memset(buff_wr, 0, UT_DEVICE_BUFF_SIZE);
+    ret = elab_device_writev(dev, 0, iov_large, 3);
+    TEST_ASSERT_EQUAL_INT32(sizeof(buff), ret);
+    TEST_ASSERT_EQUAL_MEMORY(buff, buff_wr, sizeof(buff));
+
+    /* The read data is scattered into the segments in order. */
+    memset(buff_rd, 0, UT_DEVICE_BUFF_SIZE);
+    elab_iovec_t iov_rd[2] =
+    {
+        { .buffer = buff_rd, .size = 4 },
+        { .buffer = &buff_rd[100], .size = 20 },
+    };
+    ret = elab_device_readv(dev, 0, iov_rd, 2);
+    TEST_ASSERT_EQUAL_INT32(strlen(UT_STR_READ), ret);
+    TEST_ASSERT_EQUAL_MEMORY(UT_STR_READ, buff_rd, 4);
+    TEST_ASSERT_EQUAL_MEMORY(&UT_STR_READ[4], &buff_rd[100], (ret - 4));
+
+    elab_device_close(dev);
+    elab_device_unregister(dev);
+    elab_free(dev);
+}
+
 /**
   * @brief  Read function in test mode.
   */
@@ -410,10 +536,12 @@ TEST(edf_core, write_test_mode)
 TEST_GROUP_RUNNER(edf_core)
 {
     RUN_TEST_CASE(edf_core, register_unregister);
+    RUN_TEST_CASE(edf_core, find_many);
     RUN_TEST_CASE(edf_core, open_close_standalone);
     RUN_TEST_CASE(edf_core, open_close_non_standalone);
     RUN_TEST_CASE(edf_core, read_non_test_mode);
     RUN_TEST_CASE(edf_core, write_non_test_mode);
+    RUN_TEST_CASE(edf_core, readv_writev_gather);
     RUN_TEST_CASE(edf_core, read_test_mode);
     RUN_TEST_CASE(edf_core, write_test_mode);
 }
@@ -457,9 +585,8 @@ static int32_t ops_write(elab_device_t *dev,
                             uint32_t pos, const void *buffer, uint32_t size)
 {
     (void)dev;
-    (void)pos;
 
-    memcpy(buff_wr, buffer, size);
+    memcpy(&buff_wr[pos], buffer, size);
     return size;
 }
 
@@ -475,6 +602,22 @@ static elab_err_t ops_control(elab_device_t *dev, int32_t cmd, void *args)
     return ELAB_OK;
 }
 
+/**
+  * @brief  Check the devices from elab_device_foreach are ADC ones in the
+  *         registering order, which is the address order in the test.
+  */
+static void foreach_check_order(elab_device_t *dev, void *para)
+{
+    elab_device_t **dev_last = (elab_device_t **)para;
+
+    TEST_ASSERT_EQUAL_UINT8(ELAB_DEVICE_ADC, dev->attr.type);
+    if (dev_last != NULL)
+    {
+        TEST_ASSERT_TRUE(*dev_last == NULL || *dev_last < dev);
+        *dev_last = dev;
+    }
+}
+
 /**
   * @brief  Thread function for reading data in testing mode.
   * @param  Thread parameter.
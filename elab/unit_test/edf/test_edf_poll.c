@@ -0,0 +1,291 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "../../edf/elab_device.h"
+#include "../../edf/normal/elab_serial.h"
+#include "../../edf/driver/simulator/simu_serial.h"
+#include "../../3rd/Unity/unity.h"
+#include "../../3rd/Unity/unity_fixture.h"
+#include "../../common/elab_common.h"
+#include "../../common/elab_assert.h"
+
+#define TAG                         "ut_elab_device_poll"
+#include "../../common/elab_log.h"
+
+/* Private config ------------------------------------------------------------*/
+#define UT_POLL_DEV_NUM                             (3)
+#define UT_POLL_SERIAL_NAME                         "poll_serial"
+
+#define UT_STR_READ                                 "dev_read_data"
+
+/* Exported function prototypes ----------------------------------------------*/
+void elab_device_unregister(elab_device_t *me);
+
+/* Private function prototypes -----------------------------------------------*/
+static elab_err_t ops_enable(elab_device_t *dev, bool status);
+static uint8_t ops_get_events(elab_device_t *dev);
+static void timer_func_ready(void *para);
+static void timer_func_close(void *para);
+static void timer_func_serial_rx(void *para);
+static void devices_new(void);
+static void devices_free(void);
+
+/* Private variables ---------------------------------------------------------*/
+static const elab_dev_ops_t ops_events =
+{
+    .enable = ops_enable,
+    .get_events = ops_get_events,
+};
+
+static const elab_dev_ops_t ops_no_events =
+{
+    .enable = ops_enable,
+};
+
+static elab_device_t *dev[UT_POLL_DEV_NUM];
+static uint8_t dev_events[UT_POLL_DEV_NUM];
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Define test group of device polling
+  */
+TEST_GROUP(edf_poll);
+
+/**
+  * @brief  Define test fixture setup function of device polling
+  */
+TEST_SETUP(edf_poll)
+{
+    memset(dev_events, 0, sizeof(dev_events));
+}
+
+/**
+  * @brief  Define test fixture tear down function of device polling
+  */
+TEST_TEAR_DOWN(edf_poll)
+{
+
+}
+
+/**
+  * @brief  Checking the events without waiting, and waiting until timeout.
+  */
+TEST(edf_poll, ready_timeout)
+{
+    uint8_t events[UT_POLL_DEV_NUM] =
+    {
+        ELAB_DEVICE_EV_READ, ELAB_DEVICE_EV_READ, ELAB_DEVICE_EV_WRITE,
+    };
+    uint8_t revents[UT_POLL_DEV_NUM];
+
+    devices_new();
+
+    /* Nothing ready. */
+    TEST_ASSERT_EQUAL_INT32(0, elab_device_poll(dev, events, revents,
+                                                UT_POLL_DEV_NUM, 0));
+    uint32_t time_start = elab_time_ms();
+    TEST_ASSERT_EQUAL_INT32(0, elab_device_poll(dev, events, revents,
+                                                UT_POLL_DEV_NUM, 30));
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(30, elab_time_ms() - time_start);
+
+    /* Only the waited events are reported. */
+    dev_events[1] = ELAB_DEVICE_EV_READ | ELAB_DEVICE_EV_WRITE;
+    dev_events[2] = ELAB_DEVICE_EV_READ;
+    TEST_ASSERT_EQUAL_INT32(1, elab_device_poll(dev, events, revents,
+                                                UT_POLL_DEV_NUM, 30));
+    TEST_ASSERT_EQUAL_UINT8(0, revents[0]);
+    TEST_ASSERT_EQUAL_UINT8(ELAB_DEVICE_EV_READ, revents[1]);
+    TEST_ASSERT_EQUAL_UINT8(0, revents[2]);
+
+    devices_free();
+
+    /* The device without the events interface is always ready. */
+    elab_device_t *dev_always = elab_malloc(sizeof(elab_device_t));
+    TEST_ASSERT_NOT_NULL(dev_always);
+    memset(dev_always, 0, sizeof(elab_device_t));
+    elab_device_attr_t attr =
+    {
+        .name = "dev_poll_always",
+        .sole = true,
+        .type = ELAB_DEVICE_UNKNOWN,
+    };
+    dev_always->ops = &ops_no_events;
+    elab_device_register(dev_always, &attr);
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_open(dev_always));
+    TEST_ASSERT_EQUAL_INT32(1, elab_device_poll(&dev_always, &events[2], revents,
+                                                1, osWaitForever));
+    TEST_ASSERT_EQUAL_UINT8(ELAB_DEVICE_EV_WRITE, revents[0]);
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_close(dev_always));
+    elab_device_unregister(dev_always);
+    elab_free(dev_always);
+}
+
+/**
+  * @brief  Woken up by the driver when the events change, and by closing.
+  */
+TEST(edf_poll, wake_close)
+{
+    uint8_t events[UT_POLL_DEV_NUM] =
+    {
+        ELAB_DEVICE_EV_READ, ELAB_DEVICE_EV_READ, ELAB_DEVICE_EV_WRITE,
+    };
+    uint8_t revents[UT_POLL_DEV_NUM];
+
+    devices_new();
+
+    osTimerId_t timer = osTimerNew(timer_func_ready, osTimerOnce, NULL, NULL);
+    TEST_ASSERT_NOT_NULL(timer);
+    TEST_ASSERT_EQUAL_INT32(osOK, osTimerStart(timer, 20));
+    TEST_ASSERT_EQUAL_INT32(1, elab_device_poll(dev, events, revents,
+                                                UT_POLL_DEV_NUM, 1000));
+    TEST_ASSERT_EQUAL_UINT8(0, revents[0]);
+    TEST_ASSERT_EQUAL_UINT8(0, revents[1]);
+    TEST_ASSERT_EQUAL_UINT8(ELAB_DEVICE_EV_WRITE, revents[2]);
+    TEST_ASSERT_EQUAL_INT32(osOK, osTimerDelete(timer));
+
+    /* The closed device is in error. */
+    dev_events[2] = 0;
+    timer = osTimerNew(timer_func_close, osTimerOnce, NULL, NULL);
+    TEST_ASSERT_NOT_NULL(timer);
+    TEST_ASSERT_EQUAL_INT32(osOK, osTimerStart(timer, 20));
+    TEST_ASSERT_EQUAL_INT32(1, elab_device_poll(dev, events, revents,
+                                                UT_POLL_DEV_NUM, 1000));
+    TEST_ASSERT_EQUAL_UINT8(ELAB_DEVICE_EV_ERROR, revents[0]);
+    TEST_ASSERT_EQUAL_INT32(osOK, osTimerDelete(timer));
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_open(dev[0]));
+
+    devices_free();
+}
+
+/**
+  * @brief  One simulated serial port is readable when data is received.
+  */
+TEST(edf_poll, serial)
+{
+    uint8_t events = ELAB_DEVICE_EV_READ;
+    uint8_t revents = 0;
+    char buff[32];
+
+    simu_serial_new(UT_POLL_SERIAL_NAME, SIMU_SERIAL_MODE_SINGLE, 115200);
+    elab_device_t *serial = elab_device_find(UT_POLL_SERIAL_NAME);
+    TEST_ASSERT_NOT_NULL(serial);
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_open(serial));
+
+    TEST_ASSERT_EQUAL_INT32(0, elab_device_poll(&serial, &events, &revents, 1, 0));
+    osTimerId_t timer = osTimerNew(timer_func_serial_rx, osTimerOnce, NULL, NULL);
+    TEST_ASSERT_NOT_NULL(timer);
+    TEST_ASSERT_EQUAL_INT32(osOK, osTimerStart(timer, 20));
+    TEST_ASSERT_EQUAL_INT32(1, elab_device_poll(&serial, &events, &revents,
+                                                1, 1000));
+    TEST_ASSERT_EQUAL_UINT8(ELAB_DEVICE_EV_READ, revents);
+    TEST_ASSERT_EQUAL_INT32(osOK, osTimerDelete(timer));
+
+    memset(buff, 0, sizeof(buff));
+    TEST_ASSERT_EQUAL_INT32(strlen(UT_STR_READ),
+        elab_serial_read(serial, buff, strlen(UT_STR_READ), 1000));
+    TEST_ASSERT_EQUAL_STRING(UT_STR_READ, buff);
+
+    /* Writable if not in sending. */
+    events = ELAB_DEVICE_EV_WRITE;
+    TEST_ASSERT_EQUAL_INT32(1, elab_device_poll(&serial, &events, &revents, 1, 0));
+    TEST_ASSERT_EQUAL_UINT8(ELAB_DEVICE_EV_WRITE, revents);
+
+    TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_close(serial));
+    simu_serial_destroy(UT_POLL_SERIAL_NAME);
+}
+
+/**
+  * @brief  Define test runner of device polling
+  */
+TEST_GROUP_RUNNER(edf_poll)
+{
+    RUN_TEST_CASE(edf_poll, ready_timeout);
+    RUN_TEST_CASE(edf_poll, wake_close);
+    RUN_TEST_CASE(edf_poll, serial);
+}
+
+/* Private functions ---------------------------------------------------------*/
+static elab_err_t ops_enable(elab_device_t *dev, bool status)
+{
+    (void)dev;
+    (void)status;
+
+    return ELAB_OK;
+}
+
+/**
+  * @brief  The events of the device are set by the test.
+  */
+static uint8_t ops_get_events(elab_device_t *dev)
+{
+    uint32_t id = (uint32_t)(uintptr_t)dev->user_data;
+
+    return __atomic_load_n(&dev_events[id], __ATOMIC_SEQ_CST);
+}
+
+static void timer_func_ready(void *para)
+{
+    (void)para;
+
+    __atomic_store_n(&dev_events[2], ELAB_DEVICE_EV_WRITE, __ATOMIC_SEQ_CST);
+    elab_device_poll_wake(dev[2]);
+}
+
+static void timer_func_close(void *para)
+{
+    (void)para;
+
+    elab_device_close(dev[0]);
+}
+
+static void timer_func_serial_rx(void *para)
+{
+    (void)para;
+
+    simu_serial_make_rx_data(UT_POLL_SERIAL_NAME,
+                                UT_STR_READ, strlen(UT_STR_READ));
+}
+
+static void devices_new(void)
+{
+    static const char *name[UT_POLL_DEV_NUM] =
+    {
+        "dev_poll_0", "dev_poll_1", "dev_poll_2",
+    };
+
+    for (uint32_t i = 0; i < UT_POLL_DEV_NUM; i ++)
+    {
+        dev[i] = elab_malloc(sizeof(elab_device_t));
+        TEST_ASSERT_NOT_NULL(dev[i]);
+        memset(dev[i], 0, sizeof(elab_device_t));
+        elab_device_attr_t attr =
+        {
+            .name = name[i],
+            .sole = true,
+            .type = ELAB_DEVICE_UNKNOWN,
+        };
+        dev[i]->ops = &ops_events;
+        dev[i]->user_data = (void *)(uintptr_t)i;
+        elab_device_register(dev[i], &attr);
+        TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_open(dev[i]));
+    }
+}
+
+static void devices_free(void)
+{
+    for (uint32_t i = 0; i < UT_POLL_DEV_NUM; i ++)
+    {
+        TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_device_close(dev[i]));
+        elab_device_unregister(dev[i]);
+        elab_free(dev[i]);
+        dev[i] = NULL;
+    }
+}
+
+/* ----------------------------- end of file -------------------------------- */
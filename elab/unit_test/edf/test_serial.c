@@ -8,6 +8,12 @@
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
+#if defined(__linux__)
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/socket.h>
+#endif
 #include "../../edf/normal/elab_serial.h"
 #include "../../3rd/Unity/unity.h"
 #include "../../3rd/Unity/unity_fixture.h"
@@ -22,6 +28,8 @@ ELAB_TAG("UtSerial");
 #define UT_DEVICE_CMD_TEST                          (1)
 #define UT_DEVICE_BUFF_SIZE                         (256)
 #define UT_OPEN_TIMES_MAX                           (250)
+#define UT_FRAME_GAP_BITS                           (576)   /* 5ms in 115200 */
+#define UT_FRAME_SIZE_MAX                           (64)
 
 #define UT_STR_READ                                 "dev_read_data"
 #define UT_STR_WRITE                                "dev_write_data"
@@ -38,6 +46,8 @@ static int32_t ops_read(elab_serial_t *serial, void *pbuf, uint32_t size);
 #endif
 static int32_t ops_write(elab_serial_t *serial,
                             const void *pbuf, uint32_t size);
+static int32_t ops_write_ring(elab_serial_t *serial,
+                                const void *pbuf, uint32_t size);
 static int32_t ops_write_to_self(elab_serial_t *serial,
                                     const void *pbuf, uint32_t size);
 static elab_err_t ops_config(elab_serial_t *serial, elab_serial_config_t *pcfg);
@@ -48,6 +58,13 @@ static void thread_func_config(void *paras);
 static void make_data_for_reading(void);
 static void inform_serial_tx_end_delay(elab_serial_t *serial);
 static void entry_send_self(void *paras);
+#if defined(__linux__)
+static elab_err_t ops_enable_pipe(elab_serial_t *serial, bool status);
+static int32_t ops_read_pipe(elab_serial_t *serial, void *pbuf, uint32_t size);
+static int ops_get_fd_pipe(elab_serial_t *serial);
+static int32_t ops_writev_pipe(elab_serial_t *serial,
+                                const elab_iovec_t *iov, uint32_t num);
+#endif
 
 /* Private variables ---------------------------------------------------------*/
 static elab_serial_ops_t serial_ops =
@@ -72,6 +89,30 @@ static elab_serial_ops_t serial_ops_send_self =
     .set_tx = ops_set_tx,
 };
 
+static elab_serial_ops_t serial_ops_ring =
+{
+    .enable = ops_enable,
+#if defined(__linux__) || defined(_WIN32)
+    .read = ops_read,
+#endif
+    .write = ops_write_ring,
+    .config = ops_config,
+    .set_tx = ops_set_tx,
+};
+
+#if defined(__linux__)
+static elab_serial_ops_t serial_ops_pipe =
+{
+    .enable = ops_enable_pipe,
+    .read = ops_read_pipe,
+    .write = ops_write,
+    .config = ops_config,
+    .set_tx = ops_set_tx,
+    .get_fd = ops_get_fd_pipe,
+    .writev = ops_writev_pipe,
+};
+#endif
+
 static const osThreadAttr_t thread_attr_dev_test = 
 {
     .name = "ThreadTestSerial",
@@ -94,6 +135,8 @@ static uint8_t buff_rd[UT_DEVICE_BUFF_SIZE];
 static uint8_t buff_wr[UT_DEVICE_BUFF_SIZE];
 static uint32_t count_rd = 0;
 static uint32_t count_wr = 0;
+static uint32_t count_tx_chunk = 0;
+static uint8_t buff_tx_ring[UT_DEVICE_BUFF_SIZE * 4];
 static uint32_t count_set_tx = 0;
 static int32_t count_open = 0;
 static int32_t ret_read_test = 0;
@@ -107,6 +150,9 @@ static osSemaphoreId_t sem_send_self = NULL;
 static elab_serial_attr_t config_set;
 static osMessageQueueId_t mq_read = NULL;
 static osThreadId_t thread_send_self = NULL;
+#if defined(__linux__)
+static int fd_pipe[2] = { -1, -1 };
+#endif
 
 /* Exported functions --------------------------------------------------------*/
 /**
@@ -674,6 +720,407 @@ TEST(dev_serial, send_to_self_non_test_mode)
     TEST_ASSERT_EQUAL_UINT32(count_num_init, elab_device_get_number());
 }
 
+/**
+  * @brief  Vectored reading and writting functions in non-test mode.
+  */
+TEST(dev_serial, readv_writev_non_test_mode)
+{
+    int32_t ret = 0;
+    elab_serial_t *serial = NULL;
+    elab_device_t *dev = NULL;
+    elab_serial_attr_t config = (elab_serial_attr_t)ELAB_SERIAL_ATTR_DEFAULT;
+    uint32_t count_num_init = elab_device_get_number();
+    elab_iovec_t iov_wr[3] =
+    {
+        { .buffer = buff_wr, .size = 10 },
+        { .buffer = &buff_wr[10], .size = 0 },
+        { .buffer = &buff_wr[10], .size = 90 },
+    };
+    elab_iovec_t iov_rd[2] =
+    {
+        { .buffer = buff_rd, .size = 30 },
+        { .buffer = &buff_rd[30], .size = 70 },
+    };
+
+    serial = elab_malloc(sizeof(elab_serial_t));
+    TEST_ASSERT_NOT_NULL(serial);
+
+    /* Register RS485 mode serial device. */
+    config.mode = ELAB_SERIAL_MODE_HALF_DUPLEX;
+    elab_serial_register(serial, UT_SERIAL_NAME, &serial_ops_send_self, &config, NULL);
+    dev = elab_device_find(UT_SERIAL_NAME);
+    TEST_ASSERT_NOT_NULL(dev);
+
+    for (uint32_t i = 0; i < UT_DEVICE_BUFF_SIZE; i ++)
+    {
+        buff_wr[i] = (uint8_t)(i * 7);
+    }
+
+    /* The segments are sent in one tx mode, and read back into segments. */
+    elab_device_open(dev);
+    for (uint32_t i = 0; i < 10; i ++)
+    {
+        memset(buff_rd, 0, UT_DEVICE_BUFF_SIZE);
+        ret = elab_device_writev(dev, 0, iov_wr, 3);
+        TEST_ASSERT_EQUAL_INT32(100, ret);
+        TEST_ASSERT_EQUAL_UINT32((i + 1), count_set_tx);
+        TEST_ASSERT_FALSE(serial_set_tx);
+        ret = elab_device_readv(dev, 0, iov_rd, 2);
+        TEST_ASSERT_EQUAL_INT32(100, ret);
+        TEST_ASSERT_EQUAL_MEMORY(buff_wr, buff_rd, 100);
+    }
+    elab_device_close(dev);
+
+    elab_serial_unregister(ELAB_SERIAL_CAST(dev));
+    dev = elab_device_find(UT_SERIAL_NAME);
+    TEST_ASSERT_NULL(dev);
+    elab_free(serial);
+
+    TEST_ASSERT_EQUAL_UINT32(count_num_init, elab_device_get_number());
+}
+
+/**
+  * @brief  Ranged read function in non-test mode.
+  */
+TEST(dev_serial, read_range_non_test_mode)
+{
+    int32_t ret = 0;
+    elab_serial_t *serial = NULL;
+    elab_device_t *dev = NULL;
+    elab_serial_attr_t config = (elab_serial_attr_t)ELAB_SERIAL_ATTR_DEFAULT;
+    uint32_t count_num_init = elab_device_get_number();
+    uint32_t time_start = 0;
+
+    serial = elab_malloc(sizeof(elab_serial_t));
+    TEST_ASSERT_NOT_NULL(serial);
+
+    config.mode = ELAB_SERIAL_MODE_FULL_DUPLEX;
+    elab_serial_register(serial, UT_SERIAL_NAME, &serial_ops_send_self, &config, NULL);
+    dev = elab_device_find(UT_SERIAL_NAME);
+    TEST_ASSERT_NOT_NULL(dev);
+
+    for (uint32_t i = 0; i < UT_DEVICE_BUFF_SIZE; i ++)
+    {
+        buff_wr[i] = (uint8_t)(i * 3);
+    }
+
+    elab_device_open(dev);
+    for (uint32_t i = 0; i < 10; i ++)
+    {
+        /* All the data at least 100 bytes is read in one calling. */
+        memset(buff_rd, 0, UT_DEVICE_BUFF_SIZE);
+        ret = elab_serial_write(dev, buff_wr, 100);
+        TEST_ASSERT_EQUAL_INT32(100, ret);
+        ret = elab_serial_read_range(dev, buff_rd, 100, UT_DEVICE_BUFF_SIZE, 100);
+        TEST_ASSERT_EQUAL_INT32(100, ret);
+        TEST_ASSERT_EQUAL_MEMORY(buff_wr, buff_rd, 100);
+
+        /* Less data than the least size is returned after timeout. */
+        memset(buff_rd, 0, UT_DEVICE_BUFF_SIZE);
+        ret = elab_serial_write(dev, buff_wr, 30);
+        TEST_ASSERT_EQUAL_INT32(30, ret);
+        time_start = osKernelGetTickCount();
+        ret = elab_serial_read_range(dev, buff_rd, 50, UT_DEVICE_BUFF_SIZE, 20);
+        TEST_ASSERT_EQUAL_INT32(30, ret);
+        TEST_ASSERT_EQUAL_MEMORY(buff_wr, buff_rd, 30);
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32((time_start + 20),
+                                                osKernelGetTickCount());
+
+        /* No data. */
+        ret = elab_serial_read_range(dev, buff_rd, 1, UT_DEVICE_BUFF_SIZE, 10);
+        TEST_ASSERT_EQUAL_INT32(ELAB_ERR_TIMEOUT, ret);
+    }
+    elab_device_close(dev);
+
+    elab_serial_unregister(ELAB_SERIAL_CAST(dev));
+    dev = elab_device_find(UT_SERIAL_NAME);
+    TEST_ASSERT_NULL(dev);
+    elab_free(serial);
+
+    TEST_ASSERT_EQUAL_UINT32(count_num_init, elab_device_get_number());
+}
+
+/**
+  * @brief  Frame reading function in non-test mode.
+  */
+TEST(dev_serial, read_frame_non_test_mode)
+{
+    int32_t ret = 0;
+    elab_serial_t *serial = NULL;
+    elab_device_t *dev = NULL;
+    elab_serial_attr_t config = (elab_serial_attr_t)ELAB_SERIAL_ATTR_DEFAULT;
+    uint32_t count_num_init = elab_device_get_number();
+
+    serial = elab_malloc(sizeof(elab_serial_t));
+    TEST_ASSERT_NOT_NULL(serial);
+
+    config.mode = ELAB_SERIAL_MODE_FULL_DUPLEX;
+    elab_serial_register(serial, UT_SERIAL_NAME, &serial_ops_send_self, &config, NULL);
+    dev = elab_device_find(UT_SERIAL_NAME);
+    TEST_ASSERT_NOT_NULL(dev);
+    elab_serial_set_frame(dev, UT_FRAME_GAP_BITS, UT_FRAME_SIZE_MAX);
+
+    for (uint32_t i = 0; i < UT_DEVICE_BUFF_SIZE; i ++)
+    {
+        buff_wr[i] = (uint8_t)(i * 13);
+    }
+
+    elab_device_open(dev);
+    osDelay(20);            /* Waiting for the receiving thread polling. */
+    for (uint32_t i = 0; i < 5; i ++)
+    {
+        /* Two frames split by the gap, read after both of them arrive. */
+        ret = elab_serial_write(dev, buff_wr, 20);
+        TEST_ASSERT_EQUAL_INT32(20, ret);
+        osDelay(50);
+        ret = elab_serial_write(dev, &buff_wr[20], 30);
+        TEST_ASSERT_EQUAL_INT32(30, ret);
+        osDelay(50);
+        ret = elab_serial_read_frame(dev, buff_rd, UT_DEVICE_BUFF_SIZE, 100);
+        TEST_ASSERT_EQUAL_INT32(20, ret);
+        TEST_ASSERT_EQUAL_MEMORY(buff_wr, buff_rd, 20);
+        ret = elab_serial_read_frame(dev, buff_rd, UT_DEVICE_BUFF_SIZE, 100);
+        TEST_ASSERT_EQUAL_INT32(30, ret);
+        TEST_ASSERT_EQUAL_MEMORY(&buff_wr[20], buff_rd, 30);
+
+        /* One frame in pieces without the gap, ended in the gap timeout. */
+        ret = elab_serial_write(dev, buff_wr, 10);
+        TEST_ASSERT_EQUAL_INT32(10, ret);
+        ret = elab_serial_write(dev, &buff_wr[10], 10);
+        TEST_ASSERT_EQUAL_INT32(10, ret);
+        ret = elab_serial_read_frame(dev, buff_rd, UT_DEVICE_BUFF_SIZE, 100);
+        TEST_ASSERT_EQUAL_INT32(20, ret);
+        TEST_ASSERT_EQUAL_MEMORY(buff_wr, buff_rd, 20);
+
+        /* The data over the most frame size is split. */
+        ret = elab_serial_write(dev, buff_wr, 100);
+        TEST_ASSERT_EQUAL_INT32(100, ret);
+        ret = elab_serial_read_frame(dev, buff_rd, UT_DEVICE_BUFF_SIZE, 100);
+        TEST_ASSERT_EQUAL_INT32(UT_FRAME_SIZE_MAX, ret);
+        TEST_ASSERT_EQUAL_MEMORY(buff_wr, buff_rd, UT_FRAME_SIZE_MAX);
+        ret = elab_serial_read_frame(dev, buff_rd, UT_DEVICE_BUFF_SIZE, 100);
+        TEST_ASSERT_EQUAL_INT32((100 - UT_FRAME_SIZE_MAX), ret);
+        TEST_ASSERT_EQUAL_MEMORY(&buff_wr[UT_FRAME_SIZE_MAX], buff_rd,
+                                    (100 - UT_FRAME_SIZE_MAX));
+
+        /* The part of the frame over the buffer is dropped. */
+        ret = elab_serial_write(dev, buff_wr, 20);
+        TEST_ASSERT_EQUAL_INT32(20, ret);
+        ret = elab_serial_read_frame(dev, buff_rd, 8, 100);
+        TEST_ASSERT_EQUAL_INT32(8, ret);
+        TEST_ASSERT_EQUAL_MEMORY(buff_wr, buff_rd, 8);
+
+        /* No frame. */
+        ret = elab_serial_read_frame(dev, buff_rd, UT_DEVICE_BUFF_SIZE, 20);
+        TEST_ASSERT_EQUAL_INT32(ELAB_ERR_TIMEOUT, ret);
+    }
+    elab_device_close(dev);
+
+    elab_serial_unregister(ELAB_SERIAL_CAST(dev));
+    dev = elab_device_find(UT_SERIAL_NAME);
+    TEST_ASSERT_NULL(dev);
+    elab_free(serial);
+
+    TEST_ASSERT_EQUAL_UINT32(count_num_init, elab_device_get_number());
+}
+
+/**
+  * @brief  Write function with the tx ring in non-test mode.
+  */
+TEST(dev_serial, tx_ring_non_test_mode)
+{
+    int32_t ret = 0;
+    elab_serial_t *serial = NULL;
+    elab_device_t *dev = NULL;
+    elab_serial_attr_t config = (elab_serial_attr_t)ELAB_SERIAL_ATTR_DEFAULT;
+    uint32_t count_num_init = elab_device_get_number();
+
+    serial = elab_malloc(sizeof(elab_serial_t));
+    TEST_ASSERT_NOT_NULL(serial);
+
+    config.mode = ELAB_SERIAL_MODE_FULL_DUPLEX;
+    config.tx_bufsz = UT_DEVICE_BUFF_SIZE;
+    elab_serial_register(serial, UT_SERIAL_NAME, &serial_ops_ring, &config, NULL);
+    dev = elab_device_find(UT_SERIAL_NAME);
+    TEST_ASSERT_NOT_NULL(dev);
+
+    for (uint32_t i = 0; i < UT_DEVICE_BUFF_SIZE; i ++)
+    {
+        buff_wr[i] = (uint8_t)(i * 3);
+    }
+
+    elab_device_open(dev);
+    for (uint32_t i = 0; i < 3; i ++)
+    {
+        /* The small writings return at once, and the data sent by the driver
+           in the tx end callback is coalesced into one chunk. */
+        count_wr = 0;
+        count_tx_chunk = 0;
+        memset(buff_tx_ring, 0, sizeof(buff_tx_ring));
+        for (uint32_t j = 0; j < 20; j ++)
+        {
+            ret = elab_device_write(dev, 0, &buff_wr[j * 10], 10);
+            TEST_ASSERT_EQUAL_INT32(10, ret);
+        }
+        TEST_ASSERT_EQUAL_UINT32(1, count_tx_chunk);
+        TEST_ASSERT_TRUE(elab_serial_tx_over_high_water(dev));
+        TEST_ASSERT_EQUAL_INT32(ELAB_ERR_TIMEOUT, elab_serial_flush(dev, 0));
+        TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_serial_flush(dev, 1000));
+        TEST_ASSERT_FALSE(elab_serial_tx_over_high_water(dev));
+        TEST_ASSERT_EQUAL_UINT32(200, count_wr);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(3, count_tx_chunk);
+        TEST_ASSERT_EQUAL_MEMORY(buff_wr, buff_tx_ring, 200);
+
+        /* More data than the tx ring, which is blocked for the free space. */
+        count_wr = 0;
+        for (uint32_t j = 0; j < 4; j ++)
+        {
+            ret = elab_device_write(dev, 0, buff_wr, UT_DEVICE_BUFF_SIZE);
+            TEST_ASSERT_EQUAL_INT32(UT_DEVICE_BUFF_SIZE, ret);
+        }
+        TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_serial_flush(dev, 1000));
+        TEST_ASSERT_EQUAL_UINT32(sizeof(buff_tx_ring), count_wr);
+        for (uint32_t j = 0; j < 4; j ++)
+        {
+            TEST_ASSERT_EQUAL_MEMORY(buff_wr, &buff_tx_ring[j * UT_DEVICE_BUFF_SIZE],
+                                        UT_DEVICE_BUFF_SIZE);
+        }
+    }
+    elab_device_close(dev);
+
+    elab_serial_unregister(ELAB_SERIAL_CAST(dev));
+    dev = elab_device_find(UT_SERIAL_NAME);
+    TEST_ASSERT_NULL(dev);
+    elab_free(serial);
+
+    TEST_ASSERT_EQUAL_UINT32(count_num_init, elab_device_get_number());
+}
+
+#if defined(__linux__)
+/**
+  * @brief  Read function of the port with file descriptor, received in the
+  *         serial reactor.
+  */
+TEST(dev_serial, reactor_non_test_mode)
+{
+    int32_t ret = 0;
+    elab_serial_t *serial = NULL;
+    elab_device_t *dev = NULL;
+    elab_serial_attr_t config = (elab_serial_attr_t)ELAB_SERIAL_ATTR_DEFAULT;
+    uint32_t count_num_init = elab_device_get_number();
+    static uint8_t buff_pipe[UT_DEVICE_BUFF_SIZE * 8];
+
+    serial = elab_malloc(sizeof(elab_serial_t));
+    TEST_ASSERT_NOT_NULL(serial);
+
+    config.mode = ELAB_SERIAL_MODE_FULL_DUPLEX;
+    elab_serial_register(serial, UT_SERIAL_NAME, &serial_ops_pipe, &config, NULL);
+    dev = elab_device_find(UT_SERIAL_NAME);
+    TEST_ASSERT_NOT_NULL(dev);
+    TEST_ASSERT_NULL(serial->thread_rx);
+
+    for (uint32_t i = 0; i < sizeof(buff_pipe); i ++)
+    {
+        buff_pipe[i] = (uint8_t)(i * 5);
+    }
+
+    /* Opened and closed again, the port leaves and joins the reactor. */
+    for (uint32_t i = 0; i < 3; i ++)
+    {
+        elab_device_open(dev);
+        for (uint32_t j = 0; j < 10; j ++)
+        {
+            memset(buff_rd, 0, UT_DEVICE_BUFF_SIZE);
+            ret = write(fd_pipe[1], UT_STR_READ, strlen(UT_STR_READ));
+            TEST_ASSERT_EQUAL_INT32(strlen(UT_STR_READ), ret);
+            ret = elab_serial_read(dev, buff_rd, strlen(UT_STR_READ), 100);
+            TEST_ASSERT_EQUAL_INT32(strlen(UT_STR_READ), ret);
+            TEST_ASSERT_EQUAL_MEMORY(UT_STR_READ, buff_rd, ret);
+        }
+
+        /* More data than the rx ring, which is paused and resumed. */
+        ret = write(fd_pipe[1], buff_pipe, sizeof(buff_pipe));
+        TEST_ASSERT_EQUAL_INT32(sizeof(buff_pipe), ret);
+        for (uint32_t count = 0; count < sizeof(buff_pipe);)
+        {
+            ret = elab_serial_read_range(dev, buff_rd, 1, UT_DEVICE_BUFF_SIZE, 100);
+            TEST_ASSERT_GREATER_THAN_INT32(0, ret);
+            TEST_ASSERT_EQUAL_MEMORY(&buff_pipe[count], buff_rd, ret);
+            count += ret;
+        }
+        ret = elab_serial_read(dev, buff_rd, 1, 10);
+        TEST_ASSERT_EQUAL_INT32(ELAB_ERR_TIMEOUT, ret);
+        elab_device_close(dev);
+    }
+
+    elab_serial_unregister(ELAB_SERIAL_CAST(dev));
+    dev = elab_device_find(UT_SERIAL_NAME);
+    TEST_ASSERT_NULL(dev);
+    elab_free(serial);
+
+    TEST_ASSERT_EQUAL_UINT32(count_num_init, elab_device_get_number());
+}
+
+/**
+  * @brief  Write function of the port with file descriptor and the tx ring,
+  *         sent in the serial reactor.
+  */
+TEST(dev_serial, reactor_tx_ring_non_test_mode)
+{
+    int32_t ret = 0;
+    elab_serial_t *serial = NULL;
+    elab_device_t *dev = NULL;
+    elab_serial_attr_t config = (elab_serial_attr_t)ELAB_SERIAL_ATTR_DEFAULT;
+    uint32_t count_num_init = elab_device_get_number();
+
+    serial = elab_malloc(sizeof(elab_serial_t));
+    TEST_ASSERT_NOT_NULL(serial);
+
+    config.mode = ELAB_SERIAL_MODE_FULL_DUPLEX;
+    config.tx_bufsz = UT_DEVICE_BUFF_SIZE;
+    elab_serial_register(serial, UT_SERIAL_NAME, &serial_ops_pipe, &config, NULL);
+    dev = elab_device_find(UT_SERIAL_NAME);
+    TEST_ASSERT_NOT_NULL(dev);
+
+    for (uint32_t i = 0; i < sizeof(buff_tx_ring); i ++)
+    {
+        buff_tx_ring[i] = (uint8_t)(i * 11);
+    }
+
+    for (uint32_t i = 0; i < 3; i ++)
+    {
+        elab_device_open(dev);
+        for (uint32_t j = 0; j < 20; j ++)
+        {
+            ret = elab_device_write(dev, 0, &buff_tx_ring[j * 10], 10);
+            TEST_ASSERT_EQUAL_INT32(10, ret);
+        }
+
+        /* More data than the tx ring, sent in the wrapped segments. */
+        ret = elab_device_write(dev, 0, &buff_tx_ring[200],
+                                (sizeof(buff_tx_ring) - 200));
+        TEST_ASSERT_EQUAL_INT32((sizeof(buff_tx_ring) - 200), ret);
+        TEST_ASSERT_EQUAL_INT32(ELAB_OK, elab_serial_flush(dev, 1000));
+
+        for (uint32_t count = 0; count < sizeof(buff_tx_ring);)
+        {
+            ret = read(fd_pipe[1], buff_rd, UT_DEVICE_BUFF_SIZE);
+            TEST_ASSERT_GREATER_THAN_INT32(0, ret);
+            TEST_ASSERT_EQUAL_MEMORY(&buff_tx_ring[count], buff_rd, ret);
+            count += ret;
+        }
+        elab_device_close(dev);
+    }
+
+    elab_serial_unregister(ELAB_SERIAL_CAST(dev));
+    dev = elab_device_find(UT_SERIAL_NAME);
+    TEST_ASSERT_NULL(dev);
+    elab_free(serial);
+
+    TEST_ASSERT_EQUAL_UINT32(count_num_init, elab_device_get_number());
+}
+#endif
+
 /**
   * @brief  Control function in non-test mode.
   */
@@ -965,6 +1412,14 @@ TEST_GROUP_RUNNER(dev_serial)
     RUN_TEST_CASE(dev_serial, write_non_test_mode_rs485);
     RUN_TEST_CASE(dev_serial, xfer_non_test_mode);
     RUN_TEST_CASE(dev_serial, send_to_self_non_test_mode);
+    RUN_TEST_CASE(dev_serial, readv_writev_non_test_mode);
+    RUN_TEST_CASE(dev_serial, read_range_non_test_mode);
+    RUN_TEST_CASE(dev_serial, read_frame_non_test_mode);
+    RUN_TEST_CASE(dev_serial, tx_ring_non_test_mode);
+#if defined(__linux__)
+    RUN_TEST_CASE(dev_serial, reactor_non_test_mode);
+    RUN_TEST_CASE(dev_serial, reactor_tx_ring_non_test_mode);
+#endif
     RUN_TEST_CASE(dev_serial, set_config_non_test_mode);
     RUN_TEST_CASE(dev_serial, read_test_mode);
     RUN_TEST_CASE(dev_serial, write_test_mode);
@@ -999,13 +1454,95 @@ static int32_t ops_read(elab_serial_t *serial, void *pbuf, uint32_t size)
 {
     (void)serial;
 
+    /* Block for the first byte, and then return the ones available. */
     char *ch = (char *)pbuf;
+    osStatus_t ret = osMessageQueueGet(mq_read, &ch[0], NULL, osWaitForever);
+    elab_assert(ret == osOK);
+    int32_t count = 1;
+    if (size > 1)
+    {
+        count += osMessageQueueGetN(mq_read, &ch[1], (size - 1), NULL, 0);
+    }
+
+    return count;
+}
+#endif
+
+#if defined(__linux__)
+/**
+  * @brief  Simulated driver opening function with a pipe as the port, the
+  *         socket pair of both directions, the other end of which is used
+  *         by the tests.
+  */
+static elab_err_t ops_enable_pipe(elab_serial_t *serial, bool status)
+{
+    (void)serial;
+
+    if (status)
+    {
+        int ret = socketpair(AF_UNIX, SOCK_STREAM, 0, fd_pipe);
+        elab_assert(ret == 0);
+        ret = fcntl(fd_pipe[0], F_SETFL, O_NONBLOCK);
+        elab_assert(ret == 0);
+    }
+    else
+    {
+        close(fd_pipe[0]);
+        close(fd_pipe[1]);
+        fd_pipe[0] = -1;
+        fd_pipe[1] = -1;
+    }
+
+    return ELAB_OK;
+}
+
+/**
+  * @brief  Simulated driver non-blocking reading function from the pipe.
+  */
+static int32_t ops_read_pipe(elab_serial_t *serial, void *pbuf, uint32_t size)
+{
+    (void)serial;
+
+    int32_t ret = read(fd_pipe[0], pbuf, size);
+    if (ret < 0)
+    {
+        ret = (errno == EAGAIN) ? 0 : ELAB_ERROR;
+    }
+
+    return ret;
+}
+
+/**
+  * @brief  Simulated driver file descriptor of the pipe.
+  */
+static int ops_get_fd_pipe(elab_serial_t *serial)
+{
+    (void)serial;
+
+    return fd_pipe[0];
+}
+
+/**
+  * @brief  Simulated driver non-blocking vectored writing function to the pipe.
+  */
+static int32_t ops_writev_pipe(elab_serial_t *serial,
+                                const elab_iovec_t *iov, uint32_t num)
+{
+    (void)serial;
+
     int32_t count = 0;
-    for (uint32_t i = 0; i < size; i ++)
+    for (uint32_t i = 0; i < num; i ++)
     {
-        osStatus_t ret = osMessageQueueGet(mq_read, &ch[i], NULL, osWaitForever);
-        elab_assert(ret == osOK);
-        count ++;
+        int32_t ret = write(fd_pipe[0], iov[i].buffer, iov[i].size);
+        if (ret < 0)
+        {
+            return (count != 0 || errno == EAGAIN) ? count : ELAB_ERROR;
+        }
+        count += ret;
+        if ((uint32_t)ret < iov[i].size)
+        {
+            break;
+        }
     }
 
     return count;
@@ -1023,6 +1560,23 @@ static int32_t ops_write(elab_serial_t *serial, const void *pbuf, uint32_t size)
     return size;
 }
 
+/**
+  * @brief  Simulated driver writting function with the tx ring, which sends
+  *         the chunk in the background, done in the tx end callback later.
+  */
+static int32_t ops_write_ring(elab_serial_t *serial,
+                                const void *pbuf, uint32_t size)
+{
+    elab_assert((count_wr + size) <= sizeof(buff_tx_ring));
+
+    memcpy(&buff_tx_ring[count_wr], pbuf, size);
+    count_wr += size;
+    count_tx_chunk ++;
+    inform_serial_tx_end_delay(serial);
+
+    return size;
+}
+
 /**
   * @brief  Simulated driver writting function for serial device testing.
   */
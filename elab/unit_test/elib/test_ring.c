@@ -0,0 +1,153 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <string.h>
+#include "../../common/elab_def.h"
+#include "../../common/elab_export.h"
+#include "../../common/elab_common.h"
+#include "../../elib/elib_ring.h"
+#include "../../3rd/Unity/unity.h"
+#include "../../3rd/Unity/unity_fixture.h"
+
+/* private config ----------------------------------------------------------- */
+#define ELIB_RING_CAPACITY                      (64)
+
+/* private variables -------------------------------------------------------- */
+static elib_ring_t *ring = NULL;
+static uint8_t *buffer = NULL;
+static uint8_t buff_wr[ELIB_RING_CAPACITY * 2];
+static uint8_t buff_rd[ELIB_RING_CAPACITY * 2];
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief  The elib_ring test group.
+ */
+TEST_GROUP(elib_ring);
+
+/**
+ * @brief  The setup function of elib_ring test group.
+ */
+TEST_SETUP(elib_ring)
+{
+    ring = elab_malloc(sizeof(elib_ring_t));
+    buffer = elab_malloc(ELIB_RING_CAPACITY);
+
+    elib_ring_init(ring, buffer, ELIB_RING_CAPACITY);
+    TEST_ASSERT_EQUAL_UINT32(0, elib_ring_count(ring));
+    TEST_ASSERT_EQUAL_UINT32(ELIB_RING_CAPACITY, elib_ring_free_size(ring));
+
+    for (uint32_t i = 0; i < sizeof(buff_wr); i ++)
+    {
+        buff_wr[i] = (uint8_t)(i + 1);
+    }
+    memset(buff_rd, 0, sizeof(buff_rd));
+}
+
+/**
+ * @brief  The teardown function of elib_ring test group.
+ */
+TEST_TEAR_DOWN(elib_ring)
+{
+    elab_free(buffer);
+    elab_free(ring);
+}
+
+/**
+ * @brief  The unit test for elib_ring_write and elib_ring_read.
+ */
+TEST(elib_ring, write_read)
+{
+    /* Only the free size is written. */
+    TEST_ASSERT_EQUAL_UINT32(40, elib_ring_write(ring, buff_wr, 40));
+    TEST_ASSERT_EQUAL_UINT32(24, elib_ring_write(ring, &buff_wr[40], 40));
+    TEST_ASSERT_EQUAL_UINT32(ELIB_RING_CAPACITY, elib_ring_count(ring));
+    TEST_ASSERT_EQUAL_UINT32(0, elib_ring_write(ring, buff_wr, 1));
+
+    /* All the available data is read at one time. */
+    TEST_ASSERT_EQUAL_UINT32(ELIB_RING_CAPACITY,
+                                elib_ring_read(ring, buff_rd, sizeof(buff_rd)));
+    TEST_ASSERT_EQUAL_MEMORY(buff_wr, buff_rd, ELIB_RING_CAPACITY);
+    TEST_ASSERT_EQUAL_UINT32(0, elib_ring_read(ring, buff_rd, 1));
+}
+
+/**
+ * @brief  The unit test for the data across the end of the buffer.
+ */
+TEST(elib_ring, wrap)
+{
+    for (uint32_t i = 0; i < 100; i ++)
+    {
+        uint32_t size = (i % 50) + 1;
+        uint8_t *data = &buff_wr[i % ELIB_RING_CAPACITY];
+        TEST_ASSERT_EQUAL_UINT32(size, elib_ring_write(ring, data, size));
+        memset(buff_rd, 0, sizeof(buff_rd));
+        TEST_ASSERT_EQUAL_UINT32(size, elib_ring_read(ring, buff_rd, sizeof(buff_rd)));
+        TEST_ASSERT_EQUAL_MEMORY(data, buff_rd, size);
+        TEST_ASSERT_EQUAL_UINT32(0, elib_ring_count(ring));
+    }
+}
+
+/**
+ * @brief  The unit test for the linear blocks used in place.
+ */
+TEST(elib_ring, block)
+{
+    uint32_t size = 0;
+    uint8_t *block = NULL;
+
+    TEST_ASSERT_EQUAL_UINT32(48, elib_ring_write(ring, buff_wr, 48));
+    TEST_ASSERT_EQUAL_UINT32(40, elib_ring_read(ring, buff_rd, 40));
+
+    /* The free space is in two blocks, before and after the wrapping. */
+    block = elib_ring_write_block(ring, &size);
+    TEST_ASSERT_EQUAL_UINT32(16, size);
+    TEST_ASSERT_EQUAL_PTR(&buffer[48], block);
+    memcpy(block, &buff_wr[48], size);
+    elib_ring_write_commit(ring, size);
+    block = elib_ring_write_block(ring, &size);
+    TEST_ASSERT_EQUAL_UINT32(40, size);
+    TEST_ASSERT_EQUAL_PTR(&buffer[0], block);
+    memcpy(block, &buff_wr[64], 10);
+    elib_ring_write_commit(ring, 10);
+    TEST_ASSERT_EQUAL_UINT32(34, elib_ring_count(ring));
+
+    /* And so is the data. */
+    block = elib_ring_read_block(ring, &size);
+    TEST_ASSERT_EQUAL_UINT32(24, size);
+    TEST_ASSERT_EQUAL_MEMORY(&buff_wr[40], block, size);
+    elib_ring_read_commit(ring, size);
+    block = elib_ring_read_block(ring, &size);
+    TEST_ASSERT_EQUAL_UINT32(10, size);
+    TEST_ASSERT_EQUAL_MEMORY(&buff_wr[64], block, size);
+    elib_ring_read_commit(ring, size);
+    block = elib_ring_read_block(ring, &size);
+    TEST_ASSERT_EQUAL_UINT32(0, size);
+}
+
+/**
+ * @brief  The unit test for elib_ring_clear.
+ */
+TEST(elib_ring, clear)
+{
+    TEST_ASSERT_EQUAL_UINT32(50, elib_ring_write(ring, buff_wr, 50));
+    elib_ring_clear(ring);
+    TEST_ASSERT_EQUAL_UINT32(0, elib_ring_count(ring));
+    TEST_ASSERT_EQUAL_UINT32(ELIB_RING_CAPACITY, elib_ring_free_size(ring));
+    TEST_ASSERT_EQUAL_UINT32(0, elib_ring_read(ring, buff_rd, sizeof(buff_rd)));
+}
+
+/**
+ * @brief  The elib_ring group unit test.
+ */
+TEST_GROUP_RUNNER(elib_ring)
+{
+    RUN_TEST_CASE(elib_ring, write_read);
+    RUN_TEST_CASE(elib_ring, wrap);
+    RUN_TEST_CASE(elib_ring, block);
+    RUN_TEST_CASE(elib_ring, clear);
+}
+
+/* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,235 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+#if defined(__linux__)
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "../../os/cmsis_os.h"
+#include "../../3rd/Unity/unity.h"
+#include "../../3rd/Unity/unity_fixture.h"
+#include "../../common/elab_common.h"
+#include "../../common/elab_assert.h"
+
+#define TAG                         "ut_event"
+#include "../../common/elab_log.h"
+
+/* Private config ------------------------------------------------------------*/
+#define UT_EVENT_THREAD_NUMBER                      (4)
+#define UT_EVENT_DELAY_MS                           (20)
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct ut_event_thread
+{
+    osThreadId_t thread;
+    uint32_t flags;
+    uint32_t options;
+    uint32_t result;
+} ut_event_thread_t;
+
+/* Private function prototypes -----------------------------------------------*/
+static void entry_event_wait(void *paras);
+static void entry_event_set_delay(void *paras);
+static void entry_thread_flags_wait(void *paras);
+
+/* Private variables ---------------------------------------------------------*/
+static osEventFlagsId_t ef = NULL;
+
+static const osEventFlagsAttr_t ef_attr_ut =
+{
+    .name = "ut_event",
+    .attr_bits = 0,
+    .cb_mem = NULL,
+    .cb_size = 0,
+};
+
+static const osThreadAttr_t thread_attr_event =
+{
+    .name = "ThreadEventTest",
+    .attr_bits = osThreadJoinable,
+    .priority = osPriorityNormal,
+    .stack_size = 2048,
+};
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Define test group of event flags and thread flags.
+  */
+TEST_GROUP(event);
+
+/**
+  * @brief  Define test fixture setup function of event flags.
+  */
+TEST_SETUP(event)
+{
+    ef = osEventFlagsNew(&ef_attr_ut);
+    TEST_ASSERT_NOT_NULL(ef);
+}
+
+/**
+  * @brief  Define test fixture tear down function of event flags.
+  */
+TEST_TEAR_DOWN(event)
+{
+    TEST_ASSERT_EQUAL_INT32(osOK, osEventFlagsDelete(ef));
+    ef = NULL;
+}
+
+/**
+  * @brief  Waiting for any or all of the flags, with and without clearing.
+  */
+TEST(event, any_all_no_clear)
+{
+    TEST_ASSERT_EQUAL_STRING("ut_event", osEventFlagsGetName(ef));
+    TEST_ASSERT_EQUAL_UINT32(0, osEventFlagsGet(ef));
+    TEST_ASSERT_EQUAL_UINT32(osFlagsErrorResource,
+                                osEventFlagsWait(ef, 0x01, osFlagsWaitAny, 0));
+    TEST_ASSERT_EQUAL_UINT32(osFlagsErrorTimeout,
+                                osEventFlagsWait(ef, 0x01, osFlagsWaitAny, 10));
+    TEST_ASSERT_EQUAL_UINT32(osFlagsErrorParameter,
+                                osEventFlagsSet(ef, osFlagsError));
+
+    TEST_ASSERT_EQUAL_UINT32(0x05, osEventFlagsSet(ef, 0x05));
+
+    /* Not all of the flags are set. */
+    TEST_ASSERT_EQUAL_UINT32(osFlagsErrorResource,
+                                osEventFlagsWait(ef, 0x03, osFlagsWaitAll, 0));
+
+    /* No clearing. */
+    TEST_ASSERT_EQUAL_UINT32(0x05,
+        osEventFlagsWait(ef, 0x01, osFlagsWaitAny | osFlagsNoClear, 0));
+    TEST_ASSERT_EQUAL_UINT32(0x05, osEventFlagsGet(ef));
+
+    /* Only the matched flags are cleared. */
+    TEST_ASSERT_EQUAL_UINT32(0x05, osEventFlagsWait(ef, 0x03, osFlagsWaitAny, 0));
+    TEST_ASSERT_EQUAL_UINT32(0x04, osEventFlagsGet(ef));
+
+    osEventFlagsSet(ef, 0x03);
+    TEST_ASSERT_EQUAL_UINT32(0x07, osEventFlagsWait(ef, 0x03, osFlagsWaitAll, 0));
+    TEST_ASSERT_EQUAL_UINT32(0x04, osEventFlagsClear(ef, 0x04));
+    TEST_ASSERT_EQUAL_UINT32(0, osEventFlagsGet(ef));
+}
+
+/**
+  * @brief  All the waiters with satisfied conditions are woken up by one
+  *         setting, and the waiter for all flags waits for the rest.
+  */
+TEST(event, broadcast)
+{
+    ut_event_thread_t ut_thread[UT_EVENT_THREAD_NUMBER];
+
+    for (uint32_t i = 0; i < UT_EVENT_THREAD_NUMBER; i ++)
+    {
+        ut_thread[i].flags = (i == 0) ? 0x03 : 0x01;
+        ut_thread[i].options = (i == 0) ? osFlagsWaitAll :
+                                    (osFlagsWaitAny | osFlagsNoClear);
+        ut_thread[i].result = 0;
+        ut_thread[i].thread = osThreadNew(entry_event_wait, &ut_thread[i],
+                                            &thread_attr_event);
+        TEST_ASSERT_NOT_NULL(ut_thread[i].thread);
+    }
+    osDelay(UT_EVENT_DELAY_MS);
+
+    osEventFlagsSet(ef, 0x01);
+    for (uint32_t i = 1; i < UT_EVENT_THREAD_NUMBER; i ++)
+    {
+        osThreadJoin(ut_thread[i].thread);
+        TEST_ASSERT_EQUAL_UINT32(0x01, ut_thread[i].result);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, ut_thread[0].result);
+
+    osEventFlagsSet(ef, 0x02);
+    osThreadJoin(ut_thread[0].thread);
+    TEST_ASSERT_EQUAL_UINT32(0x03, ut_thread[0].result);
+    TEST_ASSERT_EQUAL_UINT32(0, osEventFlagsGet(ef));
+}
+
+/**
+  * @brief  The blocked waiting is woken up by setting in other thread.
+  */
+TEST(event, wait_timeout)
+{
+    osThreadId_t thread = osThreadNew(entry_event_set_delay, NULL,
+                                        &thread_attr_event);
+    TEST_ASSERT_NOT_NULL(thread);
+    TEST_ASSERT_EQUAL_UINT32(osFlagsErrorTimeout,
+                                osEventFlagsWait(ef, 0x01, osFlagsWaitAny, 5));
+    TEST_ASSERT_EQUAL_UINT32(0x01,
+                                osEventFlagsWait(ef, 0x01, osFlagsWaitAny, 1000));
+    osThreadJoin(thread);
+}
+
+/**
+  * @brief  The thread flags of one thread are set by another one.
+  */
+TEST(event, thread_flags)
+{
+    ut_event_thread_t ut_thread;
+
+    /* The thread not created by osThreadNew has its thread flags too. */
+    TEST_ASSERT_EQUAL_UINT32(0x10, osThreadFlagsSet(osThreadGetId(), 0x10));
+    TEST_ASSERT_EQUAL_UINT32(0x10, osThreadFlagsGet());
+    TEST_ASSERT_EQUAL_UINT32(0x10, osThreadFlagsClear(0x10));
+    TEST_ASSERT_EQUAL_UINT32(osFlagsErrorResource,
+                                osThreadFlagsWait(0x10, osFlagsWaitAny, 0));
+
+    ut_thread.flags = 0x06;
+    ut_thread.options = osFlagsWaitAll;
+    ut_thread.result = 0;
+    ut_thread.thread = osThreadNew(entry_thread_flags_wait, &ut_thread,
+                                    &thread_attr_event);
+    TEST_ASSERT_NOT_NULL(ut_thread.thread);
+    TEST_ASSERT_EQUAL_STRING("ThreadEventTest", osThreadGetName(ut_thread.thread));
+
+    osDelay(UT_EVENT_DELAY_MS);
+    osThreadFlagsSet(ut_thread.thread, 0x02);
+    osDelay(UT_EVENT_DELAY_MS);
+    TEST_ASSERT_EQUAL_UINT32(0, ut_thread.result);
+    osThreadFlagsSet(ut_thread.thread, 0x04);
+    osThreadJoin(ut_thread.thread);
+    TEST_ASSERT_EQUAL_UINT32(0x06, ut_thread.result);
+}
+
+/**
+  * @brief  Define run test cases of event flags and thread flags.
+  */
+TEST_GROUP_RUNNER(event)
+{
+    RUN_TEST_CASE(event, any_all_no_clear);
+    RUN_TEST_CASE(event, broadcast);
+    RUN_TEST_CASE(event, wait_timeout);
+    RUN_TEST_CASE(event, thread_flags);
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void entry_event_wait(void *paras)
+{
+    ut_event_thread_t *ut_thread = (ut_event_thread_t *)paras;
+
+    ut_thread->result = osEventFlagsWait(ef, ut_thread->flags,
+                                            ut_thread->options, osWaitForever);
+}
+
+static void entry_event_set_delay(void *paras)
+{
+    (void)paras;
+
+    osDelay(UT_EVENT_DELAY_MS);
+    osEventFlagsSet(ef, 0x01);
+}
+
+static void entry_thread_flags_wait(void *paras)
+{
+    ut_event_thread_t *ut_thread = (ut_event_thread_t *)paras;
+
+    ut_thread->result = osThreadFlagsWait(ut_thread->flags,
+                                            ut_thread->options, osWaitForever);
+}
+
+#endif
+
+/* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,323 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+#if defined(__linux__)
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "../../os/cmsis_os.h"
+#include "../../3rd/Unity/unity.h"
+#include "../../3rd/Unity/unity_fixture.h"
+#include "../../common/elab_common.h"
+#include "../../common/elab_assert.h"
+
+#define TAG                         "ut_kernel"
+#include "../../common/elab_log.h"
+
+/* Private config ------------------------------------------------------------*/
+#define UT_KERNEL_PERIOD_MS                         (10)
+#define UT_KERNEL_PERIOD_TIMES                      (10)
+#define UT_KERNEL_WORK_US                           (3000)
+#define UT_KERNEL_STACK_SIZE                        (65536)
+#define UT_KERNEL_TIMER_LOCKED_MAX                  (4096)
+
+/* Private function prototypes -----------------------------------------------*/
+static void entry_static_thread(void *paras);
+static void timer_func_static(void *argument);
+static void *entry_foreign_thread(void *paras);
+
+/* Private variables ---------------------------------------------------------*/
+static osThreadBlock_t thread_cb;
+static uint64_t thread_stack[UT_KERNEL_STACK_SIZE / sizeof(uint64_t)];
+static osMutexBlock_t mutex_cb;
+static osSemaphoreBlock_t sem_cb;
+static osEventFlagsBlock_t ef_cb;
+static osTimerBlock_t timer_cb;
+static osSemaphoreId_t sem_static = NULL;
+static osMutexId_t mutex_foreign = NULL;
+static bool foreign_ok = false;
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Define test group of kernel time functions.
+  */
+TEST_GROUP(kernel);
+
+/**
+  * @brief  Define test fixture setup function of kernel time functions.
+  */
+TEST_SETUP(kernel)
+{
+
+}
+
+/**
+  * @brief  Define test fixture tear down function of kernel time functions.
+  */
+TEST_TEAR_DOWN(kernel)
+{
+
+}
+
+/**
+  * @brief  The tick count, system timer and eLab time are in the same pace.
+  */
+TEST(kernel, time_base)
+{
+    TEST_ASSERT_EQUAL_UINT32(1000, osKernelGetTickFreq());
+    TEST_ASSERT_EQUAL_UINT32(1000000000, osKernelGetSysTimerFreq());
+
+    uint32_t tick_start = osKernelGetTickCount();
+    uint32_t count_start = osKernelGetSysTimerCount();
+    uint64_t time_us_start = elab_time_us();
+    uint64_t time_ns_start = elab_time_ns();
+
+    osDelay(20);
+
+    uint32_t ticks = osKernelGetTickCount() - tick_start;
+    uint32_t count = osKernelGetSysTimerCount() - count_start;
+    uint64_t time_us = elab_time_us() - time_us_start;
+    uint64_t time_ns = elab_time_ns() - time_ns_start;
+
+    TEST_ASSERT_UINT32_WITHIN(5, 22, ticks);
+    TEST_ASSERT_UINT32_WITHIN(5000000, 22000000, count);
+    TEST_ASSERT_UINT32_WITHIN(5000, 22000, (uint32_t)time_us);
+    TEST_ASSERT_UINT32_WITHIN(5000000, 22000000, (uint32_t)time_ns);
+}
+
+/**
+  * @brief  The periodic waiting by osDelayUntil does not drift with the
+  *         working time in every period.
+  */
+TEST(kernel, delay_until)
+{
+    osStatus_t ret_os = osOK;
+
+    /* The tick in the past is not allowed. */
+    ret_os = osDelayUntil(osKernelGetTickCount());
+    TEST_ASSERT_EQUAL_INT32(osErrorParameter, ret_os);
+
+    uint32_t overrun = 0;
+    uint32_t tick = osKernelGetTickCount();
+    uint64_t time_start = elab_time_us();
+    for (uint32_t i = 0; i < UT_KERNEL_PERIOD_TIMES; i ++)
+    {
+        /* Some work in the period. */
+        uint64_t time_work = elab_time_us();
+        while ((elab_time_us() - time_work) < UT_KERNEL_WORK_US)
+        {
+        }
+
+        tick += UT_KERNEL_PERIOD_MS;
+        /* The period may be overrun if preempted, but the next periods are
+           still in the fixed pace. */
+        if (osDelayUntil(tick) != osOK)
+        {
+            overrun ++;
+        }
+    }
+    uint32_t time_us = (uint32_t)(elab_time_us() - time_start);
+
+    /* osDelay would take the working time in every period. */
+    TEST_ASSERT_UINT32_WITHIN(2000,
+                                UT_KERNEL_PERIOD_MS * UT_KERNEL_PERIOD_TIMES * 1000,
+                                time_us);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(2, overrun);
+}
+
+/**
+  * @brief  The RTOS objects are created in the memory given by the caller.
+  */
+TEST(kernel, static_objects)
+{
+    const osMutexAttr_t mutex_attr =
+    {
+        .name = "ut_mutex_static",
+        .attr_bits = osMutexRecursive | osMutexPrioInherit,
+        .cb_mem = &mutex_cb,
+        .cb_size = sizeof(mutex_cb),
+    };
+    const osSemaphoreAttr_t sem_attr =
+    {
+        .name = "ut_sem_static",
+        .cb_mem = &sem_cb,
+        .cb_size = sizeof(sem_cb),
+    };
+    const osEventFlagsAttr_t ef_attr =
+    {
+        .name = "ut_ef_static",
+        .cb_mem = &ef_cb,
+        .cb_size = sizeof(ef_cb),
+    };
+    const osTimerAttr_t timer_attr =
+    {
+        .name = "ut_timer_static",
+        .cb_mem = &timer_cb,
+        .cb_size = sizeof(timer_cb),
+    };
+    const osThreadAttr_t thread_attr =
+    {
+        .name = "ThreadStatic",
+        .attr_bits = osThreadJoinable,
+        .cb_mem = &thread_cb,
+        .cb_size = sizeof(thread_cb),
+        .stack_mem = thread_stack,
+        .stack_size = sizeof(thread_stack),
+        .priority = osPriorityNormal,
+    };
+
+    osMutexId_t mutex = osMutexNew(&mutex_attr);
+    TEST_ASSERT_EQUAL_PTR(&mutex_cb, mutex);
+    sem_static = osSemaphoreNew(2, 0, &sem_attr);
+    TEST_ASSERT_EQUAL_PTR(&sem_cb, sem_static);
+    osEventFlagsId_t ef = osEventFlagsNew(&ef_attr);
+    TEST_ASSERT_EQUAL_PTR(&ef_cb, ef);
+    osTimerId_t timer = osTimerNew(timer_func_static, osTimerOnce, NULL,
+                                    &timer_attr);
+    TEST_ASSERT_EQUAL_PTR(&timer_cb, timer);
+
+    TEST_ASSERT_EQUAL_INT32(osOK, osMutexAcquire(mutex, osWaitForever));
+    TEST_ASSERT_EQUAL_INT32(osOK, osMutexRelease(mutex));
+    TEST_ASSERT_EQUAL_UINT32(0x01, osEventFlagsSet(ef, 0x01));
+    TEST_ASSERT_EQUAL_UINT32(0x01, osEventFlagsWait(ef, 0x01, osFlagsWaitAny, 0));
+
+    /* The thread on the given stack and the timer release the semaphore. */
+    osThreadId_t thread = osThreadNew(entry_static_thread, NULL, &thread_attr);
+    TEST_ASSERT_EQUAL_PTR(&thread_cb, thread);
+    TEST_ASSERT_EQUAL_INT32(osOK, osTimerStart(timer, 10));
+    TEST_ASSERT_EQUAL_INT32(osOK, osSemaphoreAcquire(sem_static, 1000));
+    TEST_ASSERT_EQUAL_INT32(osOK, osSemaphoreAcquire(sem_static, 1000));
+    TEST_ASSERT_EQUAL_INT32(osOK, osThreadJoin(thread));
+
+    TEST_ASSERT_EQUAL_INT32(osOK, osTimerDelete(timer));
+    TEST_ASSERT_EQUAL_INT32(osOK, osEventFlagsDelete(ef));
+    TEST_ASSERT_EQUAL_INT32(osOK, osSemaphoreDelete(sem_static));
+    TEST_ASSERT_EQUAL_INT32(osOK, osMutexDelete(mutex));
+    sem_static = NULL;
+}
+
+/**
+  * @brief  The timers are created in the given memory and started with the
+  *         heap locked, until the timer heap reserved is full.
+  */
+TEST(kernel, heap_locked_timer)
+{
+    osTimerBlock_t *timer_cb_locked =
+        elab_malloc(sizeof(osTimerBlock_t) * UT_KERNEL_TIMER_LOCKED_MAX);
+    TEST_ASSERT_NOT_NULL(timer_cb_locked);
+    const osTimerAttr_t attr =
+    {
+        .name = "ut_timer_locked",
+        .cb_size = sizeof(osTimerBlock_t),
+    };
+
+    /* The timer heap may be grown by the former timers, and some of them may
+       be running. */
+    osKernelHeapLock();
+    uint32_t count = 0;
+    osStatus_t ret_os = osOK;
+    while (ret_os == osOK && count < UT_KERNEL_TIMER_LOCKED_MAX)
+    {
+        osTimerAttr_t attr_timer = attr;
+        attr_timer.cb_mem = &timer_cb_locked[count];
+        osTimerId_t timer = osTimerNew(timer_func_static, osTimerOnce, NULL,
+                                        &attr_timer);
+        TEST_ASSERT_EQUAL_PTR(&timer_cb_locked[count], timer);
+        count ++;
+        ret_os = osTimerStart(timer, 100000);
+    }
+    TEST_ASSERT_EQUAL_INT32(osErrorResource, ret_os);
+    TEST_ASSERT_EQUAL_UINT32(0, osTimerIsRunning(&timer_cb_locked[count - 1]));
+
+    /* The restarting one keeps its place, and the stopped one gives it. */
+    if (count > 1)
+    {
+        TEST_ASSERT_EQUAL_INT32(osOK, osTimerStart(&timer_cb_locked[0], 100000));
+        TEST_ASSERT_EQUAL_INT32(osOK, osTimerStop(&timer_cb_locked[0]));
+        TEST_ASSERT_EQUAL_INT32(osOK,
+                                osTimerStart(&timer_cb_locked[count - 1], 100000));
+    }
+    osKernelHeapUnlock();
+
+    for (uint32_t i = 0; i < count; i ++)
+    {
+        TEST_ASSERT_EQUAL_INT32(osOK, osTimerDelete(&timer_cb_locked[i]));
+    }
+    elab_free(timer_cb_locked);
+}
+
+/**
+  * @brief  The thread not created by osThreadNew calls the RTOS functions with
+  *         the heap locked.
+  */
+TEST(kernel, heap_locked_foreign_thread)
+{
+    mutex_foreign = osMutexNew(NULL);
+    TEST_ASSERT_NOT_NULL(mutex_foreign);
+    foreign_ok = false;
+
+    osKernelHeapLock();
+    pthread_t thread;
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, NULL,
+                                            entry_foreign_thread, NULL));
+    TEST_ASSERT_EQUAL_INT(0, pthread_join(thread, NULL));
+    osKernelHeapUnlock();
+
+    TEST_ASSERT_TRUE(foreign_ok);
+    TEST_ASSERT_EQUAL_INT32(osOK, osMutexDelete(mutex_foreign));
+    mutex_foreign = NULL;
+}
+
+/**
+  * @brief  Define run test cases of kernel time functions.
+  */
+TEST_GROUP_RUNNER(kernel)
+{
+    RUN_TEST_CASE(kernel, time_base);
+    RUN_TEST_CASE(kernel, delay_until);
+    RUN_TEST_CASE(kernel, static_objects);
+    RUN_TEST_CASE(kernel, heap_locked_timer);
+    RUN_TEST_CASE(kernel, heap_locked_foreign_thread);
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void entry_static_thread(void *paras)
+{
+    (void)paras;
+
+    /* Something on the stack. */
+    volatile uint8_t buffer[1024];
+    memset((void *)buffer, 0x5a, sizeof(buffer));
+    osSemaphoreRelease(sem_static);
+}
+
+static void timer_func_static(void *argument)
+{
+    (void)argument;
+
+    osSemaphoreRelease(sem_static);
+}
+
+static void *entry_foreign_thread(void *paras)
+{
+    (void)paras;
+
+    osThreadId_t self = osThreadGetId();
+    foreign_ok = (self != NULL &&
+                    osThreadFlagsSet(self, 0x01) == 0x01 &&
+                    osThreadFlagsWait(0x01, osFlagsWaitAny, 0) == 0x01 &&
+                    osMutexAcquire(mutex_foreign, osWaitForever) == osOK &&
+                    osMutexRelease(mutex_foreign) == osOK);
+
+    return NULL;
+}
+
+#endif
+
+/* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,247 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+#if defined(__linux__)
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../../os/cmsis_os.h"
+#include "../../3rd/Unity/unity.h"
+#include "../../3rd/Unity/unity_fixture.h"
+#include "../../common/elab_common.h"
+#include "../../common/elab_assert.h"
+
+#define TAG                         "ut_mp"
+#include "../../common/elab_log.h"
+
+/* Private config ------------------------------------------------------------*/
+#define UT_MP_BLOCK_COUNT                           (16)
+#define UT_MP_BLOCK_SIZE                            (30)
+#define UT_MP_THREAD_NUMBER                         (4)
+#define UT_MP_TEST_TIMES                            (20000)
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct ut_mp_thread
+{
+    osThreadId_t thread;
+    uint32_t id;
+    uint32_t error;
+} ut_mp_thread_t;
+
+/* Private function prototypes -----------------------------------------------*/
+static void entry_mp_stress(void *paras);
+static void entry_mp_free_delay(void *paras);
+
+/* Private variables ---------------------------------------------------------*/
+static osMemoryPoolId_t mp = NULL;
+static osMemoryPoolBlock_t mp_cb;
+static uint64_t mp_mem[MEMPOOL_ARR_SIZE(UT_MP_BLOCK_COUNT, UT_MP_BLOCK_SIZE) /
+                        sizeof(uint64_t)];
+
+static const osMemoryPoolAttr_t mp_attr_static =
+{
+    .name = "ut_mp_static",
+    .attr_bits = 0,
+    .cb_mem = &mp_cb,
+    .cb_size = sizeof(mp_cb),
+    .mp_mem = mp_mem,
+    .mp_size = sizeof(mp_mem),
+};
+
+static const osThreadAttr_t thread_attr_mp =
+{
+    .name = "ThreadMpTest",
+    .attr_bits = osThreadJoinable,
+    .priority = osPriorityNormal,
+    .stack_size = 2048,
+};
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Define test group of memory pool.
+  */
+TEST_GROUP(mp);
+
+/**
+  * @brief  Define test fixture setup function of memory pool.
+  */
+TEST_SETUP(mp)
+{
+    mp = NULL;
+}
+
+/**
+  * @brief  Define test fixture tear down function of memory pool.
+  */
+TEST_TEAR_DOWN(mp)
+{
+    if (mp != NULL)
+    {
+        osMemoryPoolDelete(mp);
+        mp = NULL;
+    }
+}
+
+/**
+  * @brief  Allocating and freeing in the pool with static memory.
+  */
+TEST(mp, alloc_free_static)
+{
+    void *block[UT_MP_BLOCK_COUNT];
+
+    mp = osMemoryPoolNew(UT_MP_BLOCK_COUNT, UT_MP_BLOCK_SIZE, &mp_attr_static);
+    TEST_ASSERT_EQUAL_PTR(&mp_cb, mp);
+    TEST_ASSERT_EQUAL_STRING("ut_mp_static", osMemoryPoolGetName(mp));
+    TEST_ASSERT_EQUAL_UINT32(UT_MP_BLOCK_COUNT, osMemoryPoolGetCapacity(mp));
+    TEST_ASSERT_EQUAL_UINT32(UT_MP_BLOCK_SIZE, osMemoryPoolGetBlockSize(mp));
+
+    for (uint32_t i = 0; i < UT_MP_BLOCK_COUNT; i ++)
+    {
+        block[i] = osMemoryPoolAlloc(mp, 0);
+        TEST_ASSERT_NOT_NULL(block[i]);
+        TEST_ASSERT((uint8_t *)block[i] >= (uint8_t *)mp_mem);
+        TEST_ASSERT((uint8_t *)block[i] < (uint8_t *)mp_mem + sizeof(mp_mem));
+        memset(block[i], (int)i, UT_MP_BLOCK_SIZE);
+    }
+    TEST_ASSERT_EQUAL_UINT32(UT_MP_BLOCK_COUNT, osMemoryPoolGetCount(mp));
+    TEST_ASSERT_EQUAL_UINT32(0, osMemoryPoolGetSpace(mp));
+    TEST_ASSERT_NULL(osMemoryPoolAlloc(mp, 0));
+    TEST_ASSERT_NULL(osMemoryPoolAlloc(mp, 10));
+
+    /* The blocks do not overlap. */
+    for (uint32_t i = 0; i < UT_MP_BLOCK_COUNT; i ++)
+    {
+        for (uint32_t j = 0; j < UT_MP_BLOCK_SIZE; j ++)
+        {
+            TEST_ASSERT_EQUAL_UINT8(i, ((uint8_t *)block[i])[j]);
+        }
+    }
+
+    /* Blocks not in the pool are refused. */
+    uint8_t buffer[UT_MP_BLOCK_SIZE];
+    TEST_ASSERT_EQUAL_INT32(osErrorParameter, osMemoryPoolFree(mp, buffer));
+    TEST_ASSERT_EQUAL_INT32(osErrorParameter,
+                            osMemoryPoolFree(mp, (uint8_t *)block[0] + 1));
+
+    for (uint32_t i = 0; i < UT_MP_BLOCK_COUNT; i ++)
+    {
+        TEST_ASSERT_EQUAL_INT32(osOK, osMemoryPoolFree(mp, block[i]));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, osMemoryPoolGetCount(mp));
+    TEST_ASSERT_EQUAL_UINT32(UT_MP_BLOCK_COUNT, osMemoryPoolGetSpace(mp));
+    TEST_ASSERT_EQUAL_UINT32(UT_MP_BLOCK_COUNT, osMemoryPoolGetCountMax(mp));
+}
+
+/**
+  * @brief  The blocked allocating is woken up by freeing in other thread.
+  */
+TEST(mp, alloc_blocking)
+{
+    void *block[UT_MP_BLOCK_COUNT];
+
+    mp = osMemoryPoolNew(UT_MP_BLOCK_COUNT, UT_MP_BLOCK_SIZE, NULL);
+    TEST_ASSERT_NOT_NULL(mp);
+    for (uint32_t i = 0; i < UT_MP_BLOCK_COUNT; i ++)
+    {
+        block[i] = osMemoryPoolAlloc(mp, 0);
+        TEST_ASSERT_NOT_NULL(block[i]);
+    }
+
+    osThreadId_t thread = osThreadNew(entry_mp_free_delay, block[3],
+                                        &thread_attr_mp);
+    TEST_ASSERT_NOT_NULL(thread);
+    void *block_new = osMemoryPoolAlloc(mp, 1000);
+    TEST_ASSERT_EQUAL_PTR(block[3], block_new);
+    osThreadJoin(thread);
+}
+
+/**
+  * @brief  Multi-thread allocating and freeing, every block is owned by one
+  *         thread at one time.
+  */
+TEST(mp, multi_thread)
+{
+    ut_mp_thread_t ut_thread[UT_MP_THREAD_NUMBER];
+
+    mp = osMemoryPoolNew(UT_MP_BLOCK_COUNT, UT_MP_BLOCK_SIZE, NULL);
+    TEST_ASSERT_NOT_NULL(mp);
+
+    for (uint32_t i = 0; i < UT_MP_THREAD_NUMBER; i ++)
+    {
+        ut_thread[i].id = i;
+        ut_thread[i].error = 0;
+        ut_thread[i].thread = osThreadNew(entry_mp_stress, &ut_thread[i],
+                                            &thread_attr_mp);
+        TEST_ASSERT_NOT_NULL(ut_thread[i].thread);
+    }
+    for (uint32_t i = 0; i < UT_MP_THREAD_NUMBER; i ++)
+    {
+        osThreadJoin(ut_thread[i].thread);
+        TEST_ASSERT_EQUAL_UINT32(0, ut_thread[i].error);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, osMemoryPoolGetCount(mp));
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(UT_MP_BLOCK_COUNT, osMemoryPoolGetCountMax(mp));
+}
+
+/**
+  * @brief  Define run test cases of memory pool.
+  */
+TEST_GROUP_RUNNER(mp)
+{
+    RUN_TEST_CASE(mp, alloc_free_static);
+    RUN_TEST_CASE(mp, alloc_blocking);
+    RUN_TEST_CASE(mp, multi_thread);
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Free the given block after a while.
+  */
+static void entry_mp_free_delay(void *paras)
+{
+    osDelay(20);
+    osStatus_t ret_os = osMemoryPoolFree(mp, paras);
+    elab_assert(ret_os == osOK);
+}
+
+/**
+  * @brief  Allocate some blocks, mark them with the thread id, and check the
+  *         marks before freeing them.
+  */
+static void entry_mp_stress(void *paras)
+{
+    ut_mp_thread_t *ut_thread = (ut_mp_thread_t *)paras;
+    uint8_t *block[2];
+
+    for (uint32_t i = 0; i < UT_MP_TEST_TIMES; i ++)
+    {
+        for (uint32_t j = 0; j < 2; j ++)
+        {
+            block[j] = osMemoryPoolAlloc(mp, osWaitForever);
+            elab_assert(block[j] != NULL);
+            memset(block[j], (int)ut_thread->id, UT_MP_BLOCK_SIZE);
+        }
+        for (uint32_t j = 0; j < 2; j ++)
+        {
+            for (uint32_t k = 0; k < UT_MP_BLOCK_SIZE; k ++)
+            {
+                if (block[j][k] != ut_thread->id)
+                {
+                    ut_thread->error ++;
+                    break;
+                }
+            }
+            osStatus_t ret_os = osMemoryPoolFree(mp, block[j]);
+            elab_assert(ret_os == osOK);
+        }
+    }
+}
+
+#endif
+
+/* ----------------------------- end of file -------------------------------- */
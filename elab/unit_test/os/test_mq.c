@@ -23,6 +23,9 @@
 #define UT_SIMU_MQ_BUFF_SIZE                        (256)
 #define UT_SIMU_MQ_TIMES                            (1000)
 
+#define UT_MQ_STATIC_COUNT                          (10)
+#define UT_MQ_STATIC_MSG_SIZE                       (6)
+
 #define UT_STR_READ                                 "dev_read_data"
 #define UT_STR_WRITE                                "dev_write_data"
 
@@ -37,6 +40,10 @@ static osMessageQueueId_t mq = NULL;
 static uint8_t *buff_tx = NULL;
 static osSemaphoreId_t sem = NULL;
 static uint32_t count_rx = 0;
+static osMessageQueueBlock_t mq_cb;
+static uint32_t mq_mem[MESSAGEQUEUE_ARR_SIZE(UT_MQ_STATIC_COUNT,
+                                                UT_MQ_STATIC_MSG_SIZE) /
+                        sizeof(uint32_t)];
 
 static const osThreadAttr_t attr_serial_read = 
 {
@@ -123,12 +130,316 @@ TEST(mq, rx_tx_cross_thread)
     TEST_ASSERT(ret_os == osOK);
 }
 
+/**
+  * @brief  Full, empty and timeout status of the message queue.
+  */
+TEST(mq, full_empty_timeout)
+{
+    osStatus_t ret_os = osOK;
+    uint32_t data = 0;
+    const osMessageQueueAttr_t attr =
+    {
+        .name = "ut_mq_spsc",
+        .attr_bits = osMessageQueueSpsc,
+    };
+
+    osMessageQueueId_t mq_small = osMessageQueueNew(5, sizeof(uint32_t), &attr);
+    TEST_ASSERT_NOT_NULL(mq_small);
+    TEST_ASSERT_EQUAL_UINT32(5, osMessageQueueGetCapacity(mq_small));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(uint32_t), osMessageQueueGetMsgSize(mq_small));
+
+    ret_os = osMessageQueueGet(mq_small, &data, NULL, 0);
+    TEST_ASSERT_EQUAL_INT32(osErrorResource, ret_os);
+    ret_os = osMessageQueueGet(mq_small, &data, NULL, 10);
+    TEST_ASSERT_EQUAL_INT32(osErrorTimeout, ret_os);
+
+    for (uint32_t i = 0; i < 5; i ++)
+    {
+        ret_os = osMessageQueuePut(mq_small, &i, 0, 0);
+        TEST_ASSERT_EQUAL_INT32(osOK, ret_os);
+    }
+    TEST_ASSERT_EQUAL_UINT32(5, osMessageQueueGetCount(mq_small));
+    TEST_ASSERT_EQUAL_UINT32(0, osMessageQueueGetSpace(mq_small));
+    ret_os = osMessageQueuePut(mq_small, &data, 0, 0);
+    TEST_ASSERT_EQUAL_INT32(osErrorResource, ret_os);
+    ret_os = osMessageQueuePut(mq_small, &data, 0, 10);
+    TEST_ASSERT_EQUAL_INT32(osErrorTimeout, ret_os);
+
+    for (uint32_t i = 0; i < 5; i ++)
+    {
+        ret_os = osMessageQueueGet(mq_small, &data, NULL, osWaitForever);
+        TEST_ASSERT_EQUAL_INT32(osOK, ret_os);
+        TEST_ASSERT_EQUAL_UINT32(i, data);
+    }
+
+    ret_os = osMessageQueuePut(mq_small, &data, 0, 0);
+    TEST_ASSERT_EQUAL_INT32(osOK, ret_os);
+    ret_os = osMessageQueueReset(mq_small);
+    TEST_ASSERT_EQUAL_INT32(osOK, ret_os);
+    TEST_ASSERT_EQUAL_UINT32(0, osMessageQueueGetCount(mq_small));
+
+    ret_os = osMessageQueueDelete(mq_small);
+    TEST_ASSERT_EQUAL_INT32(osOK, ret_os);
+}
+
+/**
+  * @brief Unit test for the bulk putting and getting, in both the MPMC and
+  *        the SPSC mode, crossing the ring end.
+  */
+TEST(mq, put_get_n)
+{
+    uint32_t data[8];
+    uint32_t count = 0;
+    const osMessageQueueAttr_t attr_spsc =
+    {
+        .name = "ut_mq_spsc",
+        .attr_bits = osMessageQueueSpsc,
+    };
+    const osMessageQueueAttr_t *attr[2] = { NULL, &attr_spsc };
+
+    for (uint32_t m = 0; m < 2; m ++)
+    {
+        osMessageQueueId_t mq_n = osMessageQueueNew(5, sizeof(uint32_t), attr[m]);
+        TEST_ASSERT_NOT_NULL(mq_n);
+
+        count = osMessageQueueGetN(mq_n, data, 8, NULL, 0);
+        TEST_ASSERT_EQUAL_UINT32(0, count);
+        count = osMessageQueueGetN(mq_n, data, 8, NULL, 10);
+        TEST_ASSERT_EQUAL_UINT32(0, count);
+
+        for (uint32_t round = 0; round < 4; round ++)
+        {
+            for (uint32_t i = 0; i < 8; i ++)
+            {
+                data[i] = round * 100 + i;
+            }
+
+            /* Only the space of the queue is filled. */
+            count = osMessageQueuePutN(mq_n, data, 8, 0, 0);
+            TEST_ASSERT_EQUAL_UINT32(5, count);
+            TEST_ASSERT_EQUAL_UINT32(5, osMessageQueueGetCount(mq_n));
+            count = osMessageQueuePutN(mq_n, data, 8, 0, 10);
+            TEST_ASSERT_EQUAL_UINT32(0, count);
+
+            memset(data, 0, sizeof(data));
+            count = osMessageQueueGetN(mq_n, data, 3, NULL, osWaitForever);
+            TEST_ASSERT_EQUAL_UINT32(3, count);
+            count = osMessageQueueGetN(mq_n, &data[3], 8, NULL, osWaitForever);
+            TEST_ASSERT_EQUAL_UINT32(2, count);
+            for (uint32_t i = 0; i < 5; i ++)
+            {
+                TEST_ASSERT_EQUAL_UINT32(round * 100 + i, data[i]);
+            }
+            TEST_ASSERT_EQUAL_UINT32(0, osMessageQueueGetCount(mq_n));
+
+            /* Move the ring position, so the next round crosses the ring end. */
+            count = osMessageQueuePutN(mq_n, data, 3, 0, 0);
+            TEST_ASSERT_EQUAL_UINT32(3, count);
+            count = osMessageQueueGetN(mq_n, data, 3, NULL, 0);
+            TEST_ASSERT_EQUAL_UINT32(3, count);
+        }
+
+        TEST_ASSERT_EQUAL_INT32(osOK, osMessageQueueDelete(mq_n));
+    }
+}
+
+/**
+  * @brief  The message queue with the control block and the data storage
+  *         given by the caller.
+  */
+TEST(mq, static_memory)
+{
+    uint8_t msg[UT_MQ_STATIC_MSG_SIZE];
+    const osMessageQueueAttr_t attr =
+    {
+        .name = "ut_mq_static",
+        .cb_mem = &mq_cb,
+        .cb_size = sizeof(mq_cb),
+        .mq_mem = mq_mem,
+        .mq_size = sizeof(mq_mem),
+    };
+
+    osMessageQueueId_t mq_static = osMessageQueueNew(UT_MQ_STATIC_COUNT,
+                                                        UT_MQ_STATIC_MSG_SIZE,
+                                                        &attr);
+    TEST_ASSERT_EQUAL_PTR(&mq_cb, mq_static);
+    TEST_ASSERT_EQUAL_STRING("ut_mq_static", osMessageQueueGetName(mq_static));
+
+    for (uint32_t i = 0; i < UT_MQ_STATIC_COUNT; i ++)
+    {
+        memset(msg, (int)i, sizeof(msg));
+        TEST_ASSERT_EQUAL_INT32(osOK, osMessageQueuePut(mq_static, msg, 0, 0));
+    }
+    TEST_ASSERT_EQUAL_INT32(osErrorResource,
+                            osMessageQueuePut(mq_static, msg, 0, 0));
+    for (uint32_t i = 0; i < UT_MQ_STATIC_COUNT; i ++)
+    {
+        TEST_ASSERT_EQUAL_INT32(osOK,
+                                osMessageQueueGet(mq_static, msg, NULL, 0));
+        for (uint32_t j = 0; j < UT_MQ_STATIC_MSG_SIZE; j ++)
+        {
+            TEST_ASSERT_EQUAL_UINT8(i, msg[j]);
+        }
+    }
+
+    TEST_ASSERT_EQUAL_INT32(osOK, osMessageQueueDelete(mq_static));
+}
+
+/**
+  * @brief  The messages are got in the order of their priorities, and in the
+  *         order of putting in one priority.
+  */
+TEST(mq, prio_order)
+{
+    static const uint8_t prio[] = { 0, 3, 0, 200, 3, 7, 31, 0 };
+    static const uint32_t order[] = { 3, 6, 5, 1, 4, 0, 2, 7 };
+    uint32_t count = sizeof(prio) / sizeof(uint8_t);
+    uint32_t data = 0;
+    uint8_t msg_prio = 0;
+    const osMessageQueueAttr_t attr =
+    {
+        .name = "ut_mq_prio",
+        .attr_bits = osMessageQueuePrio,
+    };
+
+    osMessageQueueId_t mq_prio = osMessageQueueNew(count, sizeof(uint32_t), &attr);
+    TEST_ASSERT_NOT_NULL(mq_prio);
+
+    for (uint32_t round = 0; round < 2; round ++)
+    {
+        for (uint32_t i = 0; i < count; i ++)
+        {
+            TEST_ASSERT_EQUAL_INT32(osOK,
+                                    osMessageQueuePut(mq_prio, &i, prio[i], 0));
+        }
+        TEST_ASSERT_EQUAL_UINT32(count, osMessageQueueGetCount(mq_prio));
+        TEST_ASSERT_EQUAL_INT32(osErrorResource,
+                                osMessageQueuePut(mq_prio, &data, 0, 0));
+
+        for (uint32_t i = 0; i < count; i ++)
+        {
+            TEST_ASSERT_EQUAL_INT32(osOK,
+                            osMessageQueueGet(mq_prio, &data, &msg_prio, 0));
+            TEST_ASSERT_EQUAL_UINT32(order[i], data);
+
+            /* The priorities higher than 31 share the highest lane. */
+            TEST_ASSERT_EQUAL_UINT8(prio[data] > 31 ? 31 : prio[data], msg_prio);
+        }
+        TEST_ASSERT_EQUAL_INT32(osErrorTimeout,
+                                osMessageQueueGet(mq_prio, &data, NULL, 10));
+    }
+
+    /* The bulk getting follows the priorities too. */
+    uint32_t low[2] = { 10, 11 };
+    uint32_t high = 20;
+    uint32_t buffer[4];
+    TEST_ASSERT_EQUAL_UINT32(2, osMessageQueuePutN(mq_prio, low, 2, 1, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, osMessageQueuePutN(mq_prio, &high, 1, 9, 0));
+    TEST_ASSERT_EQUAL_UINT32(3, osMessageQueueGetN(mq_prio, buffer, 4,
+                                                    &msg_prio, 0));
+    TEST_ASSERT_EQUAL_UINT8(9, msg_prio);
+    TEST_ASSERT_EQUAL_UINT32(20, buffer[0]);
+    TEST_ASSERT_EQUAL_UINT32(10, buffer[1]);
+    TEST_ASSERT_EQUAL_UINT32(11, buffer[2]);
+
+    TEST_ASSERT_EQUAL_INT32(osOK, osMessageQueueDelete(mq_prio));
+}
+
+/**
+  * @brief  The messages are filled and read in place by reserving and peeking,
+  *         in the MPMC, SPSC and priority mode, crossing the ring end.
+  */
+TEST(mq, reserve_peek)
+{
+    uint32_t data[8];
+    uint8_t msg_prio = 0;
+    const osMessageQueueAttr_t attr_spsc =
+    {
+        .name = "ut_mq_spsc",
+        .attr_bits = osMessageQueueSpsc,
+    };
+    const osMessageQueueAttr_t attr_prio =
+    {
+        .name = "ut_mq_prio",
+        .attr_bits = osMessageQueuePrio,
+    };
+    const osMessageQueueAttr_t *attr[3] = { NULL, &attr_spsc, &attr_prio };
+
+    for (uint32_t m = 0; m < 3; m ++)
+    {
+        osMessageQueueId_t mq_zc = osMessageQueueNew(3, sizeof(uint32_t) * 4,
+                                                        attr[m]);
+        TEST_ASSERT_NOT_NULL(mq_zc);
+        TEST_ASSERT_NULL(osMessageQueuePeek(mq_zc, NULL, 0));
+        TEST_ASSERT_NULL(osMessageQueuePeek(mq_zc, NULL, 10));
+
+        for (uint32_t round = 0; round < 4; round ++)
+        {
+            for (uint32_t i = 0; i < 3; i ++)
+            {
+                uint32_t *msg = osMessageQueueReserve(mq_zc, 0);
+                TEST_ASSERT_NOT_NULL(msg);
+                for (uint32_t j = 0; j < 4; j ++)
+                {
+                    msg[j] = round * 100 + i * 10 + j;
+                }
+                TEST_ASSERT_EQUAL_INT32(osOK, osMessageQueueCommit(mq_zc, msg, 1));
+            }
+            TEST_ASSERT_EQUAL_UINT32(3, osMessageQueueGetCount(mq_zc));
+            TEST_ASSERT_NULL(osMessageQueueReserve(mq_zc, 0));
+            TEST_ASSERT_NULL(osMessageQueueReserve(mq_zc, 10));
+
+            /* The in-place and the copying functions work on the same queue. */
+            TEST_ASSERT_EQUAL_INT32(osOK, osMessageQueueGet(mq_zc, data, NULL, 0));
+            TEST_ASSERT_EQUAL_UINT32(round * 100, data[0]);
+            for (uint32_t i = 1; i < 3; i ++)
+            {
+                uint32_t *msg = osMessageQueuePeek(mq_zc, &msg_prio, 0);
+                TEST_ASSERT_NOT_NULL(msg);
+                TEST_ASSERT_EQUAL_UINT8(m == 2 ? 1 : 0, msg_prio);
+                for (uint32_t j = 0; j < 4; j ++)
+                {
+                    TEST_ASSERT_EQUAL_UINT32(round * 100 + i * 10 + j, msg[j]);
+                }
+                TEST_ASSERT_EQUAL_INT32(osOK, osMessageQueueRelease(mq_zc, msg));
+            }
+            TEST_ASSERT_EQUAL_UINT32(0, osMessageQueueGetCount(mq_zc));
+            TEST_ASSERT_NULL(osMessageQueuePeek(mq_zc, NULL, 0));
+
+            /* The reserved slots are not seen before committed. */
+            if (m != 1)
+            {
+                uint32_t *msg_1 = osMessageQueueReserve(mq_zc, 0);
+                uint32_t *msg_2 = osMessageQueueReserve(mq_zc, 0);
+                TEST_ASSERT_NOT_NULL(msg_1);
+                TEST_ASSERT_NOT_NULL(msg_2);
+                TEST_ASSERT(msg_1 != msg_2);
+                TEST_ASSERT_NULL(osMessageQueuePeek(mq_zc, NULL, 0));
+                msg_1[0] = 1;
+                msg_2[0] = 2;
+                TEST_ASSERT_EQUAL_INT32(osOK, osMessageQueueCommit(mq_zc, msg_1, 0));
+                TEST_ASSERT_EQUAL_INT32(osOK, osMessageQueueCommit(mq_zc, msg_2, 0));
+                TEST_ASSERT_EQUAL_UINT32(2, osMessageQueueGetN(mq_zc, data, 2, NULL, 0));
+                TEST_ASSERT_EQUAL_UINT32(1, data[0]);
+                TEST_ASSERT_EQUAL_UINT32(2, data[4]);
+            }
+        }
+
+        TEST_ASSERT_EQUAL_INT32(osOK, osMessageQueueDelete(mq_zc));
+    }
+}
+
 /**
   * @brief  Define run test cases of device core
   */
 TEST_GROUP_RUNNER(mq)
 {
     RUN_TEST_CASE(mq, rx_tx_cross_thread);
+    RUN_TEST_CASE(mq, full_empty_timeout);
+    RUN_TEST_CASE(mq, put_get_n);
+    RUN_TEST_CASE(mq, static_memory);
+    RUN_TEST_CASE(mq, prio_order);
+    RUN_TEST_CASE(mq, reserve_peek);
 }
 
 /* Private functions ---------------------------------------------------------*/
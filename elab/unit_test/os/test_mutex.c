@@ -35,6 +35,7 @@ typedef struct ut_mutex
 
 /* Private function prototypes -----------------------------------------------*/
 static void entry_mutex_test(void *paras);
+static void entry_mutex_hold(void *paras);
 
 /* Private variables ---------------------------------------------------------*/
 static uint8_t *shared_data = NULL;
@@ -51,6 +52,22 @@ static const osMutexAttr_t mutex_attr =
     0U 
 };
 
+static const osMutexAttr_t mutex_attr_normal =
+{
+    "ut_mutex_normal",
+    0U,
+    NULL,
+    0U
+};
+
+static const osThreadAttr_t thread_attr_mutex_hold =
+{
+    .name = "ThreadMutexHold",
+    .attr_bits = osThreadJoinable,
+    .priority = osPriorityNormal,
+    .stack_size = 2048,
+};
+
 /* Exported functions --------------------------------------------------------*/
 /**
   * @brief  Define test group of mutex.
@@ -136,12 +153,105 @@ TEST(mutex, test)
     }
 }
 
+/**
+  * @brief  The recursive mutex is nested by its owner, and the normal one
+  *         refuses the relocking.
+  */
+TEST(mutex, recursive_owner)
+{
+    TEST_ASSERT_EQUAL_STRING("ut_mutex", osMutexGetName(mutex));
+    TEST_ASSERT_NULL(osMutexGetOwner(mutex));
+    TEST_ASSERT_EQUAL_INT32(osErrorResource, osMutexRelease(mutex));
+
+    TEST_ASSERT_EQUAL_INT32(osOK, osMutexAcquire(mutex, osWaitForever));
+    TEST_ASSERT_EQUAL_INT32(osOK, osMutexAcquire(mutex, 0));
+    TEST_ASSERT_EQUAL_PTR(osThreadGetId(), osMutexGetOwner(mutex));
+    TEST_ASSERT_EQUAL_INT32(osOK, osMutexRelease(mutex));
+    TEST_ASSERT_EQUAL_PTR(osThreadGetId(), osMutexGetOwner(mutex));
+    TEST_ASSERT_EQUAL_INT32(osOK, osMutexRelease(mutex));
+    TEST_ASSERT_NULL(osMutexGetOwner(mutex));
+
+    osMutexId_t mutex_normal = osMutexNew(&mutex_attr_normal);
+    TEST_ASSERT_NOT_NULL(mutex_normal);
+    TEST_ASSERT_EQUAL_INT32(osOK, osMutexAcquire(mutex_normal, 0));
+    TEST_ASSERT_EQUAL_INT32(osErrorResource, osMutexAcquire(mutex_normal, 10));
+    TEST_ASSERT_EQUAL_INT32(osErrorResource, osMutexDelete(mutex_normal));
+    TEST_ASSERT_EQUAL_INT32(osOK, osMutexRelease(mutex_normal));
+    TEST_ASSERT_EQUAL_INT32(osOK, osMutexDelete(mutex_normal));
+}
+
+/**
+  * @brief  The mutex held by other thread is acquired with timeout.
+  */
+TEST(mutex, timeout)
+{
+    osThreadId_t thread = osThreadNew(entry_mutex_hold, NULL,
+                                        &thread_attr_mutex_hold);
+    TEST_ASSERT_NOT_NULL(thread);
+    osSemaphoreAcquire(sem_one_time, osWaitForever);
+
+    TEST_ASSERT_EQUAL_PTR(thread, osMutexGetOwner(mutex));
+    TEST_ASSERT_EQUAL_INT32(osErrorResource, osMutexAcquire(mutex, 0));
+    TEST_ASSERT_EQUAL_INT32(osErrorTimeout, osMutexAcquire(mutex, 10));
+    TEST_ASSERT_EQUAL_INT32(osErrorResource, osMutexRelease(mutex));
+
+    TEST_ASSERT_EQUAL_INT32(osOK, osMutexAcquire(mutex, 1000));
+    TEST_ASSERT_EQUAL_PTR(osThreadGetId(), osMutexGetOwner(mutex));
+    TEST_ASSERT_EQUAL_INT32(osOK, osMutexRelease(mutex));
+    osThreadJoin(thread);
+}
+
+#if (ELAB_RTOS_PROFILE_EN != 0)
+/**
+  * @brief  The contended acquiring is recorded in the profile of the mutex
+  *         name, with the waiting time and the holding time.
+  */
+TEST(mutex, profile)
+{
+    unsigned long acquire = 0, contended = 0, wait_total = 0, wait_max = 0;
+    char line[256];
+
+    osKernelProfileReset();
+    osThreadId_t thread = osThreadNew(entry_mutex_hold, NULL,
+                                        &thread_attr_mutex_hold);
+    TEST_ASSERT_NOT_NULL(thread);
+    osSemaphoreAcquire(sem_one_time, osWaitForever);
+    TEST_ASSERT_EQUAL_INT32(osOK, osMutexAcquire(mutex, 1000));
+    TEST_ASSERT_EQUAL_INT32(osOK, osMutexRelease(mutex));
+    osThreadJoin(thread);
+
+    FILE *file = tmpfile();
+    TEST_ASSERT_NOT_NULL(file);
+    osKernelProfilePrint(fileno(file), 1);
+    rewind(file);
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        if (strncmp(line, "mutex,ut_mutex,", 15) == 0)
+        {
+            sscanf(&line[15], "%lu,%lu,%lu,%lu",
+                    &acquire, &contended, &wait_total, &wait_max);
+        }
+    }
+    fclose(file);
+
+    TEST_ASSERT_EQUAL_UINT32(2, acquire);
+    TEST_ASSERT_EQUAL_UINT32(1, contended);
+    TEST_ASSERT_UINT32_WITHIN(20000000, 45000000, wait_total);
+    TEST_ASSERT_EQUAL_UINT32(wait_total, wait_max);
+}
+#endif
+
 /**
   * @brief  Define run test cases of mutex
   */
 TEST_GROUP_RUNNER(mutex)
 {
     RUN_TEST_CASE(mutex, test);
+    RUN_TEST_CASE(mutex, recursive_owner);
+    RUN_TEST_CASE(mutex, timeout);
+#if (ELAB_RTOS_PROFILE_EN != 0)
+    RUN_TEST_CASE(mutex, profile);
+#endif
 }
 
 /* Private functions ---------------------------------------------------------*/
@@ -180,7 +290,22 @@ static void entry_mutex_test(void *paras)
     }
 }
 
+
+/**
+  * @brief  Hold the mutex for a while.
+  */
+static void entry_mutex_hold(void *paras)
+{
+    (void)paras;
+
+    osStatus_t ret_os = osMutexAcquire(mutex, osWaitForever);
+    elab_assert(ret_os == osOK);
+    osSemaphoreRelease(sem_one_time);
+    osDelay(50);
+    ret_os = osMutexRelease(mutex);
+    elab_assert(ret_os == osOK);
+}
+
 #endif
 
 /* ----------------------------- end of file -------------------------------- */
- 
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
+#include <sched.h>
 #include "../../os/cmsis_os.h"
 #include "../../3rd/Unity/unity.h"
 #include "../../3rd/Unity/unity_fixture.h"
@@ -22,14 +23,32 @@
 /* Private config ------------------------------------------------------------*/
 #define UT_THREAD_TEST_TIMES                      (1000)
 #define UT_THREAD_TEST_NUMBER                     (64)
+#define UT_THREAD_STACK_USED                      (8192)
+#define UT_THREAD_BUSY_MS                         (20)
 
 /* Private typedef -----------------------------------------------------------*/
 
 
 /* Private function prototypes -----------------------------------------------*/
 static void entry_thread_test(void *paras);
+static void entry_thread_stack(void *paras);
+static void entry_thread_exit(void *paras);
+static uint32_t stack_use(uint32_t size);
 
 /* Private variables ---------------------------------------------------------*/
+static volatile bool thread_stack_ready = false;
+static volatile bool thread_stack_quit = false;
+static uint32_t thread_stack_sum = 0;
+static uint32_t thread_exit_count = 0;
+
+static const osThreadAttr_t thread_attr_stack =
+{
+    .name = "ThreadStackTest",
+    .attr_bits = osThreadJoinable,
+    .priority = osPriorityNormal,
+    .stack_size = 2048,
+};
+
 static const osThreadAttr_t thread_attr_test = 
 {
     .name = "ThreadUnitTest",
@@ -78,12 +97,108 @@ TEST(thread, new_and_terminate)
     }
 }
 
+/**
+  * @brief  The CPU affinity given in the attribute is applied, and the
+  *         scheduling policy achieved is reported.
+  */
+TEST(thread, affinity_and_sched)
+{
+    osThreadAttr_t attr = thread_attr_test;
+    int32_t policy = -1, priority = -1;
+
+    attr.affinity_mask = 0x01;
+    osThreadId_t thread = osThreadNew(entry_thread_test, NULL, &attr);
+    TEST_ASSERT_NOT_NULL(thread);
+    TEST_ASSERT_EQUAL_UINT32(0x01, osThreadGetAffinityMask(thread));
+
+    TEST_ASSERT_EQUAL_INT32(osOK, osThreadGetSched(thread, &policy, &priority));
+    TEST_ASSERT_TRUE(policy == SCHED_RR || policy == SCHED_OTHER);
+    TEST_ASSERT_TRUE((policy == SCHED_RR) ? (priority > 0) : (priority == 0));
+
+    TEST_ASSERT_EQUAL_INT32(osOK, osThreadSetAffinityMask(thread, 0));
+    TEST_ASSERT_NOT_EQUAL(0, osThreadGetAffinityMask(thread) & 0x01);
+    TEST_ASSERT_EQUAL_INT32(osOK, osThreadTerminate(thread));
+}
+
+/**
+  * @brief  The thread is enumerated until it exits, and its CPU time and the
+  *         high-water mark of its stack are measured.
+  */
+TEST(thread, enumerate_and_stack)
+{
+    osThreadId_t thread_array[UT_THREAD_TEST_NUMBER];
+    uint32_t count = osThreadGetCount();
+
+    thread_stack_ready = false;
+    thread_stack_quit = false;
+    osThreadId_t thread = osThreadNew(entry_thread_stack, NULL, &thread_attr_stack);
+    TEST_ASSERT_NOT_NULL(thread);
+    while (!thread_stack_ready)
+    {
+        osDelay(1);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(count + 1, osThreadGetCount());
+    uint32_t number = osThreadEnumerate(thread_array, UT_THREAD_TEST_NUMBER);
+    bool found = false;
+    for (uint32_t i = 0; i < number; i ++)
+    {
+        found = found || (thread_array[i] == thread);
+    }
+    TEST_ASSERT_TRUE(found);
+    TEST_ASSERT_EQUAL_STRING("ThreadStackTest", osThreadGetName(thread));
+
+    uint32_t stack_size = osThreadGetStackSize(thread);
+    TEST_ASSERT_GREATER_THAN_UINT32(UT_THREAD_STACK_USED, stack_size);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(UT_THREAD_STACK_USED,
+                                stack_size - osThreadGetStackSpace(thread));
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT64((uint64_t)UT_THREAD_BUSY_MS * 1000000 / 2,
+                                        osThreadGetCpuTimeNs(thread));
+    TEST_ASSERT_EQUAL_UINT32((UT_THREAD_STACK_USED / 256) * (255 * 256 / 2),
+                                thread_stack_sum);
+
+    thread_stack_quit = true;
+    TEST_ASSERT_EQUAL_INT32(osOK, osThreadJoin(thread));
+    TEST_ASSERT_EQUAL_UINT32(count, osThreadGetCount());
+}
+
+/**
+  * @brief  The detached threads exit by themselves and leave the thread list,
+  *         and they can not be joined.
+  */
+TEST(thread, detached_exit)
+{
+    uint32_t count = osThreadGetCount();
+
+    thread_exit_count = 0;
+    for (uint32_t i = 0; i < UT_THREAD_TEST_TIMES; i ++)
+    {
+        osThreadId_t thread = osThreadNew(entry_thread_exit, NULL,
+                                            &thread_attr_test);
+        TEST_ASSERT_NOT_NULL(thread);
+    }
+    while (__atomic_load_n(&thread_exit_count, __ATOMIC_ACQUIRE) <
+            UT_THREAD_TEST_TIMES || osThreadGetCount() != count)
+    {
+        osDelay(1);
+    }
+
+    osThreadId_t thread = osThreadNew(entry_thread_test, NULL, &thread_attr_test);
+    TEST_ASSERT_NOT_NULL(thread);
+    TEST_ASSERT_EQUAL_INT32(osErrorResource, osThreadJoin(thread));
+    TEST_ASSERT_EQUAL_INT32(osOK, osThreadTerminate(thread));
+    TEST_ASSERT_EQUAL_UINT32(count, osThreadGetCount());
+}
+
 /**
   * @brief  Define run test cases of semaphores.
   */
 TEST_GROUP_RUNNER(thread)
 {
     RUN_TEST_CASE(thread, new_and_terminate);
+    RUN_TEST_CASE(thread, affinity_and_sched);
+    RUN_TEST_CASE(thread, enumerate_and_stack);
+    RUN_TEST_CASE(thread, detached_exit);
 }
 
 /* Private functions ---------------------------------------------------------*/
@@ -99,6 +214,55 @@ static void entry_thread_test(void *paras)
     osThreadExit();
 }
 
+/**
+  * @brief  Entry function for the stack and CPU time test, which runs busily
+  *         and uses some stack before waiting to quit.
+  */
+static void entry_thread_stack(void *paras)
+{
+    (void)paras;
+
+    uint64_t time_start = elab_time_ns();
+    while ((elab_time_ns() - time_start) < (UT_THREAD_BUSY_MS * 1000000ULL))
+    {
+    }
+    thread_stack_sum = stack_use(UT_THREAD_STACK_USED);
+
+    thread_stack_ready = true;
+    while (!thread_stack_quit)
+    {
+        osDelay(1);
+    }
+}
+
+/**
+  * @brief  Entry function for the detached thread test, which exits at once.
+  */
+static void entry_thread_exit(void *paras)
+{
+    (void)paras;
+
+    __atomic_add_fetch(&thread_exit_count, 1, __ATOMIC_RELEASE);
+}
+
+static uint32_t __attribute__((noinline)) stack_use(uint32_t size)
+{
+    volatile uint8_t buffer[size];
+    uint32_t sum = 0;
+
+    /* Written and read back, so the stack is really used. */
+    for (uint32_t i = 0; i < size; i ++)
+    {
+        buffer[i] = (uint8_t)i;
+    }
+    for (uint32_t i = 0; i < size; i ++)
+    {
+        sum += buffer[i];
+    }
+
+    return sum;
+}
+
 #endif
 
 /* ----------------------------- end of file -------------------------------- */
@@ -0,0 +1,232 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+#if defined(__linux__)
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../../os/cmsis_os.h"
+#include "../../3rd/Unity/unity.h"
+#include "../../3rd/Unity/unity_fixture.h"
+#include "../../common/elab_common.h"
+#include "../../common/elab_assert.h"
+
+#define TAG                         "ut_timer"
+#include "../../common/elab_log.h"
+
+/* Private config ------------------------------------------------------------*/
+#define UT_TIMER_PERIOD_MS                          (10)
+#define UT_TIMER_NUMBER                             (1000)
+#define UT_TIMER_ORDER_STEPS                        (20)
+#define UT_TIMER_ORDER_STEP_MS                      (5)
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct ut_timer
+{
+    osTimerId_t timer;
+    uint32_t ticks;
+} ut_timer_t;
+
+/* Private function prototypes -----------------------------------------------*/
+static void _timer_func_count(void *argument);
+static void _timer_func_order(void *argument);
+static void _timer_func_self_stop(void *argument);
+
+/* Private variables ---------------------------------------------------------*/
+static volatile uint32_t count_timeout = 0;
+static volatile uint32_t count_order = 0;
+static volatile uint32_t ticks_last = 0;
+static volatile bool order_error = false;
+static osSemaphoreId_t sem_timer = NULL;
+static osTimerId_t timer_self = NULL;
+
+static const osTimerAttr_t timer_attr_ut =
+{
+    .name = "ut_timer",
+    .attr_bits = 0,
+    .cb_mem = NULL,
+    .cb_size = 0,
+};
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Define test group of timer.
+  */
+TEST_GROUP(timer);
+
+/**
+  * @brief  Define test fixture setup function of timer.
+  */
+TEST_SETUP(timer)
+{
+    count_timeout = 0;
+    count_order = 0;
+    ticks_last = 0;
+    order_error = false;
+    sem_timer = osSemaphoreNew(1, 0, NULL);
+    TEST_ASSERT_NOT_NULL(sem_timer);
+}
+
+/**
+  * @brief  Define test fixture tear down function of timer.
+  */
+TEST_TEAR_DOWN(timer)
+{
+    osSemaphoreDelete(sem_timer);
+    sem_timer = NULL;
+}
+
+/**
+  * @brief  Once and periodic timer testing.
+  */
+TEST(timer, once_periodic)
+{
+    osStatus_t ret_os = osOK;
+
+    osTimerId_t timer = osTimerNew(_timer_func_count, osTimerOnce,
+                                    NULL, &timer_attr_ut);
+    TEST_ASSERT_NOT_NULL(timer);
+    TEST_ASSERT_EQUAL_STRING("ut_timer", osTimerGetName(timer));
+    TEST_ASSERT_EQUAL_UINT32(0, osTimerIsRunning(timer));
+
+    /* Stopping one idle timer is not allowed. */
+    ret_os = osTimerStop(timer);
+    TEST_ASSERT_EQUAL_INT32(osErrorResource, ret_os);
+
+    ret_os = osTimerStart(timer, UT_TIMER_PERIOD_MS);
+    TEST_ASSERT_EQUAL_INT32(osOK, ret_os);
+    TEST_ASSERT_EQUAL_UINT32(1, osTimerIsRunning(timer));
+    osDelay(UT_TIMER_PERIOD_MS * 5);
+    TEST_ASSERT_EQUAL_UINT32(1, count_timeout);
+    TEST_ASSERT_EQUAL_UINT32(0, osTimerIsRunning(timer));
+    ret_os = osTimerDelete(timer);
+    TEST_ASSERT_EQUAL_INT32(osOK, ret_os);
+
+    count_timeout = 0;
+    timer = osTimerNew(_timer_func_count, osTimerPeriodic,
+                        NULL, &timer_attr_ut);
+    TEST_ASSERT_NOT_NULL(timer);
+    ret_os = osTimerStart(timer, UT_TIMER_PERIOD_MS);
+    TEST_ASSERT_EQUAL_INT32(osOK, ret_os);
+    osDelay(UT_TIMER_PERIOD_MS * 10 + UT_TIMER_PERIOD_MS / 2);
+    ret_os = osTimerStop(timer);
+    TEST_ASSERT_EQUAL_INT32(osOK, ret_os);
+    TEST_ASSERT_EQUAL_UINT32(0, osTimerIsRunning(timer));
+    TEST_ASSERT_UINT32_WITHIN(2, 10, count_timeout);
+
+    /* No timeout any more after stopped. */
+    uint32_t count = count_timeout;
+    osDelay(UT_TIMER_PERIOD_MS * 3);
+    TEST_ASSERT_EQUAL_UINT32(count, count_timeout);
+    ret_os = osTimerDelete(timer);
+    TEST_ASSERT_EQUAL_INT32(osOK, ret_os);
+}
+
+/**
+  * @brief  Lots of timers expire in the order of their deadlines.
+  */
+TEST(timer, deadline_order)
+{
+    ut_timer_t *ut_timer = elab_malloc(sizeof(ut_timer_t) * UT_TIMER_NUMBER);
+    TEST_ASSERT_NOT_NULL(ut_timer);
+
+    for (uint32_t i = 0; i < UT_TIMER_NUMBER; i ++)
+    {
+        ut_timer[i].ticks = ((rand() % UT_TIMER_ORDER_STEPS) + 1) *
+                                UT_TIMER_ORDER_STEP_MS;
+        ut_timer[i].timer = osTimerNew(_timer_func_order, osTimerOnce,
+                                        &ut_timer[i], &timer_attr_ut);
+        TEST_ASSERT_NOT_NULL(ut_timer[i].timer);
+    }
+    for (uint32_t i = 0; i < UT_TIMER_NUMBER; i ++)
+    {
+        TEST_ASSERT_EQUAL_INT32(osOK, osTimerStart(ut_timer[i].timer,
+                                                    ut_timer[i].ticks));
+    }
+
+    osStatus_t ret_os = osSemaphoreAcquire(sem_timer, 1000);
+    TEST_ASSERT_EQUAL_INT32(osOK, ret_os);
+    TEST_ASSERT_EQUAL_UINT32(UT_TIMER_NUMBER, count_order);
+    TEST_ASSERT_FALSE(order_error);
+
+    for (uint32_t i = 0; i < UT_TIMER_NUMBER; i ++)
+    {
+        TEST_ASSERT_EQUAL_INT32(osOK, osTimerDelete(ut_timer[i].timer));
+    }
+    elab_free(ut_timer);
+}
+
+/**
+  * @brief  The timer functions are allowed to be called in the timer callback.
+  */
+TEST(timer, stop_in_callback)
+{
+    osTimerId_t timer = osTimerNew(_timer_func_self_stop, osTimerPeriodic,
+                                    NULL, &timer_attr_ut);
+    TEST_ASSERT_NOT_NULL(timer);
+    timer_self = timer;
+
+    osStatus_t ret_os = osTimerStart(timer, UT_TIMER_PERIOD_MS);
+    TEST_ASSERT_EQUAL_INT32(osOK, ret_os);
+    ret_os = osSemaphoreAcquire(sem_timer, 1000);
+    TEST_ASSERT_EQUAL_INT32(osOK, ret_os);
+    osDelay(UT_TIMER_PERIOD_MS * 3);
+    TEST_ASSERT_EQUAL_UINT32(0, osTimerIsRunning(timer));
+
+    ret_os = osTimerDelete(timer);
+    TEST_ASSERT_EQUAL_INT32(osOK, ret_os);
+}
+
+/**
+  * @brief  Define run test cases of timer
+  */
+TEST_GROUP_RUNNER(timer)
+{
+    RUN_TEST_CASE(timer, once_periodic);
+    RUN_TEST_CASE(timer, deadline_order);
+    RUN_TEST_CASE(timer, stop_in_callback);
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void _timer_func_count(void *argument)
+{
+    (void)argument;
+
+    count_timeout ++;
+}
+
+static void _timer_func_order(void *argument)
+{
+    ut_timer_t *ut_timer = (ut_timer_t *)argument;
+
+    /* All the timers are started in much less than one step, so the one with
+       the less ticks always expires at first. */
+    if (ut_timer->ticks < ticks_last)
+    {
+        order_error = true;
+    }
+    ticks_last = ut_timer->ticks;
+    count_order ++;
+    if (count_order == UT_TIMER_NUMBER)
+    {
+        osSemaphoreRelease(sem_timer);
+    }
+}
+
+static void _timer_func_self_stop(void *argument)
+{
+    (void)argument;
+
+    osStatus_t ret_os = osTimerStop(timer_self);
+    elab_assert(ret_os == osOK);
+    osSemaphoreRelease(sem_timer);
+}
+
+#endif
+
+/* ----------------------------- end of file -------------------------------- */
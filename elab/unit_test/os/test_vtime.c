@@ -0,0 +1,239 @@
+/*
+ * eLab Project
+ * Copyright (c) 2023, EventOS Team, <event-os@outlook.com>
+ */
+
+#if defined(__linux__)
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../../os/cmsis_os.h"
+#include "../../3rd/Unity/unity.h"
+#include "../../3rd/Unity/unity_fixture.h"
+#include "../../common/elab_common.h"
+#include "../../common/elab_assert.h"
+
+#define TAG                         "ut_vtime"
+#include "../../common/elab_log.h"
+
+/* Private config ------------------------------------------------------------*/
+#define UT_VTIME_DELAY_MS                           (60000)
+#define UT_VTIME_TIMEOUT_MS                         (5000)
+#define UT_VTIME_PUT_DELAY_MS                       (1000)
+#define UT_VTIME_REAL_MS_MAX                        (2000)
+#define UT_VTIME_TIMER_NUMBER                       (3)
+#define UT_VTIME_SCALE                              (100)
+#define UT_VTIME_BUSY_MS                            (20)
+
+/* Private function prototypes -----------------------------------------------*/
+static void timer_func_vtime(void *argument);
+static void entry_put_delay(void *paras);
+static uint64_t real_time_ms(void);
+
+/* Private variables ---------------------------------------------------------*/
+static osSemaphoreId_t sem = NULL;
+static osMessageQueueId_t mq = NULL;
+static uint32_t timer_tick[UT_VTIME_TIMER_NUMBER];
+static uint32_t timer_order[UT_VTIME_TIMER_NUMBER];
+static uint32_t timer_fired = 0;
+
+static const osThreadAttr_t thread_attr_vtime =
+{
+    .name = "ThreadVtimeTest",
+    .attr_bits = osThreadJoinable,
+    .priority = osPriorityNormal,
+    .stack_size = 2048,
+};
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Define test group of the virtual time.
+  */
+TEST_GROUP(vtime);
+
+/**
+  * @brief  Define test fixture setup function of the virtual time.
+  */
+TEST_SETUP(vtime)
+{
+    sem = osSemaphoreNew(UT_VTIME_TIMER_NUMBER, 0, NULL);
+    TEST_ASSERT_NOT_NULL(sem);
+    mq = osMessageQueueNew(4, sizeof(uint32_t), NULL);
+    TEST_ASSERT_NOT_NULL(mq);
+    TEST_ASSERT_EQUAL_INT32(osOK, osKernelSetVirtualTime(1, 0));
+}
+
+/**
+  * @brief  Define test fixture tear down function of the virtual time.
+  */
+TEST_TEAR_DOWN(vtime)
+{
+    TEST_ASSERT_EQUAL_INT32(osOK, osKernelSetVirtualTime(0, 0));
+    TEST_ASSERT_EQUAL_INT32(osOK, osMessageQueueDelete(mq));
+    TEST_ASSERT_EQUAL_INT32(osOK, osSemaphoreDelete(sem));
+    mq = NULL;
+    sem = NULL;
+}
+
+/**
+  * @brief  The long delay takes no real time, and the tick count moves by the
+  *         delay exactly.
+  */
+TEST(vtime, delay)
+{
+    uint64_t real_start = real_time_ms();
+    uint32_t tick_start = osKernelGetTickCount();
+    uint64_t time_ns_start = elab_time_ns();
+
+    osDelay(UT_VTIME_DELAY_MS);
+
+    TEST_ASSERT_EQUAL_UINT32(UT_VTIME_DELAY_MS,
+                                osKernelGetTickCount() - tick_start);
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)UT_VTIME_DELAY_MS * 1000000,
+                                elab_time_ns() - time_ns_start);
+    TEST_ASSERT_LESS_THAN_UINT32(UT_VTIME_REAL_MS_MAX,
+                                    (uint32_t)(real_time_ms() - real_start));
+
+    /* The time stops while the thread runs. */
+    tick_start = osKernelGetTickCount();
+    uint64_t real_busy = real_time_ms();
+    while ((real_time_ms() - real_busy) < UT_VTIME_BUSY_MS)
+    {
+    }
+    TEST_ASSERT_EQUAL_UINT32(tick_start, osKernelGetTickCount());
+}
+
+/**
+  * @brief  The timers expire in the order of their deadlines, and at the
+  *         exact ticks.
+  */
+TEST(vtime, timer_order)
+{
+    static const uint32_t ticks[UT_VTIME_TIMER_NUMBER] = { 30000, 10000, 20000 };
+    osTimerId_t timer[UT_VTIME_TIMER_NUMBER];
+
+    timer_fired = 0;
+    uint32_t tick_start = osKernelGetTickCount();
+    for (uint32_t i = 0; i < UT_VTIME_TIMER_NUMBER; i ++)
+    {
+        timer[i] = osTimerNew(timer_func_vtime, osTimerOnce,
+                                (void *)(uintptr_t)i, NULL);
+        TEST_ASSERT_NOT_NULL(timer[i]);
+        TEST_ASSERT_EQUAL_INT32(osOK, osTimerStart(timer[i], ticks[i]));
+    }
+    for (uint32_t i = 0; i < UT_VTIME_TIMER_NUMBER; i ++)
+    {
+        TEST_ASSERT_EQUAL_INT32(osOK, osSemaphoreAcquire(sem, UT_VTIME_DELAY_MS));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(1, timer_order[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, timer_order[1]);
+    TEST_ASSERT_EQUAL_UINT32(0, timer_order[2]);
+    for (uint32_t i = 0; i < UT_VTIME_TIMER_NUMBER; i ++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(ticks[i], timer_tick[i] - tick_start);
+        TEST_ASSERT_EQUAL_INT32(osOK, osTimerDelete(timer[i]));
+    }
+}
+
+/**
+  * @brief  The timeouts of the semaphore and the message queue are in the
+  *         virtual time, and the waiting thread is woken up at the tick when
+  *         the message is put.
+  */
+TEST(vtime, timeout)
+{
+    uint32_t msg = 0;
+
+    uint32_t tick_start = osKernelGetTickCount();
+    TEST_ASSERT_EQUAL_INT32(osErrorTimeout,
+                            osSemaphoreAcquire(sem, UT_VTIME_TIMEOUT_MS));
+    TEST_ASSERT_EQUAL_UINT32(UT_VTIME_TIMEOUT_MS,
+                                osKernelGetTickCount() - tick_start);
+
+    tick_start = osKernelGetTickCount();
+    TEST_ASSERT_EQUAL_INT32(osErrorTimeout,
+                            osMessageQueueGet(mq, &msg, NULL, UT_VTIME_TIMEOUT_MS));
+    TEST_ASSERT_EQUAL_UINT32(UT_VTIME_TIMEOUT_MS,
+                                osKernelGetTickCount() - tick_start);
+
+    osThreadId_t thread = osThreadNew(entry_put_delay, NULL, &thread_attr_vtime);
+    TEST_ASSERT_NOT_NULL(thread);
+    tick_start = osKernelGetTickCount();
+    TEST_ASSERT_EQUAL_INT32(osOK,
+                            osMessageQueueGet(mq, &msg, NULL, UT_VTIME_TIMEOUT_MS));
+    TEST_ASSERT_EQUAL_UINT32(UT_VTIME_PUT_DELAY_MS,
+                                osKernelGetTickCount() - tick_start);
+    TEST_ASSERT_EQUAL_UINT32(UT_VTIME_PUT_DELAY_MS, msg);
+    TEST_ASSERT_EQUAL_INT32(osOK, osThreadJoin(thread));
+}
+
+/**
+  * @brief  The scaled virtual time passes faster than the real time when the
+  *         thread runs.
+  */
+TEST(vtime, scale)
+{
+    TEST_ASSERT_EQUAL_INT32(osOK, osKernelSetVirtualTime(1, UT_VTIME_SCALE));
+
+    uint32_t tick_start = osKernelGetTickCount();
+    uint64_t real_busy = real_time_ms();
+    while ((real_time_ms() - real_busy) < UT_VTIME_BUSY_MS)
+    {
+    }
+    uint32_t ticks = osKernelGetTickCount() - tick_start;
+    /* The real time in millisecond is truncated. */
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32((UT_VTIME_BUSY_MS - 1) * UT_VTIME_SCALE,
+                                        ticks);
+
+    /* Still no real time for the blocked waiting. */
+    uint64_t real_start = real_time_ms();
+    osDelay(UT_VTIME_DELAY_MS);
+    TEST_ASSERT_LESS_THAN_UINT32(UT_VTIME_REAL_MS_MAX,
+                                    (uint32_t)(real_time_ms() - real_start));
+}
+
+/**
+  * @brief  Define run test cases of the virtual time.
+  */
+TEST_GROUP_RUNNER(vtime)
+{
+    RUN_TEST_CASE(vtime, delay);
+    RUN_TEST_CASE(vtime, timer_order);
+    RUN_TEST_CASE(vtime, timeout);
+    RUN_TEST_CASE(vtime, scale);
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void timer_func_vtime(void *argument)
+{
+    uint32_t index = (uint32_t)(uintptr_t)argument;
+
+    timer_tick[index] = osKernelGetTickCount();
+    timer_order[timer_fired ++] = index;
+    osSemaphoreRelease(sem);
+}
+
+static void entry_put_delay(void *paras)
+{
+    (void)paras;
+
+    uint32_t msg = UT_VTIME_PUT_DELAY_MS;
+    osDelay(UT_VTIME_PUT_DELAY_MS);
+    osMessageQueuePut(mq, &msg, 0, osWaitForever);
+}
+
+static uint64_t real_time_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+#endif
+
+/* ----------------------------- end of file -------------------------------- */
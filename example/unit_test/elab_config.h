@@ -10,6 +10,35 @@
 /* CMSIS OS related -------------------------------------- */
 #define ELAB_RTOS_CMSIS_OS_EN                   (1)
 #define ELAB_RTOS_TICK_MS                       (1)
+/* Virtual time of the POSIX kernel, the time jumps to the next deadline once
+   all the threads are blocked. The scale is the virtual time passing per real
+   time when any thread runs, 0 for the pure discrete-event simulation, in
+   which the shell waiting for input stops the time. */
+#define ELAB_RTOS_VIRTUAL_TIME_EN               (0)
+#define ELAB_RTOS_VIRTUAL_TIME_SCALE            (0)
+/* Contention profile of the mutexes, semaphores and message queues per name
+   in the POSIX kernel, printed by the shell command profile, and saved into
+   the CSV file at the normal exit. Off by default, and switched on by the
+   profiling build, "x_build.sh profile". */
+#ifndef ELAB_RTOS_PROFILE_EN
+#define ELAB_RTOS_PROFILE_EN                    (0)
+#endif
+#define ELAB_RTOS_PROFILE_FILE                  "elab_profile.csv"
+/* Real-time profile of the POSIX kernel selected by elab_run. The threads at
+   or above osPriorityHigh7, like the timer thread and the serial threads, run
+   in SCHED_FIFO on the CPUs of the mask, and the others are kept off them. The
+   memory is locked and the stacks are prefaulted. The mask 0 does not isolate
+   any CPU. */
+#define ELAB_RTOS_RT_PROFILE_EN                 (0)
+#define ELAB_RTOS_RT_AFFINITY_MASK              (0)
+/* The most running timers, and the threads not created by osThreadNew but
+   calling the RTOS functions, reserved in the POSIX kernel at the start. */
+#define ELAB_RTOS_TIMER_MAX                     (64)
+#define ELAB_RTOS_FOREIGN_THREAD_MAX            (16)
+
+/* Memory related ---------------------------------------- */
+/* Forbid the dynamic allocation after all the modules are initialized. */
+#define ELAB_HEAP_LOCK_EN                       (0)
 
 /* QPC related ------------------------------------------- */
 #define ELAB_QPC_EN                             (1)
@@ -1,6 +1,12 @@
 mkdir build
 
-gcc -std=gnu99 -g \
+# "x_build.sh profile" builds with the contention profile of the RTOS objects.
+FLAGS=""
+if [ "$1" = "profile" ]; then
+    FLAGS="-DELAB_RTOS_PROFILE_EN=1"
+fi
+
+gcc -std=gnu99 -g $FLAGS \
 main.c \
 ../../elab/common/*.c \
 ../../elab/export/*.c \
@@ -15,7 +21,16 @@ main.c \
 ../../elab/unit_test/os/*.c \
 ../../elab/unit_test/elib/*.c \
 ../../elab/unit_test/midware/*.c \
+../../elab/test/test_edf_find_perf.c \
+../../elab/test/test_edf_read_perf.c \
 ../../elab/test/test_elog.c \
+../../elab/test/test_mq_perf.c \
+../../elab/test/test_mp_perf.c \
+../../elab/test/test_mq_prio_perf.c \
+../../elab/test/test_mq_zc_perf.c \
+../../elab/test/test_mutex_perf.c \
+../../elab/test/test_rt_jitter.c \
+../../elab/test/test_serial_perf.c \
 ../../elab/3rd/Shell/*.c \
 ../../elab/3rd/mqtt/common/*.c \
 ../../elab/3rd/mqtt/mqtt/*.c \